@@ -0,0 +1,34 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_BADGE_H_
+#define _BLOCK_SERVER_BADGE_H_
+
+#include <refos/refos.h>
+#include <refos-util/serv_common.h>
+
+/*! @file
+    @brief Block Server badge space definitions.
+
+    The block server polls its disk rather than taking device IRQs, so unlike the console and timer
+    servers it only needs a single asynchronous badge, and its badge space is laid out the same way
+    as the file server's. Please look in @ref file_server/src/badge.h.
+*/
+
+/* ---- BadgeID 49 : Async Notify ---- */
+
+#define BLOCKSERV_ASYNC_NOTIFY_BADGE 0x31
+
+/* ---- BadgeID 50 to 4145 : Clients ---- */
+
+#define BLOCKSERV_CLIENT_BADGE_BASE 0x32
+
+/* ---- BadgeID 4146 to 5169 : Dataspaces ---- */
+
+#define BLOCKSERV_MAX_DATASPACES 1024
+#define BLOCKSERV_DSPACE_BADGE_BASE (BLOCKSERV_CLIENT_BADGE_BASE + SRV_DEFAULT_MAX_CLIENTS)
+
+#endif /* _BLOCK_SERVER_BADGE_H_ */
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <utils/arith.h>
+#include <refos/error.h>
+#include <refos-util/dprintf.h>
+
+#include "bcache.h"
+
+/*! @file
+    @brief Block server buffer cache.
+
+    A fixed pool of block buffers, looked up by block number through a hash table and recycled in
+    least recently used order.
+
+    Writes are write-back: a modified buffer is only written to the device when it is evicted, or
+    when the cache is synced. Write-back gathers the run of consecutive dirty blocks around the one
+    being written into a single device write, so a file written sequentially reaches the disk in
+    large requests.
+
+    Reads are clustered: a miss which continues on from the end of the previous miss doubles the
+    number of blocks read ahead, up to BCACHE_CLUSTER_MAX, while a miss anywhere else drops back to
+    reading a single block. Sequential readers thus quickly get large device requests, and random
+    readers do not pay for read-ahead they will never use.
+*/
+
+/* ------------------------------------------ LRU list ------------------------------------------ */
+
+static void
+bcache_lru_remove(struct bcache *bc, struct bcache_buf *buf)
+{
+    if (buf->lruPrev) {
+        buf->lruPrev->lruNext = buf->lruNext;
+    } else {
+        bc->lruHead = buf->lruNext;
+    }
+    if (buf->lruNext) {
+        buf->lruNext->lruPrev = buf->lruPrev;
+    } else {
+        bc->lruTail = buf->lruPrev;
+    }
+    buf->lruPrev = buf->lruNext = NULL;
+}
+
+static void
+bcache_lru_push_head(struct bcache *bc, struct bcache_buf *buf)
+{
+    buf->lruPrev = NULL;
+    buf->lruNext = bc->lruHead;
+    if (bc->lruHead) {
+        bc->lruHead->lruPrev = buf;
+    } else {
+        bc->lruTail = buf;
+    }
+    bc->lruHead = buf;
+}
+
+static void
+bcache_lru_push_tail(struct bcache *bc, struct bcache_buf *buf)
+{
+    buf->lruNext = NULL;
+    buf->lruPrev = bc->lruTail;
+    if (bc->lruTail) {
+        bc->lruTail->lruNext = buf;
+    } else {
+        bc->lruHead = buf;
+    }
+    bc->lruTail = buf;
+}
+
+static inline struct bcache_buf *
+bcache_lookup(struct bcache *bc, uint32_t block)
+{
+    return (struct bcache_buf *) chash_get(&bc->blockMap, block);
+}
+
+/* ----------------------------------------- Write-back ----------------------------------------- */
+
+/*! @brief Write back the run of consecutive dirty blocks containing the given dirty buffer.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+bcache_write_run(struct bcache *bc, struct bcache_buf *buf)
+{
+    assert(buf->valid && buf->dirty);
+
+    /* Find the start of the run, without letting it grow past what the cluster buffer holds. */
+    uint32_t first = buf->block;
+    while (first > 0 && buf->block - first + 1 < BCACHE_CLUSTER_MAX) {
+        struct bcache_buf *prev = bcache_lookup(bc, first - 1);
+        if (!prev || !prev->dirty) {
+            break;
+        }
+        first--;
+    }
+
+    /* Gather the run into the cluster buffer. */
+    struct bcache_buf *run[BCACHE_CLUSTER_MAX];
+    int n = 0;
+    while (n < BCACHE_CLUSTER_MAX) {
+        struct bcache_buf *b = bcache_lookup(bc, first + n);
+        if (!b || !b->dirty) {
+            break;
+        }
+        memcpy(bc->clusterBuf + n * BLOCKDEV_BLOCK_SIZE, b->data, BLOCKDEV_BLOCK_SIZE);
+        run[n++] = b;
+    }
+    assert(n > 0 && first + n > buf->block);
+
+    int error = blockdev_write(bc->dev, first, n, bc->clusterBuf);
+    if (error) {
+        ROS_ERROR("bcache_write_run failed to write blocks %u-%u.", first, first + n - 1);
+        return error;
+    }
+
+    for (int i = 0; i < n; i++) {
+        run[i]->dirty = false;
+    }
+    bc->nDirty -= n;
+    bc->nWriteBackRuns++;
+    return ESUCCESS;
+}
+
+/*! @brief Take the least recently used buffer out of the cache, writing it back if dirty.
+    @return The evicted buffer, unlinked from the LRU list and hash table. NULL on device error.
+*/
+static struct bcache_buf *
+bcache_evict(struct bcache *bc)
+{
+    struct bcache_buf *buf = bc->lruTail;
+    assert(buf && buf->magic == BCACHE_BUF_MAGIC);
+
+    if (buf->valid) {
+        if (buf->dirty && bcache_write_run(bc, buf) != ESUCCESS) {
+            return NULL;
+        }
+        chash_remove(&bc->blockMap, buf->block);
+        buf->valid = false;
+    }
+
+    bcache_lru_remove(bc, buf);
+    return buf;
+}
+
+/* -------------------------------------- Buffer cache API -------------------------------------- */
+
+void
+bcache_init(struct bcache *bc, struct blockdev *dev)
+{
+    assert(bc && dev && dev->magic == BLOCKDEV_MAGIC);
+    memset(bc, 0, sizeof(struct bcache));
+    bc->magic = BCACHE_MAGIC;
+    bc->dev = dev;
+    bc->clusterLen = 1;
+    chash_init(&bc->blockMap, BCACHE_HASH_SIZE);
+
+    for (int i = 0; i < BCACHE_NUM_BUFFERS; i++) {
+        bc->bufs[i].magic = BCACHE_BUF_MAGIC;
+        bc->bufs[i].data = bc->data[i];
+        bcache_lru_push_head(bc, &bc->bufs[i]);
+    }
+}
+
+struct bcache_buf *
+bcache_get(struct bcache *bc, uint32_t block, bool fill)
+{
+    assert(bc && bc->magic == BCACHE_MAGIC);
+    assert(block < bc->dev->nBlocks);
+
+    struct bcache_buf *buf = bcache_lookup(bc, block);
+    if (buf) {
+        bc->nHits++;
+        bcache_lru_remove(bc, buf);
+        bcache_lru_push_head(bc, buf);
+        return buf;
+    }
+    bc->nMisses++;
+
+    if (!fill) {
+        buf = bcache_evict(bc);
+        if (!buf) {
+            return NULL;
+        }
+        memset(buf->data, 0, BLOCKDEV_BLOCK_SIZE);
+        goto insert;
+    }
+
+    /* Work out how far to read ahead. */
+    bc->clusterLen = (block == bc->nextSeqBlock) ? MIN(bc->clusterLen * 2, BCACHE_CLUSTER_MAX) : 1;
+    int n = 1;
+    while (n < bc->clusterLen && block + n < bc->dev->nBlocks && !bcache_lookup(bc, block + n)) {
+        n++;
+    }
+
+    /* Evict all the buffers we need before reading, since eviction may write back through the
+       cluster buffer. Empty buffers go back on the LRU tail if anything fails. */
+    struct bcache_buf *bufs[BCACHE_CLUSTER_MAX];
+    for (int i = 0; i < n; i++) {
+        bufs[i] = bcache_evict(bc);
+        if (!bufs[i]) {
+            for (int j = 0; j < i; j++) {
+                bcache_lru_push_tail(bc, bufs[j]);
+            }
+            return NULL;
+        }
+    }
+
+    int error = blockdev_read(bc->dev, block, n, n > 1 ? bc->clusterBuf : bufs[0]->data);
+    if (error) {
+        ROS_ERROR("bcache_get failed to read blocks %u-%u.", block, block + n - 1);
+        for (int i = 0; i < n; i++) {
+            bcache_lru_push_tail(bc, bufs[i]);
+        }
+        return NULL;
+    }
+    bc->nextSeqBlock = block + n;
+    bc->nReadAheadBlocks += n - 1;
+
+    /* Insert the read-ahead blocks, then the requested block at the head of the LRU list. */
+    for (int i = n - 1; i >= 1; i--) {
+        memcpy(bufs[i]->data, bc->clusterBuf + i * BLOCKDEV_BLOCK_SIZE, BLOCKDEV_BLOCK_SIZE);
+        bufs[i]->block = block + i;
+        bufs[i]->valid = true;
+        bufs[i]->dirty = false;
+        chash_set(&bc->blockMap, block + i, (chash_item_t) bufs[i]);
+        bcache_lru_push_head(bc, bufs[i]);
+    }
+    buf = bufs[0];
+    if (n > 1) {
+        memcpy(buf->data, bc->clusterBuf, BLOCKDEV_BLOCK_SIZE);
+    }
+
+insert:
+    buf->block = block;
+    buf->valid = true;
+    buf->dirty = false;
+    chash_set(&bc->blockMap, block, (chash_item_t) buf);
+    bcache_lru_push_head(bc, buf);
+    return buf;
+}
+
+void
+bcache_dirty(struct bcache *bc, struct bcache_buf *buf)
+{
+    assert(bc && bc->magic == BCACHE_MAGIC);
+    assert(buf && buf->magic == BCACHE_BUF_MAGIC && buf->valid);
+    if (!buf->dirty) {
+        buf->dirty = true;
+        bc->nDirty++;
+    }
+}
+
+int
+bcache_sync(struct bcache *bc)
+{
+    assert(bc && bc->magic == BCACHE_MAGIC);
+    for (int i = 0; i < BCACHE_NUM_BUFFERS && bc->nDirty > 0; i++) {
+        struct bcache_buf *buf = &bc->bufs[i];
+        if (buf->valid && buf->dirty) {
+            int error = bcache_write_run(bc, buf);
+            if (error) {
+                return error;
+            }
+        }
+    }
+    assert(bc->nDirty == 0);
+    return blockdev_flush(bc->dev);
+}
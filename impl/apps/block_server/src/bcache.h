@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_BCACHE_H_
+#define _BLOCK_SERVER_BCACHE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <data_struct/chash.h>
+#include "blockdev.h"
+
+/*! @file
+    @brief Block server buffer cache. */
+
+#define BCACHE_MAGIC 0x8CAC4E00
+#define BCACHE_BUF_MAGIC 0x8CAC4E01
+
+#define BCACHE_NUM_BUFFERS 64
+#define BCACHE_HASH_SIZE 128
+#define BCACHE_CLUSTER_MAX 16
+#define BCACHE_DIRTY_HIGH_WATER (BCACHE_NUM_BUFFERS / 2)
+
+/*! @brief Cached block buffer. */
+struct bcache_buf {
+    uint32_t magic;
+    uint32_t block;
+    bool valid;
+    bool dirty;
+    char *data; /* No ownership. Points into the cache's data array. */
+
+    /* LRU list links. The head of the list is the most recently used buffer. */
+    struct bcache_buf *lruPrev;
+    struct bcache_buf *lruNext;
+};
+
+/*! @brief Buffer cache structure. */
+struct bcache {
+    uint32_t magic;
+    struct blockdev *dev; /* No ownership. */
+
+    struct bcache_buf bufs[BCACHE_NUM_BUFFERS];
+    char data[BCACHE_NUM_BUFFERS][BLOCKDEV_BLOCK_SIZE];
+    char clusterBuf[BCACHE_CLUSTER_MAX * BLOCKDEV_BLOCK_SIZE];
+
+    chash_t blockMap; /* block --> struct bcache_buf */
+    struct bcache_buf *lruHead;
+    struct bcache_buf *lruTail;
+    int nDirty;
+
+    /* Read clustering state. */
+    uint32_t nextSeqBlock;
+    int clusterLen;
+
+    /* Statistics. */
+    uint32_t nHits;
+    uint32_t nMisses;
+    uint32_t nReadAheadBlocks;
+    uint32_t nWriteBackRuns;
+};
+
+/*! @brief Initialise a buffer cache on top of a block device.
+    @param bc The buffer cache to initialise. (No ownership)
+    @param dev The initialised block device. (No ownership)
+*/
+void bcache_init(struct bcache *bc, struct blockdev *dev);
+
+/*! @brief Get the cached buffer of a block, reading it in from the device on a miss.
+
+    The returned buffer is only valid until the next call to bcache_get(); callers which need two
+    blocks at once must copy one of them out first.
+
+    @param bc The buffer cache. (No ownership)
+    @param block The block to get.
+    @param fill Whether the block contents are needed. Pass false when the caller is about to
+                overwrite the whole block, which skips the device read on a miss and hands back a
+                zeroed buffer instead.
+    @return The cached buffer if success, NULL on device error. (No ownership)
+*/
+struct bcache_buf *bcache_get(struct bcache *bc, uint32_t block, bool fill);
+
+/*! @brief Mark a cached buffer as modified. It will be written back on eviction or sync.
+    @param bc The buffer cache. (No ownership)
+    @param buf The buffer which has been modified. (No ownership)
+*/
+void bcache_dirty(struct bcache *bc, struct bcache_buf *buf);
+
+/*! @brief Write back every dirty buffer, and flush the device's write cache.
+    @param bc The buffer cache. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int bcache_sync(struct bcache *bc);
+
+#endif /* _BLOCK_SERVER_BCACHE_H_ */
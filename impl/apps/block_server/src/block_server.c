@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <assert.h>
+#include <refos/refos.h>
+#include <refos-util/init.h>
+#include <refos-io/morecore.h>
+#include "state.h"
+#include "dispatchers/dspace/dspace.h"
+#include "dispatchers/serv_dispatch.h"
+#include "dispatchers/client_watch.h"
+
+/*! @file
+    @brief Block Server main source file.
+
+    The RefOS Block server gives RefOS persistent storage. It drives a disk, caches its blocks, and
+    serves a simple extent filesystem on it through the dataspace interface.
+
+    The Block server:
+    <ul>
+        <li>Drives the master disk on the primary ATA bus on pc99 (QEMU's -hda disk). Elsewhere, or
+            when there is no such disk, it falls back to a RAM disk.</li>
+        <li>Formats the disk on first mount if it does not hold a valid filesystem.</li>
+        <li>Does NOT support providing pager service to clients.</li>
+        <li>Does NOT support providing content-initialisation for another dataserver.</li>
+        <li>Does NOT support parameter buffers using an external or internal dataspace.</li>
+        <li>Ignores nBytes parameter in open() method; files grow as they are written.</li>
+    </ul>
+
+    The block server provides its files under `/disk/`, next to the file server's boot image files
+    under `/fileserv/`. The filesystem is flat, so file names may not contain '/'.
+*/
+
+/*! @brief Block server's static morecore region. */
+static char blockServMMapRegion[BLOCKSERV_MMAP_REGION_SIZE];
+
+/*! @brief Handle messages recieved by the block server.
+    @param s The global block server state. (No ownership transfer)
+    @param msg The recieved message. (No ownership transfer)
+    @return DISPATCH_SUCCESS if message dispatched, DISPATCH_ERROR if unknown message.
+*/
+static int
+block_server_handle_message(struct blockserv_state *s, srv_msg_t *msg)
+{
+    int result = DISPATCH_PASS;
+    int label = seL4_GetMR(0);
+    void *userptr;
+
+    if (dispatch_client_watch(msg) == DISPATCH_SUCCESS) {
+        return DISPATCH_SUCCESS;
+    }
+
+    if (check_dispatch_data(msg, &userptr) == DISPATCH_SUCCESS) {
+        result = rpc_sv_data_dispatcher(userptr, label);
+        assert(result == DISPATCH_SUCCESS);
+        return DISPATCH_SUCCESS;
+    }
+
+    if (check_dispatch_serv(msg, &userptr) == DISPATCH_SUCCESS) {
+        result = rpc_sv_serv_dispatcher(userptr, label);
+        assert(result == DISPATCH_SUCCESS);
+        return DISPATCH_SUCCESS;
+    }
+
+    dprintf("Unknown message (badge = %d msgInfo = %d label = %d).\n",
+            msg->badge, seL4_MessageInfo_get_label(msg->message), label);
+    ROS_ERROR("block server unknown message.");
+    assert(!"block server unknown message.");
+
+    return DISPATCH_ERROR;
+}
+
+/*! @brief Main block server message loop. Simply loops through recieving and dispatching messages
+           repeatedly. */
+static void
+block_server_mainloop(void)
+{
+    struct blockserv_state *s = &blockServ;
+    srv_msg_t msg;
+
+    while (1) {
+        msg.message = rpc_sv_reply_recv(s->commonState.anonEP, &msg.badge);
+        block_server_handle_message(s, &msg);
+        client_table_postaction(&s->commonState.clientTable);
+    }
+}
+
+/*! @brief Main block server entry point. */
+int
+main()
+{
+    /* See Future Work 3 in timer_server.c about how the system call table is found. */
+    uintptr_t address = strtoll(getenv("SYSTABLE"), NULL, 16);
+    refos_init_selfload_child(address);
+    dprintf("Initialising RefOS block server.\n");
+    refosio_setup_morecore_override(blockServMMapRegion, BLOCKSERV_MMAP_REGION_SIZE);
+    refos_initialise();
+    blockserv_init();
+
+    block_server_mainloop();
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_BLOCKDEV_H_
+#define _BLOCK_SERVER_BLOCKDEV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/*! @file
+    @brief Block device interface.
+
+    A block device is a disk driver seen through a small table of function pointers, so the buffer
+    cache above it does not need to know which driver it is talking to. Devices are addressed in
+    whole BLOCKDEV_BLOCK_SIZE blocks; drivers with smaller sectors split each block up themselves.
+*/
+
+#define BLOCKDEV_MAGIC 0x2B10C4DE
+#define BLOCKDEV_BLOCK_SIZE 4096
+
+struct blockdev;
+
+/*! @brief Block transfer callback type. Reads or writes n consecutive blocks starting at the given
+           block. Returns ESUCCESS if success, refos_err_t otherwise. */
+typedef int (*blockdev_transfer_fn_t)(struct blockdev *dev, uint32_t block, uint32_t n, char *buf);
+
+/*! @brief Block device flush callback type. Returns ESUCCESS if success, refos_err_t otherwise. */
+typedef int (*blockdev_flush_fn_t)(struct blockdev *dev);
+
+/*! @brief Block device structure. */
+struct blockdev {
+    uint32_t magic;
+    const char *name;
+    uint32_t nBlocks;
+
+    blockdev_transfer_fn_t read;
+    blockdev_transfer_fn_t write;
+    blockdev_flush_fn_t flush;
+    void *cookie; /* Driver state. No ownership. */
+
+    /* Statistics. */
+    uint32_t nReadRequests;
+    uint32_t nWriteRequests;
+    uint32_t nBlocksRead;
+    uint32_t nBlocksWritten;
+};
+
+/*! @brief Read consecutive blocks from a block device.
+    @param dev The block device. (No ownership)
+    @param block The first block to read.
+    @param n The number of blocks to read.
+    @param buf Output buffer, at least n * BLOCKDEV_BLOCK_SIZE bytes long. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static inline int
+blockdev_read(struct blockdev *dev, uint32_t block, uint32_t n, char *buf)
+{
+    assert(dev && dev->magic == BLOCKDEV_MAGIC);
+    assert(block + n <= dev->nBlocks);
+    dev->nReadRequests++;
+    dev->nBlocksRead += n;
+    return dev->read(dev, block, n, buf);
+}
+
+/*! @brief Write consecutive blocks to a block device.
+    @param dev The block device. (No ownership)
+    @param block The first block to write.
+    @param n The number of blocks to write.
+    @param buf Input buffer, at least n * BLOCKDEV_BLOCK_SIZE bytes long. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static inline int
+blockdev_write(struct blockdev *dev, uint32_t block, uint32_t n, char *buf)
+{
+    assert(dev && dev->magic == BLOCKDEV_MAGIC);
+    assert(block + n <= dev->nBlocks);
+    dev->nWriteRequests++;
+    dev->nBlocksWritten += n;
+    return dev->write(dev, block, n, buf);
+}
+
+/*! @brief Flush a block device's volatile write cache, if it has one.
+    @param dev The block device. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static inline int
+blockdev_flush(struct blockdev *dev)
+{
+    assert(dev && dev->magic == BLOCKDEV_MAGIC);
+    return dev->flush ? dev->flush(dev) : 0;
+}
+
+#endif /* _BLOCK_SERVER_BLOCKDEV_H_ */
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/refos.h>
+#include "badge.h"
+#include "state.h"
+#include "dataspace.h"
+
+/*! @file
+    @brief Block server file dataspace object allocation and management.
+
+    Follows the file server's dataspace table (see @ref file_server/src/dataspace.c), minus the
+    window and content-init associations, since the block server does not act as a pager.
+*/
+
+/*! @brief Dataspace object OAT creation function. The first argument is the client's DeathID,
+           second argument is the inode, and third argument the permissions mask. */
+static cvector_item_t
+dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
+{
+    struct bs_dataspace_table *dt = (struct bs_dataspace_table *) oat;
+    struct bs_dataspace *ndspace = cslab_alloc(&dt->dspaceCache);
+    if (!ndspace) {
+        ROS_ERROR("dspace_oat_create out of memory!");
+        return NULL;
+    }
+
+    ndspace->magic = BS_DATASPACE_MAGIC;
+    ndspace->dID = id;
+    ndspace->deathID = arg[0];
+    ndspace->inode = (int) arg[1];
+    ndspace->permissions = arg[2];
+    ndspace->dataspaceCap = csalloc();
+    if (!ndspace->dataspaceCap) {
+        cslab_free(&dt->dspaceCache, ndspace);
+        return NULL;
+    }
+
+    /* Create the badged cap represending this dataspace. */
+    int error = seL4_CNode_Mint(
+            REFOS_CSPACE, ndspace->dataspaceCap, REFOS_CDEPTH,
+            REFOS_CSPACE, blockServCommon->anonEP, REFOS_CDEPTH,
+            seL4_AllRights, seL4_CapData_Badge_new(id + BLOCKSERV_DSPACE_BADGE_BASE)
+    );
+    assert(!error);
+    (void) error;
+
+    return (cvector_item_t) ndspace;
+}
+
+/*! @brief Dataspace object OAT deletion function. */
+static void
+dspace_oat_delete(coat_t *oat, cvector_item_t *obj)
+{
+    struct bs_dataspace_table *dt = (struct bs_dataspace_table *) oat;
+    struct bs_dataspace *dspace = (struct bs_dataspace *) obj;
+    assert(dspace && dspace->magic == BS_DATASPACE_MAGIC);
+    dprintf("Deleting dataspace ID %d\n", dspace->dID);
+
+    assert(dspace->dataspaceCap);
+    seL4_CNode_Revoke(REFOS_CSPACE, dspace->dataspaceCap, REFOS_CDEPTH);
+    csfree_delete(dspace->dataspaceCap);
+    cslab_free(&dt->dspaceCache, dspace);
+}
+
+void
+dspace_table_init(struct bs_dataspace_table *dt)
+{
+    dt->allocTable.oat_expand = NULL;
+    dt->allocTable.oat_create = dspace_oat_create;
+    dt->allocTable.oat_delete = dspace_oat_delete;
+    cslab_init(&dt->dspaceCache, sizeof(struct bs_dataspace), 0, NULL, NULL);
+    coat_init(&dt->allocTable, 1, BLOCKSERV_MAX_DATASPACES);
+}
+
+struct bs_dataspace*
+dspace_alloc(struct bs_dataspace_table *dt, uint32_t deathID, int inode, seL4_Word permissions)
+{
+    struct bs_dataspace* ndspace = NULL;
+
+    uint32_t arg[COAT_ARGS];
+    arg[0] = deathID;
+    arg[1] = (uint32_t) inode;
+    arg[2] = (uint32_t) permissions;
+
+    int ID = coat_alloc(&dt->allocTable, arg, (cvector_item_t *) &ndspace);
+    if (!ndspace) {
+        ROS_ERROR("dspace_alloc couldn't allocate a dataspace.");
+        return NULL;
+    }
+
+    assert(ID != COAT_INVALID_ID);
+    assert(ndspace->magic == BS_DATASPACE_MAGIC);
+    (void) ID;
+    return ndspace;
+}
+
+struct bs_dataspace*
+dspace_get_badge(struct bs_dataspace_table *dt, int badge)
+{
+    if (badge < BLOCKSERV_DSPACE_BADGE_BASE ||
+        badge >= BLOCKSERV_DSPACE_BADGE_BASE + BLOCKSERV_MAX_DATASPACES) {
+        return NULL;
+    }
+    struct bs_dataspace* dspace = (struct bs_dataspace*)
+            coat_get(&dt->allocTable, badge - BLOCKSERV_DSPACE_BADGE_BASE);
+    if (!dspace) {
+        return NULL;
+    }
+    assert(dspace->magic == BS_DATASPACE_MAGIC);
+    return dspace;
+}
+
+void
+dspace_delete(struct bs_dataspace_table *dt, int id)
+{
+    coat_free(&dt->allocTable, id);
+}
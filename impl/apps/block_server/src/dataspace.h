@@ -0,0 +1,74 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_DATASPACE_H_
+#define _BLOCK_SERVER_DATASPACE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <data_struct/cvector.h>
+#include <data_struct/coat.h>
+#include <data_struct/cslab.h>
+#include <refos/refos.h>
+#include <refos-rpc/rpc.h>
+
+/*! @file
+    @brief Block server file dataspace object allocation and management. */
+
+#define BS_DATASPACE_MAGIC 0x6D15C0DE
+
+/*! @brief Block server dataspace
+
+    An open file on the extent filesystem. The dataspace cap is a badged endpoint cap of the block
+    server. The structure has no ownership of the file; closing it leaves the file in place.
+ */
+struct bs_dataspace {
+    uint32_t magic;
+    uint32_t dID;
+    uint32_t deathID;
+
+    seL4_CPtr dataspaceCap;
+    seL4_Word permissions;
+    int inode;
+};
+
+struct bs_dataspace_table {
+    coat_t allocTable; /* Inherited struct, must be first. */
+    cslab_t dspaceCache; /* struct bs_dataspace */
+};
+
+/*! @brief Initialise the dataspace allocation table.
+    @param dt The dspace table to initialise. (No ownership passed)
+*/
+void dspace_table_init(struct bs_dataspace_table *dt);
+
+/*! @brief Assigns an dataspace ID and creates a bs_dataspace structure.
+    @param dt The dspace table to allocate from.
+    @param deathID The death ID of the client opening the file.
+    @param inode The extent filesystem inode of the file.
+    @param permissions The dataspace permissions mask.
+    @return Weak pointer to created dataspace. (ie. No ownership)
+*/
+struct bs_dataspace* dspace_alloc(struct bs_dataspace_table *dt, uint32_t deathID, int inode,
+                                  seL4_Word permissions);
+
+/*! @brief Gets the associated dataspace structure given an unwrapped badge.
+    @param dt The dspace table to get from.
+    @param badge The badge corresponding to dataspace ID of the dataspace to get.
+    @return Weak pointer to dataspace associated with given dataspace badge. (No ownership)
+*/
+struct bs_dataspace* dspace_get_badge(struct bs_dataspace_table *dt, int badge);
+
+/*! @brief Delete the given dataspace and release all its memory.
+    @param dt The dspace table to delete from.
+    @param id The dataspace ID of the dataspace to delete.
+*/
+void dspace_delete(struct bs_dataspace_table *dt, int id);
+
+#endif /* _BLOCK_SERVER_DATASPACE_H_ */
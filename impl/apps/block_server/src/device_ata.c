@@ -0,0 +1,304 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <autoconf.h>
+#include <utils/arith.h>
+#include <refos/error.h>
+#include <refos-util/dprintf.h>
+
+#include "device_ata.h"
+
+/*! @file
+    @brief Block server ATA disk driver.
+
+    A polled PIO driver for the master disk on the primary ATA bus, using 28-bit LBA addressing.
+    This is the disk QEMU attaches with -hda, and is enough to get persistent storage on pc99.
+
+    Every word of data costs an IO port syscall, so transfers are expensive. Sector data is moved
+    with the string port helpers (see devio_port_in_string()), which keep everything but the
+    syscall itself out of the per-word loop, and the buffer cache above this driver clusters reads
+    and coalesces write-backs to keep the number of commands down. Device interrupts are disabled
+    and the status register is polled instead, since a command completes in far less time than a
+    round trip through the IRQ path.
+*/
+
+#define ATA_REG_DATA 0
+#define ATA_REG_ERROR 1
+#define ATA_REG_SECCOUNT 2
+#define ATA_REG_LBA0 3
+#define ATA_REG_LBA1 4
+#define ATA_REG_LBA2 5
+#define ATA_REG_DRIVE 6
+#define ATA_REG_STATUS 7
+#define ATA_REG_COMMAND 7
+
+#define ATA_STATUS_ERR 0x01
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_DF 0x20
+#define ATA_STATUS_BSY 0x80
+
+#define ATA_CTRL_NIEN 0x02
+
+#define ATA_CMD_READ_SECTORS 0x20
+#define ATA_CMD_WRITE_SECTORS 0x30
+#define ATA_CMD_CACHE_FLUSH 0xE7
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define ATA_DRIVE_MASTER 0xA0
+#define ATA_DRIVE_LBA 0x40
+
+#define ATA_IDENTIFY_LBA28_SECTORS 60
+#define ATA_MAX_SECTORS_PER_CMD 256
+#define ATA_LBA28_MAX_SECTORS (1 << 28)
+#define ATA_POLL_TIMEOUT 1000000
+
+#define ATA_SECTORS_PER_BLOCK (BLOCKDEV_BLOCK_SIZE / ATA_SECTOR_SIZE)
+
+/* ---------------------------------------- Port helpers ---------------------------------------- */
+
+static uint32_t
+ata_in(struct device_ata_state *s, uint32_t port, int size)
+{
+    ps_io_port_ops_t *ops = &s->io->opsIO.io_port_ops;
+    uint32_t val = 0;
+    if (ops->io_port_in_fn(ops->cookie, port, size, &val)) {
+        /* Reads of a missing device float high. */
+        return 0xFFFFFFFF;
+    }
+    return val;
+}
+
+static void
+ata_out(struct device_ata_state *s, uint32_t port, int size, uint32_t val)
+{
+    ps_io_port_ops_t *ops = &s->io->opsIO.io_port_ops;
+    ops->io_port_out_fn(ops->cookie, port, size, val);
+}
+
+static inline uint8_t
+ata_status(struct device_ata_state *s)
+{
+    return (uint8_t) ata_in(s, s->ioBase + ATA_REG_STATUS, 1);
+}
+
+/*! @brief Wait for the drive to finish the current command phase.
+    @param s The ATA device state.
+    @param drq Whether to also wait for the drive to be ready to transfer data.
+    @return ESUCCESS if success, EINVALID if the drive reported an error or timed out.
+*/
+static int
+ata_poll(struct device_ata_state *s, bool drq)
+{
+    /* Give the drive 400ns to assert BSY; each alternate status read takes ~100ns. */
+    uint8_t altStatus[4];
+    devio_port_in_string(s->io, s->ctrlBase, 1, altStatus, 4);
+
+    for (int i = 0; i < ATA_POLL_TIMEOUT; i++) {
+        uint8_t status = ata_status(s);
+        if (status & ATA_STATUS_BSY) {
+            continue;
+        }
+        if (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+            ROS_WARNING("ATA drive error, status 0x%x error 0x%x.", status,
+                        ata_in(s, s->ioBase + ATA_REG_ERROR, 1) & 0xFF);
+            return EINVALID;
+        }
+        if (!drq || (status & ATA_STATUS_DRQ)) {
+            return ESUCCESS;
+        }
+    }
+
+    ROS_WARNING("ATA drive timed out.");
+    return EINVALID;
+}
+
+/*! @brief Select the master drive and program the LBA and sector count registers. */
+static void
+ata_setup_lba(struct device_ata_state *s, uint32_t lba, uint32_t count)
+{
+    assert(count > 0 && count <= ATA_MAX_SECTORS_PER_CMD);
+    ata_out(s, s->ioBase + ATA_REG_DRIVE, 1,
+            ATA_DRIVE_MASTER | ATA_DRIVE_LBA | ((lba >> 24) & 0xF));
+    /* A sector count of 0 means 256 sectors. */
+    ata_out(s, s->ioBase + ATA_REG_SECCOUNT, 1, count & 0xFF);
+    ata_out(s, s->ioBase + ATA_REG_LBA0, 1, lba & 0xFF);
+    ata_out(s, s->ioBase + ATA_REG_LBA1, 1, (lba >> 8) & 0xFF);
+    ata_out(s, s->ioBase + ATA_REG_LBA2, 1, (lba >> 16) & 0xFF);
+}
+
+/* --------------------------------------- Data transfer ---------------------------------------- */
+
+static int
+ata_transfer(struct device_ata_state *s, uint32_t lba, uint32_t nSectors, char *buf, bool write)
+{
+    while (nSectors > 0) {
+        uint32_t count = MIN(nSectors, ATA_MAX_SECTORS_PER_CMD);
+        int error = ata_poll(s, false);
+        if (error) {
+            return error;
+        }
+
+        ata_setup_lba(s, lba, count);
+        ata_out(s, s->ioBase + ATA_REG_COMMAND, 1,
+                write ? ATA_CMD_WRITE_SECTORS : ATA_CMD_READ_SECTORS);
+
+        for (uint32_t i = 0; i < count; i++) {
+            error = ata_poll(s, true);
+            if (error) {
+                return error;
+            }
+            if (write) {
+                error = devio_port_out_string(s->io, s->ioBase + ATA_REG_DATA, 2, buf,
+                                              ATA_SECTOR_SIZE / 2);
+            } else {
+                error = devio_port_in_string(s->io, s->ioBase + ATA_REG_DATA, 2, buf,
+                                             ATA_SECTOR_SIZE / 2);
+            }
+            if (error) {
+                ROS_WARNING("ATA data transfer failed.");
+                return EINVALID;
+            }
+            buf += ATA_SECTOR_SIZE;
+        }
+
+        if (write) {
+            /* Wait for the last sector to be committed before issuing the next command. */
+            error = ata_poll(s, false);
+            if (error) {
+                return error;
+            }
+        }
+
+        lba += count;
+        nSectors -= count;
+    }
+    return ESUCCESS;
+}
+
+static int
+ata_read_blocks(struct blockdev *dev, uint32_t block, uint32_t n, char *buf)
+{
+    struct device_ata_state *s = (struct device_ata_state *) dev->cookie;
+    assert(s && s->magic == BLOCKSERV_DEVICE_ATA_MAGIC);
+    return ata_transfer(s, block * ATA_SECTORS_PER_BLOCK, n * ATA_SECTORS_PER_BLOCK, buf, false);
+}
+
+static int
+ata_write_blocks(struct blockdev *dev, uint32_t block, uint32_t n, char *buf)
+{
+    struct device_ata_state *s = (struct device_ata_state *) dev->cookie;
+    assert(s && s->magic == BLOCKSERV_DEVICE_ATA_MAGIC);
+    return ata_transfer(s, block * ATA_SECTORS_PER_BLOCK, n * ATA_SECTORS_PER_BLOCK, buf, true);
+}
+
+static int
+ata_flush(struct blockdev *dev)
+{
+    struct device_ata_state *s = (struct device_ata_state *) dev->cookie;
+    assert(s && s->magic == BLOCKSERV_DEVICE_ATA_MAGIC);
+    int error = ata_poll(s, false);
+    if (error) {
+        return error;
+    }
+    ata_out(s, s->ioBase + ATA_REG_DRIVE, 1, ATA_DRIVE_MASTER);
+    ata_out(s, s->ioBase + ATA_REG_COMMAND, 1, ATA_CMD_CACHE_FLUSH);
+    return ata_poll(s, false);
+}
+
+/* ------------------------------------------ Probing ------------------------------------------- */
+
+/*! @brief Send IDENTIFY DEVICE to the master drive, and read out its size.
+    @return ESUCCESS if an ATA disk answered, EFILENOTFOUND otherwise.
+*/
+static int
+ata_identify(struct device_ata_state *s)
+{
+    uint8_t status = ata_status(s);
+    if (status == 0xFF) {
+        /* Floating bus; there is no controller here. */
+        return EFILENOTFOUND;
+    }
+
+    ata_out(s, s->ioBase + ATA_REG_DRIVE, 1, ATA_DRIVE_MASTER);
+    ata_out(s, s->ioBase + ATA_REG_SECCOUNT, 1, 0);
+    ata_out(s, s->ioBase + ATA_REG_LBA0, 1, 0);
+    ata_out(s, s->ioBase + ATA_REG_LBA1, 1, 0);
+    ata_out(s, s->ioBase + ATA_REG_LBA2, 1, 0);
+    ata_out(s, s->ioBase + ATA_REG_COMMAND, 1, ATA_CMD_IDENTIFY);
+
+    status = ata_status(s);
+    if (status == 0 || status == 0xFF) {
+        /* No drive attached. */
+        return EFILENOTFOUND;
+    }
+
+    if (ata_poll(s, false) != ESUCCESS) {
+        return EFILENOTFOUND;
+    }
+    if (ata_in(s, s->ioBase + ATA_REG_LBA1, 1) || ata_in(s, s->ioBase + ATA_REG_LBA2, 1)) {
+        /* ATAPI or SATA signature; not a plain ATA disk. */
+        return EFILENOTFOUND;
+    }
+    if (ata_poll(s, true) != ESUCCESS) {
+        return EFILENOTFOUND;
+    }
+
+    uint16_t identify[ATA_SECTOR_SIZE / 2];
+    for (int i = 0; i < ATA_SECTOR_SIZE / 2; i++) {
+        identify[i] = (uint16_t) ata_in(s, s->ioBase + ATA_REG_DATA, 2);
+    }
+    s->nSectors = identify[ATA_IDENTIFY_LBA28_SECTORS] |
+                  ((uint32_t) identify[ATA_IDENTIFY_LBA28_SECTORS + 1] << 16);
+    s->nSectors = MIN(s->nSectors, ATA_LBA28_MAX_SECTORS);
+    return s->nSectors >= ATA_SECTORS_PER_BLOCK ? ESUCCESS : EFILENOTFOUND;
+}
+
+int
+device_ata_init(struct device_ata_state *s, dev_io_ops_t *io, struct blockdev *dev)
+{
+    assert(s && io && dev);
+    memset(s, 0, sizeof(struct device_ata_state));
+    s->magic = BLOCKSERV_DEVICE_ATA_MAGIC;
+    s->io = io;
+    s->ioBase = ATA_PRIMARY_IO_BASE;
+    s->ctrlBase = ATA_PRIMARY_CTRL_BASE;
+
+#if defined(PLAT_PC99)
+    if (!io->IOPorts) {
+        return EACCESSDENIED;
+    }
+
+    /* We poll; keep the drive from raising IRQ 14. */
+    ata_out(s, s->ctrlBase, 1, ATA_CTRL_NIEN);
+
+    int error = ata_identify(s);
+    if (error) {
+        return error;
+    }
+
+    memset(dev, 0, sizeof(struct blockdev));
+    dev->magic = BLOCKDEV_MAGIC;
+    dev->name = "ata0";
+    dev->nBlocks = s->nSectors / ATA_SECTORS_PER_BLOCK;
+    dev->read = ata_read_blocks;
+    dev->write = ata_write_blocks;
+    dev->flush = ata_flush;
+    dev->cookie = (void *) s;
+
+    dprintf("    Found ATA disk, %u sectors (%u blocks).\n", s->nSectors, dev->nBlocks);
+    return ESUCCESS;
+#else
+    (void) ata_identify;
+    (void) ata_read_blocks;
+    (void) ata_write_blocks;
+    (void) ata_flush;
+    return EUNIMPLEMENTED;
+#endif
+}
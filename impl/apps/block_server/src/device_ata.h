@@ -0,0 +1,42 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_DEVICE_ATA_H_
+#define _BLOCK_SERVER_DEVICE_ATA_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <refos-util/device_io.h>
+#include "blockdev.h"
+
+/*! @file
+    @brief Block server ATA disk driver. */
+
+#define BLOCKSERV_DEVICE_ATA_MAGIC 0xA7A0D15C
+
+#define ATA_PRIMARY_IO_BASE 0x1F0
+#define ATA_PRIMARY_CTRL_BASE 0x3F6
+#define ATA_SECTOR_SIZE 512
+
+/*! @brief ATA disk device state structure. */
+struct device_ata_state {
+    uint32_t magic;
+    dev_io_ops_t *io; /* No ownership, weak reference. */
+    uint32_t ioBase;
+    uint32_t ctrlBase;
+    uint32_t nSectors;
+};
+
+/*! @brief Probe for the master disk on the primary ATA bus, and set it up as a block device.
+    @param s The ATA device state structure to initialise. (No ownership)
+    @param io The initialised device IO manager. (No ownership)
+    @param dev Output block device to fill in. (No ownership)
+    @return ESUCCESS if a usable disk was found, refos_err_t otherwise.
+*/
+int device_ata_init(struct device_ata_state *s, dev_io_ops_t *io, struct blockdev *dev);
+
+#endif /* _BLOCK_SERVER_DEVICE_ATA_H_ */
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <refos/error.h>
+
+#include "device_ramdisk.h"
+
+/*! @file
+    @brief Block server RAM disk.
+
+    Used on platforms without a disk driver, and on pc99 when no ATA disk is attached, so the
+    filesystem above it can always be mounted. Its contents do not survive a reboot.
+*/
+
+static int
+ramdisk_read_blocks(struct blockdev *dev, uint32_t block, uint32_t n, char *buf)
+{
+    struct device_ramdisk_state *s = (struct device_ramdisk_state *) dev->cookie;
+    assert(s && s->magic == BLOCKSERV_DEVICE_RAMDISK_MAGIC);
+    memcpy(buf, s->mem + block * BLOCKDEV_BLOCK_SIZE, n * BLOCKDEV_BLOCK_SIZE);
+    return ESUCCESS;
+}
+
+static int
+ramdisk_write_blocks(struct blockdev *dev, uint32_t block, uint32_t n, char *buf)
+{
+    struct device_ramdisk_state *s = (struct device_ramdisk_state *) dev->cookie;
+    assert(s && s->magic == BLOCKSERV_DEVICE_RAMDISK_MAGIC);
+    memcpy(s->mem + block * BLOCKDEV_BLOCK_SIZE, buf, n * BLOCKDEV_BLOCK_SIZE);
+    return ESUCCESS;
+}
+
+void
+device_ramdisk_init(struct device_ramdisk_state *s, char *mem, uint32_t size, struct blockdev *dev)
+{
+    assert(s && mem && dev);
+    s->magic = BLOCKSERV_DEVICE_RAMDISK_MAGIC;
+    s->mem = mem;
+    s->size = size;
+
+    memset(dev, 0, sizeof(struct blockdev));
+    dev->magic = BLOCKDEV_MAGIC;
+    dev->name = "ram0";
+    dev->nBlocks = size / BLOCKDEV_BLOCK_SIZE;
+    dev->read = ramdisk_read_blocks;
+    dev->write = ramdisk_write_blocks;
+    dev->flush = NULL;
+    dev->cookie = (void *) s;
+}
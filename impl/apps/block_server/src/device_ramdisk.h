@@ -0,0 +1,36 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_DEVICE_RAMDISK_H_
+#define _BLOCK_SERVER_DEVICE_RAMDISK_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "blockdev.h"
+
+/*! @file
+    @brief Block server RAM disk. */
+
+#define BLOCKSERV_DEVICE_RAMDISK_MAGIC 0x5A3D15C0
+
+/*! @brief RAM disk device state structure. */
+struct device_ramdisk_state {
+    uint32_t magic;
+    char *mem; /* No ownership. */
+    uint32_t size;
+};
+
+/*! @brief Set up the given memory as a RAM disk block device.
+    @param s The RAM disk state structure to initialise. (No ownership)
+    @param mem The backing memory of the disk. (No ownership)
+    @param size The size of the backing memory, in bytes.
+    @param dev Output block device to fill in. (No ownership)
+*/
+void device_ramdisk_init(struct device_ramdisk_state *s, char *mem, uint32_t size,
+                         struct blockdev *dev);
+
+#endif /* _BLOCK_SERVER_DEVICE_RAMDISK_H_ */
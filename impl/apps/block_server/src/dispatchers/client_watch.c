@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <refos/share.h>
+#include <refos-rpc/proc_client.h>
+#include <refos-rpc/proc_common.h>
+#include "dispatch.h"
+#include "../state.h"
+#include "../badge.h"
+
+/*! @file
+    @brief Client watch dispatcher module. */
+
+/*! @brief Handles client death notifications.
+    @param notification Structure containing the notification message, read from the notification
+                        ring buffer.
+    @return DISPATCH_SUCCESS if success, DISPATCHER_ERROR otherwise.
+*/
+static int
+handle_blockserver_death_notification(struct proc_notification *notification)
+{
+    dprintf(COLOUR_Y "## Block server Handling death notification...\n" COLOUR_RESET);
+    dprintf("     Label: PROCSERV_NOTIFY_DEATH\n");
+    dprintf("     deathID: %d\n", notification->arg[0]);
+
+    /* Find the client and queue it for deletion. */
+    int error = client_queue_delete_deathID(&blockServCommon->clientTable, notification->arg[0]);
+
+    if (error) {
+        ROS_ERROR("Unknown deathID. block server book-keeping error.");
+        assert(!"block server book-keeping bug.");
+        return DISPATCH_ERROR;
+    }
+
+    /* The client may have died without closing its files; make sure what it wrote is on disk. */
+    bcache_sync(&blockServ.bcache);
+    return DISPATCH_SUCCESS;
+}
+
+int dispatch_client_watch(srv_msg_t *m)
+{
+    if (m->badge != BLOCKSERV_ASYNC_NOTIFY_BADGE) {
+        return DISPATCH_PASS;
+    }
+
+    srv_common_notify_handler_callbacks_t cb = {
+        .handle_server_fault = NULL,
+        .handle_server_content_init = NULL,
+        .handle_server_death_notification = handle_blockserver_death_notification
+    };
+
+    return srv_dispatch_notification(blockServCommon, cb);
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <refos/error.h>
+#include "dspace.h"
+#include "../../badge.h"
+
+ /*! @file
+     @brief Handles block server file dataspace calls.
+
+     This module implements the functions defined in <refos-rpc/data_server.h>, exposing the files
+     of the extent filesystem as dataspaces. Clients read and write them with data_read() and
+     data_write(); the block server does not page, so they cannot be datamapped.
+
+     Writes are buffered in the buffer cache. They reach the disk when the cache needs the space,
+     when enough of the cache is dirty, when a writable file is closed, and when a client dies.
+*/
+
+/*! @brief Look up the dataspace a data call refers to, checking the caller and the passed cap.
+    @param rpc_userptr The RPC userptr of the call.
+    @param rpc_dspace_fd The unwrapped dataspace badge passed in the call.
+    @param fn The name of the calling handler, for debug printing.
+    @return The dataspace if found, NULL otherwise. (No ownership)
+*/
+static struct bs_dataspace*
+blockserv_dspace_get(void *rpc_userptr, seL4_CPtr rpc_dspace_fd, const char *fn)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    if (c->magic != BLOCKSERV_CLIENT_MAGIC) {
+        dprintf("%s EINVALIDPARAM: client not connected.\n", fn);
+        return NULL;
+    }
+    if (!srv_check_dispatch_caps(m, 0x00000001, 1)) {
+        dprintf("%s EINVALIDPARAM: bad caps.\n", fn);
+        return NULL;
+    }
+    struct bs_dataspace* dspace = dspace_get_badge(&blockServ.dspaceTable, rpc_dspace_fd);
+    if (!dspace) {
+        ROS_WARNING("%s: no such dataspace.", fn);
+    }
+    return dspace;
+}
+
+/*! @brief Open a file dataspace for the given client. Helper function for data_open_handler() and
+           data_open_stat_handler().
+    @param c The client to open the dataspace for. (No ownership)
+    @param rpc_name The name of the file to open.
+    @param rpc_flags The read / write / create / truncate flags.
+    @param rpc_errno Output errno variable.
+    @return The opened dataspace if success, NULL otherwise. (No ownership)
+*/
+static struct bs_dataspace*
+blockserv_dspace_open(struct srv_client *c, char* rpc_name, int rpc_flags, int* rpc_errno)
+{
+    if (c->magic != BLOCKSERV_CLIENT_MAGIC || !rpc_name) {
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return NULL;
+    }
+
+    dprintf("Opening %s...\n", rpc_name);
+    int ino = extfs_lookup(&blockServ.fs, rpc_name);
+    if (ino < 0) {
+        if ((rpc_flags & O_CREAT) == 0) {
+            dprintf("File %s not found!\n", rpc_name);
+            SET_ERRNO_PTR(rpc_errno, EFILENOTFOUND);
+            return NULL;
+        }
+        ino = extfs_create(&blockServ.fs, rpc_name);
+        if (ino < 0) {
+            SET_ERRNO_PTR(rpc_errno, -ino);
+            return NULL;
+        }
+        dvprintf("Created file %s inode %d.\n", rpc_name, ino);
+    } else if ((rpc_flags & O_TRUNC) && (rpc_flags & O_ACCMODE) != O_RDONLY) {
+        int error = extfs_truncate(&blockServ.fs, ino, 0);
+        if (error) {
+            SET_ERRNO_PTR(rpc_errno, error);
+            return NULL;
+        }
+    }
+
+    struct bs_dataspace* nds = dspace_alloc(&blockServ.dspaceTable, c->deathID, ino,
+                                            rpc_flags & O_ACCMODE);
+    if (!nds) {
+        ROS_ERROR("blockserv_dspace_open failed to allocate dataspace.");
+        SET_ERRNO_PTR(rpc_errno, ENOMEM);
+        return NULL;
+    }
+
+    SET_ERRNO_PTR(rpc_errno, ESUCCESS);
+    assert(nds->dataspaceCap);
+    return nds;
+}
+
+seL4_CPtr
+data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode , int rpc_size ,
+                  int* rpc_errno)
+{
+    struct bs_dataspace* nds = blockserv_dspace_open((struct srv_client *) rpc_userptr, rpc_name,
+                                                     rpc_flags, rpc_errno);
+    return nds ? nds->dataspaceCap : 0;
+}
+
+seL4_CPtr
+data_open_stat_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode ,
+                       int rpc_size , uint32_t* rpc_dspaceSize , int* rpc_dspaceMode ,
+                       uint32_t* rpc_dspaceFlags , int* rpc_errno)
+{
+    struct bs_dataspace* nds = blockserv_dspace_open((struct srv_client *) rpc_userptr, rpc_name,
+                                                     rpc_flags, rpc_errno);
+    if (!nds) {
+        return 0;
+    }
+    if (rpc_dspaceSize) {
+        (*rpc_dspaceSize) = extfs_size(&blockServ.fs, nds->inode);
+    }
+    if (rpc_dspaceMode) {
+        (*rpc_dspaceMode) = (int) nds->permissions;
+    }
+    if (rpc_dspaceFlags) {
+        (*rpc_dspaceFlags) = 0;
+    }
+    return nds->dataspaceCap;
+}
+
+refos_err_t
+data_stat_handler(void *rpc_userptr , char* rpc_name , uint32_t* rpc_size , uint32_t* rpc_mode ,
+                  uint32_t* rpc_mtime , uint32_t* rpc_flags)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    if (c->magic != BLOCKSERV_CLIENT_MAGIC || !rpc_name || !rpc_size || !rpc_mode || !rpc_mtime ||
+            !rpc_flags) {
+        return EINVALIDPARAM;
+    }
+
+    /* The extent filesystem keeps no times, and any of its files may be written to. */
+    (*rpc_mtime) = 0;
+    (*rpc_flags) = 0;
+    if (rpc_name[0] == '\0') {
+        /* The flat root directory. */
+        (*rpc_size) = 0;
+        (*rpc_mode) = S_IFDIR | S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+        return ESUCCESS;
+    }
+
+    int ino = extfs_lookup(&blockServ.fs, rpc_name);
+    if (ino < 0) {
+        return EFILENOTFOUND;
+    }
+    (*rpc_size) = extfs_size(&blockServ.fs, ino);
+    (*rpc_mode) = S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+    return ESUCCESS;
+}
+
+refos_err_t
+data_close_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    struct bs_dataspace* dspace = blockserv_dspace_get(rpc_userptr, rpc_dspace_fd,
+                                                       "data_close_handler");
+    if (!dspace) {
+        return EINVALIDPARAM;
+    }
+
+    bool writable = dspace->permissions != O_RDONLY;
+    dprintf("Closing dataspace ID %d...\n", dspace->dID);
+    dspace_delete(&blockServ.dspaceTable, dspace->dID);
+
+    if (writable) {
+        return bcache_sync(&blockServ.bcache);
+    }
+    return ESUCCESS;
+}
+
+int
+data_read_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , uint32_t rpc_offset ,
+                  rpc_buffer_t rpc_buf , uint32_t rpc_count)
+{
+    struct bs_dataspace* dspace = blockserv_dspace_get(rpc_userptr, rpc_dspace_fd,
+                                                       "data_read_handler");
+    if (!dspace) {
+        return -EINVALIDPARAM;
+    }
+    return extfs_read(&blockServ.fs, dspace->inode, rpc_offset, rpc_buf.data, rpc_buf.count);
+}
+
+int
+data_write_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , uint32_t rpc_offset ,
+                   rpc_buffer_t rpc_buf , uint32_t rpc_count)
+{
+    struct bs_dataspace* dspace = blockserv_dspace_get(rpc_userptr, rpc_dspace_fd,
+                                                       "data_write_handler");
+    if (!dspace) {
+        return -EINVALIDPARAM;
+    }
+    if (dspace->permissions == O_RDONLY) {
+        return -EACCESSDENIED;
+    }
+
+    int n = extfs_write(&blockServ.fs, dspace->inode, rpc_offset, rpc_buf.data, rpc_buf.count);
+
+    /* Bound how much unwritten data a crash can lose. */
+    if (blockServ.bcache.nDirty >= BCACHE_DIRTY_HIGH_WATER) {
+        bcache_sync(&blockServ.bcache);
+    }
+    return n;
+}
+
+int
+data_getc_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , int rpc_block)
+{
+    return EUNIMPLEMENTED;
+}
+
+refos_err_t
+data_putc_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , int rpc_c)
+{
+    return EUNIMPLEMENTED;
+}
+
+off_t
+data_lseek_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , off_t rpc_offset , int rpc_whence)
+{
+    assert(!"data_lseek_handler unimplemented.");
+    return 0;
+}
+
+uint32_t
+data_get_size_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    struct bs_dataspace* dspace = blockserv_dspace_get(rpc_userptr, rpc_dspace_fd,
+                                                       "data_get_size_handler");
+    if (!dspace) {
+        return 0;
+    }
+    return extfs_size(&blockServ.fs, dspace->inode);
+}
+
+refos_err_t
+data_expand_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , uint32_t rpc_size)
+{
+    struct bs_dataspace* dspace = blockserv_dspace_get(rpc_userptr, rpc_dspace_fd,
+                                                       "data_expand_handler");
+    if (!dspace) {
+        return EINVALIDPARAM;
+    }
+    if (dspace->permissions == O_RDONLY) {
+        return EACCESSDENIED;
+    }
+    if (rpc_size <= extfs_size(&blockServ.fs, dspace->inode)) {
+        return ESUCCESS;
+    }
+    return extfs_truncate(&blockServ.fs, dspace->inode, rpc_size);
+}
+
+refos_err_t
+data_datamap_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , seL4_CPtr rpc_memoryWindow ,
+                     uint32_t rpc_offset)
+{
+    assert(!"data_datamap_handler unimplemented.");
+    return EUNIMPLEMENTED;
+}
+
+refos_err_t
+data_dataunmap_handler(void *rpc_userptr , seL4_CPtr rpc_memoryWindow)
+{
+    assert(!"data_dataunmap_handler unimplemented.");
+    return EUNIMPLEMENTED;
+}
+
+refos_err_t
+data_init_data_handler(void *rpc_userptr , seL4_CPtr rpc_destDataspace , seL4_CPtr rpc_srcDataspace,
+                       uint32_t rpc_srcDataspaceOffset)
+{
+    assert(!"data_init_data_handler unimplemented.");
+    return EUNIMPLEMENTED;
+}
+
+refos_err_t
+data_have_data_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , seL4_CPtr rpc_faultNotifyEP ,
+                       uint32_t* rpc_dataID)
+{
+    assert(!"data_have_data_handler unimplemented.");
+    return EUNIMPLEMENTED;
+}
+
+refos_err_t
+data_unhave_data_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    assert(!"data_unhave_data_handler unimplemented.");
+    return EUNIMPLEMENTED;
+}
+
+refos_err_t
+data_provide_data_from_parambuffer_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd ,
+                                           uint32_t rpc_offset , uint32_t rpc_contentSize)
+{
+    assert(!"data_provide_data_from_parambuffer_handler unimplemented.");
+    return EUNIMPLEMENTED;
+}
+
+int
+data_aio_bind_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    /* Asynchronous I/O rings are only served by the file server. Not an assert, as clients may
+       probe for ring support and fall back to data_read() and data_write(). */
+    return -EUNIMPLEMENTED;
+}
+
+int
+data_aio_enter_handler(void *rpc_userptr)
+{
+    return -EUNIMPLEMENTED;
+}
+
+int
+check_dispatch_data(srv_msg_t *m, void **userptr)
+{
+    return check_dispatch_interface(m, userptr, RPC_DATA_LABEL_MIN, RPC_DATA_LABEL_MAX);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "dispatch.h"
+#include "serv_dispatch.h"
+#include "../badge.h"
+#include "../state.h"
+#include <refos/error.h>
+#include <refos-rpc/serv_server.h>
+#include <refos-rpc/proc_client.h>
+#include <refos-rpc/proc_client_helper.h>
+
+/*! @file
+    @brief Handles server connection and session establishment syscalls.
+
+    This file contains the handlers for serv interface syscalls. It should implement the
+    declarations in the generated <refos-rpc/serv_server.h>.
+*/
+
+seL4_CPtr
+serv_connect_direct_handler(void *rpc_userptr , seL4_CPtr rpc_liveness , int* rpc_errno)
+{
+    struct srv_client *anonc = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) anonc->rpcClient.userptr;
+    assert(anonc->magic == BLOCKSERV_DISPATCH_ANON_CLIENT_MAGIC);
+    struct srv_client *c = blockServCommon->ctable_connect_direct_handler(
+            blockServCommon, m, rpc_liveness, rpc_errno);
+    return c ? c->session : (seL4_CPtr) 0;
+}
+
+refos_err_t
+serv_ping_handler(void *rpc_userptr)
+{
+    dprintf(COLOUR_B "Block server RECIEVED PING!!! HI THERE! ʕ•ᴥ•ʔ" COLOUR_RESET "\n");
+    return ESUCCESS;
+}
+
+refos_err_t
+serv_set_param_buffer_handler(void *rpc_userptr , seL4_CPtr rpc_parambuffer_dataspace ,
+                              uint32_t rpc_parambuffer_size)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    assert(c->magic == BLOCKSERV_CLIENT_MAGIC);
+    return blockServCommon->ctable_set_param_buffer_handler(blockServCommon, c, m,
+            rpc_parambuffer_dataspace, rpc_parambuffer_size);
+}
+
+seL4_CPtr
+serv_set_aio_ring_handler(void *rpc_userptr , seL4_CPtr rpc_ring_dataspace ,
+                          uint32_t rpc_ring_size , int* rpc_errno)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    assert(c->magic == BLOCKSERV_CLIENT_MAGIC);
+    return blockServCommon->ctable_set_aio_ring_handler(blockServCommon, c, m, rpc_ring_dataspace,
+            rpc_ring_size, rpc_errno);
+}
+
+seL4_CPtr
+serv_get_log_ring_handler(void *rpc_userptr , seL4_CPtr rpc_doorbell , uint32_t* rpc_ring_size ,
+                          int* rpc_errno)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    assert(c->magic == BLOCKSERV_CLIENT_MAGIC);
+    return blockServCommon->ctable_get_log_ring_handler(blockServCommon, c, m, rpc_doorbell,
+            rpc_ring_size, rpc_errno);
+}
+
+void
+serv_disconnect_direct_handler(void *rpc_userptr)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    assert(c->magic == BLOCKSERV_CLIENT_MAGIC);
+    dprintf("block server disconnecting client cID = %d. Bye! (D:)\n", c->cID);
+    return blockServCommon->ctable_disconnect_direct_handler(blockServCommon, c);
+}
+
+int
+check_dispatch_serv(srv_msg_t *m, void **userptr)
+{
+    int label = seL4_GetMR(0);
+    if (label == RPC_SERV_CONNECT_DIRECT && m->badge != 0) {
+        return DISPATCH_PASS;
+    }
+    return check_dispatch_interface(m, userptr, RPC_SERV_LABEL_MIN, RPC_SERV_LABEL_MAX);
+}
\ No newline at end of file
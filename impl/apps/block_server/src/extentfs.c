@@ -0,0 +1,407 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <utils/arith.h>
+#include <refos/error.h>
+#include <refos-util/dprintf.h>
+
+#include "extentfs.h"
+
+/*! @file
+    @brief Block server extent filesystem.
+
+    A deliberately simple filesystem: a superblock, a fixed size table of inodes, and the data area.
+    There are no directories; each inode holds a file name and a single extent of contiguous data
+    blocks. Keeping every file contiguous means a sequential file access is a sequential disk
+    access, which is what the buffer cache's read clustering and write-back coalescing want.
+
+    Extents are allocated first-fit. A file which outgrows its extent is grown in place if the
+    blocks after it are free, or else moved to a free extent twice its size, so the cost of moving
+    is amortised over the file's growth.
+
+    All metadata and data goes through the buffer cache, and the in-memory inode table is written
+    through to its cached block whenever it changes.
+*/
+
+#define EXTFS_BLOCKS(x) (((x) + BLOCKDEV_BLOCK_SIZE - 1) / BLOCKDEV_BLOCK_SIZE)
+
+static inline struct extfs_inode *
+extfs_inode(struct extfs *fs, int ino)
+{
+    assert(ino >= 0 && ino < EXTFS_MAX_INODES);
+    assert(fs->inodes[ino].used);
+    return &fs->inodes[ino];
+}
+
+/*! @brief Write an in-memory inode through to its buffer cache block. */
+static int
+extfs_inode_sync(struct extfs *fs, int ino)
+{
+    uint32_t block = EXTFS_INODE_TABLE_START + ino / EXTFS_INODES_PER_BLOCK;
+    struct bcache_buf *buf = bcache_get(fs->bc, block, true);
+    if (!buf) {
+        return EINVALID;
+    }
+    memcpy(buf->data + (ino % EXTFS_INODES_PER_BLOCK) * sizeof(struct extfs_inode),
+           &fs->inodes[ino], sizeof(struct extfs_inode));
+    bcache_dirty(fs->bc, buf);
+    return ESUCCESS;
+}
+
+/* ------------------------------------------ Mounting ------------------------------------------ */
+
+static int
+extfs_format(struct extfs *fs)
+{
+    dprintf("    Formatting extent filesystem, %u blocks...\n", fs->nBlocks);
+
+    /* Clear the inode table. */
+    for (int i = 0; i < EXTFS_INODE_TABLE_BLOCKS; i++) {
+        struct bcache_buf *buf = bcache_get(fs->bc, EXTFS_INODE_TABLE_START + i, false);
+        if (!buf) {
+            return EINVALID;
+        }
+        memset(buf->data, 0, BLOCKDEV_BLOCK_SIZE);
+        bcache_dirty(fs->bc, buf);
+    }
+
+    /* Write the superblock last. */
+    struct bcache_buf *buf = bcache_get(fs->bc, EXTFS_SUPERBLOCK, false);
+    if (!buf) {
+        return EINVALID;
+    }
+    struct extfs_superblock *sb = (struct extfs_superblock *) buf->data;
+    memset(buf->data, 0, BLOCKDEV_BLOCK_SIZE);
+    sb->magic = EXTFS_MAGIC;
+    sb->version = EXTFS_VERSION;
+    sb->blockSize = BLOCKDEV_BLOCK_SIZE;
+    sb->nBlocks = fs->nBlocks;
+    sb->inodeTableStart = EXTFS_INODE_TABLE_START;
+    sb->inodeTableBlocks = EXTFS_INODE_TABLE_BLOCKS;
+    sb->dataStart = EXTFS_DATA_START;
+    bcache_dirty(fs->bc, buf);
+
+    return bcache_sync(fs->bc);
+}
+
+int
+extfs_mount(struct extfs *fs, struct bcache *bc)
+{
+    assert(fs && bc && bc->magic == BCACHE_MAGIC);
+    memset(fs, 0, sizeof(struct extfs));
+    fs->bc = bc;
+    fs->nBlocks = bc->dev->nBlocks;
+
+    if (fs->nBlocks <= EXTFS_DATA_START) {
+        ROS_ERROR("extfs_mount: device too small.");
+        return ENOMEM;
+    }
+
+    struct bcache_buf *buf = bcache_get(bc, EXTFS_SUPERBLOCK, true);
+    if (!buf) {
+        return EINVALID;
+    }
+    struct extfs_superblock sb;
+    memcpy(&sb, buf->data, sizeof(sb));
+    if (sb.magic != EXTFS_MAGIC || sb.version != EXTFS_VERSION ||
+        sb.blockSize != BLOCKDEV_BLOCK_SIZE || sb.nBlocks != fs->nBlocks ||
+        sb.inodeTableStart != EXTFS_INODE_TABLE_START ||
+        sb.inodeTableBlocks != EXTFS_INODE_TABLE_BLOCKS || sb.dataStart != EXTFS_DATA_START) {
+        int error = extfs_format(fs);
+        if (error) {
+            ROS_ERROR("extfs_mount: could not format device.");
+            return error;
+        }
+    }
+
+    /* Load the inode table. */
+    for (int i = 0; i < EXTFS_INODE_TABLE_BLOCKS; i++) {
+        buf = bcache_get(bc, EXTFS_INODE_TABLE_START + i, true);
+        if (!buf) {
+            return EINVALID;
+        }
+        memcpy(&fs->inodes[i * EXTFS_INODES_PER_BLOCK], buf->data,
+               EXTFS_INODES_PER_BLOCK * sizeof(struct extfs_inode));
+    }
+    for (int i = 0; i < EXTFS_MAX_INODES; i++) {
+        struct extfs_inode *in = &fs->inodes[i];
+        in->name[EXTFS_NAME_LEN - 1] = '\0';
+        if (!in->used) {
+            continue;
+        }
+        if (in->size > in->nBlocks * BLOCKDEV_BLOCK_SIZE || (in->nBlocks > 0 &&
+            (in->startBlock < EXTFS_DATA_START || in->nBlocks > fs->nBlocks ||
+             in->startBlock > fs->nBlocks - in->nBlocks))) {
+            ROS_WARNING("extfs_mount: dropping corrupt inode %d.", i);
+            memset(in, 0, sizeof(struct extfs_inode));
+            extfs_inode_sync(fs, i);
+        }
+    }
+
+    return ESUCCESS;
+}
+
+/* ----------------------------------------- Allocation ----------------------------------------- */
+
+/*! @brief Check that a run of blocks is inside the data area and in no file's extent. */
+static bool
+extfs_range_free(struct extfs *fs, uint32_t start, uint32_t n)
+{
+    if (start < EXTFS_DATA_START || n > fs->nBlocks || start > fs->nBlocks - n) {
+        return false;
+    }
+    for (int i = 0; i < EXTFS_MAX_INODES; i++) {
+        struct extfs_inode *in = &fs->inodes[i];
+        if (in->used && in->nBlocks > 0 && start < in->startBlock + in->nBlocks &&
+            in->startBlock < start + n) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! @brief First-fit search for a free run of blocks.
+    @return The first block of the run, or 0 if there is no large enough run.
+*/
+static uint32_t
+extfs_find_free(struct extfs *fs, uint32_t n)
+{
+    uint32_t start = EXTFS_DATA_START;
+    while (n <= fs->nBlocks && start <= fs->nBlocks - n) {
+        bool moved = false;
+        for (int i = 0; i < EXTFS_MAX_INODES; i++) {
+            struct extfs_inode *in = &fs->inodes[i];
+            if (in->used && in->nBlocks > 0 && start < in->startBlock + in->nBlocks &&
+                in->startBlock < start + n) {
+                /* Overlaps this extent; skip past it. */
+                start = in->startBlock + in->nBlocks;
+                moved = true;
+            }
+        }
+        if (!moved) {
+            return start;
+        }
+    }
+    return 0;
+}
+
+/*! @brief Move a file's data to a new extent. */
+static int
+extfs_move(struct extfs *fs, struct extfs_inode *in, uint32_t newStart)
+{
+    uint32_t nUsed = EXTFS_BLOCKS(in->size);
+    for (uint32_t i = 0; i < nUsed; i++) {
+        struct bcache_buf *src = bcache_get(fs->bc, in->startBlock + i, true);
+        if (!src) {
+            return EINVALID;
+        }
+        memcpy(fs->moveBuf, src->data, BLOCKDEV_BLOCK_SIZE);
+        struct bcache_buf *dst = bcache_get(fs->bc, newStart + i, false);
+        if (!dst) {
+            return EINVALID;
+        }
+        memcpy(dst->data, fs->moveBuf, BLOCKDEV_BLOCK_SIZE);
+        bcache_dirty(fs->bc, dst);
+    }
+    in->startBlock = newStart;
+    return ESUCCESS;
+}
+
+/*! @brief Make sure a file's extent is at least the given number of blocks long. */
+static int
+extfs_reserve(struct extfs *fs, int ino, uint32_t nBlocks)
+{
+    struct extfs_inode *in = extfs_inode(fs, ino);
+    if (nBlocks <= in->nBlocks) {
+        return ESUCCESS;
+    }
+
+    /* Try for double the current extent first, then settle for just what is needed. */
+    uint32_t sizes[2] = { MAX(nBlocks, MAX(in->nBlocks * 2, EXTFS_MIN_EXTENT_BLOCKS)), nBlocks };
+
+    for (int i = 0; i < 2; i++) {
+        if (in->nBlocks > 0 &&
+            extfs_range_free(fs, in->startBlock + in->nBlocks, sizes[i] - in->nBlocks)) {
+            in->nBlocks = sizes[i];
+            return extfs_inode_sync(fs, ino);
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        uint32_t start = extfs_find_free(fs, sizes[i]);
+        if (!start) {
+            continue;
+        }
+        int error = extfs_move(fs, in, start);
+        if (error) {
+            return error;
+        }
+        in->nBlocks = sizes[i];
+        return extfs_inode_sync(fs, ino);
+    }
+
+    ROS_WARNING("extfs_reserve: no free extent of %u blocks.", nBlocks);
+    return ENOMEM;
+}
+
+/* ------------------------------------------- Files -------------------------------------------- */
+
+int
+extfs_lookup(struct extfs *fs, const char *name)
+{
+    assert(fs && name);
+    for (int i = 0; i < EXTFS_MAX_INODES; i++) {
+        if (fs->inodes[i].used && !strncmp(fs->inodes[i].name, name, EXTFS_NAME_LEN)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int
+extfs_create(struct extfs *fs, const char *name)
+{
+    assert(fs && name);
+    size_t len = strlen(name);
+    if (len == 0 || len >= EXTFS_NAME_LEN) {
+        return -EINVALIDPARAM;
+    }
+    if (extfs_lookup(fs, name) >= 0) {
+        return -EINVALIDPARAM;
+    }
+
+    for (int i = 0; i < EXTFS_MAX_INODES; i++) {
+        struct extfs_inode *in = &fs->inodes[i];
+        if (in->used) {
+            continue;
+        }
+        memset(in, 0, sizeof(struct extfs_inode));
+        strncpy(in->name, name, EXTFS_NAME_LEN - 1);
+        in->used = 1;
+        int error = extfs_inode_sync(fs, i);
+        if (error) {
+            in->used = 0;
+            return -error;
+        }
+        return i;
+    }
+    return -ENOMEM;
+}
+
+uint32_t
+extfs_size(struct extfs *fs, int ino)
+{
+    return extfs_inode(fs, ino)->size;
+}
+
+int
+extfs_truncate(struct extfs *fs, int ino, uint32_t size)
+{
+    struct extfs_inode *in = extfs_inode(fs, ino);
+    if (size <= in->size) {
+        in->size = size;
+        return extfs_inode_sync(fs, ino);
+    }
+
+    int error = extfs_reserve(fs, ino, EXTFS_BLOCKS(size));
+    if (error) {
+        return error;
+    }
+
+    /* Zero from the old end of file. Blocks past it may hold data from an earlier, longer file. */
+    uint32_t pos = in->size;
+    while (pos < size) {
+        uint32_t blockOffset = pos % BLOCKDEV_BLOCK_SIZE;
+        struct bcache_buf *buf = bcache_get(fs->bc, in->startBlock + pos / BLOCKDEV_BLOCK_SIZE,
+                                            blockOffset != 0);
+        if (!buf) {
+            return EINVALID;
+        }
+        memset(buf->data + blockOffset, 0, BLOCKDEV_BLOCK_SIZE - blockOffset);
+        bcache_dirty(fs->bc, buf);
+        pos += BLOCKDEV_BLOCK_SIZE - blockOffset;
+    }
+
+    in->size = size;
+    return extfs_inode_sync(fs, ino);
+}
+
+int
+extfs_read(struct extfs *fs, int ino, uint32_t offset, char *buf, uint32_t count)
+{
+    struct extfs_inode *in = extfs_inode(fs, ino);
+    if (offset >= in->size) {
+        return 0;
+    }
+    count = MIN(count, in->size - offset);
+
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t pos = offset + done;
+        uint32_t blockOffset = pos % BLOCKDEV_BLOCK_SIZE;
+        uint32_t n = MIN(BLOCKDEV_BLOCK_SIZE - blockOffset, count - done);
+        struct bcache_buf *b = bcache_get(fs->bc, in->startBlock + pos / BLOCKDEV_BLOCK_SIZE, true);
+        if (!b) {
+            return done ? (int) done : -EINVALID;
+        }
+        memcpy(buf + done, b->data + blockOffset, n);
+        done += n;
+    }
+    return (int) done;
+}
+
+int
+extfs_write(struct extfs *fs, int ino, uint32_t offset, char *buf, uint32_t count)
+{
+    struct extfs_inode *in = extfs_inode(fs, ino);
+    if (count == 0) {
+        return 0;
+    }
+    if (offset + count < offset) {
+        return -EINVALIDPARAM;
+    }
+
+    /* Reserve first, so a write which does not fit leaves the file alone. */
+    int error = extfs_reserve(fs, ino, EXTFS_BLOCKS(offset + count));
+    if (error) {
+        return -error;
+    }
+
+    /* Zero fill any hole between the end of file and the write. */
+    if (offset > in->size) {
+        error = extfs_truncate(fs, ino, offset);
+        if (error) {
+            return -error;
+        }
+    }
+
+    /* Blocks past the end of file need not be read in; their old contents are never visible. */
+    uint32_t nUsed = EXTFS_BLOCKS(in->size);
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t pos = offset + done;
+        uint32_t block = pos / BLOCKDEV_BLOCK_SIZE;
+        uint32_t blockOffset = pos % BLOCKDEV_BLOCK_SIZE;
+        uint32_t n = MIN(BLOCKDEV_BLOCK_SIZE - blockOffset, count - done);
+        bool fill = block < nUsed && n < BLOCKDEV_BLOCK_SIZE;
+        struct bcache_buf *b = bcache_get(fs->bc, in->startBlock + block, fill);
+        if (!b) {
+            break;
+        }
+        memcpy(b->data + blockOffset, buf + done, n);
+        bcache_dirty(fs->bc, b);
+        done += n;
+    }
+
+    if (offset + done > in->size) {
+        in->size = offset + done;
+        extfs_inode_sync(fs, ino);
+    }
+    return done ? (int) done : -EINVALID;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_EXTENTFS_H_
+#define _BLOCK_SERVER_EXTENTFS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bcache.h"
+
+/*! @file
+    @brief Block server extent filesystem. */
+
+#define EXTFS_MAGIC 0x45585446 /* "EXTF" */
+#define EXTFS_VERSION 1
+#define EXTFS_NAME_LEN 44
+
+#define EXTFS_SUPERBLOCK 0
+#define EXTFS_INODE_TABLE_START 1
+#define EXTFS_INODE_TABLE_BLOCKS 2
+#define EXTFS_DATA_START (EXTFS_INODE_TABLE_START + EXTFS_INODE_TABLE_BLOCKS)
+#define EXTFS_INODES_PER_BLOCK (BLOCKDEV_BLOCK_SIZE / sizeof(struct extfs_inode))
+#define EXTFS_MAX_INODES (EXTFS_INODE_TABLE_BLOCKS * EXTFS_INODES_PER_BLOCK)
+#define EXTFS_MIN_EXTENT_BLOCKS 4
+
+/*! @brief On-disk superblock, at the start of block EXTFS_SUPERBLOCK. */
+struct extfs_superblock {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockSize;
+    uint32_t nBlocks;
+    uint32_t inodeTableStart;
+    uint32_t inodeTableBlocks;
+    uint32_t dataStart;
+};
+
+/*! @brief On-disk inode. Each file is stored in a single extent of contiguous blocks. */
+struct extfs_inode {
+    char name[EXTFS_NAME_LEN];
+    uint32_t used;
+    uint32_t startBlock;
+    uint32_t nBlocks; /*!< Allocated extent length; may be longer than the file. */
+    uint32_t size;
+    uint32_t reserved;
+};
+
+/*! @brief Mounted extent filesystem state. */
+struct extfs {
+    struct bcache *bc; /* No ownership. */
+    uint32_t nBlocks;
+
+    /* In-memory copy of the inode table, written through to the buffer cache on change. */
+    struct extfs_inode inodes[EXTFS_MAX_INODES];
+
+    /* Scratch block used when moving an extent. */
+    char moveBuf[BLOCKDEV_BLOCK_SIZE];
+};
+
+/*! @brief Mount the filesystem on the given buffer cache, formatting the device first if it does
+           not hold a valid filesystem.
+    @param fs The filesystem state to initialise. (No ownership)
+    @param bc The initialised buffer cache of the device. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int extfs_mount(struct extfs *fs, struct bcache *bc);
+
+/*! @brief Look up a file by name.
+    @return The inode number of the file if found, -1 otherwise.
+*/
+int extfs_lookup(struct extfs *fs, const char *name);
+
+/*! @brief Create a new empty file.
+    @return The inode number of the new file if success, negative refos_err_t otherwise.
+*/
+int extfs_create(struct extfs *fs, const char *name);
+
+/*! @brief Get the size of a file in bytes. */
+uint32_t extfs_size(struct extfs *fs, int ino);
+
+/*! @brief Set the size of a file in bytes. Space added to the end of the file reads as zeroes.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int extfs_truncate(struct extfs *fs, int ino, uint32_t size);
+
+/*! @brief Read from a file.
+    @return The number of bytes read, or negative refos_err_t.
+*/
+int extfs_read(struct extfs *fs, int ino, uint32_t offset, char *buf, uint32_t count);
+
+/*! @brief Write to a file, growing it if needed.
+    @return The number of bytes written, or negative refos_err_t.
+*/
+int extfs_write(struct extfs *fs, int ino, uint32_t offset, char *buf, uint32_t count);
+
+#endif /* _BLOCK_SERVER_EXTENTFS_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <refos-util/cspace.h>
+#include <refos/vmlayout.h>
+#include <refos/refos.h>
+#include <refos-io/stdio.h>
+#include <refos-rpc/proc_client.h>
+#include <refos-rpc/proc_client_helper.h>
+#include "state.h"
+#include "badge.h"
+
+/*! @file
+    @brief Block server global state & helper functions. */
+
+struct blockserv_state blockServ;
+srv_common_t *blockServCommon;
+const char* dprintfServerName = "BLOCKSERV";
+int dprintfServerColour = 33;
+
+/*! @brief Backing memory of the RAM disk, used when there is no disk driver or no disk. */
+static char blockServRamDisk[BLOCKSERV_RAMDISK_SIZE];
+
+void
+blockserv_init(void)
+{
+    /* Initialise device IO manager. */
+    dprintf("    Initialising blockserv device IO manager...\n");
+    devio_init(&blockServ.devIO);
+
+    /* Set up the server common config. */
+    srv_common_config_t cfg = {
+        .maxClients = SRV_DEFAULT_MAX_CLIENTS,
+        .clientBadgeBase = BLOCKSERV_CLIENT_BADGE_BASE,
+        .clientMagic = BLOCKSERV_CLIENT_MAGIC,
+        .notificationBufferSize = SRV_DEFAULT_NOTIFICATION_BUFFER_SIZE,
+        .paramBufferSize = SRV_DEFAULT_PARAM_BUFFER_SIZE,
+        .serverName = "blockserver",
+        .mountPointPath = BLOCKSERV_MOUNTPOINT,
+        .nameServEP = REFOS_NAMESERV_EP,
+        .faultDeathNotifyBadge = BLOCKSERV_ASYNC_NOTIFY_BADGE
+    };
+
+    /* Set up block server common state. */
+    blockServCommon = &blockServ.commonState;
+    srv_common_init(blockServCommon, cfg);
+
+    /* Find a disk. There is no SD/MMC driver yet, so outside of pc99 this is always the RAM
+       disk. */
+    dprintf("    Probing for disk...\n");
+    if (device_ata_init(&blockServ.ata, &blockServ.devIO, &blockServ.dev) != ESUCCESS) {
+        dprintf("    No disk found, using a %d KiB RAM disk.\n", BLOCKSERV_RAMDISK_SIZE / 1024);
+        device_ramdisk_init(&blockServ.ramdisk, blockServRamDisk, BLOCKSERV_RAMDISK_SIZE,
+                            &blockServ.dev);
+    }
+
+    dprintf("    Mounting extent filesystem on %s...\n", blockServ.dev.name);
+    bcache_init(&blockServ.bcache, &blockServ.dev);
+    int error = extfs_mount(&blockServ.fs, &blockServ.bcache);
+    if (error) {
+        ROS_ERROR("Block server could not mount filesystem.");
+        assert(!"Block server could not mount filesystem.");
+    }
+
+    dprintf("    Initialising dataspace allocation table...\n");
+    dspace_table_init(&blockServ.dspaceTable);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _BLOCK_SERVER_STATE_H_
+#define _BLOCK_SERVER_STATE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/vmlayout.h>
+#include <refos-rpc/rpc.h>
+
+#include "badge.h"
+#include "blockdev.h"
+#include "device_ata.h"
+#include "device_ramdisk.h"
+#include "bcache.h"
+#include "extentfs.h"
+#include "dataspace.h"
+
+#include <refos-util/serv_connect.h>
+#include <refos-util/serv_common.h>
+#include <refos-util/cspace.h>
+#include <refos-util/device_io.h>
+#include <refos-rpc/data_client.h>
+#include <refos-rpc/data_client_helper.h>
+#include <refos/refos.h>
+
+/*! @file
+    @brief Block server global state & helper functions. */
+
+// Debug printing.
+#include <refos-util/dprintf.h>
+
+#ifndef CONFIG_REFOS_DEBUG
+    #define printf(x,...)
+#endif /* CONFIG_REFOS_DEBUG */
+
+#define BLOCKSERV_MMAP_REGION_SIZE 0x80000
+#define BLOCKSERV_MOUNTPOINT "disk"
+#define BLOCKSERV_CLIENT_MAGIC 0x3B10C4C1
+#define BLOCKSERV_RAMDISK_SIZE 0x200000
+
+/*! @brief Block server global state. */
+struct blockserv_state {
+    srv_common_t commonState;
+    dev_io_ops_t devIO;
+
+    struct device_ata_state ata;
+    struct device_ramdisk_state ramdisk;
+    struct blockdev dev;
+
+    struct bcache bcache;
+    struct extfs fs;
+    struct bs_dataspace_table dspaceTable;
+};
+
+extern struct blockserv_state blockServ;
+extern srv_common_t *blockServCommon;
+
+/*! @brief Initialise block server state, probe for a disk and mount the filesystem on it. */
+void blockserv_init(void);
+
+#endif /* _BLOCK_SERVER_STATE_H_ */
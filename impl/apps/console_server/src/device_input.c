@@ -41,16 +41,16 @@
 static void
 input_push_char(struct input_state *s, int c)
 {
-    /* If backlog is too big, prune it. */
-    while (cqueue_size(&s->inputBacklog) >= CONSERV_DEVICE_INPUT_BACKLOG_MAXSIZE) {
-        cqueue_item_t item = cqueue_pop(&s->inputBacklog);
-        (void) item;
+    /* If backlog is too big, drop the oldest characters. */
+    cring_item_t item;
+    while (cring_full(&s->inputBacklog) && cring_pop(&s->inputBacklog, &item)) {
+        s->numDropped++;
     }
 
     /* Push new character onto the queue. */
-    bool success = cqueue_push(&s->inputBacklog, (cqueue_item_t) c);
+    bool success = cring_push(&s->inputBacklog, (cring_item_t) c);
     if (!success) {
-        ROS_ERROR("input backlog queue should not be full. conserv book-keeping error.");
+        ROS_ERROR("input_push_char could not push onto backlog. Conserv out of memory.");
     }
 }
 
@@ -91,35 +91,29 @@ input_handle_irq(void *cookie, uint32_t irq)
     #endif
 
     /* Notify any waiters. */
-    for (int i = 0; i < cvector_count(&s->waiterList); i++) {
-        struct input_waiter *waiter = (struct input_waiter*) cvector_get(&s->waiterList, i);
-        assert(waiter && waiter->magic == CONSERV_DEVICE_INPUT_WAITER_MAGIC);
-        assert(waiter->reply && waiter->client);
+    struct srv_reply_waiter *waiter = srv_reply_first(&s->waiterPool);
+    while (waiter) {
+        struct srv_reply_waiter *next = srv_reply_next(waiter);
+        assert(waiter->magic == SRV_REPLY_WAITER_MAGIC && waiter->client);
 
-        if (cqueue_size(&s->inputBacklog) <= 0) {
+        if (cring_count(&s->inputBacklog) == 0) {
             /* No more backlog to reply to. Cannot reply to more waiters. */
             break;
         }
 
-        waiter->client->rpcClient.skip_reply = false;
-        waiter->client->rpcClient.reply = waiter->reply;
-
         /* Reply to the waiter. */
+        srv_reply_bind(waiter);
         if (waiter->type == INPUT_WAITERTYPE_GETC) {
-            int ch = (int) cqueue_pop(&s->inputBacklog);
-            reply_data_getc((void*) waiter->client, ch);
+            cring_item_t ch;
+            cring_pop(&s->inputBacklog, &ch);
+            reply_data_getc((void*) waiter->client, (int) ch);
         } else {
             assert(!"Not implemented.");
         }
 
-        /* Delete the saved reply cap, and free the structure. */
-        waiter->client->rpcClient.reply = 0;
-        csfree_delete(waiter->reply);
-        waiter->magic = 0x0;
-        free(waiter);
-        cvector_set(&s->waiterList, i, (cvector_item_t) NULL);
-        cvector_delete(&s->waiterList, i);
-        i--;
+        /* Return the waiter back to the pool. */
+        srv_reply_free(waiter);
+        waiter = next;
     }
 }
 
@@ -130,8 +124,14 @@ input_init(struct input_state *s)
     s->magic = CONSERV_DEVICE_INPUT_MAGIC;
 
     /* Initialise the input backlog and waiting list. */
-    cqueue_init(&s->inputBacklog, CONSERV_DEVICE_INPUT_BACKLOG_MAXSIZE);
-    cvector_init(&s->waiterList);
+    cring_init(&s->inputBacklog, CONSERV_DEVICE_INPUT_BACKLOG_MAXSIZE);
+    s->numDropped = 0;
+    int error = srv_reply_pool_init(&s->waiterPool, CONSERV_DEVICE_INPUT_INITIAL_WAITERS,
+                                    SRV_DEFAULT_MAX_CLIENTS);
+    if (error != ESUCCESS) {
+        ROS_ERROR("input_init failed to initialise waiter pool.");
+        assert(!"input_init failed to initialise waiter pool.");
+    }
 
     /* Loop through every possible IRQ, and get the ones that the input device needs to
        listen to. */
@@ -159,16 +159,16 @@ input_read(struct input_state *s, int *dest, uint32_t count)
         return 0;
     }
 
-    if (cqueue_size(&s->inputBacklog) == 0) {
+    if (cring_count(&s->inputBacklog) == 0) {
         /* Nothing in the backlog. We're going to have to block. */
         return 0;
     }
 
     /* Read in from backlog. */
     int i = 0;
-    while (cqueue_size(&s->inputBacklog) > 0) {
-        int c = (int) cqueue_pop(&s->inputBacklog);
-        dest[i++] = c;
+    cring_item_t c;
+    while (cring_pop(&s->inputBacklog, &c)) {
+        dest[i++] = (int) c;
         if (i >= count) {
             break;
         }
@@ -182,50 +182,20 @@ input_save_caller_as_waiter(struct input_state *s, struct srv_client *c, bool ty
 {
     assert(s && s->magic == CONSERV_DEVICE_INPUT_MAGIC);
     assert(c && c->magic == CONSERV_CLIENT_MAGIC);
-    int error = EINVALID;
 
-    /* Allocate and fill out waiter structure. */
-    struct input_waiter *waiter = malloc(sizeof(struct input_waiter));
+    /* Save current caller into a pooled waiter. (Pool keeps ownership) */
+    struct srv_reply_waiter *waiter = srv_reply_save_caller(&s->waiterPool, c);
     if (!waiter) {
-        ROS_ERROR("input_save_caller_as_waiter failed to alloc waiter struct.");
+        ROS_ERROR("input_save_caller_as_waiter failed to save caller.");
         return ENOMEM;
     }
-    waiter->magic = CONSERV_DEVICE_INPUT_WAITER_MAGIC;
-    waiter->client = c;
     waiter->type = type;
-
-    /* Allocate a cslot to save the reply cap into. */
-    waiter->reply = csalloc();
-    if (!waiter->reply) {
-        ROS_ERROR("input_save_caller_as_waiter failed to alloc cslot.");
-        error = ENOMEM;
-        goto exit1;
-    }
-
-    /* Save current caller into the reply cap. */
-    error = seL4_CNode_SaveCaller(REFOS_CSPACE, waiter->reply, REFOS_CDEPTH);
-    if (error != seL4_NoError) {
-        ROS_ERROR("input_save_caller_as_waiter failed to save caller.");
-        error = EINVALID;
-        goto exit2;
-    }
-
-    /* Add to waiter list. (Takes ownership) */
-    cvector_add(&s->waiterList, (cvector_item_t) waiter);
-
     return ESUCCESS;
-
-    /* Exit stack. */
-exit2:
-    csfree(waiter->reply);
-exit1:
-    waiter->magic = 0;
-    free(waiter);
-    return error;
 }
 
 void
-input_purge_client(struct srv_client *client)
+input_purge_client(struct input_state *s, struct srv_client *client)
 {
-    assert(!"not implemented.");
+    assert(s && s->magic == CONSERV_DEVICE_INPUT_MAGIC);
+    srv_reply_cancel_client(client);
 }
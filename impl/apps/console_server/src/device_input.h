@@ -12,31 +12,26 @@
 #include <stdbool.h>
 #include <sel4/sel4.h>
 #include <data_struct/cvector.h>
-#include <data_struct/cqueue.h>
+#include <data_struct/cring.h>
+#include <refos-util/serv_reply.h>
 
 /*! @file
     @brief Console Server input device implementation. */
 
 #define CONSERV_DEVICE_INPUT_MAGIC 0x54F1A770
 #define CONSERV_DEVICE_INPUT_BACKLOG_MAXSIZE 2
-#define CONSERV_DEVICE_INPUT_WAITER_MAGIC 0x341A8321
+#define CONSERV_DEVICE_INPUT_INITIAL_WAITERS 16
 
 #define INPUT_WAITERTYPE_GETC 0x0
 #define INPUT_WAITERTYPE_READ 0x1
 
 struct srv_client;
 
-struct input_waiter {
-    uint32_t magic;
-    seL4_CPtr reply;
-    struct srv_client *client; /*!< No ownership, Weak Reference. */
-    bool type; /*!< Whether getc or read. */
-};
-
 struct input_state {
     uint32_t magic;
-    cqueue_t inputBacklog; /*!< char */
-    cvector_t waiterList; /*!< input_waiter */
+    cring_t inputBacklog; /*!< char */
+    uint32_t numDropped; /*!< Characters dropped off the front of a full backlog. */
+    struct srv_reply_pool waiterPool; /*!< srv_reply_waiter, type is getc or read. */
 };
 
 /*! @brief Initialise input state manager and waiter list.
@@ -63,8 +58,9 @@ int input_read(struct input_state *s, int *dest, uint32_t count);
 int input_save_caller_as_waiter(struct input_state *s, struct srv_client *c, bool type);
 
 /*! @brief Purge all weak references to client form waiting list. Used when client dies.
+    @param s The input state structure. (No ownership transfer)
     @param client The dying client to be purged.
 */
-void input_purge_client(struct srv_client *client);
+void input_purge_client(struct input_state *s, struct srv_client *client);
 
 #endif /* _CONSOLE_SERVER_DEVICE_INPUT_H_ */
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "device_serial.h"
+#include <assert.h>
+#include <string.h>
+#include <autoconf.h>
+#include <refos/error.h>
+#include <refos-util/dprintf.h>
+
+/*! @file
+    @brief Console Server serial output. */
+
+#ifdef PLAT_PC99
+    /* 16550 UART registers, as offsets from the UART's IO port base. */
+    #define DEVICE_SERIAL_THR 0
+    #define DEVICE_SERIAL_IIR 2
+    #define DEVICE_SERIAL_FCR 2
+    #define DEVICE_SERIAL_LSR 5
+
+    #define DEVICE_SERIAL_FCR_ENABLE_CLEAR 0x07 /* Enable FIFOs and clear both of them. */
+    #define DEVICE_SERIAL_IIR_FIFO_ENABLED 0xC0
+    #define DEVICE_SERIAL_LSR_THRE 0x20 /* Transmit holding register (or FIFO) empty. */
+
+    #define DEVICE_SERIAL_FIFO_SIZE 16
+    #define DEVICE_SERIAL_POLL_TRIES 0x100000
+#endif
+
+void
+device_serial_init(struct device_serial_state *s, ps_chardevice_t *dev, dev_io_ops_t *io)
+{
+    assert(s && dev && io);
+    memset(s, 0, sizeof(struct device_serial_state));
+    s->magic = CONSERV_DEVICE_SERIAL_MAGIC;
+    s->dev = dev;
+    s->io = io;
+    s->fifoSize = 1;
+
+    #ifdef PLAT_PC99
+    /* The pc99 serial driver keeps the UART's IO port base as its vaddr. */
+    s->port = (uint32_t) dev->vaddr;
+    if (!s->port) {
+        return;
+    }
+
+    /* Enable the FIFOs, and check that they really are there; a plain 8250 / 16450 has none. */
+    uint32_t iir = 0;
+    ps_io_port_out(&io->opsIO.io_port_ops, s->port + DEVICE_SERIAL_FCR, 1,
+                   DEVICE_SERIAL_FCR_ENABLE_CLEAR);
+    ps_io_port_in(&io->opsIO.io_port_ops, s->port + DEVICE_SERIAL_IIR, 1, &iir);
+    if ((iir & DEVICE_SERIAL_IIR_FIFO_ENABLED) == DEVICE_SERIAL_IIR_FIFO_ENABLED) {
+        s->fifoSize = DEVICE_SERIAL_FIFO_SIZE;
+    }
+    dprintf("    Serial port 0x%x transmit FIFO size %d.\n", s->port, s->fifoSize);
+    #endif
+}
+
+#ifdef PLAT_PC99
+
+/*! @brief Write out a chunk of at most one FIFO's worth of characters, waiting for the transmit
+           FIFO to drain first. */
+static void
+device_serial_write_chunk(struct device_serial_state *s, const char *chunk, int n)
+{
+    assert(n <= s->fifoSize);
+    /* On timeout, write anyway like ps_cdev_putchar() would after its wait. */
+    devio_port_poll(s->io, s->port + DEVICE_SERIAL_LSR, 1, DEVICE_SERIAL_LSR_THRE,
+                    DEVICE_SERIAL_LSR_THRE, DEVICE_SERIAL_POLL_TRIES, NULL);
+    devio_port_out_string(s->io, s->port + DEVICE_SERIAL_THR, 1, chunk, n);
+}
+
+/*! @brief Add a character to the chunk being built, writing the chunk out once it fills the
+           FIFO. */
+static inline void
+device_serial_push(struct device_serial_state *s, char *chunk, int *n, char c)
+{
+    chunk[(*n)++] = c;
+    if ((*n) == s->fifoSize) {
+        device_serial_write_chunk(s, chunk, *n);
+        (*n) = 0;
+    }
+}
+
+#endif /* PLAT_PC99 */
+
+void
+device_serial_write(struct device_serial_state *s, const char *buf, int count)
+{
+    assert(s && s->magic == CONSERV_DEVICE_SERIAL_MAGIC);
+
+    #ifdef PLAT_PC99
+    if (s->port) {
+        char chunk[DEVICE_SERIAL_FIFO_SIZE];
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            if (buf[i] == '\n') {
+                device_serial_push(s, chunk, &n, '\r');
+            }
+            device_serial_push(s, chunk, &n, buf[i]);
+        }
+        if (n > 0) {
+            device_serial_write_chunk(s, chunk, n);
+        }
+        return;
+    }
+    #endif
+
+    for (int i = 0; i < count; i++) {
+        ps_cdev_putchar(s->dev, buf[i]);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _CONSOLE_SERVER_DEVICE_SERIAL_H_
+#define _CONSOLE_SERVER_DEVICE_SERIAL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <platsupport/chardev.h>
+#include <refos-util/device_io.h>
+
+/*! @file
+    @brief Console Server serial output.
+
+    Writes whole buffers out to the serial device. ps_cdev_putchar() polls the line status register
+    before every character it writes, which on pc99 is two IO port syscalls per character. Here the
+    16550 UART's transmit FIFO is enabled instead, so that once a single line status read shows the
+    FIFO empty, a FIFO's worth of characters can be written without polling again. Platforms
+    without a port IO UART fall back to ps_cdev_putchar().
+*/
+
+#define CONSERV_DEVICE_SERIAL_MAGIC 0x5E21A10C
+
+/*! @brief Serial output state structure. */
+struct device_serial_state {
+    uint32_t magic;
+    ps_chardevice_t *dev; /* No ownership. */
+    dev_io_ops_t *io;     /* No ownership. */
+    uint32_t port;        /* UART IO port base, or 0 to use ps_cdev_putchar(). */
+    int fifoSize;
+};
+
+/*! @brief Initialise serial output, enabling the UART's transmit FIFO if it has one.
+    @param s The serial output state structure to initialise. (No ownership)
+    @param dev The initialised serial character device. (No ownership)
+    @param io The initialised device IO manager. (No ownership)
+*/
+void device_serial_init(struct device_serial_state *s, ps_chardevice_t *dev, dev_io_ops_t *io);
+
+/*! @brief Write a buffer out to the serial device. On a port IO UART, newlines are written out as
+           "\r\n"; otherwise each character goes through ps_cdev_putchar() unchanged.
+    @param s The serial output state structure. (No ownership)
+    @param buf The buffer to write out. (No ownership)
+    @param count The number of characters to write.
+*/
+void device_serial_write(struct device_serial_state *s, const char *buf, int count);
+
+#endif /* _CONSOLE_SERVER_DEVICE_SERIAL_H_ */
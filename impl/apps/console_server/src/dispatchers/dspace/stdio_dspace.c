@@ -35,9 +35,7 @@ serial_write_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , uint32_t rpc_
                      rpc_buffer_t rpc_buf , uint32_t rpc_count)
 {
     assert(rpc_dspace_fd == CONSERV_DSPACE_BADGE_STDIO);
-    for (int i = 0; i < rpc_buf.count; i++) {
-        ps_cdev_putchar(&conServ.devSerial, ((char*) rpc_buf.data)[i]);
-    }
+    device_serial_write(&conServ.devSerialOut, (char*) rpc_buf.data, rpc_buf.count);
     return rpc_buf.count;
 }
 
@@ -71,6 +69,7 @@ refos_err_t
 serial_putc_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , int rpc_c)
 {
     assert(rpc_dspace_fd == CONSERV_DSPACE_BADGE_STDIO);
-    ps_cdev_putchar(&conServ.devSerial, rpc_c);
+    char c = (char) rpc_c;
+    device_serial_write(&conServ.devSerialOut, &c, 1);
     return ESUCCESS;
 }
\ No newline at end of file
@@ -42,9 +42,7 @@ int dprintfServerColour = 33;
 static size_t
 conserv_writev_override(void *data, size_t count)
 {
-    for (int i = 0; i < count; i++) {
-        ps_cdev_putchar(&conServ.devSerial, ((char*) data)[i]);
-    }
+    device_serial_write(&conServ.devSerialOut, (char*) data, (int) count);
     if (conServ.devScreen.initialised) {
         device_screen_write(&conServ.devScreen, (char*) data, (int) count);
     }
@@ -78,6 +76,7 @@ conserv_init(void)
         exit(1);
     }
     dprintf("    Serial device initialised at vaddr 0x%x\n", (uint32_t) devSerialRet->vaddr);
+    device_serial_init(&conServ.devSerialOut, &conServ.devSerial, &conServ.devIO);
     refos_override_stdio(NULL, conserv_writev_override);
 
     /* Set up the server common config. */
@@ -20,6 +20,7 @@
 #include <platsupport/serial.h>
 #include "device_input.h"
 #include "device_screen.h"
+#include "device_serial.h"
 #include "badge.h"
 
 #include <data_struct/cvector.h>
@@ -63,6 +64,7 @@ struct conserv_state {
     /* Main console server data structures. */
     dev_io_ops_t devIO;
     ps_chardevice_t devSerial;
+    struct device_serial_state devSerialOut;
     struct input_state devInput;
     struct device_screen_state devScreen;
 
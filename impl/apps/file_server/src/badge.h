@@ -17,6 +17,11 @@
 
 #define FS_ASYNC_NOTIFY_BADGE 0x31
 
+/* ---- Badge bit 0x10000 : Async I/O ring doorbell ---- */
+
+/* Notification badges are ORed together, so the doorbell uses a bit above the whole badge space. */
+#define FS_ASYNC_AIO_BADGE 0x10000
+
 /* ---- BadgeID 50 to 4145 : Clients ---- */
 
 #define FS_CLIENT_BADGE_BASE 0x32
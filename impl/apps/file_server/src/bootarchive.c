@@ -0,0 +1,317 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief File server boot archive access.
+
+    Implements lookup in both boot archive formats, and on-demand decompression of compressed
+    archive blocks. See bootarchive.h for the compressed archive layout.
+*/
+
+#include <string.h>
+#include <assert.h>
+#include <cpio/cpio.h>
+#include <utils/arith.h>
+#include <refos/error.h>
+#include <refos-util/dprintf.h>
+
+#include "bootarchive.h"
+
+/*! @brief Forward declaration of the boot archive.
+
+    The boot archive is stored inside the file server's ELF image. This is a similar idea to
+    something like creating a
+    > const char data[] = { 0x3F, 0xFF, 0x23 ...etc}
+*/
+extern char _cpio_archive[];
+
+/*! @brief Decompressed block cache entry. */
+struct bootarchive_cache_entry {
+    bool valid;
+    uint32_t block;   /*!< Block table index of the cached block. */
+    uint32_t lastUse;
+    uint32_t length;  /*!< Decompressed length of the block. */
+    char data[BOOTARCHIVE_BLOCK_SIZE];
+};
+
+static struct bootarchive_header *_header = NULL; /* NULL if the archive is a plain CPIO. */
+static struct bootarchive_file *_files = NULL;
+static struct bootarchive_block *_blocks = NULL;
+static const char *_names = NULL;
+
+/* The file server serialises its handlers, so the block cache needs no locking. */
+static struct bootarchive_cache_entry _cache[BOOTARCHIVE_CACHE_BLOCKS];
+static uint32_t _cacheUseCounter = 0;
+
+/* ----------------------------- LZ4 block decompression ---------------------------------------- */
+
+/*! @brief Decompress a single LZ4 format block. Only the block format is supported, there is no
+           frame header. Every read and write is bounds checked, so a corrupt block gives an error
+           rather than overrunning either buffer.
+    @param src The compressed block.
+    @param srcLen The compressed block length.
+    @param dest The destination buffer.
+    @param destLen The destination buffer size.
+    @return Decompressed length if success, -1 if the block is corrupt.
+*/
+static int
+bootarchive_lz4_decompress(const uint8_t *src, uint32_t srcLen, uint8_t *dest, uint32_t destLen)
+{
+    const uint8_t *ip = src, *iend = src + srcLen;
+    uint8_t *op = dest, *oend = dest + destLen;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        /* Copy the literals. */
+        uint32_t len = token >> 4;
+        if (len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (uint32_t) (iend - ip) || len > (uint32_t) (oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        /* The last sequence has literals only. */
+        if (ip >= iend) {
+            break;
+        }
+
+        /* Copy the match, which may overlap the bytes it is producing. */
+        if (iend - ip < 2) {
+            return -1;
+        }
+        uint32_t matchOffset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (matchOffset == 0 || matchOffset > (uint32_t) (op - dest)) {
+            return -1;
+        }
+        len = token & 15;
+        if (len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += 4;
+        if (len > (uint32_t) (oend - op)) {
+            return -1;
+        }
+        const uint8_t *match = op - matchOffset;
+        while (len--) {
+            *op++ = *match++;
+        }
+    }
+    return op - dest;
+}
+
+/* ----------------------------- Compressed archive helpers ------------------------------------- */
+
+/*! @brief Decompress a block of the compressed archive.
+    @param block The block table index of the block.
+    @param length The expected decompressed length of the block.
+    @param dest The destination buffer, at least length bytes long.
+    @return ESUCCESS if success, EINVALID if the block is corrupt.
+*/
+static int
+bootarchive_decompress_block(uint32_t block, uint32_t length, char *dest)
+{
+    assert(_header && block < _header->nBlocks && length <= BOOTARCHIVE_BLOCK_SIZE);
+    struct bootarchive_block *b = &_blocks[block];
+    const char *src = _cpio_archive + b->offset;
+
+    if (b->length & BOOTARCHIVE_BLOCK_RAW) {
+        if ((b->length & ~BOOTARCHIVE_BLOCK_RAW) != length) {
+            goto corrupt;
+        }
+        memcpy(dest, src, length);
+        return ESUCCESS;
+    }
+
+    int len = bootarchive_lz4_decompress((const uint8_t *) src, b->length, (uint8_t *) dest,
+                                         length);
+    if (len != (int) length) {
+        goto corrupt;
+    }
+    return ESUCCESS;
+
+corrupt:
+    ROS_ERROR("Boot archive block %u is corrupt.", block);
+    return EINVALID;
+}
+
+/*! @brief Get a decompressed block from the block cache, decompressing it into the least recently
+           used cache entry if it is not cached.
+    @param block The block table index of the block.
+    @param length The decompressed length of the block.
+    @return The cache entry holding the block if success, NULL otherwise. (No ownership)
+*/
+static struct bootarchive_cache_entry *
+bootarchive_cache_get(uint32_t block, uint32_t length)
+{
+    struct bootarchive_cache_entry *victim = &_cache[0];
+    for (int i = 0; i < BOOTARCHIVE_CACHE_BLOCKS; i++) {
+        struct bootarchive_cache_entry *e = &_cache[i];
+        if (e->valid && e->block == block) {
+            e->lastUse = ++_cacheUseCounter;
+            return e;
+        }
+        if (!e->valid || (victim->valid && e->lastUse < victim->lastUse)) {
+            victim = e;
+        }
+    }
+
+    victim->valid = false;
+    if (bootarchive_decompress_block(block, length, victim->data) != ESUCCESS) {
+        return NULL;
+    }
+    victim->valid = true;
+    victim->block = block;
+    victim->length = length;
+    victim->lastUse = ++_cacheUseCounter;
+    return victim;
+}
+
+/* ------------------------------------ Boot archive -------------------------------------------- */
+
+void
+bootarchive_init(void)
+{
+    struct bootarchive_header *h = (struct bootarchive_header *) _cpio_archive;
+    if (h->magic != BOOTARCHIVE_MAGIC) {
+        dvprintf("Boot archive is a plain CPIO archive.\n");
+        return;
+    }
+    if (h->version != BOOTARCHIVE_VERSION || h->blockSize != BOOTARCHIVE_BLOCK_SIZE) {
+        ROS_ERROR("Unsupported compressed boot archive version %u block size %u.", h->version,
+                  h->blockSize);
+        assert(!"Unsupported boot archive.");
+        return;
+    }
+
+    _header = h;
+    _files = (struct bootarchive_file *) (_cpio_archive + h->filesOffset);
+    _blocks = (struct bootarchive_block *) (_cpio_archive + h->blocksOffset);
+    _names = _cpio_archive + h->namesOffset;
+
+    uint32_t total = 0, stored = 0;
+    for (uint32_t i = 0; i < h->nFiles; i++) {
+        total += _files[i].size;
+    }
+    for (uint32_t i = 0; i < h->nBlocks; i++) {
+        stored += _blocks[i].length & ~BOOTARCHIVE_BLOCK_RAW;
+    }
+    dvprintf("Boot archive is compressed: %u files, %u blocks, %u bytes stored as %u bytes.\n",
+             h->nFiles, h->nBlocks, total, stored);
+    (void) total;
+    (void) stored;
+}
+
+bool
+bootarchive_find(const char *name, struct bootarchive_entry *entry)
+{
+    assert(name && entry);
+
+    if (!_header) {
+        unsigned long size = 0;
+        char *data = cpio_get_file(_cpio_archive, name, &size);
+        if (!data) {
+            return false;
+        }
+        entry->data = data;
+        entry->index = -1;
+        entry->size = (uint32_t) size;
+        return true;
+    }
+
+    /* The file table is sorted by name. */
+    int lo = 0, hi = (int) _header->nFiles - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(_names + _files[mid].nameOffset, name);
+        if (cmp == 0) {
+            entry->data = NULL;
+            entry->index = mid;
+            entry->size = _files[mid].size;
+            return true;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return false;
+}
+
+const char *
+bootarchive_entry_name(int n)
+{
+    if (!_header) {
+        const char *name = NULL;
+        unsigned long size = 0;
+        if (!cpio_get_entry(_cpio_archive, n, &name, &size)) {
+            return NULL;
+        }
+        return name;
+    }
+    if (n < 0 || n >= (int) _header->nFiles) {
+        return NULL;
+    }
+    return _names + _files[n].nameOffset;
+}
+
+int
+bootarchive_read(int32_t index, uint32_t offset, char *dest, uint32_t count)
+{
+    assert(_header && index >= 0 && index < (int32_t) _header->nFiles);
+    struct bootarchive_file *f = &_files[index];
+    if (offset >= f->size) {
+        return 0;
+    }
+    count = MIN(f->size - offset, count);
+
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t pos = offset + done;
+        uint32_t block = pos / BOOTARCHIVE_BLOCK_SIZE;
+        uint32_t blockOffset = pos % BOOTARCHIVE_BLOCK_SIZE;
+        uint32_t blockLength = MIN(f->size - block * BOOTARCHIVE_BLOCK_SIZE,
+                                   BOOTARCHIVE_BLOCK_SIZE);
+        uint32_t n = MIN(blockLength - blockOffset, count - done);
+
+        if (blockOffset == 0 && n == blockLength) {
+            /* The whole block is wanted; skip the cache and decompress it in place. */
+            if (bootarchive_decompress_block(f->firstBlock + block, blockLength,
+                                             dest + done) != ESUCCESS) {
+                return -EINVALID;
+            }
+        } else {
+            struct bootarchive_cache_entry *e = bootarchive_cache_get(f->firstBlock + block,
+                                                                      blockLength);
+            if (!e) {
+                return -EINVALID;
+            }
+            memcpy(dest + done, e->data + blockOffset, n);
+        }
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief File server boot archive access.
+
+    The file server's boot files are linked into its image as the _cpio_archive blob. The blob is
+    either a plain CPIO archive, or a compressed archive built by tools/mkcarchive.py (see
+    CONFIG_APP_FILE_SERVER_COMPRESSED_ARCHIVE), which is told apart by its magic number at start
+    up. Both are accessed through the functions here, so the rest of the file server does not care
+    which one it was built with.
+
+    Compressed archive layout (all fields little endian 32-bit words):
+
+    > struct bootarchive_header                      At offset 0.
+    > struct bootarchive_file  files[nFiles]         At filesOffset, sorted by name.
+    > struct bootarchive_block blocks[nBlocks]       At blocksOffset.
+    > char names[]                                   At namesOffset, NUL terminated names.
+    > compressed block data
+
+    Every file is split into blockSize (one page) sized blocks, each compressed on its own in the
+    LZ4 block format, so that any page of any file may be decompressed without touching the rest
+    of the file. Blocks which do not compress are stored raw. Recently used decompressed blocks
+    are kept in a small cache for data_read() style access; whole pages for the pager are
+    decompressed straight into the pager frame instead.
+*/
+
+#ifndef _FILE_SERVER_BOOT_ARCHIVE_H_
+#define _FILE_SERVER_BOOT_ARCHIVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <refos/refos.h>
+
+#define BOOTARCHIVE_MAGIC 0x5A504352 /* "RCPZ" */
+#define BOOTARCHIVE_VERSION 1
+#define BOOTARCHIVE_BLOCK_SIZE REFOS_PAGE_SIZE
+#define BOOTARCHIVE_BLOCK_RAW 0x80000000 /* Block length flag; block is stored uncompressed. */
+#define BOOTARCHIVE_CACHE_BLOCKS 8
+
+struct bootarchive_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockSize;
+    uint32_t nFiles;
+    uint32_t nBlocks;
+    uint32_t filesOffset;
+    uint32_t blocksOffset;
+    uint32_t namesOffset;
+};
+
+struct bootarchive_file {
+    uint32_t nameOffset; /*!< Offset of the name in the names table. */
+    uint32_t size;       /*!< Uncompressed file size. */
+    uint32_t firstBlock; /*!< Index of the first block of the file in the block table. */
+};
+
+struct bootarchive_block {
+    uint32_t offset; /*!< Offset of the block data from the start of the archive. */
+    uint32_t length; /*!< Stored block length, ORed with BOOTARCHIVE_BLOCK_RAW if uncompressed. */
+};
+
+/*! @brief A file in the boot archive. */
+struct bootarchive_entry {
+    char *data;    /*!< Content of an uncompressed file, or NULL if it is compressed. */
+    int32_t index; /*!< Compressed archive file index, or -1 if uncompressed. */
+    uint32_t size; /*!< Uncompressed file size. */
+};
+
+/*! @brief Detect the boot archive format and print some statistics about it. */
+void bootarchive_init(void);
+
+/*! @brief Look up a file in the boot archive.
+    @param name The name of the file.
+    @param entry Output file entry. (No ownership)
+    @return true if the file was found, false otherwise.
+*/
+bool bootarchive_find(const char *name, struct bootarchive_entry *entry);
+
+/*! @brief Get the name of the n-th file in the boot archive.
+    @param n The index of the file.
+    @return The name of the file, or NULL if there are not that many files. (No ownership, valid
+            for the lifetime of the file server)
+*/
+const char *bootarchive_entry_name(int n);
+
+/*! @brief Read from a compressed boot archive file. Reads of whole blocks are decompressed straight
+           into the destination; partial reads go through the decompressed block cache.
+    @param index The compressed archive file index.
+    @param offset The offset into the file to read from.
+    @param dest The destination buffer. (No ownership)
+    @param count The number of bytes to read.
+    @return Number of bytes read, or negative refos_err_t if the archive is corrupt.
+*/
+int bootarchive_read(int32_t index, uint32_t offset, char *dest, uint32_t count);
+
+#endif /* _FILE_SERVER_BOOT_ARCHIVE_H_ */
@@ -6,13 +6,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <sel4/sel4.h>
+#include <utils/arith.h>
 #include <refos/refos.h>
 #include <refos/vmlayout.h>
 #include "badge.h"
 #include "state.h"
 #include "dataspace.h"
+#include "bootarchive.h"
 
  /*! @file
      @brief File server CPIO dataspace object allocation and management.
@@ -42,8 +45,10 @@
 static cvector_item_t
 dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
 {
+    struct fs_dataspace_table *dt = (struct fs_dataspace_table *) oat;
+
     /* Allocate and fill in structure. */
-    struct fs_dataspace *ndspace = malloc(sizeof(struct fs_dataspace));
+    struct fs_dataspace *ndspace = cslab_alloc(&dt->dspaceCache);
     if (!ndspace) {
         assert(!"oom");
         ROS_ERROR("dspace_oat_create out of memory!");
@@ -57,12 +62,14 @@ dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     ndspace->fileData = (char*) arg[1];
     ndspace->fileDataSize = arg[2];
     ndspace->permissions = arg[3];
+    ndspace->archiveIndex = -1;
     ndspace->fileCreated = false;
+    ndspace->directory = false;
 
-    /* Check that the dataspace cap cslot has been successfully allocated, and that
-       the given pointer is valid. */
-    if (!ndspace->dataspaceCap || !ndspace->fileData) {
-        free(ndspace);
+    /* Check that the dataspace cap cslot has been successfully allocated. The file data pointer
+       is NULL for compressed boot archive files, whose archiveIndex the caller sets. */
+    if (!ndspace->dataspaceCap) {
+        cslab_free(&dt->dspaceCache, ndspace);
         return NULL;
     }
 
@@ -86,6 +93,7 @@ dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
 static void
 dspace_oat_delete(coat_t *oat, cvector_item_t *obj)
 {
+    struct fs_dataspace_table *dt = (struct fs_dataspace_table *) oat;
     struct fs_dataspace *dspace = (struct fs_dataspace *) obj;
     assert(dspace && dspace->magic == FS_DATASPACE_MAGIC);
     dprintf("Deleting dataspace ID %d\n", dspace->dID);
@@ -94,8 +102,13 @@ dspace_oat_delete(coat_t *oat, cvector_item_t *obj)
     seL4_CNode_Revoke(REFOS_CSPACE, dspace->dataspaceCap, REFOS_CDEPTH);
     csfree_delete(dspace->dataspaceCap);
 
+    /* Directory dataspaces own their listing. */
+    if (dspace->directory) {
+        free(dspace->fileData);
+    }
+
     /* Finally, free the entire structure. */
-    free(dspace);
+    cslab_free(&dt->dspaceCache, dspace);
 }
 
 /* ----------------------- CPIO Dataspace Table Functions --------------------------------------- */
@@ -109,6 +122,7 @@ dspace_table_init(struct fs_dataspace_table *dt)
     dt->allocTable.oat_delete = dspace_oat_delete;
 
     /* Initialise our data structures. */
+    cslab_init(&dt->dspaceCache, sizeof(struct fs_dataspace), 0, NULL, NULL);
     coat_init(&dt->allocTable, 1, FILESERVER_MAX_DATASPACES);
     chash_init(&dt->windowAssocTable, FILESERVER_WINDOW_ASSOC_HASHSIZE);
     chash_init(&dt->dspaceAssocTable, FILESERVER_DSPACE_ASSOC_HASHSIZE);
@@ -121,6 +135,7 @@ dspace_table_release(struct fs_dataspace_table *dt)
         dspace_window_unassociate(dt, i);
     }
     coat_release(&dt->allocTable);
+    cslab_release(&dt->dspaceCache);
     chash_release(&dt->windowAssocTable);
 }
 
@@ -185,6 +200,22 @@ dspace_delete(struct fs_dataspace_table *dt, int id)
 
 /* ----------------------------- CPIO Dataspace Functions --------------------------------------- */
 
+int
+dspace_read_content(struct fs_dataspace *dspace, uint32_t offset, char *dest, uint32_t count)
+{
+    assert(dspace && dspace->magic == FS_DATASPACE_MAGIC);
+    if (dspace->archiveIndex >= 0) {
+        return bootarchive_read(dspace->archiveIndex, offset, dest, count);
+    }
+    assert(dspace->fileData);
+    if (offset >= dspace->fileDataSize) {
+        return 0;
+    }
+    count = MIN(dspace->fileDataSize - offset, count);
+    memcpy(dest, dspace->fileData + offset, count);
+    return count;
+}
+
 /*! @brief Internal unassociation helper function. */
 static void
 dspace_externalID_unassociate(chash_t *ht, int objID)
@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <data_struct/cvector.h>
 #include <data_struct/coat.h>
+#include <data_struct/cslab.h>
 #include <data_struct/chash.h>
 #include <refos/refos.h>
 #include <refos-rpc/rpc.h>
@@ -32,7 +33,9 @@
 /*! @brief File server dataspace
 
     File server dataspace structure. Dataspace cap is a badged endpoint cap of the file server.
-    The structure has no ownership of the actual file data.
+    The structure has no ownership of the actual file data, except for directory dataspaces, which
+    own their packed directory listing (see refos/dirent.h). Files in a compressed boot archive
+    have no flat file data; their content is read with dspace_read_content() instead.
  */
 struct fs_dataspace {
     uint32_t magic;
@@ -42,9 +45,11 @@ struct fs_dataspace {
     seL4_CPtr dataspaceCap;
     seL4_Word permissions;
 
-    char *fileData; /* Not owned. */
+    char *fileData; /* Not owned, unless directory is set. NULL if archiveIndex is set. */
     size_t fileDataSize;
+    int32_t archiveIndex; /* Compressed boot archive file index, or -1. */
     bool fileCreated;
+    bool directory;
 };
 
 /*! @brief File server CPIO dataspace association
@@ -63,7 +68,8 @@ struct dataspace_association_info {
 };
 
 struct fs_dataspace_table {
-    coat_t allocTable;
+    coat_t allocTable; /* Inherited struct, must be first. */
+    cslab_t dspaceCache; /* struct fs_dataspace */
     chash_t windowAssocTable; /* struct dataspace_association_info */
     chash_t dspaceAssocTable; /* struct dataspace_association_info */
 };
@@ -117,6 +123,26 @@ void dspace_delete(struct fs_dataspace_table *dt, int id);
 
 /* ----------------------------- CPIO Dataspace Functions --------------------------------------- */
 
+/*! @brief Check whether the given dataspace has any file content, flat or compressed.
+    @param dspace The dataspace. (No ownership)
+    @return true if the dataspace has file content, false otherwise.
+*/
+static inline bool
+dspace_has_content(struct fs_dataspace *dspace)
+{
+    return dspace->fileData != NULL || dspace->archiveIndex >= 0;
+}
+
+/*! @brief Read the file content of a dataspace, decompressing it if it lives in a compressed boot
+           archive.
+    @param dspace The dataspace to read. (No ownership)
+    @param offset The offset into the dataspace to read from.
+    @param dest The destination buffer. (No ownership)
+    @param count The maximum number of bytes to read.
+    @return Number of bytes read, or negative refos_err_t.
+*/
+int dspace_read_content(struct fs_dataspace *dspace, uint32_t offset, char *dest, uint32_t count);
+
 /*! @brief Associate given window with the dataspace.
 
     When a client maps one of out CPIO dataspaces to its window, we notify the memory manager (ie.
@@ -6,17 +6,22 @@
 
 #include "dispatch.h"
 #include "serv_dispatch.h"
+#include "cpio_dspace.h"
 #include "../state.h"
 #include "../badge.h"
+#include "../bootarchive.h"
 #include <sys/types.h>
 #include <sys/stat.h> 
 #include <utils/arith.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <refos/error.h>
+#include <refos/dirent.h>
 #include <refos-rpc/data_server.h>
 #include <refos-rpc/data_client.h>
 #include <refos-util/serv_connect.h>
 #include <refos-util/serv_common.h>
+#include <refos-util/serv_aio.h>
 
 /*! @file
     @brief Handles CPIO file server dataspace calls.
@@ -29,14 +34,9 @@
 #define CPIO_RAMFS_MAX_CREATED_FILES 64
 #define CPIO_RAMFS_MAX_FILESSIZE 40960
 #define CPIO_RAMFS_MAX_FILENAME 32
-
-/*! @brief Forward declaration of the CPIO archive.
-
-    The CPIO archive is a simple format file archive stored inside a parent program's ELF section.
-    This is a similar idea to something like creating a
-    > const char data[] = { 0x3F, 0xFF, 0x23 ...etc}
-*/
-extern char _cpio_archive[];
+#define CPIO_DIRINDEX_INITIAL_SIZE 64
+#define CPIO_DIRLIST_INITIAL_SIZE 256
+#define CPIO_DIRINDEX_PREFIX_MAX (REFOS_DIRENT_NAME_MAX + 2)
 
 /*! @brief Rather hacky minimal ramfs created files.
     
@@ -49,31 +49,319 @@ static char _ramfs_filename[CPIO_RAMFS_MAX_CREATED_FILES][CPIO_RAMFS_MAX_FILENAM
 static int _ramfs_filesz[CPIO_RAMFS_MAX_CREATED_FILES];
 static int _ramfs_curfile = 0; /* Incrementally allocated files. */
 
-seL4_CPtr
-data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode , int rpc_size ,
-                  int* rpc_errno)
+/*! @brief Directory index.
+
+    Sorted array of every file path in the boot archive and the RAMFS, built once at start up and
+    kept up to date as RAMFS files are created. Directories are implicit; a path is a directory if
+    some file path has it as a '/' separated prefix. Listing a directory is then a binary search for
+    its prefix followed by a linear walk over its descendants, instead of one archive lookup per
+    guessed name.
+*/
+static const char **_dirindex = NULL; /* Names not owned. */
+static int _dirindex_count = 0;
+static int _dirindex_size = 0;
+
+/*! @brief Find the index of the first path in the directory index not less than the given path.
+    @param name The path to look for.
+    @return Index of the first path not less than the given path.
+*/
+static int
+cpio_dirindex_lower_bound(const char *name)
+{
+    int lo = 0, hi = _dirindex_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strcmp(_dirindex[mid], name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*! @brief Insert a path into the directory index, keeping it sorted.
+    @param name The path to insert. (No ownership, must outlive the index)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+cpio_dirindex_insert(const char *name)
+{
+    assert(name);
+    if (!name[0] || !strcmp(name, ".")) {
+        return ESUCCESS;
+    }
+    int i = cpio_dirindex_lower_bound(name);
+    if (i < _dirindex_count && !strcmp(_dirindex[i], name)) {
+        return ESUCCESS;
+    }
+    if (_dirindex_count >= _dirindex_size) {
+        int nsize = _dirindex_size ? _dirindex_size * 2 : CPIO_DIRINDEX_INITIAL_SIZE;
+        const char **nindex = realloc(_dirindex, nsize * sizeof(const char*));
+        if (!nindex) {
+            ROS_ERROR("cpio_dirindex_insert out of memory.");
+            return ENOMEM;
+        }
+        _dirindex = nindex;
+        _dirindex_size = nsize;
+    }
+    memmove(&_dirindex[i + 1], &_dirindex[i], (_dirindex_count - i) * sizeof(const char*));
+    _dirindex[i] = name;
+    _dirindex_count++;
+    return ESUCCESS;
+}
+
+/*! @brief Check whether the given directory prefix has any entries in the directory index.
+    @param prefix The directory prefix, either empty or ending in '/'.
+    @return true if some path lies under the given prefix, false otherwise.
+*/
+static bool
+cpio_dirindex_has_prefix(const char *prefix)
+{
+    int i = cpio_dirindex_lower_bound(prefix);
+    return i < _dirindex_count && !strncmp(_dirindex[i], prefix, strlen(prefix));
+}
+
+/*! @brief Find the directory index prefix of a directory name.
+    @param name The directory name. The empty name is the root directory.
+    @param prefix Output directory prefix; empty, or the name with a single trailing '/'. Must be
+                  at least CPIO_DIRINDEX_PREFIX_MAX bytes.
+    @return ESUCCESS if the directory exists, EFILENOTFOUND if it does not, refos_err_t otherwise.
+*/
+static int
+cpio_dirindex_dir_prefix(const char *name, char *prefix)
+{
+    size_t nlen = strlen(name);
+    while (nlen > 0 && name[nlen - 1] == '/') {
+        nlen--;
+    }
+    if (nlen > REFOS_DIRENT_NAME_MAX) {
+        return EINVALIDPARAM;
+    }
+    memcpy(prefix, name, nlen);
+    prefix[nlen] = '\0';
+    if (nlen == 0) {
+        return ESUCCESS;
+    }
+    strcat(prefix, "/");
+    return cpio_dirindex_has_prefix(prefix) ? ESUCCESS : EFILENOTFOUND;
+}
+
+/*! @brief Build the packed directory listing of the immediate children of a directory.
+
+    Subdirectories appear once each, however many files lie under them. The listing is built into
+    a newly allocated buffer in the refos/dirent.h record format.
+
+    @param prefix The directory prefix, either empty or ending in '/'.
+    @param listing Output newly allocated listing buffer. (Gives ownership)
+    @param listingSize Output listing size in bytes.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+cpio_dirindex_list(const char *prefix, char **listing, size_t *listingSize)
+{
+    size_t plen = strlen(prefix);
+    size_t size = CPIO_DIRLIST_INITIAL_SIZE, len = 0;
+    char *buf = malloc(size);
+    if (!buf) {
+        return ENOMEM;
+    }
+
+    for (int i = cpio_dirindex_lower_bound(prefix); i < _dirindex_count; i++) {
+        const char *name = _dirindex[i];
+        if (strncmp(name, prefix, plen)) {
+            break;
+        }
+        name += plen;
+        size_t nlen = strcspn(name, "/");
+        uint8_t type = name[nlen] == '/' ? DT_DIR : DT_REG;
+        if (nlen == 0 || nlen > REFOS_DIRENT_NAME_MAX) {
+            continue;
+        }
+
+        /* Subdirectories are shared by every path under them. Paths which sort in between two paths
+           of the same subdirectory (eg. "a", "a-b", "a/c") mean they are not always adjacent. */
+        bool dup = false;
+        for (size_t off = 0; off < len; off += (uint8_t) buf[off]) {
+            struct refos_dirent *d = (struct refos_dirent *) (buf + off);
+            if (REFOS_DIRENT_NAMELEN(d) == nlen && !memcmp(d->name, name, nlen)) {
+                if (type == DT_DIR) {
+                    d->type = DT_DIR;
+                }
+                dup = true;
+                break;
+            }
+        }
+        if (dup) {
+            continue;
+        }
+
+        size_t reclen = REFOS_DIRENT_HEADER_SIZE + nlen;
+        if (len + reclen > size) {
+            char *nbuf = realloc(buf, size * 2);
+            if (!nbuf) {
+                free(buf);
+                return ENOMEM;
+            }
+            buf = nbuf;
+            size *= 2;
+        }
+        struct refos_dirent *d = (struct refos_dirent *) (buf + len);
+        d->reclen = (uint8_t) reclen;
+        d->type = type;
+        memcpy(d->name, name, nlen);
+        len += reclen;
+    }
+
+    (*listing) = buf;
+    (*listingSize) = len;
+    return ESUCCESS;
+}
+
+void
+cpio_dspace_init(void)
+{
+    const char *name = NULL;
+    for (int i = 0; (name = bootarchive_entry_name(i)) != NULL; i++) {
+        int error = cpio_dirindex_insert(name);
+        if (error != ESUCCESS) {
+            ROS_WARNING("Directory index is incomplete.");
+            break;
+        }
+    }
+    dvprintf("Directory index has %d entries.\n", _dirindex_count);
+}
+
+/*! @brief Open a directory dataspace, holding the packed listing of the given directory.
+    @param c The client to open the dataspace for. (No ownership)
+    @param rpc_name The name of the directory to open. The empty name is the root directory.
+    @param rpc_errno Output errno variable.
+    @return The opened dataspace if success, NULL otherwise. (No ownership)
+*/
+static struct fs_dataspace*
+cpio_dspace_open_dir(struct srv_client *c, char* rpc_name, int* rpc_errno)
+{
+    char prefix[CPIO_DIRINDEX_PREFIX_MAX];
+    int error = cpio_dirindex_dir_prefix(rpc_name, prefix);
+    if (error != ESUCCESS) {
+        SET_ERRNO_PTR(rpc_errno, error);
+        return NULL;
+    }
+
+    char *listing = NULL;
+    size_t listingSize = 0;
+    error = cpio_dirindex_list(prefix, &listing, &listingSize);
+    if (error != ESUCCESS) {
+        SET_ERRNO_PTR(rpc_errno, error);
+        return NULL;
+    }
+
+    struct fs_dataspace* nds = dspace_alloc(&fileServ.dspaceTable, c->deathID, listing,
+                                            listingSize, O_RDONLY);
+    if (!nds) {
+        ROS_ERROR("cpio_dspace_open_dir failed to allocate dataspace.");
+        free(listing);
+        SET_ERRNO_PTR(rpc_errno, ENOMEM);
+        return NULL;
+    }
+    nds->directory = true;
+
+    dvprintf("Opened directory /%s OK ID %d...\n", prefix, nds->dID);
+    SET_ERRNO_PTR(rpc_errno, ESUCCESS);
+    return nds;
+}
+
+/*! @brief Read from a CPIO dataspace. Shared by data_read() and asynchronous I/O ring reads.
+    @return Number of bytes read.
+*/
+static int
+cpio_dspace_read(struct fs_dataspace* dspace, uint32_t offset, char *buf, uint32_t count)
+{
+    assert(dspace && dspace->magic == FS_DATASPACE_MAGIC);
+    int n = dspace_read_content(dspace, offset, buf, count);
+    return MAX(n, 0);
+}
+
+/*! @brief Write to a created RAMFS dataspace. Shared by data_write() and asynchronous I/O ring
+           writes.
+    @return Number of bytes written, or negative refos_err_t.
+*/
+static int
+cpio_dspace_write(struct fs_dataspace* dspace, uint32_t offset, char *buf, uint32_t count)
+{
+    assert(dspace && dspace->magic == FS_DATASPACE_MAGIC);
+
+    if (!dspace->fileCreated) {
+        /* Tried to write to a read only CPIO file. */
+        ROS_WARNING("cpio_dspace_write: Tried to write to a read only CPIO file %d.", dspace->dID);
+        return -EACCESSDENIED;
+    }
+    assert(dspace->fileData);
+
+    if (offset + count > dspace->fileDataSize) {
+        if (offset + count > CPIO_RAMFS_MAX_FILESSIZE) {
+            assert(!"File maxsize overflow.");
+            return -ENOMEM;
+        }
+        dspace->fileDataSize = offset + count;
+    }
+    for (int i = 0; i < _ramfs_curfile; i++) {
+        if (_ramfs_archive[i] == dspace->fileData) {
+            _ramfs_filesz[i] = dspace->fileDataSize;
+            break;
+        }
+    }
+    memcpy(dspace->fileData + offset, buf, count);
+    return count;
+}
+
+/*! @brief Open a CPIO or RAMFS file dataspace for the given client. Helper function for
+           data_open_handler() and data_open_stat_handler().
+    @param c The client to open the dataspace for. (No ownership)
+    @param rpc_name The name of the file to open.
+    @param rpc_flags The read / write / create flags.
+    @param rpc_errno Output errno variable.
+    @return The opened dataspace if success, NULL otherwise. (No ownership)
+*/
+static struct fs_dataspace*
+cpio_dspace_open(struct srv_client *c, char* rpc_name, int rpc_flags, int* rpc_errno)
 {
-    struct srv_client *c = (struct srv_client *) rpc_userptr;
     assert(c->magic == FS_CLIENT_MAGIC);
 
     if (!rpc_name) {
         SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
-        return 0;
+        return NULL;
     }
 
-    /* Find file data in CPIO. */
+    /* Find file data in the boot archive. Compressed files have no flat file data. */
     dprintf("Opening %s...\n", rpc_name);
-    unsigned long fileDataSize = 0;
-    char *fileData = cpio_get_file(_cpio_archive, rpc_name, &fileDataSize);
+    struct bootarchive_entry entry;
+    bool archived = bootarchive_find(rpc_name, &entry);
+    char *fileData = archived ? entry.data : NULL;
+    unsigned long fileDataSize = archived ? entry.size : 0;
+    int32_t archiveIndex = archived ? entry.index : -1;
     bool fileCreated = false;
 
-    if (fileData && (rpc_flags & O_ACCMODE) != O_RDONLY) {
+    if (rpc_flags & O_DIRECTORY) {
+        if (archived) {
+            /* Not a directory. */
+            SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+            return NULL;
+        }
+        if ((rpc_flags & O_ACCMODE) != O_RDONLY) {
+            SET_ERRNO_PTR(rpc_errno, EACCESSDENIED);
+            return NULL;
+        }
+        return cpio_dspace_open_dir(c, rpc_name, rpc_errno);
+    }
+
+    if (archived && (rpc_flags & O_ACCMODE) != O_RDONLY) {
         /* CPIO dataspaces require read only. */
         SET_ERRNO_PTR(rpc_errno, EACCESSDENIED);
-        return 0;
+        return NULL;
     }
 
-    if (!fileData) {
+    if (!archived) {
         for (int i = 0; i < _ramfs_curfile; i++) {
             if (!strcmp(rpc_name, _ramfs_filename[i])) {
                 if ((rpc_flags & O_CREAT)) {
@@ -89,40 +377,119 @@ data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_m
         }
     }
 
-    if (!fileData) {
+    if (!archived && !fileData) {
         if ((rpc_flags & O_CREAT) == 0) {
             dprintf("File %s not found!\n", rpc_name);
             SET_ERRNO_PTR(rpc_errno, EFILENOTFOUND);
-            return 0;
+            return NULL;
         }
         /* Assign new blank RAMFS file. */
         if (_ramfs_curfile >= CPIO_RAMFS_MAX_CREATED_FILES) {
             SET_ERRNO_PTR(rpc_errno, EACCESSDENIED);
-            return 0;
+            return NULL;
         }
         dvprintf("Creating new file %s...\n", rpc_name);
-        strncpy(_ramfs_filename[_ramfs_curfile], rpc_name, CPIO_RAMFS_MAX_FILENAME);
+        strncpy(_ramfs_filename[_ramfs_curfile], rpc_name, CPIO_RAMFS_MAX_FILENAME - 1);
+        cpio_dirindex_insert(_ramfs_filename[_ramfs_curfile]);
         fileData = _ramfs_archive[_ramfs_curfile++];
         fileDataSize = 0;
         fileCreated = true;
     }
 
-    /* Allocate new dataspace structure. */
+    /* Allocate new dataspace structure. Archived files are always read-only. RAMFS files, new or
+       re-opened, get the mode they were opened with, which data_open_stat() reports back. */
     struct fs_dataspace* nds = dspace_alloc(&fileServ.dspaceTable, c->deathID, fileData,
-        (size_t) fileDataSize, O_RDONLY);
+        (size_t) fileDataSize, fileCreated ? (rpc_flags & O_ACCMODE) : O_RDONLY);
     if (!nds) {
-        ROS_ERROR("data_open_handler failed to allocate dataspace.");
+        ROS_ERROR("cpio_dspace_open failed to allocate dataspace.");
         SET_ERRNO_PTR(rpc_errno, ENOMEM);
-        return 0;
+        return NULL;
     }
     nds->fileCreated = fileCreated;
+    nds->archiveIndex = archiveIndex;
 
     dvprintf("%s file %s OK ID %d...\n", fileCreated ? "Created" : "Opened", rpc_name, nds->dID);
     SET_ERRNO_PTR(rpc_errno, ESUCCESS);
     assert(nds->dataspaceCap);
+    return nds;
+}
+
+seL4_CPtr
+data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode , int rpc_size ,
+                  int* rpc_errno)
+{
+    struct fs_dataspace* nds = cpio_dspace_open((struct srv_client *) rpc_userptr, rpc_name,
+                                                rpc_flags, rpc_errno);
+    return nds ? nds->dataspaceCap : 0;
+}
+
+seL4_CPtr
+data_open_stat_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode ,
+                       int rpc_size , uint32_t* rpc_dspaceSize , int* rpc_dspaceMode ,
+                       uint32_t* rpc_dspaceFlags , int* rpc_errno)
+{
+    struct fs_dataspace* nds = cpio_dspace_open((struct srv_client *) rpc_userptr, rpc_name,
+                                                rpc_flags, rpc_errno);
+    if (!nds) {
+        return 0;
+    }
+    if (rpc_dspaceSize) {
+        (*rpc_dspaceSize) = (uint32_t) nds->fileDataSize;
+    }
+    if (rpc_dspaceMode) {
+        (*rpc_dspaceMode) = (int) nds->permissions | (nds->directory ? O_DIRECTORY : 0);
+    }
+    if (rpc_dspaceFlags) {
+        /* Boot archive files never change. RAMFS files and directory listings may, through other
+           clients. */
+        (*rpc_dspaceFlags) = (!nds->fileCreated && !nds->directory) ? DATA_STAT_IMMUTABLE : 0;
+    }
     return nds->dataspaceCap;
 }
 
+refos_err_t
+data_stat_handler(void *rpc_userptr , char* rpc_name , uint32_t* rpc_size , uint32_t* rpc_mode ,
+                  uint32_t* rpc_mtime , uint32_t* rpc_flags)
+{
+    assert(((struct srv_client *) rpc_userptr)->magic == FS_CLIENT_MAGIC);
+    if (!rpc_name || !rpc_size || !rpc_mode || !rpc_mtime || !rpc_flags) {
+        return EINVALIDPARAM;
+    }
+
+    /* The file server keeps no time. */
+    (*rpc_mtime) = 0;
+
+    /* Boot archive files are read only and can never be re-created, so their metadata never
+       changes. */
+    struct bootarchive_entry entry;
+    if (bootarchive_find(rpc_name, &entry)) {
+        (*rpc_size) = entry.size;
+        (*rpc_mode) = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+        (*rpc_flags) = DATA_STAT_IMMUTABLE;
+        return ESUCCESS;
+    }
+
+    for (int i = 0; i < _ramfs_curfile; i++) {
+        if (!strcmp(rpc_name, _ramfs_filename[i])) {
+            (*rpc_size) = (uint32_t) _ramfs_filesz[i];
+            (*rpc_mode) = S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+            (*rpc_flags) = 0;
+            return ESUCCESS;
+        }
+    }
+
+    /* Directories gain entries as RAMFS files are created. */
+    char prefix[CPIO_DIRINDEX_PREFIX_MAX];
+    int error = cpio_dirindex_dir_prefix(rpc_name, prefix);
+    if (error != ESUCCESS) {
+        return error;
+    }
+    (*rpc_size) = 0;
+    (*rpc_mode) = S_IFDIR | S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+    (*rpc_flags) = 0;
+    return ESUCCESS;
+}
+
 refos_err_t
 data_close_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
 {
@@ -144,6 +511,9 @@ data_close_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
 
     dprintf("Closing dataspace ID %d...\n", rpc_dspace_fd- FS_DSPACE_BADGE_BASE);
 
+    /* Drop any asynchronous I/O ring bindings to this dataspace. */
+    srv_aio_unbind_object(&fileServCommon->clientTable, rpc_dspace_fd - FS_DSPACE_BADGE_BASE);
+
     dspace_delete(&fileServ.dspaceTable, rpc_dspace_fd - FS_DSPACE_BADGE_BASE);
     return ESUCCESS;
 }
@@ -168,15 +538,7 @@ data_read_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , uint32_t rpc_off
         ROS_WARNING("data_read_handler: no such dataspace.");
         return 0;
     }
-    assert(dspace->magic == FS_DATASPACE_MAGIC);
-    assert(dspace->fileData);
-
-    if (rpc_offset >= dspace->fileDataSize) {
-        return 0;
-    }
-    uint32_t count = MIN(dspace->fileDataSize - rpc_offset, rpc_buf.count);
-    memcpy(rpc_buf.data, dspace->fileData + rpc_offset, count);
-    return count;
+    return cpio_dspace_read(dspace, rpc_offset, rpc_buf.data, rpc_buf.count);
 }
 
 int
@@ -199,30 +561,7 @@ data_write_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , uint32_t rpc_of
         ROS_WARNING("data_write_handler: no such dataspace.");
         return 0;
     }
-    assert(dspace->magic == FS_DATASPACE_MAGIC);
-    assert(dspace->fileData);
-
-    if (!dspace->fileCreated) {
-        /* Tried to write to a read only CPIO file. */
-        ROS_WARNING("data_write_handler: Tried to write to a read only CPIO file %d.", dspace->dID);
-        return -EACCESSDENIED;
-    }
-
-    if (rpc_offset + rpc_buf.count > dspace->fileDataSize) {
-        if (rpc_offset + rpc_buf.count > CPIO_RAMFS_MAX_FILESSIZE) {
-            assert(!"File maxsize overflow.");
-            return -ENOMEM;
-        }
-        dspace->fileDataSize = rpc_offset + rpc_buf.count;
-    }
-    for (int i = 0; i < _ramfs_curfile; i++) {
-        if (_ramfs_archive[i] == dspace->fileData) {
-            _ramfs_filesz[i] = dspace->fileDataSize;
-            break;
-        }
-    }
-    memcpy(dspace->fileData + rpc_offset, rpc_buf.data, rpc_buf.count);
-    return rpc_buf.count;
+    return cpio_dspace_write(dspace, rpc_offset, rpc_buf.data, rpc_buf.count);
 }
 
 int
@@ -432,6 +771,64 @@ data_provide_data_from_parambuffer_handler(void *rpc_userptr , seL4_CPtr rpc_dsp
     return EUNIMPLEMENTED;
 }
 
+int
+data_aio_bind_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    assert(c->magic == FS_CLIENT_MAGIC);
+
+    /* Sanity check the dataspace cap. */
+    if (!srv_check_dispatch_caps(m, 0x00000001, 1)) {
+        dprintf("data_aio_bind_handler EINVALIDPARAM: bad caps.\n");
+        return -EINVALIDPARAM;
+    }
+
+    struct fs_dataspace* dspace = dspace_get_badge(&fileServ.dspaceTable, rpc_dspace_fd);
+    if (!dspace) {
+        ROS_WARNING("data_aio_bind_handler: no such dataspace.");
+        return -EINVALIDPARAM;
+    }
+    assert(dspace->magic == FS_DATASPACE_MAGIC);
+    return srv_aio_bind(c, dspace->dID);
+}
+
+int
+data_aio_enter_handler(void *rpc_userptr)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    assert(c->magic == FS_CLIENT_MAGIC);
+    return srv_aio_process(c, fileserv_aio_op);
+}
+
+int32_t
+fileserv_aio_op(struct srv_client *c, uint32_t object, struct refos_aio_sqe *sqe, char *buf)
+{
+    assert(c && c->magic == FS_CLIENT_MAGIC && sqe);
+    struct fs_dataspace* dspace = dspace_get(&fileServ.dspaceTable, object);
+    if (!dspace) {
+        return -EINVALIDPARAM;
+    }
+    assert(dspace->magic == FS_DATASPACE_MAGIC);
+
+    switch (sqe->opcode) {
+    case REFOS_AIO_OP_READ:
+        return cpio_dspace_read(dspace, sqe->offset, buf, sqe->len);
+    case REFOS_AIO_OP_WRITE:
+        return cpio_dspace_write(dspace, sqe->offset, buf, sqe->len);
+    case REFOS_AIO_OP_LSEEK: {
+        int32_t pos = sqe->offset;
+        if (sqe->whence == SEEK_END) {
+            pos += (int32_t) dspace->fileDataSize;
+        }
+        return MIN(MAX(pos, 0), (int32_t) dspace->fileDataSize);
+    }
+    default:
+        break;
+    }
+    return -EUNIMPLEMENTED;
+}
+
 int
 check_dispatch_data(srv_msg_t *m, void **userptr)
 {
@@ -10,12 +10,17 @@
 #include "../state.h"
 #include "dispatch.h"
 #include <refos-util/serv_connect.h>
+#include <refos/aio_ring.h>
 
  /*! @file
     @brief Handles CPIO file server dataspace calls. */
 
 int rpc_sv_data_dispatcher(void *rpc_userptr, uint32_t label);
 
+/*! @brief Build the directory index of the CPIO archive. Must be called once before the first
+           dataspace is opened. */
+void cpio_dspace_init(void);
+
 /*! @brief Check whether the given recieved message is a data syscall.
     @param m Struct containing info about the recieved message.
     @param userptr Output user pointer. Pass this into the generated dispatcher function.
@@ -23,4 +28,15 @@ int rpc_sv_data_dispatcher(void *rpc_userptr, uint32_t label);
 */
 int check_dispatch_data(srv_msg_t *m, void **userptr);
 
+/*! @brief Carry out a single asynchronous I/O ring submission on a CPIO dataspace. Passed to the
+           serv_aio.h ring processing helpers, see srv_aio_op_fn_t.
+    @param c The client owning the ring.
+    @param object The dataspace ID bound to the submission's handle.
+    @param sqe The submission entry, with its offset resolved.
+    @param buf The submission's buffer in the ring data area.
+    @return Bytes read / written, the new lseek offset, or negative refos_err_t.
+*/
+int32_t fileserv_aio_op(struct srv_client *c, uint32_t object, struct refos_aio_sqe *sqe,
+                        char *buf);
+
 #endif /* _FILESERV_CPIO_DATASPACE_SYSCALL_DISPATCHER_H_ */
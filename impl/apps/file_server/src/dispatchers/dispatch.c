@@ -6,17 +6,25 @@
 
 #include "dispatch.h"
 #include <refos-util/serv_connect.h>
+#include <refos-util/serv_runtime.h>
 
  /*! @file
      @brief Common file server dispatcher helper functions. */
 
-/*! @brief Special anonymous client structure.
+/*! @brief Special anonymous client structure of the calling worker thread.
 
     We use this to temporarily book-keep an anonymous client who has not fully connected yet. This
     solves the chicken-and-egg problem of needing a rpc_client_t to communicate so the client can
-    communicate to set up real communication session.
+    communicate to set up real communication session. Each worker thread has its own, as workers
+    may be recieving from different anonymous clients at once.
 */
-static struct srv_client _anonClient;
+static struct srv_client *
+dispatch_anon_client(void)
+{
+    struct srv_worker *w = srv_worker_current();
+    assert(w && w->magic == SRV_WORKER_MAGIC);
+    return &w->anonClient;
+}
 
 int
 check_dispatch_interface(srv_msg_t *m, void **userptr, int labelMin, int labelMax)
@@ -33,7 +41,7 @@ check_dispatch_interface(srv_msg_t *m, void **userptr, int labelMin, int labelMa
         c = client_get_badge(&fileServCommon->clientTable, m->badge);
     } else {
         /* Anonymous client, unbadged. */
-        c = &_anonClient;
+        c = dispatch_anon_client();
         memset(c, 0, sizeof(struct srv_client));
         c->magic = FS_DISPATCH_ANON_CLIENT_MAGIC;
     }
@@ -11,9 +11,11 @@
 #include <refos-rpc/data_client.h>
 #include <refos-rpc/data_client_helper.h>
 #include <refos-util/serv_connect.h>
+#include <refos-util/serv_aio.h>
 #include <utils/arith.h>
 
 #include "dispatch.h"
+#include "cpio_dspace.h"
 #include "../state.h"
 #include "../badge.h"
 
@@ -26,69 +28,27 @@
     an anonymous memory dataspace (ie. the notification buffer).
 */
 
-/*! @brief Handles client page fault notifications.
-    
-    This function handles client page fault notifications from the process server. When we act as
-    the pager, the process server delegates all page faults to us via this notification.
-    We then choose a page to map, and map it.
+/*! @brief Content init page buffer, for file content which is not stored flat. */
+static char _contentInitBuffer[REFOS_PAGE_SIZE];
 
-    @param notification Structure containing the notification message, read from the notification
-                        ring buffer.
+/*! @brief Fills a pager frame with the content of a faulting page.
+    @param dspace The dataspace associated with the faulting window.
+    @param dwa The faulting window's association info.
+    @param winBase The base address of the faulting window in the client's VSpace.
+    @param winSize The size of the faulting window.
+    @param faultAddr The address in the client's VSpace of the page to fill the frame for.
+    @param pframe The pager frame to fill.
     @return DISPATCH_SUCCESS if success, DISPATCHER_ERROR otherwise.
 */
 static int
-handle_fileserver_fault(struct proc_notification *notification)
+fileserv_fill_fault_frame(struct fs_dataspace *dspace, struct dataspace_association_info *dwa,
+                          seL4_Word winBase, seL4_Word winSize, seL4_Word faultAddr,
+                          vaddr_t pframe)
 {
-    int error;
-
-    dvprintf(COLOUR_M "## Fileserv Handling Notification VM fault delegation...\n" COLOUR_RESET);
-    dvprintf("     Label: PROCSERV_NOTIFY_FAULT_DELEGATION\n");
-    dvprintf("     winID: %d\n", notification->arg[0]);
-    dvprintf("     win size: %d\n", notification->arg[1]);
-    dvprintf("     fault address: 0x%x\n", notification->arg[2]);
-    dvprintf("     window base: 0x%x\n", notification->arg[3]);
-    dvprintf("     instruction: 0x%x\n", notification->arg[4]);
-    dvprintf("     permission: 0x%x\n", notification->arg[5]);
-    dvprintf("     pc: 0x%x\n", notification->arg[6]);
-
-    seL4_Word winID = notification->arg[0];
-    seL4_Word winSize = notification->arg[1];
-    seL4_Word faultAddr = notification->arg[2];
-    seL4_Word winBase = notification->arg[3];
-
-    /* Look up the faulting window. */
-    struct dataspace_association_info *dwa = dspace_window_find(&fileServ.dspaceTable, winID);
-    if (!dwa) {
-        ROS_ERROR("File Server does not know about this faulting window.");
-        ROS_ERROR("  This paging delegation request will be ignored. This is most likely a bug.");
-        ROS_ERROR("  Faulting client will be permanently blocked.");
-        assert(!"handle_fileserver_fault bug.");
-        return DISPATCH_SUCCESS;
-    }
-
-    /* Look up the dataspace associated with the faulting window. */
-    struct fs_dataspace* dspace = dspace_get(&fileServ.dspaceTable, dwa->dataspaceID);
-    if (!dspace) {
-        ROS_ERROR("File Server could not find the dataspace associated with the faulting window.");
-        ROS_ERROR("  This paging delegation request will be ignored. This is most likely a bug.");
-        ROS_ERROR("  Faulting client will be permanently blocked.");
-        assert(!"handle_fileserver_fault bug.");
-        return DISPATCH_ERROR;
-    }
-    size_t faultAddrWinOffset = faultAddr - winBase;
-
-    /* Allocate a frame to page client with. */
-    vaddr_t pframe = pager_alloc_frame(&fileServ.pageFrameBlock);
-    if (!pframe) {
-        ROS_ERROR("File Server Out of memory handling VM fault. Paging not implemented.");
-        ROS_ERROR("  Try increasing FILESERVER_MAX_PAGE_FRAMES.");
-        ROS_ERROR("  Faulting client will be permanently blocked.");
-        return DISPATCH_ERROR;
-    }
     memset((void*) pframe, 0, REFOS_PAGE_SIZE);
 
     /* Copy any CPIO file content if there is data. */
-    if (dspace->fileData) {
+    if (dspace_has_content(dspace)) {
         /* Round faulting address down to page. */
         seL4_Word alignedFaultAddr = REFOS_PAGE_ALIGN(faultAddr);
 
@@ -152,30 +112,142 @@ handle_fileserver_fault(struct proc_notification *notification)
             (dspace->fileDataSize - dwa->dataspaceOffset > dspace->fileDataSize)) {
             ROS_ERROR("nbytes overflowed.\n");
             assert(!"nbytes overflowed. Fileserver bug.");
-            pager_free_frame(&fileServ.pageFrameBlock, pframe);
             return DISPATCH_ERROR;
         }
 
-        memcpy (
-                (void*) (pframe + initFrameSkip),
-                dspace->fileData + dwa->dataspaceOffset + dataspaceSkipWinOffset,
-                nbytes
-        );
+        /* Compressed file pages decompress straight into the frame here. */
+        int n = dspace_read_content(dspace, dwa->dataspaceOffset + dataspaceSkipWinOffset,
+                                    (char*) (pframe + initFrameSkip), nbytes);
+        if (n < 0) {
+            ROS_ERROR("Could not read file content for faulting page.");
+            return DISPATCH_ERROR;
+        }
     }
 
-    /* Now map the frame into the client's vspace window. */
-    dvprintf("    Mapping frame at  0x%x ―――▶ client 0x%x\n", (uint32_t) pframe,
+    return DISPATCH_SUCCESS;
+}
+
+/*! @brief Handles client page fault notifications.
+
+    This function handles client page fault notifications from the process server. When we act as
+    the pager, the process server delegates all page faults to us via this notification.
+    We then choose a page to map, and map it. The pages of CPIO file content following the
+    faulting page are prefaulted along with it, so that sequentially accessing a mapped file does
+    not take a fault delegation round trip for every page. Prefaulting stops at the end of the
+    window and of the file content, and is skipped altogether once the frame pool runs low, as the
+    frames are shared by every client and are not paged out.
+
+    @param notification Structure containing the notification message, read from the notification
+                        ring buffer.
+    @return DISPATCH_SUCCESS if success, DISPATCHER_ERROR otherwise.
+*/
+static int
+handle_fileserver_fault(struct proc_notification *notification)
+{
+    int error;
+
+    dvprintf(COLOUR_M "## Fileserv Handling Notification VM fault delegation...\n" COLOUR_RESET);
+    dvprintf("     Label: PROCSERV_NOTIFY_FAULT_DELEGATION\n");
+    dvprintf("     winID: %d\n", notification->arg[0]);
+    dvprintf("     win size: %d\n", notification->arg[1]);
+    dvprintf("     fault address: 0x%x\n", notification->arg[2]);
+    dvprintf("     window base: 0x%x\n", notification->arg[3]);
+    dvprintf("     instruction: 0x%x\n", notification->arg[4]);
+    dvprintf("     permission: 0x%x\n", notification->arg[5]);
+    dvprintf("     pc: 0x%x\n", notification->arg[6]);
+
+    seL4_Word winID = notification->arg[0];
+    seL4_Word winSize = notification->arg[1];
+    seL4_Word faultAddr = notification->arg[2];
+    seL4_Word winBase = notification->arg[3];
+
+    /* Look up the faulting window. */
+    struct dataspace_association_info *dwa = dspace_window_find(&fileServ.dspaceTable, winID);
+    if (!dwa) {
+        ROS_ERROR("File Server does not know about this faulting window.");
+        ROS_ERROR("  This paging delegation request will be ignored. This is most likely a bug.");
+        ROS_ERROR("  Faulting client will be permanently blocked.");
+        assert(!"handle_fileserver_fault bug.");
+        return DISPATCH_SUCCESS;
+    }
+
+    /* Look up the dataspace associated with the faulting window. */
+    struct fs_dataspace* dspace = dspace_get(&fileServ.dspaceTable, dwa->dataspaceID);
+    if (!dspace) {
+        ROS_ERROR("File Server could not find the dataspace associated with the faulting window.");
+        ROS_ERROR("  This paging delegation request will be ignored. This is most likely a bug.");
+        ROS_ERROR("  Faulting client will be permanently blocked.");
+        assert(!"handle_fileserver_fault bug.");
+        return DISPATCH_ERROR;
+    }
+    size_t faultAddrWinOffset = faultAddr - winBase;
+
+    /* Prefault up to the end of the window, and the end of the CPIO file content, unless the frame
+       pool is running low. */
+    seL4_Word alignedFaultAddr = REFOS_PAGE_ALIGN(faultAddr);
+    uint32_t nPages = 1;
+    if (dspace_has_content(dspace) && dspace->fileDataSize > dwa->dataspaceOffset &&
+            pager_num_free(&fileServ.pageFrameBlock) >= FILESERVER_PREFAULT_MIN_FREE_FRAMES) {
+        seL4_Word end = MIN(winBase + winSize,
+                winBase + (dspace->fileDataSize - dwa->dataspaceOffset));
+        if (end > alignedFaultAddr) {
+            nPages = ((end - alignedFaultAddr) + REFOS_PAGE_SIZE - 1) / REFOS_PAGE_SIZE;
+            /* Never prefault the pool below the low mark. */
+            uint32_t spare = pager_num_free(&fileServ.pageFrameBlock) -
+                             FILESERVER_PREFAULT_MIN_FREE_FRAMES + 1;
+            nPages = MAX(MIN(MIN(nPages, FILESERVER_PREFAULT_PAGES), spare), 1);
+        }
+    }
+
+    /* Allocate the frames to page client with. */
+    uint32_t nFrames = 0;
+    vaddr_t pframe = pager_alloc_frames(&fileServ.pageFrameBlock, nPages, &nFrames);
+    if (!pframe) {
+        ROS_ERROR("File Server Out of memory handling VM fault. Paging not implemented.");
+        ROS_ERROR("  Try increasing FILESERVER_MAX_PAGE_FRAMES.");
+        ROS_ERROR("  Faulting client will be permanently blocked.");
+        return DISPATCH_ERROR;
+    }
+
+    /* Copy any CPIO file content into the frames. */
+    for (uint32_t i = 0; i < nFrames; i++) {
+        seL4_Word pageAddr = i ? (alignedFaultAddr + i * REFOS_PAGE_SIZE) : faultAddr;
+        error = fileserv_fill_fault_frame(dspace, dwa, winBase, winSize, pageAddr,
+                                          pframe + i * REFOS_PAGE_SIZE);
+        if (error != DISPATCH_SUCCESS) {
+            /* Only map the frames before the one that failed. */
+            for (uint32_t j = i; j < nFrames; j++) {
+                pager_free_frame(&fileServ.pageFrameBlock, pframe + j * REFOS_PAGE_SIZE);
+            }
+            if (i == 0) {
+                return DISPATCH_ERROR;
+            }
+            nFrames = i;
+            break;
+        }
+    }
+
+    /* Now map the frames into the client's vspace window. */
+    dvprintf("    Mapping %u frames at  0x%x ―――▶ client 0x%x\n", nFrames, (uint32_t) pframe,
             (uint32_t) faultAddr);
-    error = proc_window_map(dwa->objectCap, faultAddrWinOffset, (seL4_Word) pframe);
-    if (error) {
+    int nMapped = proc_window_map_range(dwa->objectCap, faultAddrWinOffset, (seL4_Word) pframe,
+                                        nFrames);
+    if (nMapped < 0) {
         ROS_ERROR("File Server Unexpected error while mapping frame!");
         ROS_ERROR("  Most likely a file server bug.");
-        assert(!"proc_window_map error. Fileserver bug.");
-        pager_free_frame(&fileServ.pageFrameBlock, pframe);
+        assert(!"proc_window_map_range error. Fileserver bug.");
+        for (uint32_t i = 0; i < nFrames; i++) {
+            pager_free_frame(&fileServ.pageFrameBlock, pframe + i * REFOS_PAGE_SIZE);
+        }
         return DISPATCH_ERROR;
     }
 
-    dvprintf("    Successfully mapped frame...\n");
+    /* Take back the frames of any pages the client already had mapped. */
+    for (uint32_t i = nMapped; i < nFrames; i++) {
+        pager_free_frame(&fileServ.pageFrameBlock, pframe + i * REFOS_PAGE_SIZE);
+    }
+
+    dvprintf("    Successfully mapped %d frames...\n", nMapped);
     return DISPATCH_SUCCESS;
 }
 
@@ -230,10 +302,19 @@ handle_fileserver_content_init(struct proc_notification *notification)
 
     /* Provide the data back to the process server who notified us. */
     assert(dataspaceOffset < dspace->fileDataSize);
-    if (dspace->fileData) {
+    if (dspace_has_content(dspace)) {
+        char *content = dspace->fileData + dataspaceOffset;
+        if (!dspace->fileData) {
+            /* Compressed file; decompress the page first. */
+            content = _contentInitBuffer;
+            if (dspace_read_content(dspace, dataspaceOffset, content, contentSize) < 0) {
+                ROS_ERROR("File Server could not read content init file data.");
+                return DISPATCH_ERROR;
+            }
+        }
         int error = data_provide_data(
                 REFOS_PROCSERV_EP, dda->objectCap,
-                destDataspaceOffset, (char*)dspace->fileData + dataspaceOffset,
+                destDataspaceOffset, content,
                 contentSize, &fileServCommon->procServParamBuffer
         );
         if (error != ESUCCESS) {
@@ -269,10 +350,22 @@ handle_fileserver_death_notification(struct proc_notification *notification)
 int
 dispatch_notification(srv_msg_t *m)
 {
-    if (m->badge != FS_ASYNC_NOTIFY_BADGE) {
+    seL4_Word notifyBadge = m->badge & ~FS_ASYNC_AIO_BADGE;
+    if (notifyBadge != FS_ASYNC_NOTIFY_BADGE && m->badge != FS_ASYNC_AIO_BADGE) {
         return DISPATCH_PASS;
     }
 
+    /* Asynchronous I/O ring doorbell. */
+    if (m->badge & FS_ASYNC_AIO_BADGE) {
+        if (srv_aio_process_all(&fileServCommon->clientTable, fileserv_aio_op) > 0) {
+            /* Processing is bounded; come back for the rest after serving pending requests. */
+            seL4_Signal(fileServCommon->notifyAioAsyncEP);
+        }
+        if (!notifyBadge) {
+            return DISPATCH_SUCCESS;
+        }
+    }
+
     srv_common_notify_handler_callbacks_t cb = {
         .handle_server_fault = handle_fileserver_fault,
         .handle_server_content_init = handle_fileserver_content_init,
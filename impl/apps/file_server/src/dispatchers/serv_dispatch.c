@@ -46,6 +46,28 @@ serv_set_param_buffer_handler(void *rpc_userptr , seL4_CPtr rpc_parambuffer_data
         rpc_parambuffer_dataspace, rpc_parambuffer_size);
 }
 
+seL4_CPtr
+serv_set_aio_ring_handler(void *rpc_userptr , seL4_CPtr rpc_ring_dataspace ,
+                          uint32_t rpc_ring_size , int* rpc_errno)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    assert(c->magic == FS_CLIENT_MAGIC);
+    return fileServCommon->ctable_set_aio_ring_handler(fileServCommon, c, m, rpc_ring_dataspace,
+            rpc_ring_size, rpc_errno);
+}
+
+seL4_CPtr
+serv_get_log_ring_handler(void *rpc_userptr , seL4_CPtr rpc_doorbell , uint32_t* rpc_ring_size ,
+                          int* rpc_errno)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    assert(c->magic == FS_CLIENT_MAGIC);
+    return fileServCommon->ctable_get_log_ring_handler(fileServCommon, c, m, rpc_doorbell,
+            rpc_ring_size, rpc_errno);
+}
+
 void
 serv_disconnect_direct_handler(void *rpc_userptr)
 {
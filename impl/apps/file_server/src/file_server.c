@@ -45,7 +45,9 @@
 #include <refos-io/stdio.h>
 #include <refos-util/init.h>
 #include <refos-util/serv_connect.h>
+#include <refos-util/serv_runtime.h>
 
+#include "badge.h"
 #include "state.h"
 #include "dispatchers/dispatch.h"
 #include "dispatchers/serv_dispatch.h"
@@ -64,13 +66,12 @@ uint32_t faketime() {
     return _faketime++;
 }
 
-/*! @brief Handle messages received by the CPIO file server.
-    @param s The global file server state. (No ownership transfer)
+/*! @brief Handle messages received by the CPIO file server. Called by the server runtime workers.
     @param msg The received message. (No ownership transfer)
     @return DISPATCH_SUCCESS if message dispatched, DISPATCH_ERROR if unknown message.
 */
 static int
-fileserv_handle_message(struct fs_state *s, srv_msg_t *msg)
+fileserv_handle_message(srv_msg_t *msg)
 {
     int result;
     int label = seL4_GetMR(0);
@@ -101,20 +102,25 @@ fileserv_handle_message(struct fs_state *s, srv_msg_t *msg)
     return DISPATCH_ERROR;
 }
 
-/*! @brief Main CPIO file server message loop. Simply loops through recieving and dispatching
-           messages repeatedly. */
+/*! @brief Main CPIO file server message loop. Hands the message loop over to the server runtime's
+           worker threads. The dataspace table and pager frame block are not thread safe, so the
+           handlers are serialised; the workers still overlap their IPC with each other. */
 static void
 fileserv_mainloop(void)
 {
-    struct fs_state *s = &fileServ;
-    srv_msg_t msg;
-
-    while (1) {
-        dvprintf("Fileserver blocking for message...\n");
-        msg.message = seL4_Recv(fileServCommon->anonEP, &msg.badge);
-        fileserv_handle_message(s, &msg);
-        client_table_postaction(&fileServCommon->clientTable);
+    srv_runtime_config_t cfg = {
+        .numWorkers = FILESERVER_NUM_WORKERS,
+        .serialise = true,
+        .handler = fileserv_handle_message
+    };
+
+    int error = srv_runtime_init(&fileServ.runtime, fileServCommon, cfg);
+    if (error != ESUCCESS) {
+        ROS_ERROR("File server could not initialise server runtime.");
+        assert(!"File server could not initialise server runtime.");
+        return;
     }
+    srv_runtime_run(&fileServ.runtime);
 }
 
 /*! @brief Main CPIO file server entry point. */
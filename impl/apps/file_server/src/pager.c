@@ -43,6 +43,7 @@ pager_init(struct fs_frame_block* fb, uint32_t framesSize)
     assert(framesSize % REFOS_PAGE_SIZE == 0);
     fb->frameBlockNumPages = framesSize / REFOS_PAGE_SIZE;
     cpool_init(&fb->framePool, 1, fb->frameBlockNumPages);
+    fb->numFree = fb->frameBlockNumPages - 1;
 
     /* Initialise the anonymouse RAM dataspace to allocate from. */
     dprintf("        Creating pager frame block...\n");
@@ -93,6 +94,7 @@ pager_release(struct fs_frame_block* fb)
     /* Release the allocator pool. */
     fb->frameBlockVAddr = 0;
     fb->frameBlockNumPages = 0;
+    fb->numFree = 0;
     cpool_release(&fb->framePool);
 }
 
@@ -108,9 +110,36 @@ pager_alloc_frame(struct fs_frame_block *fb)
         /* Allocation failed. */
         return (vaddr_t) 0;
     }
+    fb->numFree--;
     return (vaddr_t) (fb->frameBlockVAddr + (pagen * REFOS_PAGE_SIZE));
 }
 
+vaddr_t
+pager_alloc_frames(struct fs_frame_block *fb, uint32_t maxFrames, uint32_t *outNFrames)
+{
+    assert(fb && fb->initialised && outNFrames);
+    (*outNFrames) = 0;
+    vaddr_t start = pager_alloc_frame(fb);
+    if (!start) {
+        return (vaddr_t) 0;
+    }
+    (*outNFrames) = 1;
+
+    /* Keep allocating for as long as the frames we get follow on from the run. */
+    while ((*outNFrames) < maxFrames) {
+        vaddr_t frame = pager_alloc_frame(fb);
+        if (!frame) {
+            break;
+        }
+        if (frame != start + (*outNFrames) * REFOS_PAGE_SIZE) {
+            pager_free_frame(fb, frame);
+            break;
+        }
+        (*outNFrames)++;
+    }
+    return start;
+}
+
 void
 pager_free_frame(struct fs_frame_block *fb, vaddr_t frame)
 {
@@ -129,4 +158,5 @@ pager_free_frame(struct fs_frame_block *fb, vaddr_t frame)
         return;
     }
     cpool_free(&fb->framePool, pagen);
+    fb->numFree++;
 }
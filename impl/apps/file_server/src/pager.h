@@ -29,6 +29,7 @@ struct fs_frame_block {
     seL4_CPtr window;
     vaddr_t frameBlockVAddr;
     uint32_t frameBlockNumPages;
+    uint32_t numFree;
 };
 
 /*! @brief Initialises pager frame block table.
@@ -50,6 +51,23 @@ void pager_release(struct fs_frame_block* fb);
  */
 vaddr_t pager_alloc_frame(struct fs_frame_block *fb);
 
+/*! @brief Allocates a run of consecutive frames from the pager frame block. The run may be shorter
+           than asked for, down to a single frame, if the frame block is fragmented.
+    @param fb Pager frame block table to allocate from.
+    @param maxFrames The maximum number of frames in the run.
+    @param outNFrames Output number of frames in the allocated run.
+    @return Virtual addr of the first frame of the run if success, NULL otherwise. Each frame in
+            the run is freed separately with pager_free_frame().
+*/
+vaddr_t pager_alloc_frames(struct fs_frame_block *fb, uint32_t maxFrames, uint32_t *outNFrames);
+
+/*! @brief Get the number of frames left free in the pager frame block. */
+static inline uint32_t
+pager_num_free(struct fs_frame_block *fb)
+{
+    return fb->numFree;
+}
+
 /*! @brief Frees a frame.
     @param fb Pager frame block table to return the frame to.
     @param frame VAddr to the frame to be freed.
@@ -18,6 +18,8 @@
 #include "state.h"
 #include "dataspace.h"
 #include "pager.h"
+#include "bootarchive.h"
+#include "dispatchers/cpio_dspace.h"
 
  /*! @file
      @brief CPIO Fileserver global state & helper functions. */
@@ -43,7 +45,8 @@ fileserv_init(void) {
         .serverName = "fileserver",
         .mountPointPath = FILESERVER_MOUNTPOINT,
         .nameServEP = REFOS_NAMESERV_EP,
-        .faultDeathNotifyBadge = FS_ASYNC_NOTIFY_BADGE
+        .faultDeathNotifyBadge = FS_ASYNC_NOTIFY_BADGE,
+        .aioNotifyBadge = FS_ASYNC_AIO_BADGE
     };
 
     /* Set up file server common state. */
@@ -56,4 +59,10 @@ fileserv_init(void) {
 
     dprintf("    initialising dataspace allocation table...\n");
     dspace_table_init(&s->dspaceTable);
+
+    dprintf("    opening boot archive...\n");
+    bootarchive_init();
+
+    dprintf("    building directory index...\n");
+    cpio_dspace_init();
 }
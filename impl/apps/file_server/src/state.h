@@ -22,6 +22,7 @@
 #include <cpio/cpio.h>
 #include <refos-util/serv_connect.h>
 #include <refos-util/serv_common.h>
+#include <refos-util/serv_runtime.h>
 
 #include "dataspace.h"
 #include "pager.h"
@@ -33,13 +34,17 @@
 #include <refos-util/dprintf.h>
 
 #define FILESERVER_MAX_PAGE_FRAMES 128
+#define FILESERVER_PREFAULT_PAGES 8
+#define FILESERVER_PREFAULT_MIN_FREE_FRAMES (FILESERVER_MAX_PAGE_FRAMES / 4)
 #define FILESERVER_NOTIFICATION_BUFFER_SIZE 0x2000 /* 2 Frames. */
 #define FILESERVER_MOUNTPOINT "fileserv"
+#define FILESERVER_NUM_WORKERS 2
 #define FS_CLIENT_MAGIC 0x3FA3EF6E
 
 /*! @brief Global CPIO file server state structure. */
 struct fs_state {
     srv_common_t commonState;
+    srv_runtime_t runtime;
 
     /* Main file server data structures. */
     struct fs_frame_block pageFrameBlock;
@@ -0,0 +1,154 @@
+#!/usr/bin/env python
+#
+# Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+#
+# SPDX-License-Identifier: BSD-2-Clause
+
+import sys, os, struct, argparse
+
+# ------------------------------------------- Configuration ----------------------------------------
+DESCRIPTION = """\
+Builds the file server's compressed boot archive. Every file is split into page sized blocks, and
+each block is compressed on its own in the LZ4 block format, so that the file server can
+decompress any single page on demand. See apps/file_server/src/bootarchive.h for the layout.
+"""
+MAGIC = 0x5A504352 # "RCPZ"
+VERSION = 1
+BLOCK_SIZE = 4096
+BLOCK_RAW = 0x80000000
+HEADER_FORMAT = '<8I'
+FILE_FORMAT = '<3I'
+BLOCK_FORMAT = '<2I'
+ASM_TEMPLATE = """\
+/* DO NOT EDIT MANUALLY!!!
+   This file was generated by mkcarchive.py. */
+    .section .rodata
+    .balign 8
+    .global %(symbol)s
+%(symbol)s:
+    .incbin "%(path)s"
+    .balign 8
+    .global %(symbol)s_end
+%(symbol)s_end:
+"""
+
+# LZ4 block format constants.
+MIN_MATCH = 4
+LAST_LITERALS = 5   # The last 5 bytes of a block are always literals.
+MF_LIMIT = 12       # The last match must start at least 12 bytes before the end of a block.
+MAX_OFFSET = 65535
+
+# ------------------------------------------ LZ4 Compression ---------------------------------------
+
+def lz4_write_length(out, length):
+    length -= 15
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+def lz4_write_sequence(out, literals, match_offset, match_length):
+    lit_len = len(literals)
+    token = (min(lit_len, 15) << 4)
+    if match_length is not None:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        lz4_write_length(out, lit_len)
+    out.extend(literals)
+    if match_length is not None:
+        out.append(match_offset & 0xFF)
+        out.append(match_offset >> 8)
+        if match_length - MIN_MATCH >= 15:
+            lz4_write_length(out, match_length - MIN_MATCH)
+
+def lz4_compress_block(data):
+    """Greedy LZ4 block compression, with a hash table of the last position of each 4 byte
+       sequence. Trades ratio for simplicity; the file server only ever decompresses."""
+    out = bytearray()
+    n = len(data)
+    table = {}
+    anchor = 0
+    i = 0
+    match_limit = n - MF_LIMIT
+    while i < match_limit:
+        key = bytes(data[i:i + MIN_MATCH])
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > MAX_OFFSET:
+            i += 1
+            continue
+        # Extend the match forwards, keeping the last literals out of it.
+        length = MIN_MATCH
+        end = n - LAST_LITERALS
+        while i + length < end and data[candidate + length] == data[i + length]:
+            length += 1
+        lz4_write_sequence(out, data[anchor:i], i - candidate, length)
+        i += length
+        anchor = i
+    lz4_write_sequence(out, data[anchor:], None, None)
+    return out
+
+# ------------------------------------------ Archive Building --------------------------------------
+
+def build_archive(paths, block_size):
+    files = sorted(((os.path.basename(p), p) for p in paths), key=lambda f: f[0])
+    names = bytearray()
+    file_table = []
+    blocks = []
+    for name, path in files:
+        with open(path, 'rb') as f:
+            content = bytearray(f.read())
+        file_table.append((len(names), len(content), len(blocks)))
+        names.extend(name.encode('utf-8') + b'\0')
+        for off in range(0, len(content), block_size):
+            raw = content[off:off + block_size]
+            packed = lz4_compress_block(raw)
+            if len(packed) >= len(raw):
+                blocks.append((raw, len(raw) | BLOCK_RAW))
+            else:
+                blocks.append((packed, len(packed)))
+
+    files_offset = struct.calcsize(HEADER_FORMAT)
+    blocks_offset = files_offset + len(file_table) * struct.calcsize(FILE_FORMAT)
+    names_offset = blocks_offset + len(blocks) * struct.calcsize(BLOCK_FORMAT)
+    data_offset = names_offset + len(names)
+    data_offset += (-data_offset) % 4
+
+    out = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, block_size, len(file_table),
+                                len(blocks), files_offset, blocks_offset, names_offset))
+    for entry in file_table:
+        out.extend(struct.pack(FILE_FORMAT, *entry))
+    offset = data_offset
+    for data, length in blocks:
+        out.extend(struct.pack(BLOCK_FORMAT, offset, length))
+        offset += len(data)
+    out.extend(names)
+    out.extend(bytearray(data_offset - len(out)))
+    for data, length in blocks:
+        out.extend(data)
+
+    total = sum(entry[1] for entry in file_table)
+    return out, total
+
+# ---------------------------------------- Arguments Processing ------------------------------------
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=DESCRIPTION)
+    parser.add_argument('-o', '--output', required=True, help='Output archive file.')
+    parser.add_argument('-s', '--asm', help='Also write an assembly file which includes the '
+                        'archive under the given symbol, ready to be assembled into an object.')
+    parser.add_argument('--symbol', default='_cpio_archive', help='Archive symbol name.')
+    parser.add_argument('files', nargs='+', help='Files to put into the archive.')
+    args = parser.parse_args()
+
+    archive, total = build_archive(args.files, BLOCK_SIZE)
+    with open(args.output, 'wb') as f:
+        f.write(archive)
+    if args.asm:
+        with open(args.asm, 'w') as f:
+            f.write(ASM_TEMPLATE % {'symbol': args.symbol, 'path': os.path.abspath(args.output)})
+
+    sys.stdout.write("    %d files, %d bytes compressed to %d bytes (%.1f%%).\n" %
+                     (len(args.files), total, len(archive),
+                      100.0 * len(archive) / max(total, 1)))
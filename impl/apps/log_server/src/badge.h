@@ -0,0 +1,32 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _LOG_SERVER_BADGE_H_
+#define _LOG_SERVER_BADGE_H_
+
+#include <refos/refos.h>
+#include <refos-util/serv_common.h>
+
+/*! @file
+    @brief Log Server badge space definitions.
+
+    Laid out the same way as the file server's. Please look in @ref file_server/src/badge.h.
+*/
+
+/* ---- BadgeID 49 : Async Notify ---- */
+
+#define LOGSERV_ASYNC_NOTIFY_BADGE 0x31
+
+/* ---- Badge bit 0x10000 : Log ring doorbell ---- */
+
+/* Notification badges are ORed together, so the doorbell uses a bit above the whole badge space. */
+#define LOGSERV_ASYNC_RING_BADGE 0x10000
+
+/* ---- BadgeID 50 to 4145 : Clients ---- */
+
+#define LOGSERV_CLIENT_BADGE_BASE 0x32
+
+#endif /* _LOG_SERVER_BADGE_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <refos/share.h>
+#include <refos-rpc/proc_client.h>
+#include <refos-rpc/proc_common.h>
+#include "dispatch.h"
+#include "../state.h"
+#include "../badge.h"
+#include "../ring.h"
+
+/*! @file
+    @brief Client watch dispatcher module. */
+
+/*! @brief Handles client death notifications.
+    @param notification Structure containing the notification message, read from the notification
+                        ring buffer.
+    @return DISPATCH_SUCCESS if success, DISPATCHER_ERROR otherwise.
+*/
+static int
+handle_logserver_death_notification(struct proc_notification *notification)
+{
+    dprintf(COLOUR_Y "## Log server Handling death notification...\n" COLOUR_RESET);
+    dprintf("     Label: PROCSERV_NOTIFY_DEATH\n");
+    dprintf("     deathID: %d\n", notification->arg[0]);
+
+    /* The client's ring dataspace outlives it, so its last words can still be logged. */
+    logserv_ring_release(SRC_CLIENT_INVALID_ID, notification->arg[0]);
+
+    /* Find the client and queue it for deletion. */
+    int error = client_queue_delete_deathID(&logServCommon->clientTable, notification->arg[0]);
+
+    if (error) {
+        ROS_ERROR("Unknown deathID. log server book-keeping error.");
+        assert(!"log server book-keeping bug.");
+        return DISPATCH_ERROR;
+    }
+    return DISPATCH_SUCCESS;
+}
+
+int dispatch_client_watch(srv_msg_t *m)
+{
+    seL4_Word notifyBadge = m->badge & ~LOGSERV_ASYNC_RING_BADGE;
+    if (notifyBadge != LOGSERV_ASYNC_NOTIFY_BADGE && m->badge != LOGSERV_ASYNC_RING_BADGE) {
+        return DISPATCH_PASS;
+    }
+
+    /* Log ring doorbell. */
+    if (m->badge & LOGSERV_ASYNC_RING_BADGE) {
+        logserv_ring_drain_all();
+        if (!notifyBadge) {
+            return DISPATCH_SUCCESS;
+        }
+    }
+
+    srv_common_notify_handler_callbacks_t cb = {
+        .handle_server_fault = NULL,
+        .handle_server_content_init = NULL,
+        .handle_server_death_notification = handle_logserver_death_notification
+    };
+
+    return srv_dispatch_notification(logServCommon, cb);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "dispatch.h"
+#include "log_dispatch.h"
+#include "../badge.h"
+#include "../state.h"
+#include "../ring.h"
+#include <refos/error.h>
+
+/*! @file
+    @brief Handles log ring set up syscalls.
+
+    This file contains the handlers for log interface syscalls. It should implement the
+    declarations in the generated <refos-rpc/log_server.h>. Log records themselves never come
+    through here; they are appended to the client's log ring, see ring.h.
+*/
+
+seL4_CPtr
+log_set_ring_handler(void *rpc_userptr , seL4_CPtr rpc_ring_dataspace , uint32_t rpc_ring_size ,
+                     char* rpc_name , int* rpc_errno)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    srv_msg_t *m = (srv_msg_t *) c->rpcClient.userptr;
+    if (c->magic != LOGSERV_CLIENT_MAGIC) {
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return 0;
+    }
+
+    /* Sanity check parameters. */
+    if (!rpc_ring_dataspace || !srv_check_dispatch_caps(m, 0x00000000, 1)) {
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return 0;
+    }
+
+    /* Copyout the ring dataspace cap. Do not printf before copyout. */
+    seL4_CPtr ringDS = rpc_copyout_cptr(rpc_ring_dataspace);
+    if (!ringDS) {
+        ROS_ERROR("Failed to copyout the cap.");
+        SET_ERRNO_PTR(rpc_errno, ENOMEM);
+        return 0;
+    }
+
+    int error = logserv_ring_create(c, ringDS, rpc_ring_size, rpc_name ? rpc_name : "");
+    if (error != ESUCCESS) {
+        SET_ERRNO_PTR(rpc_errno, error);
+        return 0;
+    }
+    dprintf("Set log ring for client cID = %d (%s)...\n", c->cID, rpc_name);
+
+    /* Every client shares the same doorbell badge, so give out a copy of the one minted cap. */
+    SET_ERRNO_PTR(rpc_errno, ESUCCESS);
+    return logServ.ringDoorbell;
+}
+
+refos_err_t
+log_set_level_handler(void *rpc_userptr , int rpc_level)
+{
+    struct srv_client *c = (struct srv_client *) rpc_userptr;
+    if (c->magic != LOGSERV_CLIENT_MAGIC) {
+        return EINVALIDPARAM;
+    }
+    if (rpc_level < 0 || rpc_level >= REFOS_LOG_NUM_LEVELS) {
+        return EINVALIDPARAM;
+    }
+    struct logserv_ring *r = logserv_ring_find(c);
+    if (!r) {
+        return ENOPARAMBUFFER;
+    }
+    logserv_ring_set_level(r, rpc_level);
+    return ESUCCESS;
+}
+
+int
+check_dispatch_log(srv_msg_t *m, void **userptr)
+{
+    return check_dispatch_interface(m, userptr, RPC_LOG_LABEL_MIN, RPC_LOG_LABEL_MAX);
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _LOG_SERVER_DISPATCHER_LOG_INTERFACE_H_
+#define _LOG_SERVER_DISPATCHER_LOG_INTERFACE_H_
+
+#include "../state.h"
+#include "dispatch.h"
+#include <refos-rpc/log_server.h>
+#include <refos-util/serv_connect.h>
+
+/*! @file
+    @brief Handles log ring set up syscalls. */
+
+int rpc_sv_log_dispatcher(void *rpc_userptr, uint32_t label);
+
+/*! @brief Check whether the given recieved message is a log syscall.
+    @param m Struct containing info about the recieved message.
+    @param userptr Output user pointer. Pass this into the generated dispatcher function.
+    @return DISPATCH_SUCCESS if message is a log syscall, DISPATCH_PASS otherwise.
+*/
+int check_dispatch_log(srv_msg_t *m, void **userptr);
+
+#endif /* _LOG_SERVER_DISPATCHER_LOG_INTERFACE_H_ */
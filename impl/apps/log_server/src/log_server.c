@@ -0,0 +1,110 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <assert.h>
+#include <refos/refos.h>
+#include <refos-util/init.h>
+#include <refos-io/morecore.h>
+#include "state.h"
+#include "ring.h"
+#include "dispatchers/serv_dispatch.h"
+#include "dispatchers/log_dispatch.h"
+#include "dispatchers/client_watch.h"
+
+/*! @file
+    @brief Log Server main source file.
+
+    The RefOS Log server collects the debug and error output of RefOS processes, so that logging
+    does not cost them an IPC to the console server per line.
+
+    The Log server:
+    <ul>
+        <li>Maps a log ring shared with each connected client. The client appends records to it
+            without IPC, and only rings our doorbell if we are asleep.</li>
+        <li>Drains every ring whenever the doorbell is rung, tagging each record with a timestamp
+            and the client's name.</li>
+        <li>Filters records by severity, and rate limits each client, counting and reporting the
+            records it suppresses and the records a client lost to a full ring.</li>
+        <li>Writes the log out to a file (see APP_LOG_SERVER_OUTPUT), or to stdio.</li>
+        <li>Does NOT support parameter buffers using an external or internal dataspace.</li>
+    </ul>
+
+    The log server is at `/dev_log/`. Processes connect to it in refos_initialise(). The console,
+    file and timer servers are started before it, and are called by it to write out the log, so
+    it asks them for their rings with serv_get_log_ring() instead; see refos-io/log.h.
+*/
+
+/*! @brief Log server's static morecore region. */
+static char logServMMapRegion[LOGSERV_MMAP_REGION_SIZE];
+
+/*! @brief Handle messages recieved by the log server.
+    @param s The global log server state. (No ownership transfer)
+    @param msg The recieved message. (No ownership transfer)
+    @return DISPATCH_SUCCESS if message dispatched, DISPATCH_ERROR if unknown message.
+*/
+static int
+log_server_handle_message(struct logserv_state *s, srv_msg_t *msg)
+{
+    int result = DISPATCH_PASS;
+    int label = seL4_GetMR(0);
+    void *userptr;
+
+    if (dispatch_client_watch(msg) == DISPATCH_SUCCESS) {
+        return DISPATCH_SUCCESS;
+    }
+
+    if (check_dispatch_log(msg, &userptr) == DISPATCH_SUCCESS) {
+        result = rpc_sv_log_dispatcher(userptr, label);
+        assert(result == DISPATCH_SUCCESS);
+        return DISPATCH_SUCCESS;
+    }
+
+    if (check_dispatch_serv(msg, &userptr) == DISPATCH_SUCCESS) {
+        result = rpc_sv_serv_dispatcher(userptr, label);
+        assert(result == DISPATCH_SUCCESS);
+        return DISPATCH_SUCCESS;
+    }
+
+    dprintf("Unknown message (badge = %d msgInfo = %d label = %d).\n",
+            msg->badge, seL4_MessageInfo_get_label(msg->message), label);
+    ROS_ERROR("log server unknown message.");
+    assert(!"log server unknown message.");
+
+    return DISPATCH_ERROR;
+}
+
+/*! @brief Main log server message loop. Simply loops through recieving and dispatching messages
+           repeatedly. */
+static void
+log_server_mainloop(void)
+{
+    struct logserv_state *s = &logServ;
+    srv_msg_t msg;
+
+    while (1) {
+        msg.message = rpc_sv_reply_recv(s->commonState.anonEP, &msg.badge);
+        log_server_handle_message(s, &msg);
+        client_table_postaction(&s->commonState.clientTable);
+    }
+}
+
+/*! @brief Main log server entry point. */
+int
+main()
+{
+    /* See Future Work 3 in timer_server.c about how the system call table is found. */
+    uintptr_t address = strtoll(getenv("SYSTABLE"), NULL, 16);
+    refos_init_selfload_child(address);
+    dprintf("Initialising RefOS log server.\n");
+    refosio_setup_morecore_override(logServMMapRegion, LOGSERV_MMAP_REGION_SIZE);
+    refos_initialise();
+    logserv_init();
+
+    log_server_mainloop();
+
+    return 0;
+}
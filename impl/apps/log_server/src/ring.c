@@ -0,0 +1,427 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <refos/error.h>
+#include <refos-util/walloc.h>
+#include <refos-util/cspace.h>
+#include <refos-rpc/data_client.h>
+#include <refos-rpc/serv_client.h>
+#include <refos-rpc/serv_client_helper.h>
+#include "ring.h"
+#include "state.h"
+
+/*! @file
+    @brief Log server client log rings. */
+
+#define LOGSERV_LINE_MAXLEN 320
+#define LOGSERV_RING_TOKEN 1000
+#define LOGSERV_RING_MAX_REFILL_NS 10000000000ULL
+
+static const char *logservLevelNames[REFOS_LOG_NUM_LEVELS] = {
+    "ERROR", "WARNING", "INFO", "DEBUG"
+};
+
+/*! @brief A system server we ask for its log ring, rather than have it connect to us. */
+struct logserv_ring_pull {
+    const char *path;
+    const char *name;
+    bool done;
+};
+
+/*! @brief The servers started before us, or which we call to write the log out. See
+           refos-io/log.h. */
+static struct logserv_ring_pull logservPulls[] = {
+    { "/dev_console/", "CONSERV", false },
+    { "/fileserv/", "FILESERV", false },
+    { "/dev_timer/", "TIMESERV", false },
+#ifdef CONFIG_APP_BLOCK_SERVER
+    /* Started after us, so it normally connects itself, and only needs asking if it beat our
+       mountpoint registration. */
+    { "/disk/", "BLOCKSERV", false },
+#endif
+};
+
+/*! @brief Drains left until the servers not yet reached are asked again. 0 once all have been. */
+static int logservPullCountdown;
+
+/*! @brief Unmap and free a ring. It must already be off the ring list. */
+static void
+logserv_ring_free(struct logserv_ring *r)
+{
+    assert(r && r->magic == LOGSERV_RING_MAGIC);
+    data_dataunmap(REFOS_PROCSERV_EP, r->window);
+    walloc_free((uint32_t) r->vaddr, r->sizeNPages);
+    csfree_delete(r->dataspace);
+    r->magic = 0;
+    free(r);
+}
+
+/*! @brief Map a log ring dataspace, and start draining it.
+    @param cID The ID of the client the ring belongs to, or SRC_CLIENT_INVALID_ID for a ring we
+               asked a system server for.
+    @param deathID The client's deathID, or -1 for a ring we asked a system server for.
+    @param ringDataspace The ring dataspace. (Takes ownership)
+    @param ringSize The size of the ring dataspace.
+    @param name The name to tag the ring's records with. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+logserv_ring_map(uint32_t cID, int32_t deathID, seL4_CPtr ringDataspace, uint32_t ringSize,
+                 const char *name)
+{
+    assert(ringDataspace && name);
+    int error = EINVALIDPARAM;
+
+    if (ringSize == 0 || ringSize > LOGSERV_RING_MAX_SIZE) {
+        goto exit0;
+    }
+    /* The ring size comes from the ring's owner. Anything past the end of the dataspace it hands
+       us would fault when we touch it, so it must cover the whole ring. */
+    if (data_get_size(REFOS_PROCSERV_EP, ringDataspace) < ringSize) {
+        ROS_WARNING("logserv_ring_map: ring dataspace smaller than ring size.");
+        goto exit0;
+    }
+
+    struct logserv_ring *r = malloc(sizeof(struct logserv_ring));
+    if (!r) {
+        ROS_ERROR("logserv_ring_map out of memory.");
+        error = ENOMEM;
+        goto exit0;
+    }
+    memset(r, 0, sizeof(struct logserv_ring));
+    r->dataspace = ringDataspace;
+
+    /* Map the ring dataspace into our own vspace. */
+    r->sizeNPages = (ringSize / REFOS_PAGE_SIZE) + ((ringSize % REFOS_PAGE_SIZE) ? 1 : 0);
+    r->vaddr = (char*) walloc(r->sizeNPages, &r->window);
+    if (!r->vaddr || !r->window) {
+        ROS_ERROR("logserv_ring_map failed to allocate window.");
+        error = ENOMEM;
+        goto exit1;
+    }
+    error = data_datamap(REFOS_PROCSERV_EP, r->dataspace, r->window, 0);
+    if (error != ESUCCESS) {
+        ROS_WARNING("logserv_ring_map failed to datamap ring dataspace.");
+        goto exit2;
+    }
+
+    /* The ring contents come from its owner, and are not trusted. */
+    error = refos_log_ring_attach(&r->ring, r->vaddr, ringSize);
+    if (error != ESUCCESS) {
+        ROS_WARNING("logserv_ring_map: invalid ring header.");
+        goto exit3;
+    }
+
+    r->magic = LOGSERV_RING_MAGIC;
+    r->cID = cID;
+    r->deathID = deathID;
+    strncpy(r->name, name, LOGSERV_RING_NAME_MAXLEN - 1);
+    r->tokens = (uint64_t) CONFIG_APP_LOG_SERVER_BURST * LOGSERV_RING_TOKEN;
+    logserv_ring_set_level(r, REFOS_LOG_DEBUG);
+    cvector_add(&logServ.ringList, (cvector_item_t) r);
+    return ESUCCESS;
+
+    /* Exit stack. */
+exit3:
+    data_dataunmap(REFOS_PROCSERV_EP, r->window);
+exit2:
+    walloc_free((uint32_t) r->vaddr, r->sizeNPages);
+exit1:
+    free(r);
+exit0:
+    csfree_delete(ringDataspace);
+    return error;
+}
+
+int
+logserv_ring_create(struct srv_client *c, seL4_CPtr ringDataspace, uint32_t ringSize,
+                    const char *name)
+{
+    assert(c && ringDataspace && name);
+    logserv_ring_release(c->cID, c->deathID);
+    return logserv_ring_map(c->cID, c->deathID, ringDataspace, ringSize, name);
+}
+
+/*! @brief Ask a system server for its log ring, and map it.
+    @return true if the server has a log ring now, false if it should be asked again later.
+*/
+static bool
+logserv_ring_pull_one(struct logserv_ring_pull *p)
+{
+    serv_connection_t sc = serv_connect_no_pbuffer((char*) p->path);
+    if (sc.error != ESUCCESS || !sc.serverSession) {
+        /* Not started yet. */
+        return false;
+    }
+
+    uint32_t ringSize = 0;
+    int error = EINVALID;
+    seL4_CPtr ringDS = serv_get_log_ring(sc.serverSession, logServ.ringDoorbell, &ringSize,
+                                         &error);
+    serv_disconnect(&sc);
+    if (error == EINVALID || error == EUNIMPLEMENTED) {
+        /* It already logs through a ring of its own, or does not log through one at all. */
+        return true;
+    }
+    if (error != ESUCCESS || !ringDS) {
+        ROS_WARNING("Could not get log ring from %s. Error: %d.", p->name, error);
+        return false;
+    }
+
+    /* System servers never exit, so their rings are kept for good. */
+    error = logserv_ring_map(SRC_CLIENT_INVALID_ID, -1, ringDS, ringSize, p->name);
+    if (error != ESUCCESS) {
+        /* It logs through the ring already, so there is no asking it again. */
+        ROS_WARNING("Could not map log ring of %s. Error: %d.", p->name, error);
+        return true;
+    }
+
+    /* The ring is not armed yet, so nothing rings for what it logged before we mapped it. */
+    seL4_Signal(logServ.ringDoorbell);
+    return true;
+}
+
+void
+logserv_ring_pull(void)
+{
+    logservPullCountdown = 0;
+    for (int i = 0; i < sizeof(logservPulls) / sizeof(logservPulls[0]); i++) {
+        if (logservPulls[i].done) {
+            continue;
+        }
+        logservPulls[i].done = logserv_ring_pull_one(&logservPulls[i]);
+        if (!logservPulls[i].done) {
+            logservPullCountdown = LOGSERV_RING_PULL_RETRY_DRAINS;
+        }
+    }
+}
+
+struct logserv_ring *
+logserv_ring_find(struct srv_client *c)
+{
+    assert(c);
+    int n = cvector_count(&logServ.ringList);
+    for (int i = 0; i < n; i++) {
+        struct logserv_ring *r = (struct logserv_ring *) cvector_get(&logServ.ringList, i);
+        assert(r && r->magic == LOGSERV_RING_MAGIC);
+        if (r->cID == c->cID) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+void
+logserv_ring_set_level(struct logserv_ring *r, int level)
+{
+    assert(r && r->magic == LOGSERV_RING_MAGIC);
+    if (level > CONFIG_APP_LOG_SERVER_LEVEL) {
+        level = CONFIG_APP_LOG_SERVER_LEVEL;
+    }
+    refos_log_ring_set_level(&r->ring, level);
+}
+
+/*! @brief Format a record as a log line, and append it to the sink. */
+static void
+logserv_ring_emit(struct logserv_ring *r, uint64_t now, int level, const char *msg, int len,
+                  bool truncated)
+{
+    char line[LOGSERV_LINE_MAXLEN];
+    int n = snprintf(line, sizeof(line), "[%5u.%06u] %s %s: %.*s%s\n",
+                     (uint32_t) (now / 1000000000ULL), (uint32_t) ((now % 1000000000ULL) / 1000),
+                     r->name, logservLevelNames[level], len, msg, truncated ? "..." : "");
+    if (n < 0) {
+        return;
+    }
+    if (n >= sizeof(line)) {
+        n = sizeof(line) - 1;
+        line[n - 1] = '\n';
+    }
+    logserv_sink_append(&logServ.sink, line, n);
+}
+
+/*! @brief Report records a client lost, as a warning in its own name. */
+static void
+logserv_ring_emit_lost(struct logserv_ring *r, uint64_t now, uint32_t count, const char *why)
+{
+    char msg[64];
+    int n = snprintf(msg, sizeof(msg), "%u log records %s.", count, why);
+    if (n > 0 && n < sizeof(msg)) {
+        logserv_ring_emit(r, now, REFOS_LOG_WARNING, msg, n, false);
+    }
+}
+
+/*! @brief Take a rate limiting token for a record.
+    @return true if the record may be logged, false if it should be suppressed.
+*/
+static bool
+logserv_ring_admit(struct logserv_ring *r, uint64_t now)
+{
+#if CONFIG_APP_LOG_SERVER_RATE > 0
+    if (!now) {
+        /* No clock, no rate limiting. */
+        return true;
+    }
+    if (now > r->lastRefill) {
+        uint64_t elapsed = now - r->lastRefill;
+        if (elapsed > LOGSERV_RING_MAX_REFILL_NS) {
+            elapsed = LOGSERV_RING_MAX_REFILL_NS;
+        }
+        /* Only move the refill time on once a whole thousandth has built up, so that frequent
+           drains do not round the refill away. */
+        uint64_t add = elapsed * CONFIG_APP_LOG_SERVER_RATE / 1000000;
+        if (add) {
+            r->tokens += add;
+            r->lastRefill = now;
+            if (r->tokens > (uint64_t) CONFIG_APP_LOG_SERVER_BURST * LOGSERV_RING_TOKEN) {
+                r->tokens = (uint64_t) CONFIG_APP_LOG_SERVER_BURST * LOGSERV_RING_TOKEN;
+            }
+        }
+    }
+    if (r->tokens < LOGSERV_RING_TOKEN) {
+        return false;
+    }
+    r->tokens -= LOGSERV_RING_TOKEN;
+#endif
+    return true;
+}
+
+/*! @brief Drain up to one ring's worth of records from a ring.
+    @return The number of records popped.
+*/
+static int
+logserv_ring_drain(struct logserv_ring *r, uint64_t now)
+{
+    assert(r && r->magic == LOGSERV_RING_MAGIC);
+    struct refos_log_record rec;
+    int n = 0;
+
+    uint32_t dropped = refos_log_ring_take_dropped(&r->ring);
+    if (dropped) {
+        logserv_ring_emit_lost(r, now, dropped, "lost to a full ring");
+    }
+
+    /* Bounded, so a client logging as fast as we drain can not keep us here. */
+    int max = r->ring.queue.mask + 1;
+    while (n < max && refos_log_ring_pop(&r->ring, &rec)) {
+        n++;
+        if (rec.level > CONFIG_APP_LOG_SERVER_LEVEL) {
+            continue;
+        }
+        if (!logserv_ring_admit(r, now)) {
+            r->suppressed++;
+            continue;
+        }
+        if (r->suppressed) {
+            logserv_ring_emit_lost(r, now, r->suppressed, "suppressed by rate limit");
+            r->suppressed = 0;
+        }
+        logserv_ring_emit(r, now, rec.level, rec.msg, rec.len,
+                          (rec.flags & REFOS_LOG_FLAG_TRUNCATED) != 0);
+    }
+    return n;
+}
+
+/*! @brief Give up on the rings found corrupt while draining. Their clients stay connected, but
+           need to set a new ring to be logged again.
+    @return The number of rings left.
+*/
+static int
+logserv_ring_detach_corrupt(uint64_t now)
+{
+    int n = cvector_count(&logServ.ringList);
+    for (int i = n - 1; i >= 0; i--) {
+        struct logserv_ring *r = (struct logserv_ring *) cvector_get(&logServ.ringList, i);
+        assert(r && r->magic == LOGSERV_RING_MAGIC);
+        if (!r->ring.corrupt) {
+            continue;
+        }
+        static const char msg[] = "log ring corrupt; detached.";
+        logserv_ring_emit(r, now, REFOS_LOG_ERROR, msg, sizeof(msg) - 1, false);
+        cvector_delete_unordered(&logServ.ringList, i);
+        logserv_ring_free(r);
+        n--;
+    }
+    return n;
+}
+
+void
+logserv_ring_release(uint32_t cID, int32_t deathID)
+{
+    int n = cvector_count(&logServ.ringList);
+    for (int i = 0; i < n; i++) {
+        struct logserv_ring *r = (struct logserv_ring *) cvector_get(&logServ.ringList, i);
+        assert(r && r->magic == LOGSERV_RING_MAGIC);
+        bool match = (cID != SRC_CLIENT_INVALID_ID) ? (r->cID == cID) :
+                     (deathID >= 0 && r->deathID == deathID);
+        if (!match) {
+            continue;
+        }
+
+        /* Drain what the client left behind before letting go of its ring. */
+        uint64_t now = logserv_sink_begin(&logServ.sink);
+        logserv_ring_drain(r, now);
+        if (r->suppressed) {
+            logserv_ring_emit_lost(r, now, r->suppressed, "suppressed by rate limit");
+        }
+        logserv_sink_flush(&logServ.sink);
+
+        cvector_delete_unordered(&logServ.ringList, i);
+        logserv_ring_free(r);
+        return;
+    }
+}
+
+void
+logserv_ring_drain_all(void)
+{
+    if (logservPullCountdown > 0 && --logservPullCountdown == 0) {
+        logserv_ring_pull();
+    }
+    uint64_t now = logserv_sink_begin(&logServ.sink);
+    int n = cvector_count(&logServ.ringList);
+    int popped = 0;
+
+    for (int pass = 0; pass < LOGSERV_RING_MAX_PASSES; pass++) {
+        popped = 0;
+        for (int i = 0; i < n; i++) {
+            popped += logserv_ring_drain(
+                    (struct logserv_ring *) cvector_get(&logServ.ringList, i), now);
+        }
+        if (!popped) {
+            break;
+        }
+    }
+    n = logserv_ring_detach_corrupt(now);
+
+    if (popped) {
+        /* Still going. Come back to it after serving any pending requests, without arming the
+           rings, as we are not going to sleep. */
+        logserv_sink_flush(&logServ.sink);
+        seL4_Signal(logServ.ringDoorbell);
+        return;
+    }
+
+    /* About to sleep. Arm every ring, then look once more; anything appended after this look
+       rings the doorbell. */
+    for (int i = 0; i < n; i++) {
+        refos_log_ring_arm(&((struct logserv_ring *) cvector_get(&logServ.ringList, i))->ring);
+    }
+    popped = 0;
+    for (int i = 0; i < n; i++) {
+        popped += logserv_ring_drain(
+                (struct logserv_ring *) cvector_get(&logServ.ringList, i), now);
+    }
+    logserv_ring_detach_corrupt(now);
+    logserv_sink_flush(&logServ.sink);
+    if (popped) {
+        /* That look was bounded too, so there may be more left that nobody will ring for. */
+        seL4_Signal(logServ.ringDoorbell);
+    }
+}
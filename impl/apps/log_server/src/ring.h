@@ -0,0 +1,99 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _LOG_SERVER_RING_H_
+#define _LOG_SERVER_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sel4/sel4.h>
+#include <refos/log_ring.h>
+#include <refos-util/serv_connect.h>
+
+/*! @file
+    @brief Log server client log rings.
+
+    Each client hands us a log ring (see refos/log_ring.h) in an anonymous dataspace, which is
+    mapped here for as long as the client is connected. All rings are drained together whenever
+    the doorbell is rung, and the records are tagged with a timestamp and the client's name, rate
+    limited, and written out to the sink.
+
+    Before going back to sleep, the log server arms every ring and drains them once more, so a
+    record appended while it was draining either gets drained then, or rings the doorbell again.
+
+    The ring contents are written by the client, so a drain never waits on them. A ring found
+    corrupt is detached after the drain, and its client is not logged until it sets a new ring.
+
+    The system servers which must not call us (see refos-io/log.h) are asked for their rings
+    instead, at startup and then every LOGSERV_RING_PULL_RETRY_DRAINS drains until each has been
+    reached.
+*/
+
+#define LOGSERV_RING_MAGIC 0x106B10C5
+#define LOGSERV_RING_NAME_MAXLEN 16
+#define LOGSERV_RING_MAX_SIZE 0x40000
+
+/*! Drain passes over every ring per doorbell, before yielding to pending requests. */
+#define LOGSERV_RING_MAX_PASSES 8
+
+/*! Drains between asking the system servers not reached yet for their rings again. */
+#define LOGSERV_RING_PULL_RETRY_DRAINS 32
+
+/*! @brief A client's mapped log ring. */
+struct logserv_ring {
+    uint32_t magic;
+    uint32_t cID;
+    int32_t deathID;
+    char name[LOGSERV_RING_NAME_MAXLEN];
+
+    seL4_CPtr dataspace; /* Has ownership. */
+    seL4_CPtr window; /* Has ownership. */
+    char *vaddr;
+    int sizeNPages;
+    refos_log_ring_t ring;
+
+    /* Rate limiting token bucket. In thousandths of a record. */
+    uint64_t tokens;
+    uint64_t lastRefill;
+    uint32_t suppressed;
+};
+
+/*! @brief Map a client's log ring dataspace, and start draining it. Replaces the client's
+           existing ring, if any.
+    @param c The client setting the ring. (No ownership)
+    @param ringDataspace The client's ring dataspace. (Takes ownership)
+    @param ringSize The size of the ring dataspace.
+    @param name The name to tag the client's records with. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int logserv_ring_create(struct srv_client *c, seL4_CPtr ringDataspace, uint32_t ringSize,
+                        const char *name);
+
+/*! @brief Ask the system servers which do not connect to us for their log rings, and start
+           draining them. Servers not started yet are asked again on a later drain. */
+void logserv_ring_pull(void);
+
+/*! @brief Find a client's log ring.
+    @param c The client. (No ownership)
+    @return The client's ring if it has one, NULL otherwise. (No ownership)
+*/
+struct logserv_ring *logserv_ring_find(struct srv_client *c);
+
+/*! @brief Set the least severe level a client logs, capped to the configured server level. */
+void logserv_ring_set_level(struct logserv_ring *r, int level);
+
+/*! @brief Drain and release a client's log ring, if it has one. Called when the client goes away,
+           so that its last words still make it into the log.
+    @param cID The client ID, or SRC_CLIENT_INVALID_ID to look the client up by deathID instead.
+    @param deathID The client's deathID.
+*/
+void logserv_ring_release(uint32_t cID, int32_t deathID);
+
+/*! @brief Drain every log ring, and write the records out. Detaches corrupt rings, and rings the
+           doorbell again if there are still records left after LOGSERV_RING_MAX_PASSES passes. */
+void logserv_ring_drain_all(void);
+
+#endif /* _LOG_SERVER_RING_H_ */
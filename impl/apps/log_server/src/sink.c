@@ -0,0 +1,110 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <refos-util/init.h>
+#include "sink.h"
+#include "state.h"
+
+/*! @file
+    @brief Log server output and clock. */
+
+/*! @brief Try to open the log file and the clock, whichever is not open yet. */
+static void
+logserv_sink_open(struct logserv_sink *s)
+{
+    if (s->fd < 0 && s->path[0]) {
+        /* Start a fresh log on boot, but keep what is there when reopening it. */
+        s->fd = open(s->path, O_WRONLY | O_CREAT | (s->opened ? 0 : O_TRUNC), 0644);
+        if (s->fd < 0) {
+            s->fd = -1;
+        } else if (s->opened) {
+            lseek(s->fd, 0, SEEK_END);
+        } else {
+            dprintf("    Logging to %s.\n", s->path);
+            s->opened = true;
+        }
+    }
+    if (s->timerFd < 0) {
+        s->timerFd = open(REFOS_DEFAULT_TIMER_DSPACE, O_RDONLY);
+        if (s->timerFd < 0) {
+            s->timerFd = -1;
+        }
+    }
+}
+
+void
+logserv_sink_init(struct logserv_sink *s, const char *path)
+{
+    assert(s && path);
+    memset(s, 0, sizeof(struct logserv_sink));
+    s->path = path;
+    s->fd = -1;
+    s->timerFd = -1;
+    s->retryCountdown = LOGSERV_SINK_RETRY_DRAINS;
+    logserv_sink_open(s);
+}
+
+uint64_t
+logserv_sink_begin(struct logserv_sink *s)
+{
+    assert(s);
+    if ((s->fd < 0 && s->path[0]) || s->timerFd < 0) {
+        if (--s->retryCountdown <= 0) {
+            s->retryCountdown = LOGSERV_SINK_RETRY_DRAINS;
+            logserv_sink_open(s);
+        }
+    }
+    if (s->timerFd < 0) {
+        return 0;
+    }
+
+    /* Read the timer dataspace directly, like sys_clock_gettime() does, rather than through
+       clock_gettime(), which asserts when there is no timer. */
+    uint64_t ns = 0;
+    if (read(s->timerFd, (char*) &ns, sizeof(uint64_t)) < (int) sizeof(uint64_t)) {
+        return 0;
+    }
+    return ns;
+}
+
+void
+logserv_sink_append(struct logserv_sink *s, const char *line, int len)
+{
+    assert(s && line && len >= 0);
+    if (len > LOGSERV_SINK_BUFFER_SIZE - s->bufferLen) {
+        logserv_sink_flush(s);
+    }
+    if (len > LOGSERV_SINK_BUFFER_SIZE) {
+        len = LOGSERV_SINK_BUFFER_SIZE;
+    }
+    memcpy(s->buffer + s->bufferLen, line, len);
+    s->bufferLen += len;
+}
+
+void
+logserv_sink_flush(struct logserv_sink *s)
+{
+    assert(s);
+    if (!s->bufferLen) {
+        return;
+    }
+    if (s->fd >= 0) {
+        if (write(s->fd, s->buffer, s->bufferLen) == s->bufferLen) {
+            s->bufferLen = 0;
+            return;
+        }
+        /* The log file went away. Write this lot to stdio, and retry opening it later. */
+        close(s->fd);
+        s->fd = -1;
+    }
+    fwrite(s->buffer, 1, s->bufferLen, stdout);
+    fflush(stdout);
+    s->bufferLen = 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _LOG_SERVER_SINK_H_
+#define _LOG_SERVER_SINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*! @file
+    @brief Log server output and clock.
+
+    Formatted log lines are gathered in a buffer and written out in one go at the end of each
+    drain, rather than with an IPC per line. The output is the configured log file, or stdio when
+    there is none or it can not be opened yet. The clock used to timestamp records and rate limit
+    clients is the timer server's time dataspace.
+
+    Neither the output file nor the clock may be reachable when the log server starts (the block
+    server for example is started after us), so they are retried every LOGSERV_SINK_RETRY_DRAINS
+    drains until they are.
+*/
+
+#define LOGSERV_SINK_BUFFER_SIZE 0x1000
+#define LOGSERV_SINK_RETRY_DRAINS 32
+
+/*! @brief Log server output state. */
+struct logserv_sink {
+    const char *path; /* No ownership. Empty to always log to stdio. */
+    int fd; /* The log file, or -1 if logging to stdio. */
+    bool opened; /* Whether the log file has been opened (and truncated) before. */
+    int timerFd; /* The timer dataspace, or -1 if there is no clock. */
+    int retryCountdown;
+
+    char buffer[LOGSERV_SINK_BUFFER_SIZE];
+    int bufferLen;
+};
+
+/*! @brief Initialise the log output, and try to open the log file and the clock.
+    @param s The sink state to initialise. (No ownership)
+    @param path The path of the log file, or an empty string to log to stdio. (No ownership)
+*/
+void logserv_sink_init(struct logserv_sink *s, const char *path);
+
+/*! @brief Start a drain. Retries opening the log file and the clock if they are not open yet.
+    @param s The sink state. (No ownership)
+    @return The current time in nanoseconds, or 0 if there is no clock.
+*/
+uint64_t logserv_sink_begin(struct logserv_sink *s);
+
+/*! @brief Append a formatted line to the output, writing out the buffer first if it is full.
+    @param s The sink state. (No ownership)
+    @param line The line to write, including its newline. (No ownership)
+    @param len The length of the line.
+*/
+void logserv_sink_append(struct logserv_sink *s, const char *line, int len);
+
+/*! @brief Write out everything appended so far.
+    @param s The sink state. (No ownership)
+*/
+void logserv_sink_flush(struct logserv_sink *s);
+
+#endif /* _LOG_SERVER_SINK_H_ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <refos-util/cspace.h>
+#include <refos/vmlayout.h>
+#include <refos/refos.h>
+#include "state.h"
+#include "badge.h"
+#include "ring.h"
+
+/*! @file
+    @brief Log server global state & helper functions. */
+
+struct logserv_state logServ;
+srv_common_t *logServCommon;
+const char* dprintfServerName = "LOGSERV";
+int dprintfServerColour = 36;
+
+void
+logserv_init(void)
+{
+    /* Set up the server common config. */
+    srv_common_config_t cfg = {
+        .maxClients = SRV_DEFAULT_MAX_CLIENTS,
+        .clientBadgeBase = LOGSERV_CLIENT_BADGE_BASE,
+        .clientMagic = LOGSERV_CLIENT_MAGIC,
+        .notificationBufferSize = SRV_DEFAULT_NOTIFICATION_BUFFER_SIZE,
+        .paramBufferSize = SRV_DEFAULT_PARAM_BUFFER_SIZE,
+        .serverName = "logserver",
+        .mountPointPath = LOGSERV_MOUNTPOINT,
+        .nameServEP = REFOS_NAMESERV_EP,
+        .faultDeathNotifyBadge = LOGSERV_ASYNC_NOTIFY_BADGE
+    };
+
+    /* Open the log output first. Our mountpoint is not registered until srv_common_init(), so
+       nobody can be logging to us yet. */
+    dprintf("    Opening log output...\n");
+    logserv_sink_init(&logServ.sink, CONFIG_APP_LOG_SERVER_OUTPUT);
+
+    /* Set up log server common state. */
+    logServCommon = &logServ.commonState;
+    cvector_init(&logServ.ringList);
+    srv_common_init(logServCommon, cfg);
+
+    /* Mint the log ring doorbell. Every client shares the same doorbell badge; the rings are
+       all drained together anyway. */
+    dprintf("    Creating log ring doorbell badged EP...\n");
+    logServ.ringDoorbell = srv_mint(LOGSERV_ASYNC_RING_BADGE, logServCommon->notifyAsyncEP);
+    if (!logServ.ringDoorbell) {
+        ROS_ERROR("Log server could not create log ring doorbell.");
+        assert(!"Log server could not create log ring doorbell.");
+    }
+
+    /* Get the rings of the servers which must not call us. */
+    dprintf("    Asking system servers for their log rings...\n");
+    logserv_ring_pull();
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _LOG_SERVER_STATE_H_
+#define _LOG_SERVER_STATE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/vmlayout.h>
+#include <refos-rpc/rpc.h>
+#include <data_struct/cvector.h>
+
+#include "badge.h"
+#include "sink.h"
+
+#include <refos-util/serv_connect.h>
+#include <refos-util/serv_common.h>
+#include <refos-util/cspace.h>
+#include <refos-rpc/data_client.h>
+#include <refos-rpc/data_client_helper.h>
+#include <refos/refos.h>
+
+/*! @file
+    @brief Log server global state & helper functions. */
+
+// Debug printing. The log server never logs through itself, so this always goes to stdio.
+#include <refos-util/dprintf.h>
+
+#define LOGSERV_MMAP_REGION_SIZE 0x40000
+#define LOGSERV_MOUNTPOINT "dev_log"
+#define LOGSERV_CLIENT_MAGIC 0x106C11E7
+
+/*! @brief Log server global state. */
+struct logserv_state {
+    srv_common_t commonState;
+
+    /*! Doorbell cap handed out to every client with a log ring. Signalling it sets
+        LOGSERV_ASYNC_RING_BADGE on our async endpoint. */
+    seL4_CPtr ringDoorbell;
+
+    cvector_t ringList; /* struct logserv_ring. Has ownership. */
+    struct logserv_sink sink;
+};
+
+extern struct logserv_state logServ;
+extern srv_common_t *logServCommon;
+
+/*! @brief Initialise log server state, and open the log output. */
+void logserv_init(void);
+
+#endif /* _LOG_SERVER_STATE_H_ */
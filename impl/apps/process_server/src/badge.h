@@ -23,18 +23,30 @@
 #define PID_LIVENESS_BADGE_BASE PID_BADGE_END
 #define PID_LIVENESS_BADGE_END (PID_LIVENESS_BADGE_BASE + PID_MAX)
 
-/* ---- BadgeID 4099 to 12290 : Windows ---- */
+/* ---- Dynamic object badges ----
 
-#define W_MAX_WINDOWS 8192
+   Windows and RAM dataspaces are allocated dynamically from object tables (see
+   system/memserv/objtable.h). Each type gets a badge range of PROCSERV_OBJ_BADGE_SPAN badges, in
+   which the low PROCSERV_OBJ_ID_BITS bits of a badge are the object ID, and the next
+   PROCSERV_OBJ_GEN_BITS bits are the generation of that ID, so stale badges of deleted objects may
+   be told apart from badges of the objects reusing their IDs. */
+
+#define PROCSERV_OBJ_ID_BITS 16
+#define PROCSERV_OBJ_GEN_BITS 8
+#define PROCSERV_OBJ_BADGE_SPAN (1 << (PROCSERV_OBJ_ID_BITS + PROCSERV_OBJ_GEN_BITS))
+
+/* ---- BadgeID 0x1000000 to 0x1FFFFFF : Windows ---- */
+
+#define W_MAX_WINDOWS (1 << PROCSERV_OBJ_ID_BITS)
 #define W_MAX_ASSOCIATED_WINDOWS 2048
 
-#define W_BADGE_BASE PID_LIVENESS_BADGE_END
-#define W_BADGE_END (W_BADGE_BASE + W_MAX_WINDOWS)
+#define W_BADGE_BASE PROCSERV_OBJ_BADGE_SPAN
+#define W_BADGE_END (W_BADGE_BASE + PROCSERV_OBJ_BADGE_SPAN)
 
-/* ---- BadgeID 12291 to 20482 : RAM Dataspace Objects ---- */
+/* ---- BadgeID 0x2000000 to 0x2FFFFFF : RAM Dataspace Objects ---- */
 
-#define RAM_DATASPACE_MAX_NUM_DATASPACE 8192
+#define RAM_DATASPACE_MAX_NUM_DATASPACE (1 << PROCSERV_OBJ_ID_BITS)
 #define RAM_DATASPACE_BADGE_BASE W_BADGE_END
-#define RAM_DATASPACE_BADGE_END (RAM_DATASPACE_BADGE_BASE + RAM_DATASPACE_MAX_NUM_DATASPACE)
+#define RAM_DATASPACE_BADGE_END (RAM_DATASPACE_BADGE_BASE + PROCSERV_OBJ_BADGE_SPAN)
 
 #endif /* _REFOS_PROCESS_SERVER_BADGE_H_ */
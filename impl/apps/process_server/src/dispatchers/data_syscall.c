@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <fcntl.h>
 #include <sel4/sel4.h>
 #include "data_syscall.h"
 #include <refos-rpc/data_server.h>
@@ -22,26 +23,32 @@
    <refos-rpc/data_server.h>, for anon dataspaces.
 */
 
-seL4_CPtr
-data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode , int rpc_size ,
-                  int* rpc_errno)
+/*! @brief Create an anonymous RAM dataspace for the given client. Helper function for
+           data_open_handler() and data_open_stat_handler().
+    @param pcb The client to create the dataspace for. (No ownership)
+    @param rpc_name The name of the dataspace to open. Must be NULL, empty or "anon".
+    @param rpc_flags The dataspace flags.
+    @param rpc_mode The physical address, if PROCSERV_DSPACE_FLAG_DEVICE_PADDR is set in flags.
+    @param rpc_size The size of the dataspace to create.
+    @param rpc_errno Output errno variable.
+    @return The created RAM dataspace if success, NULL otherwise. (No ownership)
+*/
+static struct ram_dspace*
+data_open_ram_dspace(struct proc_pcb *pcb, char* rpc_name, int rpc_flags, int rpc_mode,
+                     int rpc_size, int* rpc_errno)
 {
-    struct proc_pcb *pcb = (struct proc_pcb*) rpc_userptr;
     assert(pcb && pcb->magic == REFOS_PCB_MAGIC);
 
-    (void) pcb;
-    (void) rpc_mode;
-
     if (rpc_size <= 0) {
         SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
-        return 0;
+        return NULL;
     }
 
     /* Name must either be NULL, empty string or anon. */
     if (rpc_name != NULL) {
         if (strlen(rpc_name) > 0 && strcmp(rpc_name, "anon") != 0) {
             SET_ERRNO_PTR(rpc_errno, EFILENOTFOUND);
-            return 0;
+            return NULL;
         }
     }
 
@@ -50,7 +57,7 @@ data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_m
     if (!newDataspace) {
         ROS_ERROR("Failed to create new_dataspace.\n");
         SET_ERRNO_PTR(rpc_errno, ENOMEM);
-        return 0;
+        return NULL;
     }
 
     /* Set physical address mode, if required. */
@@ -62,13 +69,61 @@ data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_m
         if (error) {
             ram_dspace_unref(&procServ.dspaceList, newDataspace->ID);
             SET_ERRNO_PTR(rpc_errno, error);
-            return 0;
+            return NULL;
         }
     }
 
     SET_ERRNO_PTR(rpc_errno, ESUCCESS);
     assert(newDataspace->magic == RAM_DATASPACE_MAGIC);
-    return newDataspace->capability.capPtr;
+    return newDataspace;
+}
+
+seL4_CPtr
+data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode , int rpc_size ,
+                  int* rpc_errno)
+{
+    struct ram_dspace *dspace = data_open_ram_dspace((struct proc_pcb*) rpc_userptr, rpc_name,
+                                                     rpc_flags, rpc_mode, rpc_size, rpc_errno);
+    return dspace ? dspace->capability.capPtr : 0;
+}
+
+seL4_CPtr
+data_open_stat_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode ,
+                       int rpc_size , uint32_t* rpc_dspaceSize , int* rpc_dspaceMode ,
+                       uint32_t* rpc_dspaceFlags , int* rpc_errno)
+{
+    struct ram_dspace *dspace = data_open_ram_dspace((struct proc_pcb*) rpc_userptr, rpc_name,
+                                                     rpc_flags, rpc_mode, rpc_size, rpc_errno);
+    if (!dspace) {
+        return 0;
+    }
+
+    /* RAM dataspaces are always readable and writable. */
+    if (rpc_dspaceSize) {
+        (*rpc_dspaceSize) = dspace->npages * REFOS_PAGE_SIZE;
+    }
+    if (rpc_dspaceMode) {
+        (*rpc_dspaceMode) = O_RDWR;
+    }
+    if (rpc_dspaceFlags) {
+        (*rpc_dspaceFlags) = 0;
+    }
+    return dspace->capability.capPtr;
+}
+
+refos_err_t
+data_stat_handler(void *rpc_userptr , char* rpc_name , uint32_t* rpc_size , uint32_t* rpc_mode ,
+                  uint32_t* rpc_mtime , uint32_t* rpc_flags)
+{
+    (void) rpc_userptr;
+    (void) rpc_name;
+    (void) rpc_size;
+    (void) rpc_mode;
+    (void) rpc_mtime;
+    (void) rpc_flags;
+
+    /* Anonymous RAM dataspaces have no names to stat; every open creates a new one. */
+    return EUNIMPLEMENTED;
 }
 
 refos_err_t
@@ -198,7 +253,7 @@ data_datamap_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd , seL4_CPtr rpc
     if (!dispatcher_badge_window(rpc_memoryWindow)) { 
         return EINVALIDWINDOW;
     }
-    struct w_window *window = w_get_window(&procServ.windowList, rpc_memoryWindow - W_BADGE_BASE);
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_memoryWindow);
     if (!window) {
         return EINVALIDWINDOW;
     }
@@ -240,7 +295,7 @@ data_dataunmap_handler(void *rpc_userptr , seL4_CPtr rpc_memoryWindow)
     if (!dispatcher_badge_window(rpc_memoryWindow)) { 
         return EINVALIDWINDOW;
     }
-    struct w_window *window = w_get_window(&procServ.windowList, rpc_memoryWindow - W_BADGE_BASE);
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_memoryWindow);
     if (!window) {
         return EINVALIDWINDOW;
     }
@@ -389,6 +444,24 @@ data_provide_data_from_parambuffer_handler(void *rpc_userptr , seL4_CPtr rpc_dsp
     return ESUCCESS;
 }
 
+int
+data_aio_bind_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    (void) rpc_userptr;
+    (void) rpc_dspace_fd;
+
+    /* Anonymous RAM dataspaces are mapped, not read and written through the data interface, so
+       there is no asynchronous I/O ring to bind them to. */
+    return -EUNIMPLEMENTED;
+}
+
+int
+data_aio_enter_handler(void *rpc_userptr)
+{
+    (void) rpc_userptr;
+    return -EUNIMPLEMENTED;
+}
+
 int
 check_dispatch_dataspace(struct procserv_msg *m, void **userptr)
 {
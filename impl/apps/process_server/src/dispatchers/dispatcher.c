@@ -13,8 +13,8 @@
  /*! @file
      @brief Common Process server dispatcher helper functions. */
 
-#define PROCSERV_SYSCALL_PARAM_SIZE_MAX (REFOS_PAGE_SIZE * 8)
-static char _paramBuffer[PROCSERV_SYSCALL_PARAM_SIZE_MAX];
+#define PROCSERV_SYSCALL_PARAM_SIZE_MAX REFOS_PCB_PARAMBUFFER_MAP_SIZE
+static char _paramBuffer[PROCSERV_SYSCALL_PARAM_SIZE_MAX + 1];
 
 seL4_MessageInfo_t _dispatcherEmptyReply;
 
@@ -107,21 +107,26 @@ dispatcher_read_param(struct proc_pcb *pcb, uint32_t readLen)
         ROS_ERROR("Parameter buffer too large to be read.")
         return NULL;
     }
-    
-    /* Reset the static temp buffer. */
-    char *tempBuffer = _paramBuffer;
-    memset(tempBuffer, 0, PROCSERV_SYSCALL_PARAM_SIZE_MAX);
-
-    /* Read bytes out of the paramBuffer dataspace. */
-    if (readLen > 0) {
-        int error = ram_dspace_read(tempBuffer, readLen, pcb->paramBuffer, 0);
-        if (error != ESUCCESS) {
-            ROS_ERROR("Parameter buffer failed to read from parameter buffer.");
-            assert(!"Failed to read from parameter buffer. This shouldn't happen; Procserv OOM.");
-            return NULL;
-        }
+
+    if (readLen == 0) {
+        _paramBuffer[0] = '\0';
+        return _paramBuffer;
     }
 
-    return tempBuffer;
-}
+    /* Read in place if the parameter buffer is mapped, which it is unless mapping it failed. */
+    struct ram_dspace_local_map *map = &pcb->paramBufferMap;
+    if (map->vaddr && readLen <= map->size) {
+        procserv_flush(map->frames, (readLen + REFOS_PAGE_SIZE - 1) / REFOS_PAGE_SIZE);
+        return map->vaddr;
+    }
 
+    /* Copy bytes out of the paramBuffer dataspace into the static temp buffer. */
+    int error = ram_dspace_read(_paramBuffer, readLen, pcb->paramBuffer, 0);
+    if (error != ESUCCESS) {
+        ROS_ERROR("Parameter buffer failed to read from parameter buffer.");
+        assert(!"Failed to read from parameter buffer. This shouldn't happen; Procserv OOM.");
+        return NULL;
+    }
+    _paramBuffer[readLen] = '\0';
+    return _paramBuffer;
+}
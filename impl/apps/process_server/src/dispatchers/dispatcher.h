@@ -126,9 +126,16 @@ seL4_CPtr dispatcher_copyout_cptr(seL4_CPtr c);
 void dispatcher_release_copyout_cptr(seL4_CPtr c);
 
 /*! @brief Reads the contents of the given process's param buffer.
+
+    Returns the process server's own mapping of the parameter buffer if it has one, so nothing is
+    copied; otherwise the first readLen bytes are copied into a static temporary buffer. Only the
+    first readLen bytes of the result are valid. As the client may still be writing to its
+    parameter buffer, callers must bound every access by readLen, and must copy anything they
+    validate before using it.
+
     @param pcb The PCB of the process to read parameter buffer from.
     @param readLen The length in bytes to read from the parambuffer.
-    @return A static temporary buffer with contents of parameter buffer. (No ownership)
+    @return The parameter buffer contents, or NULL on error. (No ownership)
 */
 char* dispatcher_read_param(struct proc_pcb *pcb, uint32_t readLen);
 
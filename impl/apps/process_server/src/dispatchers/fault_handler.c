@@ -24,6 +24,11 @@
 /*! @file
     @brief Process server fault dispatcher which handles VM faults. */
 
+/*! @brief The maximum number of extra device frames mapped in on a fault to a physical address
+           dataspace window. Device windows are small register blocks, so mapping all of it on the
+           first fault saves the driver a fault round trip per page. */
+#define FAULT_DEVICE_PREFAULT_MAX_PAGES 16
+
 /*! @brief Temporary internal VM fault message info struct. */
 struct procserv_vmfault_msg {
     /*! The faulting program's process control block. */
@@ -104,6 +109,48 @@ fault_delegate_notification(struct procserv_vmfault_msg *f, struct proc_pcb *del
 
 /* ----------------------------- Proc Server fault handler functions ---------------------------- */
 
+/*! @brief Map in the rest of a window onto a device physical address dataspace.
+
+    Device frames need no allocation or zeroing, so the rest of the window (up to
+    FAULT_DEVICE_PREFAULT_MAX_PAGES pages) is mapped in along with the faulting page. Pages which
+    are already mapped are skipped. Failing to map a page here is not an error; it will simply
+    fault in later.
+
+    @param f The VM fault message info struct.
+    @param aw Found associated window of the faulting address & client.
+    @param window The window structure of the faulting address & client.
+*/
+static void
+handle_vm_fault_device_prefault(struct procserv_vmfault_msg *f, struct w_associated_window *aw,
+        struct w_window *window)
+{
+    struct ram_dspace *dspace = window->ramDataspace;
+    assert(dspace && dspace->physicalAddrEnabled);
+    vaddr_t faultPage = REFOS_PAGE_ALIGN(f->faultAddr);
+    int nPages = 0;
+
+    for (vaddr_t va = REFOS_PAGE_ALIGN(aw->offset); va < aw->offset + aw->size &&
+            nPages < FAULT_DEVICE_PREFAULT_MAX_PAGES; va += REFOS_PAGE_SIZE) {
+        if (va == faultPage) {
+            continue;
+        }
+        vaddr_t dspaceOffset = (va + window->ramDataspaceOffset) - REFOS_PAGE_ALIGN(aw->offset);
+        seL4_CPtr frame = ram_dspace_get_page(dspace, dspaceOffset);
+        if (!frame) {
+            /* Past the end of the dataspace. */
+            break;
+        }
+        int error = vs_map(&f->pcb->vspace, va, &frame, 1);
+        if (error == EUNMAPFIRST) {
+            continue;
+        }
+        if (error != ESUCCESS) {
+            break;
+        }
+        nPages++;
+    }
+}
+
 /*! @brief Handles faults on windows mapped to anonymous memory.
 
     This function is responsible for handling VM faults on windows which have been mapped to the
@@ -198,6 +245,10 @@ handle_vm_fault_dspace(struct procserv_msg *m, struct procserv_vmfault_msg *f,
         return error;
     }
 
+    if (dspace->physicalAddrEnabled) {
+        handle_vm_fault_device_prefault(f, aw, window);
+    }
+
     return ESUCCESS;
 }
 
@@ -27,6 +27,44 @@
     separted into two files for better code organisation.
 */
 
+struct w_window *
+mem_create_window(struct proc_pcb *pcb, uint32_t vaddr, uint32_t size, uint32_t permissions,
+                  uint32_t flags, refos_err_t* rpc_errno)
+{
+    assert(pcb && pcb->magic == REFOS_PCB_MAGIC);
+
+    /* Check that this window does not override protected kernel memory. */
+    if (vaddr >= PROCESS_KERNEL_RESERVED || PROCESS_KERNEL_RESERVED < (size + vaddr)) {
+        dvprintf("memory window out of bounds, overlaps kernel reserved.\n");
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return NULL;
+    }
+
+    /* Create the window. */
+    int windowID = W_INVALID_WINID;
+    bool cached = (flags & W_FLAGS_UNCACHED) ? false : true;
+    int error = vs_create_window(&pcb->vspace, vaddr, size, permissions, cached, &windowID);
+    if (error != ESUCCESS || windowID == W_INVALID_WINID) {
+        dvprintf("Could not create window.\n");
+        SET_ERRNO_PTR(rpc_errno, error);
+        return NULL;
+    }
+
+    /* Find the window. */
+    struct w_window* window = w_get_window(&procServ.windowList, windowID);
+    if (!window) {
+        assert(!"Successfully allocated window failed to be found. Process server bug.");
+        /* Cannot recover from this situation cleanly. Shouldn't ever happen. */
+        SET_ERRNO_PTR(rpc_errno, EINVALID);
+        return NULL;
+    }
+
+    assert(window->magic == W_MAGIC);
+    assert(window->capability.capPtr);
+    SET_ERRNO_PTR(rpc_errno, ESUCCESS);
+    return window;
+}
+
 /*! @brief Handles memory window creation syscalls.
 
     The window must not be overlapping with an existing window in the client's VSpace, or
@@ -42,43 +80,80 @@ seL4_CPtr
 proc_create_mem_window_internal_handler(void *rpc_userptr , uint32_t rpc_vaddr , uint32_t rpc_size ,
                                         uint32_t rpc_permissions, uint32_t flags,
                                         refos_err_t* rpc_errno)
+{
+    struct w_window *window = mem_create_window((struct proc_pcb*) rpc_userptr, rpc_vaddr,
+                                                rpc_size, rpc_permissions, flags, rpc_errno);
+    return window ? window->capability.capPtr : 0;
+}
+
+/*! @brief Handles anonymous memory window creation syscalls.
+
+    Creates the window exactly as proc_create_mem_window_internal_handler() does, then creates an
+    anonymous RAM dataspace of the same size and maps it there. The window takes the only reference
+    to the dataspace, so deleting the window releases the dataspace too. This saves the client the
+    data_open() and data_datamap() round trips, and the book-keeping of the dataspace capability.
+*/
+seL4_CPtr
+proc_create_anon_mem_window_internal_handler(void *rpc_userptr , uint32_t rpc_vaddr ,
+                                             uint32_t rpc_size , uint32_t rpc_permissions,
+                                             uint32_t flags, refos_err_t* rpc_errno)
 {
     struct proc_pcb *pcb = (struct proc_pcb*) rpc_userptr;
     assert(pcb && pcb->magic == REFOS_PCB_MAGIC);
 
-    /* Check that this window does not override protected kernel memory. */
-    if (rpc_vaddr >= PROCESS_KERNEL_RESERVED || PROCESS_KERNEL_RESERVED < (rpc_size + rpc_vaddr)) {
-        dvprintf("memory window out of bounds, overlaps kernel reserved.\n");
+    if (!rpc_size) {
         SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
         return 0;
     }
 
     /* Create the window. */
-    int windowID = W_INVALID_WINID;
-    bool cached = (flags & W_FLAGS_UNCACHED) ? false : true;
-    int error = vs_create_window(&pcb->vspace, rpc_vaddr, rpc_size, rpc_permissions, cached,
-            &windowID);
-    if (error != ESUCCESS || windowID == W_INVALID_WINID) {
-        dvprintf("Could not create window.\n");
-        SET_ERRNO_PTR(rpc_errno, error);
+    struct w_window *window = mem_create_window(pcb, rpc_vaddr, rpc_size, rpc_permissions, flags,
+                                                rpc_errno);
+    if (!window) {
         return 0;
     }
 
-    /* Find the window and return the window capability. */
-    struct w_window* window = w_get_window(&procServ.windowList, windowID);
-    if (!window) {
-        assert(!"Successfully allocated window failed to be found. Process server bug.");
-        /* Cannot recover from this situation cleanly. Shouldn't ever happen. */
-        SET_ERRNO_PTR(rpc_errno, EINVALID);
+    /* Create the backing dataspace. */
+    struct ram_dspace *dspace = ram_dspace_create(&procServ.dspaceList, rpc_size);
+    if (!dspace) {
+        ROS_ERROR("Failed to create anon window dataspace. Procserv out of memory.");
+        vs_delete_window(&pcb->vspace, window->wID);
+        SET_ERRNO_PTR(rpc_errno, ENOMEM);
         return 0;
     }
 
-    assert(window->magic == W_MAGIC);
-    assert(window->capability.capPtr);
+    /* Map it into the window, and hand our reference over to the window. */
+    w_set_anon_dspace(window, dspace, 0);
+    window->ramDataspaceOwned = true;
+    ram_dspace_unref(&procServ.dspaceList, dspace->ID);
+
     SET_ERRNO_PTR(rpc_errno, ESUCCESS);
     return window->capability.capPtr;
 }
 
+int
+mem_resize_window(struct proc_pcb *pcb, struct w_window *window, uint32_t size)
+{
+    assert(pcb && pcb->magic == REFOS_PCB_MAGIC);
+    assert(window && window->magic == W_MAGIC);
+
+    /* Windows which own their dataspace grow it along with them. The dataspace is expanded first,
+       as it can not be contracted again if the resize fails; the spare pages are harmless. */
+    if (window->mode == W_MODE_ANONYMOUS && window->ramDataspaceOwned) {
+        assert(window->ramDataspace && window->ramDataspace->magic == RAM_DATASPACE_MAGIC);
+        uint32_t dspaceSize = window->ramDataspaceOffset + size;
+        if (dspaceSize > window->ramDataspace->npages * REFOS_PAGE_SIZE) {
+            int error = ram_dspace_expand(window->ramDataspace, dspaceSize);
+            if (error != ESUCCESS) {
+                return error;
+            }
+        }
+    }
+
+    /* Perform the actual window resize operation. */
+    return vs_resize_window(&pcb->vspace, window->wID, size);
+}
+
 /*! @brief Handles memory window resize syscalls. */
 refos_err_t
 proc_resize_mem_window_handler(void *rpc_userptr , seL4_CPtr rpc_window , uint32_t rpc_size)
@@ -97,8 +172,13 @@ proc_resize_mem_window_handler(void *rpc_userptr , seL4_CPtr rpc_window , uint32
         return EINVALIDWINDOW;
     }
 
-    /* Perform the actual window resize operation. */
-    return vs_resize_window(&pcb->vspace, rpc_window - W_BADGE_BASE, rpc_size);
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_window);
+    if (!window) {
+        dvprintf("Warning: proc_resize_mem_window no such window.\n");
+        return EINVALIDWINDOW;
+    }
+
+    return mem_resize_window(pcb, window, rpc_size);
 }
 
 /*! @brief Handles memory window deletion syscalls. */
@@ -117,8 +197,13 @@ proc_delete_mem_window_handler(void *rpc_userptr , seL4_CPtr rpc_window)
         return EINVALIDWINDOW;
     }
 
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_window);
+    if (!window) {
+        return EINVALIDWINDOW;
+    }
+
     /* Perform the actual window deletion. Also unmaps the window. */
-    vs_delete_window(&pcb->vspace, rpc_window - W_BADGE_BASE);
+    vs_delete_window(&pcb->vspace, window->wID);
     return ESUCCESS;
 }
 
@@ -164,7 +249,7 @@ proc_get_mem_window_dspace_handler(void *rpc_userptr , seL4_CPtr rpc_window ,
     }
     
     /* Retrieve the window from global window list. */
-    struct w_window *window = w_get_window(&procServ.windowList, rpc_window - W_BADGE_BASE);
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_window);
     if (!window) {
         ROS_ERROR("Failed to find associated window in global list. Procserv book-keeping bug.");
         SET_ERRNO_PTR(rpc_errno, EINVALIDWINDOW);
@@ -206,7 +291,7 @@ proc_register_as_pager_handler(void *rpc_userptr , seL4_CPtr rpc_window ,
         ROS_WARNING("Invalid window badge.");
         return EINVALIDPARAM;
     }
-    struct w_window *win = w_get_window(&procServ.windowList, rpc_window - W_BADGE_BASE);
+    struct w_window *win = w_get_window_badge(&procServ.windowList, rpc_window);
     if (!win) {
         ROS_ERROR("invalid window ID.");
         return EINVALIDPARAM;
@@ -248,7 +333,7 @@ proc_unregister_as_pager_handler(void *rpc_userptr , seL4_CPtr rpc_window)
         ROS_WARNING("Invalid window badge.");
         return EINVALIDPARAM;
     }
-    struct w_window *win = w_get_window(&procServ.windowList, rpc_window - W_BADGE_BASE);
+    struct w_window *win = w_get_window_badge(&procServ.windowList, rpc_window);
     if (!win) {
         ROS_ERROR("invalid window ID.");
         return EINVALIDPARAM;
@@ -314,7 +399,7 @@ proc_window_map_handler(void *rpc_userptr , seL4_CPtr rpc_window , uint32_t rpc_
     if (!dispatcher_badge_window(rpc_window)) {
         return EINVALIDPARAM;
     }
-    struct w_window *window = w_get_window(&procServ.windowList, rpc_window - W_BADGE_BASE);
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_window);
     if (!window) {
         ROS_ERROR("window does not exist!\n");
         return EINVALIDWINDOW;
@@ -335,6 +420,53 @@ proc_window_map_handler(void *rpc_userptr , seL4_CPtr rpc_window , uint32_t rpc_
     return ESUCCESS;
 }
 
+/*! @brief Handles server window range map syscalls.
+
+    Vectored version of proc_window_map_handler(), which lets a pager resolve a delegated fault
+    and prefault the pages around it in one call. A window belongs to a single client, which
+    has at most one outstanding fault, so resuming the window's owner resumes every client
+    blocked on a page in the range.
+ */
+int
+proc_window_map_range_handler(void *rpc_userptr , seL4_CPtr rpc_window ,
+                              uint32_t rpc_windowOffset , uint32_t rpc_srcAddr ,
+                              uint32_t rpc_nFrames)
+{
+    struct proc_pcb *pcb = (struct proc_pcb*) rpc_userptr;
+    struct procserv_msg *m = (struct procserv_msg*) pcb->rpcClient.userptr;
+    assert(pcb && pcb->magic == REFOS_PCB_MAGIC);
+
+    if (!check_dispatch_caps(m, 0x00000001, 1)) {
+        return -EINVALIDPARAM;
+    }
+
+    /* Retrieve and verify the window cap. */
+    if (!dispatcher_badge_window(rpc_window)) {
+        return -EINVALIDPARAM;
+    }
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_window);
+    if (!window) {
+        ROS_ERROR("window does not exist!\n");
+        return -EINVALIDWINDOW;
+    }
+
+    /* Map the frames from src vspace to dest vspace. */
+    struct proc_pcb *clientPCB = NULL;
+    int nMapped = 0;
+    int error = vs_map_across_vspace_range(&pcb->vspace, rpc_srcAddr, window, rpc_windowOffset,
+                                           (int) rpc_nFrames, &nMapped, &clientPCB);
+    if (error) {
+        return -error;
+    }
+    assert(clientPCB != NULL && clientPCB->magic == REFOS_PCB_MAGIC);
+
+    /* Resume the blocked faulting thread if there is one. This is done even if none of the
+       frames were mapped, as then the faulting page has already been mapped in. */
+    assert(procServ.unblockClientFaultPID == PID_NULL);
+    procServ.unblockClientFaultPID = clientPCB->pid;
+    return nMapped;
+}
+
 /*! @brief Handles device server device map syscalls. */
 refos_err_t
 proc_device_map_handler(void *rpc_userptr , seL4_CPtr rpc_window , uint32_t rpc_windowOffset ,
@@ -354,7 +486,7 @@ proc_device_map_handler(void *rpc_userptr , seL4_CPtr rpc_window , uint32_t rpc_
     }
 
     /* Retrieve and verify window. */
-    struct w_window *window = w_get_window(&procServ.windowList, rpc_window - W_BADGE_BASE);
+    struct w_window *window = w_get_window_badge(&procServ.windowList, rpc_window);
     if (!window) {
         ROS_ERROR("window does not exist!\n");
         return EINVALIDWINDOW;
@@ -13,10 +13,33 @@
 
 #include "dispatcher.h"
 #include "../state.h"
+#include "../system/memserv/window.h"
 
 /*! @file
     @brief Handles process server memory-related syscalls. */
 
+/*! @brief Create a memory window in a client's vspace. Helper function for the window creation
+           syscall handlers.
+    @param pcb The client to create the window for. (No ownership)
+    @param vaddr The window base address in the client's VSpace.
+    @param size The size of the window.
+    @param permissions The read / write permission bitmask.
+    @param flags The flags bitmask (cached / uncached).
+    @param rpc_errno Output errno variable.
+    @return The created window if success, NULL otherwise. (No ownership)
+*/
+struct w_window *mem_create_window(struct proc_pcb *pcb, uint32_t vaddr, uint32_t size,
+                                   uint32_t permissions, uint32_t flags, refos_err_t* rpc_errno);
+
+/*! @brief Resize a memory window in a client's vspace, growing its dataspace along with it if the
+           window owns its dataspace. Helper function for the window resize syscall handlers.
+    @param pcb The client owning the window. (No ownership)
+    @param window The window to resize. (No ownership)
+    @param size The new window size.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int mem_resize_window(struct proc_pcb *pcb, struct w_window *window, uint32_t size);
+
 /*! @brief Memory syscall post-action.
 
     Replies to any processes that are waiting to be resumed from a dataspace VM fault.
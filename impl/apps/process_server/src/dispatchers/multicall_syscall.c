@@ -0,0 +1,312 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! \file multicall_syscall.c
+    @brief Dispatcher for the procserv multicall syscall.
+*/
+
+#include "proc_syscall.h"
+#include "mem_syscall.h"
+
+#include <refos-rpc/proc_common.h>
+#include <refos-rpc/proc_server.h>
+
+#include "../system/process/process.h"
+#include "../system/memserv/window.h"
+#include "../system/memserv/dataspace.h"
+#include "../system/addrspace/vspace.h"
+
+/*! @file
+    @brief Handles the process server multicall syscall.
+
+    A multicall runs a short table of memory and process operations in a single syscall, so that
+    setup sequences such as creating a window, opening a dataspace and mapping one into the other
+    take one round trip rather than one each. Every operation leaves the window or dataspace it
+    produced (if any) in its own slot, and later operations name their window and dataspace
+    arguments by slot. The operations themselves are implemented by the same helpers as the
+    corresponding single syscalls.
+*/
+
+enum multicall_slot_type {
+    MULTICALL_SLOT_EMPTY = 0,
+    MULTICALL_SLOT_WINDOW,
+    MULTICALL_SLOT_DSPACE
+};
+
+/*! @brief A multicall slot, holding the window or dataspace produced by an operation. */
+struct multicall_slot {
+    enum multicall_slot_type type;
+    void *obj; /* No ownership. */
+    bool created; /* Whether the object was created by this multicall. */
+};
+
+/*! @brief Multicall execution state. */
+struct multicall_state {
+    struct proc_pcb *pcb; /* No ownership. */
+    struct multicall_slot cap;
+    struct multicall_slot slot[PROCSERV_MULTICALL_MAX_OPS];
+    uint32_t current; /* Index of the operation being run. */
+};
+
+static void
+multicall_set_slot(struct multicall_slot *slot, enum multicall_slot_type type, void *obj,
+                   bool created)
+{
+    assert(slot && obj);
+    slot->type = type;
+    slot->obj = obj;
+    slot->created = created;
+}
+
+/*! @brief Look up an operation argument naming a window or dataspace.
+    @param s The multicall state.
+    @param ref The slot argument; an earlier operation's index, or PROCSERV_MULTICALL_SLOT_CAP.
+    @param type The type of object expected in the slot.
+    @return The object in the slot if it holds one of the given type, NULL otherwise.
+            (No ownership)
+*/
+static void *
+multicall_get_slot(struct multicall_state *s, seL4_Word ref, enum multicall_slot_type type)
+{
+    struct multicall_slot *slot = NULL;
+    if (ref == PROCSERV_MULTICALL_SLOT_CAP) {
+        slot = &s->cap;
+    } else if (ref < s->current) {
+        slot = &s->slot[ref];
+    }
+    if (!slot || slot->type != type) {
+        return NULL;
+    }
+    return slot->obj;
+}
+
+/*! @brief Run a single multicall operation.
+    @param s The multicall state.
+    @param op The operation to run.
+    @param result Output result value of the operation.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+multicall_run_op(struct multicall_state *s, struct proc_multicall_op *op, seL4_Word *result)
+{
+    struct multicall_slot *out = &s->slot[s->current];
+    struct w_window *window = NULL;
+    struct ram_dspace *dspace = NULL;
+    refos_err_t error = EINVALID;
+
+    switch (op->opcode) {
+        case PROCSERV_MULTICALL_CREATE_MEM_WINDOW:
+            window = mem_create_window(s->pcb, op->arg[0], op->arg[1], op->arg[2], op->arg[3],
+                                       &error);
+            if (!window) {
+                return error;
+            }
+            multicall_set_slot(out, MULTICALL_SLOT_WINDOW, window, true);
+            return ESUCCESS;
+
+        case PROCSERV_MULTICALL_GET_MEM_WINDOW: {
+            struct w_associated_window *aw = w_associate_find(&s->pcb->vspace.windows,
+                                                              op->arg[0]);
+            if (!aw) {
+                return EINVALIDWINDOW;
+            }
+            window = w_get_window(&procServ.windowList, aw->winID);
+            if (!window) {
+                ROS_ERROR("Failed to find associated window in global list. Procserv bug.");
+                return EINVALIDWINDOW;
+            }
+            multicall_set_slot(out, MULTICALL_SLOT_WINDOW, window, false);
+            return ESUCCESS;
+        }
+
+        case PROCSERV_MULTICALL_RESIZE_MEM_WINDOW:
+            window = multicall_get_slot(s, op->arg[0], MULTICALL_SLOT_WINDOW);
+            if (!window) {
+                return EINVALIDWINDOW;
+            }
+            return mem_resize_window(s->pcb, window, op->arg[1]);
+
+        case PROCSERV_MULTICALL_WINDOW_GETID:
+            window = multicall_get_slot(s, op->arg[0], MULTICALL_SLOT_WINDOW);
+            if (!window) {
+                return EINVALIDWINDOW;
+            }
+            (*result) = window->wID;
+            return ESUCCESS;
+
+        case PROCSERV_MULTICALL_OPEN_ANON:
+            if ((int) op->arg[0] <= 0) {
+                return EINVALIDPARAM;
+            }
+            dspace = ram_dspace_create(&procServ.dspaceList, op->arg[0]);
+            if (!dspace) {
+                ROS_ERROR("Failed to create multicall dataspace. Procserv out of memory.");
+                return ENOMEM;
+            }
+            multicall_set_slot(out, MULTICALL_SLOT_DSPACE, dspace, true);
+            return ESUCCESS;
+
+        case PROCSERV_MULTICALL_GET_MEM_WINDOW_DSPACE:
+            window = multicall_get_slot(s, op->arg[0], MULTICALL_SLOT_WINDOW);
+            if (!window || window->mode != W_MODE_ANONYMOUS) {
+                return EINVALIDWINDOW;
+            }
+            assert(window->ramDataspace && window->ramDataspace->magic == RAM_DATASPACE_MAGIC);
+            multicall_set_slot(out, MULTICALL_SLOT_DSPACE, window->ramDataspace, false);
+            return ESUCCESS;
+
+        case PROCSERV_MULTICALL_DATAMAP:
+            dspace = multicall_get_slot(s, op->arg[0], MULTICALL_SLOT_DSPACE);
+            window = multicall_get_slot(s, op->arg[1], MULTICALL_SLOT_WINDOW);
+            if (!dspace || op->arg[2] > (dspace->npages * REFOS_PAGE_SIZE)) {
+                return EINVALIDPARAM;
+            }
+            if (!window) {
+                return EINVALIDWINDOW;
+            }
+            w_set_anon_dspace(window, dspace, op->arg[2]);
+            return ESUCCESS;
+
+        case PROCSERV_MULTICALL_SET_PARAMBUFFER:
+            dspace = multicall_get_slot(s, op->arg[0], MULTICALL_SLOT_DSPACE);
+            if (!dspace) {
+                return EINVALIDPARAM;
+            }
+            proc_set_parambuffer(s->pcb, dspace);
+            return ESUCCESS;
+
+        case PROCSERV_MULTICALL_NOTIFICATION_BUFFER:
+            dspace = multicall_get_slot(s, op->arg[0], MULTICALL_SLOT_DSPACE);
+            if (!dspace) {
+                return EINVALIDPARAM;
+            }
+            return proc_set_notificationbuffer(s->pcb, dspace);
+
+        default:
+            break;
+    }
+
+    dvprintf("Warning: unknown multicall opcode %u.\n", op->opcode);
+    return EINVALIDPARAM;
+}
+
+/*! @brief Release the objects created by a multicall.
+    @param s The multicall state.
+    @param keepSlot A slot whose object to keep, or PROCSERV_MULTICALL_SLOT_NONE.
+    @param windows Whether to delete the created windows as well as release the created
+                   dataspaces. Windows are deleted first, so any dataspace reference they hold is
+                   given up before the dataspaces themselves are released.
+*/
+static void
+multicall_release(struct multicall_state *s, int keepSlot, bool windows)
+{
+    if (windows) {
+        for (int i = s->current - 1; i >= 0; i--) {
+            struct multicall_slot *slot = &s->slot[i];
+            if (slot->created && slot->type == MULTICALL_SLOT_WINDOW && i != keepSlot) {
+                vs_delete_window(&s->pcb->vspace, ((struct w_window*) slot->obj)->wID);
+            }
+        }
+    }
+    for (int i = s->current - 1; i >= 0; i--) {
+        struct multicall_slot *slot = &s->slot[i];
+        if (slot->created && slot->type == MULTICALL_SLOT_DSPACE && i != keepSlot) {
+            ram_dspace_unref(&procServ.dspaceList, ((struct ram_dspace*) slot->obj)->ID);
+        }
+    }
+}
+
+/*! @brief Handles multicall syscalls.
+
+    Runs the given operations in order, stopping at the first one which fails. On failure the
+    windows and dataspaces created by the call are deleted again. On success, the dataspaces it
+    created are released unless returned, as everything they were set up for holds its own
+    reference to them.
+*/
+seL4_CPtr
+proc_multicall_internal_handler(void *rpc_userptr , seL4_CPtr rpc_cap ,
+                                struct proc_multicall_ops* rpc_ops , uint32_t rpc_nops ,
+                                int rpc_retSlot , struct proc_multicall_results* rpc_results ,
+                                refos_err_t* rpc_errno)
+{
+    struct proc_pcb *pcb = (struct proc_pcb*) rpc_userptr;
+    struct procserv_msg *m = (struct procserv_msg*) pcb->rpcClient.userptr;
+    assert(pcb && pcb->magic == REFOS_PCB_MAGIC);
+
+    struct multicall_state s;
+    memset(&s, 0, sizeof(struct multicall_state));
+    s.pcb = pcb;
+    if (rpc_results) {
+        memset(rpc_results, 0, sizeof(struct proc_multicall_results));
+    }
+
+    if (!rpc_ops || rpc_nops == 0 || rpc_nops > PROCSERV_MULTICALL_MAX_OPS) {
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return 0;
+    }
+    if (rpc_retSlot != PROCSERV_MULTICALL_SLOT_NONE &&
+            (rpc_retSlot < 0 || rpc_retSlot >= (int) rpc_nops)) {
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return 0;
+    }
+
+    /* Retrieve the window or dataspace passed in, if any. */
+    if (!(check_dispatch_caps(m, 0x00000000, 0) || check_dispatch_caps(m, 0x00000001, 1))) {
+        SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+        return 0;
+    }
+    if (seL4_MessageInfo_get_extraCaps(m->message) == 1) {
+        void *obj = NULL;
+        if (dispatcher_badge_window(rpc_cap)) {
+            obj = w_get_window_badge(&procServ.windowList, rpc_cap);
+            s.cap.type = MULTICALL_SLOT_WINDOW;
+        } else if (dispatcher_badge_dspace(rpc_cap)) {
+            obj = ram_dspace_get_badge(&procServ.dspaceList, rpc_cap);
+            s.cap.type = MULTICALL_SLOT_DSPACE;
+        }
+        if (!obj) {
+            SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+            return 0;
+        }
+        s.cap.obj = obj;
+    }
+
+    /* Run the operations. */
+    for (s.current = 0; s.current < rpc_nops; s.current++) {
+        seL4_Word result = 0;
+        int error = multicall_run_op(&s, &rpc_ops->op[s.current], &result);
+        if (error != ESUCCESS) {
+            dvprintf("Warning: multicall operation %u failed (%d).\n", s.current, error);
+            multicall_release(&s, PROCSERV_MULTICALL_SLOT_NONE, true);
+            SET_ERRNO_PTR(rpc_errno, error);
+            return 0;
+        }
+        if (rpc_results) {
+            rpc_results->result[s.current] = result;
+        }
+    }
+
+    /* Find the object to return. */
+    seL4_CPtr ret = 0;
+    if (rpc_retSlot != PROCSERV_MULTICALL_SLOT_NONE) {
+        struct multicall_slot *slot = &s.slot[rpc_retSlot];
+        if (slot->type == MULTICALL_SLOT_WINDOW) {
+            ret = ((struct w_window*) slot->obj)->capability.capPtr;
+        } else if (slot->type == MULTICALL_SLOT_DSPACE) {
+            ret = ((struct ram_dspace*) slot->obj)->capability.capPtr;
+        } else {
+            /* The operation in the return slot did not produce anything to return. */
+            multicall_release(&s, PROCSERV_MULTICALL_SLOT_NONE, true);
+            SET_ERRNO_PTR(rpc_errno, EINVALIDPARAM);
+            return 0;
+        }
+        assert(ret);
+    }
+
+    multicall_release(&s, rpc_retSlot, false);
+    SET_ERRNO_PTR(rpc_errno, ESUCCESS);
+    return ret;
+}
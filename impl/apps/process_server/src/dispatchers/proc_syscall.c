@@ -26,7 +26,8 @@
     to the protocol design document.). The methods here implement the functions in the generated
     header file <refos-rpc/proc_server.h>.
 
-    The memory related process server syscalls resides in mem_syscall.c and mem_syscall.h.
+    The memory related process server syscalls resides in mem_syscall.c and mem_syscall.h, and the
+    multicall syscall in multicall_syscall.c.
 */
 
 /* ---------------------------- Proc Server syscall helper functions ---------------------------- */
@@ -50,9 +51,9 @@ proc_syscall_allocate_endpoint(struct proc_pcb *pcb, kobject_t type)
     vka_object_t endpoint;
     int error = -1;
     if (type == KOBJECT_ENDPOINT) {
-        error = vka_alloc_endpoint(&procServ.vka, &endpoint);
+        error = kcache_alloc(&procServ.kcache, KCACHE_ENDPOINT, &endpoint);
     } else if (type == KOBJECT_NOTIFICATION) {
-        error = vka_alloc_notification(&procServ.vka, &endpoint);
+        error = kcache_alloc(&procServ.kcache, KCACHE_NOTIFICATION, &endpoint);
     } else {
         assert(!"Invalid endpoint type.");
     }
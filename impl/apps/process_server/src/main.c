@@ -120,8 +120,14 @@ proc_server_loop(void)
     struct procserv_msg msg = { .state = s };
 
     while (1) {
+        if (kcache_needs_refill(&s->kcache)) {
+            /* Top up the kernel object caches now, rather than while a client waits on them. */
+            rpc_sv_reply_flush();
+            kcache_refill(&s->kcache);
+        }
+
         dvprintf("procserv blocking for new message...\n");
-        msg.message = seL4_Recv(s->endpoint.cptr, &msg.badge);
+        msg.message = rpc_sv_reply_recv(s->endpoint.cptr, &msg.badge);
         proc_server_handle_message(s, &msg);
         s->faketime++;
     }
@@ -176,6 +182,26 @@ main(void)
         assert(!"RefOS system startup error.");
     }
 
+    // -----> Start RefOS log server.
+    #ifdef CONFIG_APP_LOG_SERVER
+        error = proc_load_direct("selfloader", 245, "fileserv/log_server", PID_NULL, 0x0);
+        if (error) {
+            ROS_WARNING("Procserv could not start log_server.");
+            assert(!"RefOS system startup error.");
+        }
+    #endif
+
+    // -----> Start RefOS block server.
+    #ifdef CONFIG_APP_BLOCK_SERVER
+        error = proc_load_direct("selfloader", 245, "fileserv/block_server", PID_NULL,
+                PROCESS_PERMISSION_DEVICE_IRQ | PROCESS_PERMISSION_DEVICE_MAP |
+                PROCESS_PERMISSION_DEVICE_IOPORT);
+        if (error) {
+            ROS_WARNING("Procserv could not start block_server.");
+            assert(!"RefOS system startup error.");
+        }
+    #endif
+
     // -----> Start initial task.
     if (strlen(CONFIG_REFOS_INIT_TASK) > 0) {
         error = proc_load_direct("selfloader", CONFIG_REFOS_INIT_TASK_PRIO, CONFIG_REFOS_INIT_TASK,
@@ -94,6 +94,7 @@ initialise_allocator(seL4_BootInfo *info, struct procserv_state *s)
 static void
 initialise_modules(struct procserv_state *s)
 {
+    kcache_init(&s->kcache);
     pd_init(&s->PDList);
     pid_init(&s->PIDList);
     w_init(&s->windowList);
@@ -195,6 +196,7 @@ initialise(seL4_BootInfo *info, struct procserv_state *s)
     s->unblockClientFaultPID = PID_NULL;
 
     /* Procserv initialised OK. */
+    kcache_print(&s->kcache);
     dprintf("PROCSERV initialised.\n");
     dprintf("==========================================\n\n");
 }
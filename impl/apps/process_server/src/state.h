@@ -33,6 +33,7 @@
 #include "system/addrspace/pagedir.h"
 #include "system/memserv/window.h"
 #include "system/memserv/dataspace.h"
+#include "system/kobject/kcache.h"
 
 /*! @file
     @brief Global environment struct & helper functions for process server. */
@@ -59,6 +60,7 @@ struct procserv_state {
     cspacepath_t                       IPCCapRecv;
 
     /* Process server global lists. */
+    struct kcache_list                 kcache;
     struct pid_list                    PIDList;
     struct pd_list                     PDList;
     struct w_list                      windowList;
@@ -113,8 +113,8 @@ pd_free(struct pd_list *pdlist, seL4_CPtr pdPtr)
     vka_cnode_delete(&cpath);
     vka_free_object(&procServ.vka, &pdlist->cnode[idx]);
 
-    /* Allocate a new kernel Root CNode object. */
-    int error = vka_alloc_cnode_object(&procServ.vka, REFOS_CSPACE_RADIX, &pdlist->cnode[idx]);
+    /* Take a new kernel Root CNode object from the cache. */
+    int error = kcache_alloc(&procServ.kcache, KCACHE_CNODE, &pdlist->cnode[idx]);
     if (error) {
         ROS_ERROR("Failed to re-allocate Root CNode. error %d\n", error);
         return;
@@ -12,6 +12,7 @@
 #include "../process/process.h"
 #include <autoconf.h>
 #include <refos/refos.h>
+#include <refos-rpc/proc_common.h>
 #include <sel4utils/vspace.h>
 
 /*! @file
@@ -491,6 +492,94 @@ vs_map_across_vspace(struct vs_vspace *vsSrc, vaddr_t vaddrSrc, struct w_window
     return vs_map(&clientPCB->vspace, wa->offset + windowDestOffset, &frameCap, 1);
 }
 
+int
+vs_map_across_vspace_range(struct vs_vspace *vsSrc, vaddr_t vaddrSrc, struct w_window *windowDest,
+                           uint32_t windowDestOffset, int nFrames, int *outNFramesMapped,
+                           struct proc_pcb **outClientPCB)
+{
+    assert(vsSrc && vsSrc->magic == REFOS_VSPACE_MAGIC);
+    assert(windowDest && windowDest->magic == W_MAGIC);
+    assert(outNFramesMapped);
+    int error = EINVALIDPARAM;
+    (*outNFramesMapped) = 0;
+
+    if (nFrames <= 0 || nFrames > PROCSERV_WINDOW_MAP_RANGE_MAX) {
+        return EINVALIDPARAM;
+    }
+
+    /* Verify that the offset is within the window limits. */
+    if (windowDestOffset >= windowDest->size) {
+        ROS_ERROR("invalid window offset address!\n");
+        return EINVALIDPARAM;
+    }
+
+    /* Find the client which this window lives in. */
+    struct proc_pcb *clientPCB = pid_get_pcb(&procServ.PIDList, windowDest->clientOwnerPID);
+    if (!clientPCB) {
+        ROS_ERROR("could not find window's corresponding client.\n");
+        return EINVALIDWINDOW;
+    }
+    if (outClientPCB) {
+        (*outClientPCB) = clientPCB;
+    }
+
+    /* Check that this client actually has its own window mapped. */
+    struct w_associated_window *wa = w_associate_find_winID(&clientPCB->vspace.windows,
+                                                            windowDest->wID);
+    if (!wa) {
+        ROS_ERROR("client did not map its window, so invalid map call.\n");
+        return EINVALIDWINDOW;
+    }
+
+    /* Verify that the last page of the range still starts within the window. */
+    vaddr_t vaddrDest = REFOS_PAGE_ALIGN(wa->offset + windowDestOffset);
+    if (vaddrDest + (nFrames - 1) * REFOS_PAGE_SIZE >= wa->offset + windowDest->size) {
+        ROS_ERROR("invalid window range!\n");
+        return EINVALIDPARAM;
+    }
+
+    seL4_CPtr *frameCaps = malloc(sizeof(seL4_CPtr) * nFrames);
+    if (!frameCaps) {
+        ROS_ERROR("Could not allocate frame array, procserv out of memory.\n");
+        return ENOMEM;
+    }
+
+    /* Find the caps in the source vspace's pagetable. */
+    for (int i = 0; i < nFrames; i++) {
+        frameCaps[i] = vspace_get_cap(&vsSrc->vspace, (void*) (vaddrSrc + i * REFOS_PAGE_SIZE));
+        if (!frameCaps[i]) {
+            dvprintf("vs_map_across_vspace_range could not find source frame.\n");
+            error = EINVALIDPARAM;
+            goto exit1;
+        }
+    }
+
+    /* Only map up to the first page that the client already has mapped. The pager may race
+       with pages being mapped in by another fault, and the remaining frames are left for the
+       pager to reclaim. */
+    int n = 0;
+    for (; n < nFrames; n++) {
+        if (vspace_get_cap(&clientPCB->vspace.vspace,
+                           (void*) (vaddrDest + n * REFOS_PAGE_SIZE))) {
+            break;
+        }
+    }
+    if (n > 0) {
+        error = vs_map(&clientPCB->vspace, vaddrDest, frameCaps, n);
+        if (error) {
+            goto exit1;
+        }
+    }
+
+    (*outNFramesMapped) = n;
+    error = ESUCCESS;
+
+    /* Exit stack. */
+exit1:
+    free(frameCaps);
+    return error;
+}
+
 int
 vs_map_device(struct vs_vspace *vs, struct w_window *window, uint32_t windowOffset,
               uint32_t paddr , uint32_t size, bool cached)
@@ -155,6 +155,23 @@ int vs_map(struct vs_vspace *vs, vaddr_t vaddr, seL4_CPtr frames[], int nFrames)
 int vs_map_across_vspace(struct vs_vspace *vsSrc, vaddr_t vaddrSrc, struct w_window *windowDest,
                          uint32_t windowDestOffset, struct proc_pcb **outClientPCB);
 
+/*! @brief Map a run of consecutive frames that have been mapped into one vspace, into another
+           vspace. Mapping stops at the first destination page which is already mapped.
+    @param vsSrc The source vspace to map from.
+    @param vaddrSrc The vaddr of the first frame in the source vspace to map from.
+    @param windowDest Destination window to map into.
+    @param windowDestOffset Offset into destination window of the first frame.
+    @param nFrames Number of frames in the run. Must be at most
+                   PROCSERV_WINDOW_MAP_RANGE_MAX.
+    @param outNFramesMapped Output number of frames from the start of the run that were mapped.
+    @param outClientPCB Optional destination client PCB which uses this vspace.
+    @return ESUCCESS on success, refos_err_t otherwise.
+*/
+int vs_map_across_vspace_range(struct vs_vspace *vsSrc, vaddr_t vaddrSrc,
+                               struct w_window *windowDest, uint32_t windowDestOffset,
+                               int nFrames, int *outNFramesMapped,
+                               struct proc_pcb **outClientPCB);
+
 /*! @brief Find & map a device frame into client's vspace. 
     @param vs The vspace to map device frame into.
     @param window The window in which to map the device.
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <vka/capops.h>
+#include "kcache.h"
+#include "../../state.h"
+
+/*! @file
+    @brief Kernel object caches for the process server. */
+
+/*! @brief Kernel object cache configuration. */
+static const struct kcache_config {
+    const char *name;
+    seL4_Word objType;
+    seL4_Word sizeBits;
+    int low;
+    int high;
+} kcacheConfig[KCACHE_NUM_TYPES] = {
+    [KCACHE_TCB] = { "TCB", seL4_TCBObject, seL4_TCBBits, 4, 16 },
+    [KCACHE_ENDPOINT] = { "endpoint", seL4_EndpointObject, seL4_EndpointBits, 8, 32 },
+    [KCACHE_NOTIFICATION] = { "notification", seL4_NotificationObject, seL4_NotificationBits,
+                              8, 32 },
+    /* Root CNodes are big, so only keep one spare around for pd_free(). */
+    [KCACHE_CNODE] = { "root CNode", seL4_CapTableObject, REFOS_CSPACE_RADIX, 1, 1 },
+};
+
+/*! @brief Find the cache for objects of the given kernel type and size.
+    @return The cache if found, NULL if objects of this type and size are not cached.
+*/
+static struct kcache *
+kcache_find(struct kcache_list *kl, seL4_Word objType, seL4_Word sizeBits)
+{
+    for (int i = 0; i < KCACHE_NUM_TYPES; i++) {
+        if (kl->cache[i].objType == objType && kl->cache[i].sizeBits == sizeBits) {
+            return &kl->cache[i];
+        }
+    }
+    return NULL;
+}
+
+/*! @brief Take an object off a cache.
+    @return true if an object was taken, false if the cache was empty.
+*/
+static bool
+kcache_pop(struct kcache *c, vka_object_t *obj)
+{
+    if (c->count == 0) {
+        c->misses++;
+        return false;
+    }
+    (*obj) = c->obj[--c->count];
+    c->hits++;
+    return true;
+}
+
+/*! @brief Allocate a new object onto a cache which has room for it.
+    @return ESUCCESS if success, ENOMEM if out of untyped memory.
+*/
+static int
+kcache_grow(struct kcache *c)
+{
+    assert(c->count < c->high);
+    int error = vka_alloc_object(&procServ.vka, c->objType, c->sizeBits, &c->obj[c->count]);
+    if (error || !c->obj[c->count].cptr) {
+        c->starved = true;
+        return ENOMEM;
+    }
+    c->count++;
+    c->refilled++;
+    return ESUCCESS;
+}
+
+/* ------------------------------------- Caching VKA ------------------------------------------- */
+
+static int
+kcache_vka_utspace_alloc_maybe_device(void *data, const cspacepath_t *dest, seL4_Word type,
+                                      seL4_Word sizeBits, bool canBeDev, seL4_Word *cookie)
+{
+    struct kcache *c = kcache_find(&procServ.kcache, type, sizeBits);
+    vka_object_t obj;
+    if (c && kcache_pop(c, &obj)) {
+        /* Move the cached object into the slot the VKA caller allocated, and hand its
+           untyped cookie over, so that the caller frees it like an object of its own. */
+        cspacepath_t src;
+        vka_cspace_make_path(&procServ.vka, obj.cptr, &src);
+        int error = vka_cnode_move(dest, &src);
+        if (!error) {
+            vka_cspace_free(&procServ.vka, obj.cptr);
+            (*cookie) = obj.ut;
+            return 0;
+        }
+        ROS_WARNING("kcache: could not move cached object, error %d.", error);
+        c->obj[c->count++] = obj;
+    }
+    return vka_utspace_alloc_maybe_device(&procServ.vka, dest, type, sizeBits, canBeDev, cookie);
+}
+
+static int
+kcache_vka_utspace_alloc(void *data, const cspacepath_t *dest, seL4_Word type,
+                         seL4_Word sizeBits, seL4_Word *cookie)
+{
+    return kcache_vka_utspace_alloc_maybe_device(data, dest, type, sizeBits, false, cookie);
+}
+
+/* ---------------------------------- Kernel object caches -------------------------------------- */
+
+void
+kcache_init(struct kcache_list *kl)
+{
+    assert(kl);
+    dprintf("Initialising kernel object caches...\n");
+    memset(kl, 0, sizeof(struct kcache_list));
+    kl->magic = KCACHE_MAGIC;
+
+    kl->vka = procServ.vka;
+    kl->vka.utspace_alloc = kcache_vka_utspace_alloc;
+    kl->vka.utspace_alloc_maybe_device = kcache_vka_utspace_alloc_maybe_device;
+
+    for (int i = 0; i < KCACHE_NUM_TYPES; i++) {
+        struct kcache *c = &kl->cache[i];
+        assert(kcacheConfig[i].high <= KCACHE_MAX_OBJECTS);
+        assert(kcacheConfig[i].low <= kcacheConfig[i].high);
+        c->objType = kcacheConfig[i].objType;
+        c->sizeBits = kcacheConfig[i].sizeBits;
+        c->low = kcacheConfig[i].low;
+        c->high = kcacheConfig[i].high;
+        while (c->count < c->high) {
+            if (kcache_grow(c) != ESUCCESS) {
+                ROS_WARNING("kcache_init: could not fill %s cache.", kcacheConfig[i].name);
+                break;
+            }
+        }
+    }
+}
+
+int
+kcache_alloc(struct kcache_list *kl, enum kcache_type type, vka_object_t *obj)
+{
+    assert(kl && kl->magic == KCACHE_MAGIC);
+    assert(type >= 0 && type < KCACHE_NUM_TYPES);
+    assert(obj);
+    struct kcache *c = &kl->cache[type];
+
+    if (kcache_pop(c, obj)) {
+        return ESUCCESS;
+    }
+    int error = vka_alloc_object(&procServ.vka, c->objType, c->sizeBits, obj);
+    if (error || !obj->cptr) {
+        memset(obj, 0, sizeof(vka_object_t));
+        return ENOMEM;
+    }
+    return ESUCCESS;
+}
+
+void
+kcache_free(struct kcache_list *kl, enum kcache_type type, vka_object_t *obj)
+{
+    assert(kl && kl->magic == KCACHE_MAGIC);
+    assert(type >= 0 && type < KCACHE_NUM_TYPES);
+    assert(obj);
+    if (!obj->cptr) {
+        return;
+    }
+    struct kcache *c = &kl->cache[type];
+
+    /* Never put a used object back on its cache; see kcache.h. Revoking first destroys any copies
+       handed out to processes along with it. */
+    cspacepath_t path;
+    vka_cspace_make_path(&procServ.vka, obj->cptr, &path);
+    vka_cnode_revoke(&path);
+    vka_free_object(&procServ.vka, obj);
+    c->released++;
+
+    /* Untyped memory was given back, so it's worth trying to refill again. */
+    for (int i = 0; i < KCACHE_NUM_TYPES; i++) {
+        kl->cache[i].starved = false;
+    }
+    memset(obj, 0, sizeof(vka_object_t));
+}
+
+bool
+kcache_needs_refill(struct kcache_list *kl)
+{
+    assert(kl && kl->magic == KCACHE_MAGIC);
+    for (int i = 0; i < KCACHE_NUM_TYPES; i++) {
+        if (kl->cache[i].count < kl->cache[i].low && !kl->cache[i].starved) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int
+kcache_refill(struct kcache_list *kl)
+{
+    assert(kl && kl->magic == KCACHE_MAGIC);
+    int n = 0;
+    for (int i = 0; i < KCACHE_NUM_TYPES && n < KCACHE_REFILL_BATCH; i++) {
+        struct kcache *c = &kl->cache[i];
+        if (c->count >= c->low || c->starved) {
+            continue;
+        }
+        while (c->count < c->high && n < KCACHE_REFILL_BATCH) {
+            if (kcache_grow(c) != ESUCCESS) {
+                dvprintf("kcache_refill: out of memory refilling %s cache.\n",
+                         kcacheConfig[i].name);
+                break;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+vka_t *
+kcache_vka(struct kcache_list *kl)
+{
+    assert(kl && kl->magic == KCACHE_MAGIC);
+    return &kl->vka;
+}
+
+void
+kcache_print(struct kcache_list *kl)
+{
+    assert(kl && kl->magic == KCACHE_MAGIC);
+    dprintf("Kernel object caches:\n");
+    for (int i = 0; i < KCACHE_NUM_TYPES; i++) {
+        struct kcache *c = &kl->cache[i];
+        dprintf("    %-12s %2d / %2d | hits %u misses %u released %u refilled %u\n",
+                kcacheConfig[i].name, c->count, c->high, c->hits, c->misses, c->released,
+                c->refilled);
+    }
+}
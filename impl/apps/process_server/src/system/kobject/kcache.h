@@ -0,0 +1,122 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief Kernel object caches for the process server.
+
+    Keeps a small stock of ready to use kernel objects of each type the process server creates on
+    behalf of processes (TCBs, endpoints, notifications and root CNodes), so that creating one is
+    usually a matter of popping it off the cache rather than going through the allocman untyped
+    allocator and an Untyped_Retype. The caches are topped up in small batches by kcache_refill(),
+    which the process server main loop calls after it has replied to a client and before it blocks
+    for the next message.
+
+    Released objects are never recycled; they always go back to untyped memory, and the caches
+    only ever hold freshly retyped objects. A released TCB still holds the registers, FPU state and
+    IPC buffer of the thread it ran, which would leak to the next process given it. Endpoints and
+    notifications may still have a thread of another process queued on them, and deleting their
+    last capability is the only way the kernel offers to cancel that. Emptying all the slots of a
+    root CNode costs far more than retyping a new one.
+
+    sel4utils allocates TCBs itself, through the VKA it is given. kcache_vka() returns a VKA
+    interface which hands out cached objects before falling back to the process server allocator,
+    for passing on to sel4utils.
+*/
+
+#ifndef _REFOS_PROCESS_SERVER_SYSTEM_KOBJECT_KCACHE_H_
+#define _REFOS_PROCESS_SERVER_SYSTEM_KOBJECT_KCACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <vka/vka.h>
+#include <vka/object.h>
+#include "../../common.h"
+
+#define KCACHE_MAGIC 0x6C0BCAC4
+#define KCACHE_MAX_OBJECTS 32
+#define KCACHE_REFILL_BATCH 8
+
+/*! @brief Kernel object cache types. */
+enum kcache_type {
+    KCACHE_TCB = 0,
+    KCACHE_ENDPOINT,
+    KCACHE_NOTIFICATION,
+    KCACHE_CNODE,
+    KCACHE_NUM_TYPES
+};
+
+/*! @brief Cache of ready to use kernel objects of a single type and size. */
+struct kcache {
+    seL4_Word objType;
+    seL4_Word sizeBits;
+    int low;  /* Refilled once it holds fewer than this many objects. */
+    int high; /* Refilled up to this many objects, and never holds more. */
+    vka_object_t obj[KCACHE_MAX_OBJECTS]; /* Has ownership. */
+    int count;
+    bool starved; /* The last refill ran out of memory; don't retry until something is freed. */
+
+    /* Statistics. */
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t released;
+    uint32_t refilled;
+};
+
+/*! @brief The set of kernel object caches; one for each type. */
+struct kcache_list {
+    uint32_t magic;
+    struct kcache cache[KCACHE_NUM_TYPES];
+    vka_t vka;
+};
+
+/*! @brief Initialise the kernel object caches, and fill them up. The process server allocator must
+           be initialised first.
+    @param kl The kernel object caches to initialise.
+*/
+void kcache_init(struct kcache_list *kl);
+
+/*! @brief Allocate a kernel object, from its cache if possible.
+    @param kl The kernel object caches.
+    @param type The type of kernel object to allocate.
+    @param obj Output allocated kernel object. (Ownership transferred)
+    @return ESUCCESS if success, ENOMEM if out of untyped memory.
+*/
+int kcache_alloc(struct kcache_list *kl, enum kcache_type type, vka_object_t *obj);
+
+/*! @brief Release a kernel object allocated by kcache_alloc() or through kcache_vka(), revoking
+           any capabilities derived from it and giving it back to untyped memory.
+    @param kl The kernel object caches.
+    @param type The type of the kernel object.
+    @param obj The kernel object to release. (Takes ownership)
+*/
+void kcache_free(struct kcache_list *kl, enum kcache_type type, vka_object_t *obj);
+
+/*! @brief Check whether any cache has dropped below its low watermark.
+    @param kl The kernel object caches.
+    @return true if kcache_refill() has work to do, false otherwise.
+*/
+bool kcache_needs_refill(struct kcache_list *kl);
+
+/*! @brief Top up the caches which have dropped below their low watermark, allocating at most
+           KCACHE_REFILL_BATCH objects.
+    @param kl The kernel object caches.
+    @return The number of kernel objects allocated.
+*/
+int kcache_refill(struct kcache_list *kl);
+
+/*! @brief Get a VKA interface which allocates cached kernel objects from the caches, and anything
+           else from the process server allocator.
+    @param kl The kernel object caches.
+    @return The caching VKA interface. (No ownership)
+*/
+vka_t *kcache_vka(struct kcache_list *kl);
+
+/*! @brief Print the occupancy and statistics of every cache.
+    @param kl The kernel object caches.
+*/
+void kcache_print(struct kcache_list *kl);
+
+#endif /* _REFOS_PROCESS_SERVER_SYSTEM_KOBJECT_KCACHE_H_ */
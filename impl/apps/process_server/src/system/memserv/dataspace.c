@@ -15,12 +15,39 @@
 
 extern seL4_MessageInfo_t _dispatcherEmptyReply;
 
+/*! @brief Delete a content init waiter, and the reply cap it owns. The waiter must already be
+           unlinked from its waiting list. */
+static void
+ram_dspace_waiter_delete(struct ram_dspace *rds, struct ram_dspace_waiter *waiter)
+{
+    assert(waiter && waiter->magic == RAM_DATASPACE_WAITER_MAGIC);
+    assert(waiter->reply.capPtr);
+    vka_cnode_revoke(&waiter->reply);
+    vka_cnode_delete(&waiter->reply);
+    vka_cspace_free(&procServ.vka, waiter->reply.capPtr);
+    waiter->magic = 0;
+    cslab_free(&rds->parentList->waiterCache, waiter);
+}
+
+/*! @brief Delete every content init waiter of a dataspace, without replying to them. */
+static void
+ram_dspace_clear_waiters(struct ram_dspace *rds)
+{
+    for (int i = 0; i < RAM_DATASPACE_WAITER_BUCKETS; i++) {
+        while (!chlist_empty(&rds->contentInitWaiters[i])) {
+            chlist_node_t *n = rds->contentInitWaiters[i].first;
+            chlist_remove(n);
+            ram_dspace_waiter_delete(rds, clist_entry(n, struct ram_dspace_waiter, node));
+        }
+    }
+}
+
 /* --------------------------- RAM dataspace OAT callback functions ----------------------------- */
 
 /*! @brief Dataspace OAT creation callback function.
     
-    This callback function is called by the OAT allocation helper library in <data_struct/coat.h>,
-    in order to create dataspace objects. Here we malloc some memory for the structure, initialise
+    This callback function is called by the object table in "objtable.h", in order to create
+    dataspace objects. Here we malloc some memory for the structure, initialise
     its data structures, initialise its page array, and mint the dataspace badge capability.
 
     @param oat The parent dataspace list (struct ram_dspace_list*).
@@ -28,10 +55,10 @@ extern seL4_MessageInfo_t _dispatcherEmptyReply;
     @param arg Arg[0] is the dataspace size, the rest unused.
     @return A new dataspace (struct ram_dspace *) on success, NULL on error. (Transfers ownership)
 */
-static cvector_item_t
-ram_dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
+static void *
+ram_dspace_oat_create(struct ot_table *oat, int id, uint32_t arg[OT_ARGS])
 {
-    struct ram_dspace *ndspace = malloc(sizeof(struct ram_dspace));
+    struct ram_dspace *ndspace = cslab_alloc(&((struct ram_dspace_list *) oat)->dspaceCache);
     if (!ndspace) {
         ROS_ERROR("ram_dspace_oat_create out of memory!");
         return NULL;
@@ -47,8 +74,10 @@ ram_dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     ndspace->parentList = (struct ram_dspace_list *) oat;
     assert(ndspace->parentList->magic == RAM_DATASPACE_LIST_MAGIC);
 
-    /* Initialise content init list. */
-    cvector_init(&ndspace->contentInitWaitingList);
+    /* Initialise content init waiting lists. */
+    for (int i = 0; i < RAM_DATASPACE_WAITER_BUCKETS; i++) {
+        chlist_init(&ndspace->contentInitWaiters[i]);
+    }
 
     /* Create the page array. */
     ndspace->pages = kmalloc(sizeof(vka_object_t) * ndspace->npages);
@@ -59,26 +88,26 @@ ram_dspace_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     memset(ndspace->pages, 0, sizeof(vka_object_t) * ndspace->npages);
 
     /* Mint the badged capability representing this ram dataspace. */
-    ndspace->capability = procserv_mint_badge(RAM_DATASPACE_BADGE_BASE + id);
+    ndspace->capability = procserv_mint_badge(RAM_DATASPACE_BADGE_BASE + ot_tag(oat, id));
     if (!ndspace->capability.capPtr) {
         ROS_ERROR("ram_dspace_oat_create could not mint cap!");
         goto exit2;
     }
 
-    return (cvector_item_t) ndspace;
+    return (void *) ndspace;
 
     /* Exit stack. */
 exit2:
     assert(ndspace->pages);
-    free(ndspace->pages);
+    kfree(ndspace->pages);
 exit1:
-    free(ndspace);
+    cslab_free(&ndspace->parentList->dspaceCache, ndspace);
     return NULL;
 }
 
 /*! @brief Dataspace OAT deletion callback function.
     
-    This callback function is called by the OAT library defined in <data_struct/coat.h>, in order
+    This callback function is called by the object table in "objtable.h", in order
     to delete dataspace objects created by ram_dspace_oat_create(). It unmaps the dataspace from
     all mapped windows, frees the caps, cslots, frames & frame arrays, and then the structure 
     itself.
@@ -87,7 +116,7 @@ exit1:
     @param obj The dataspace to delete (struct ram_dspace *) (Takes ownership).
 */
 static void
-ram_dspace_oat_delete(coat_t *oat, cvector_item_t *obj)
+ram_dspace_oat_delete(struct ot_table *oat, void *obj)
 {
     struct ram_dspace *rds = (struct ram_dspace *) obj;
     assert(rds);
@@ -125,19 +154,7 @@ ram_dspace_oat_delete(coat_t *oat, cvector_item_t *obj)
     }
 
     /* Clear the content init waiting list. */
-    int waitingListCount = cvector_count(&rds->contentInitWaitingList);
-    for (int i = 0; i < waitingListCount; i++) {
-        struct ram_dspace_waiter *waiter = (struct ram_dspace_waiter *)
-                cvector_get(&rds->contentInitWaitingList, i);
-        assert(waiter && waiter->magic == RAM_DATASPACE_WAITER_MAGIC);
-        assert(waiter->reply.capPtr);
-
-        vka_cnode_revoke(&waiter->reply);
-        vka_cnode_delete(&waiter->reply);
-        vka_cspace_free(&procServ.vka, waiter->reply.capPtr);
-        kfree(waiter);
-    }
-    cvector_free(&rds->contentInitWaitingList);
+    ram_dspace_clear_waiters(rds);
 
     /* Free the pages. */
     assert(rds->pages);
@@ -164,8 +181,8 @@ ram_dspace_oat_delete(coat_t *oat, cvector_item_t *obj)
     vka_cnode_delete(&rds->capability);
     vka_cspace_free(&procServ.vka, rds->capability.capPtr);
 
-    /* Free the actual window structure. */
-    free(rds);
+    /* Free the actual dataspace structure. */
+    cslab_free(&rds->parentList->dspaceCache, rds);
 }
 
 /* ------------------------------- RAM dataspace table functions -------------------------------- */
@@ -188,39 +205,43 @@ ram_dspace_init(struct ram_dspace_list *rdslist)
             RAM_DATASPACE_MAX_NUM_DATASPACE);
 
     /* Configure the object allocation table creation / deletion callback func pointers. */
-    rdslist->allocTable.oat_expand = NULL;
-    rdslist->allocTable.oat_create = ram_dspace_oat_create;
-    rdslist->allocTable.oat_delete = ram_dspace_oat_delete;
+    rdslist->allocTable.ot_create = ram_dspace_oat_create;
+    rdslist->allocTable.ot_delete = ram_dspace_oat_delete;
     rdslist->magic = RAM_DATASPACE_LIST_MAGIC;
 
     /* Initialise the allocation table. */
-    coat_init(&rdslist->allocTable, 1, RAM_DATASPACE_MAX_NUM_DATASPACE);
+    cslab_init(&rdslist->dspaceCache, sizeof(struct ram_dspace), 0, NULL, NULL);
+    cslab_init(&rdslist->waiterCache, sizeof(struct ram_dspace_waiter), 0, NULL, NULL);
+    ot_init(&rdslist->allocTable, RAM_DATASPACE_MAX_NUM_DATASPACE);
 }
 
 void
 ram_dspace_deinit(struct ram_dspace_list *rdslist)
 {
     assert(rdslist);
-    for (int i = 1; i < RAM_DATASPACE_MAX_NUM_DATASPACE; i++) {
+    int idLimit = ot_id_limit(&rdslist->allocTable);
+    for (int i = 1; i < idLimit; i++) {
         struct ram_dspace *dspace = ram_dspace_get(rdslist, i);
         if (dspace) {
             assert(dspace->magic == RAM_DATASPACE_MAGIC);
             dspace->ref--;
         }
     }
-    coat_release(&rdslist->allocTable);
+    ot_release(&rdslist->allocTable);
+    cslab_release(&rdslist->dspaceCache);
+    cslab_release(&rdslist->waiterCache);
 }
 
 struct ram_dspace *
 ram_dspace_create(struct ram_dspace_list *rdslist, size_t size)
 {
     assert(rdslist);
-    uint32_t arg[COAT_ARGS];
+    uint32_t arg[OT_ARGS];
     struct ram_dspace *dspace= NULL;
 
     /* Allocate the dataspace ID and structure. */
     arg[0] = (uint32_t) size;
-    int ID = coat_alloc(&rdslist->allocTable, arg, (cvector_item_t *) &dspace);
+    int ID = ot_alloc(&rdslist->allocTable, arg, (void **) &dspace);
     if (ID == RAM_DATASPACE_INVALID_ID) {
         ROS_ERROR("Could not allocate window.");
         return NULL;
@@ -255,7 +276,7 @@ ram_dspace_unref(struct ram_dspace_list *rdslist, int ID)
     dspace->ref--;
     if (dspace->ref == 0) {
         /* Last reference, delete the object. */
-        coat_free(&rdslist->allocTable, ID);
+        ot_free(&rdslist->allocTable, ID);
     }
 }
       
@@ -310,7 +331,7 @@ ram_dspace_get(struct ram_dspace_list *rdslist, int ID)
         /* Invalid ID. */
         return NULL;
     }
-    struct ram_dspace* dspace = (struct ram_dspace*) coat_get(&rdslist->allocTable, ID);
+    struct ram_dspace* dspace = (struct ram_dspace*) ot_get(&rdslist->allocTable, ID);
     if (!dspace) {
         return NULL;
     }
@@ -321,7 +342,17 @@ ram_dspace_get(struct ram_dspace_list *rdslist, int ID)
 struct ram_dspace *
 ram_dspace_get_badge(struct ram_dspace_list *rdslist, seL4_Word badge)
 {
-    return ram_dspace_get(rdslist, badge - RAM_DATASPACE_BADGE_BASE);
+    if (badge < RAM_DATASPACE_BADGE_BASE || badge >= RAM_DATASPACE_BADGE_END) {
+        return NULL;
+    }
+    struct ram_dspace* dspace = (struct ram_dspace*)
+            ot_get_tagged(&rdslist->allocTable, badge - RAM_DATASPACE_BADGE_BASE);
+    if (!dspace) {
+        /* No such dataspace, or a stale badge of a deleted dataspace. */
+        return NULL;
+    }
+    assert(dspace->magic == RAM_DATASPACE_MAGIC);
+    return dspace;
 }
 
 uint32_t
@@ -540,6 +571,86 @@ ram_dspace_write(char *buf, size_t len, struct ram_dspace *dataspace, uint32_t o
     return ESUCCESS;
 }
 
+int
+ram_dspace_map_local(struct ram_dspace *dataspace, uint32_t size, struct ram_dspace_local_map *m)
+{
+    assert(dataspace && dataspace->magic == RAM_DATASPACE_MAGIC);
+    assert(m);
+    memset(m, 0, sizeof(struct ram_dspace_local_map));
+    if (dataspace->physicalAddrEnabled) {
+        return EINVALIDPARAM;
+    }
+
+    int npages = MIN((int) dataspace->npages, (size + REFOS_PAGE_SIZE - 1) / REFOS_PAGE_SIZE);
+    if (npages <= 0) {
+        return EINVALIDPARAM;
+    }
+    m->frames = kmalloc(sizeof(seL4_CPtr) * npages);
+    if (!m->frames) {
+        return ENOMEM;
+    }
+
+    /* Copy the frame caps, allocating pages as needed. */
+    int error = ESUCCESS;
+    for (m->npages = 0; m->npages < npages; m->npages++) {
+        seL4_CPtr frame = ram_dspace_get_page(dataspace, m->npages * REFOS_PAGE_SIZE);
+        if (!frame) {
+            error = ENOMEM;
+            goto exit1;
+        }
+        cspacepath_t src, dest;
+        vka_cspace_make_path(&procServ.vka, frame, &src);
+        error = vka_cspace_alloc_path(&procServ.vka, &dest);
+        if (error || !dest.capPtr) {
+            error = ENOMEM;
+            goto exit1;
+        }
+        error = vka_cnode_copy(&dest, &src, seL4_AllRights);
+        if (error) {
+            vka_cspace_free(&procServ.vka, dest.capPtr);
+            error = ENOMEM;
+            goto exit1;
+        }
+        m->frames[m->npages] = dest.capPtr;
+    }
+
+    /* Map the copies. */
+    m->vaddr = (char*) vspace_map_pages(&procServ.vspace, m->frames, NULL, seL4_AllRights,
+                                        m->npages, seL4_PageBits, true);
+    if (!m->vaddr) {
+        ROS_ERROR("ram_dspace_map_local couldn't map frames.");
+        error = ENOMEM;
+        goto exit1;
+    }
+    m->size = MIN(size, m->npages * REFOS_PAGE_SIZE);
+    return ESUCCESS;
+
+    /* Exit stack. */
+exit1:
+    ram_dspace_unmap_local(m);
+    return error;
+}
+
+void
+ram_dspace_unmap_local(struct ram_dspace_local_map *m)
+{
+    assert(m);
+    if (m->vaddr) {
+        vspace_unmap_pages(&procServ.vspace, m->vaddr, m->npages, seL4_PageBits,
+                           VSPACE_PRESERVE);
+    }
+    for (int i = 0; i < m->npages; i++) {
+        cspacepath_t path;
+        vka_cspace_make_path(&procServ.vka, m->frames[i], &path);
+        vka_cnode_delete(&path);
+        vka_cspace_free(&procServ.vka, m->frames[i]);
+    }
+    if (m->frames) {
+        kfree(m->frames);
+    }
+    memset(m, 0, sizeof(struct ram_dspace_local_map));
+}
+
 /* --------------------------- RAM dataspace content init functions ----------------------------- */
 
 int
@@ -585,20 +696,7 @@ ram_dspace_content_init(struct ram_dspace *dataspace, cspacepath_t initEP, uint3
     memset(dataspace->contentInitBitmask, 0, nbitmask * sizeof(uint32_t));
 
     /* Clear the waiting list. */
-    int waitingListCount = cvector_count(&dataspace->contentInitWaitingList);
-    for (int i = 0; i < waitingListCount; i++) {
-        struct ram_dspace_waiter *waiter = (struct ram_dspace_waiter *)
-                cvector_get(&dataspace->contentInitWaitingList, i);
-        assert(waiter && waiter->magic == RAM_DATASPACE_WAITER_MAGIC);
-        assert(waiter->reply.capPtr);
-
-        vka_cnode_revoke(&waiter->reply);
-        vka_cnode_delete(&waiter->reply);
-        vka_cspace_free(&procServ.vka, waiter->reply.capPtr);
-        kfree(waiter);
-    }
-    cvector_free(&dataspace->contentInitWaitingList);
-    cvector_init(&dataspace->contentInitWaitingList);
+    ram_dspace_clear_waiters(dataspace);
 
     /* Set the content EP, taking ownership of given endpoint. */
     dataspace->contentInitEP = initEP;
@@ -647,7 +745,7 @@ ram_dspace_add_content_init_waiter(struct ram_dspace *dataspace, uint32_t offset
     assert(npage < dataspace->npages);
 
     /* Allocate the waiter structure. */
-    struct ram_dspace_waiter* waiter = kmalloc(sizeof(struct ram_dspace_waiter));
+    struct ram_dspace_waiter* waiter = cslab_alloc(&dataspace->parentList->waiterCache);
     if (!waiter) {
         ROS_ERROR("add_content_init_waiter could not malloc waiter struct. Procserv OOM.");
         return ENOMEM;
@@ -657,7 +755,9 @@ ram_dspace_add_content_init_waiter(struct ram_dspace *dataspace, uint32_t offset
     waiter->magic = RAM_DATASPACE_WAITER_MAGIC;
     waiter->pageidx = npage;
     waiter->reply = reply;
-    cvector_add(&dataspace->contentInitWaitingList, (cvector_item_t) waiter);
+    chlist_node_init(&waiter->node);
+    chlist_add_head(&dataspace->contentInitWaiters[npage % RAM_DATASPACE_WAITER_BUCKETS],
+                    &waiter->node);
     return ESUCCESS;
 }
 
@@ -698,30 +798,20 @@ ram_dspace_content_init_reply_waiters(struct ram_dspace *dataspace, uint32_t off
         return;
     }
 
-    /* Loop through the waiting list, find any clients that are currently blocked on the page
-       we have data for, and reply to them. */
-    int waitingListCount = cvector_count(&dataspace->contentInitWaitingList);
-    for (int i = 0; i < waitingListCount; i++) {
-        struct ram_dspace_waiter *waiter = (struct ram_dspace_waiter *)
-                cvector_get(&dataspace->contentInitWaitingList, i);
-        assert(waiter && waiter->magic == RAM_DATASPACE_WAITER_MAGIC);
+    /* Loop through the waiting list bucket of this page, find any clients that are currently
+       blocked on the page we have data for, and reply to them. */
+    chlist_node_t *n, *tmp;
+    chlist_foreach_safe(&dataspace->contentInitWaiters[npage % RAM_DATASPACE_WAITER_BUCKETS],
+                        n, tmp) {
+        struct ram_dspace_waiter *waiter = clist_entry(n, struct ram_dspace_waiter, node);
+        assert(waiter->magic == RAM_DATASPACE_WAITER_MAGIC);
         assert(waiter->reply.capPtr);
 
         if (waiter->pageidx == npage) {
-            /* Unblock this client. */
+            /* Unblock this client, then remove and delete the waiter. */
             seL4_Send(waiter->reply.capPtr, _dispatcherEmptyReply);
-
-            /* Remove this waiter from the waiting list. */
-            cvector_delete(&dataspace->contentInitWaitingList, i);
-            waitingListCount--;
-            assert(waitingListCount == cvector_count(&dataspace->contentInitWaitingList));
-            i--;
-
-            /* Delete this waiter. */
-            vka_cnode_revoke(&waiter->reply);
-            vka_cnode_delete(&waiter->reply);
-            vka_cspace_free(&procServ.vka, waiter->reply.capPtr);
-            kfree(waiter);
+            chlist_remove(n);
+            ram_dspace_waiter_delete(dataspace, waiter);
         }
     }
 }
@@ -20,14 +20,17 @@
 #include <stdbool.h>
 #include <sel4/sel4.h>
 #include <data_struct/cvector.h>
-#include <data_struct/coat.h>
+#include <data_struct/cslab.h>
+#include <data_struct/clist.h>
 #include <vspace/vspace.h>
 #include "../../common.h"
+#include "objtable.h"
 
 #define RAM_DATASPACE_MAGIC 0xF89D8531 
 #define RAM_DATASPACE_LIST_MAGIC 0xC923BE76
 #define RAM_DATASPACE_WAITER_MAGIC 0x351095BC
 #define RAM_DATASPACE_INVALID_ID 0
+#define RAM_DATASPACE_WAITER_BUCKETS 16
 
 struct ram_dspace_list;
 
@@ -51,7 +54,8 @@ struct ram_dspace {
     cspacepath_t contentInitEP;
     uint32_t contentInitPID; /* No ownership. */
     uint32_t *contentInitBitmask;
-    cvector_t contentInitWaitingList; /* ram_dspace_waiter */
+    /* Content init waiters (struct ram_dspace_waiter), hashed by page index. */
+    chlist_t contentInitWaiters[RAM_DATASPACE_WAITER_BUCKETS];
 
     /* Physical device state. */
     bool physicalAddrEnabled;
@@ -63,7 +67,9 @@ struct ram_dspace {
 
 /*! @brief Ram dataspace list. */
 struct ram_dspace_list {
-    coat_t allocTable; /* struct ram_dspace */
+    struct ot_table allocTable; /* struct ram_dspace */
+    cslab_t dspaceCache; /* struct ram_dspace */
+    cslab_t waiterCache; /* struct ram_dspace_waiter */
     uint32_t magic;
 };
 
@@ -72,6 +78,15 @@ struct ram_dspace_waiter {
     int pageidx;
     cspacepath_t reply;
     uint32_t magic;
+    chlist_node_t node; /* ram_dspace.contentInitWaiters */
+};
+
+/*! @brief The start of a RAM dataspace, mapped into the process server's own vspace. */
+struct ram_dspace_local_map {
+    char *vaddr; /* NULL if not mapped. */
+    uint32_t size;
+    int npages;
+    seL4_CPtr *frames; /* Has ownership of the array, and of the frame cap copies in it. */
 };
 
 /* ------------------------------- RAM dataspace table functions -------------------------------- */
@@ -128,7 +143,8 @@ struct ram_dspace *ram_dspace_get(struct ram_dspace_list *rdslist, int ID);
 /*! @brief Finds a ram dataspace in a ram dataspace list by a dataspace badge.
     @param rdslist The source list of ram dataspaces. (No ownership)
     @param badge The dataspace badge to locate the ram dataspace in the list.
-    @return The (weak) reference to target ram dataspace if found, NULL otherwise.
+    @return The (weak) reference to target ram dataspace if found, NULL otherwise. Badges of deleted
+            dataspaces do not resolve, even if their ID has since been reused.
  */
 struct ram_dspace *ram_dspace_get_badge(struct ram_dspace_list *rdslist, seL4_Word badge);
 
@@ -179,6 +195,29 @@ int ram_dspace_read(char *buf, size_t len, struct ram_dspace *dataspace, uint32_
  */
 int ram_dspace_write(char *buf, size_t len, struct ram_dspace *dataspace, uint32_t offset);
 
+/*! @brief Map the start of a RAM dataspace into the process server's own vspace, so that its
+           contents may be accessed in place instead of through ram_dspace_read().
+
+    Copies of the dataspace's frame caps are mapped, so the dataspace's own frames may still be
+    mapped into clients and read / written through ram_dspace_read() / ram_dspace_write(). Pages
+    which have not been allocated yet are allocated. Physical address dataspaces are not supported.
+    The mapping does not follow later expansion of the dataspace. The contents may change
+    underneath the process server at any time if the dataspace is mapped into a client.
+
+    @param dataspace The RAM dataspace to map. (No ownership)
+    @param size The number of bytes from the start of the dataspace to map. Capped to the size of
+                the dataspace.
+    @param m Output mapping structure. (No ownership)
+    @return ESUCCESS if success, refos_error otherwise.
+ */
+int ram_dspace_map_local(struct ram_dspace *dataspace, uint32_t size,
+                         struct ram_dspace_local_map *m);
+
+/*! @brief Unmap a mapping made by ram_dspace_map_local(). Does nothing if not mapped.
+    @param m The mapping to release. (No ownership)
+ */
+void ram_dspace_unmap_local(struct ram_dspace_local_map *m);
+
 /* --------------------------- RAM dataspace content init functions ----------------------------- */
 
 /*! @brief Sets the RAM dataspace to be initialised by another RAM dataspace.
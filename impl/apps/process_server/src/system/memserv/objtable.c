@@ -0,0 +1,162 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+#include <refos/error.h>
+#include "objtable.h"
+#include "../../common.h"
+
+/*! @file
+    @brief Dynamically growing object ID table for badged process server objects. */
+
+/*! @brief Get the entry of an ID, optionally allocating its chunk.
+    @param t The table.
+    @param id The ID.
+    @param create Whether to allocate the chunk holding the entry if it does not exist yet.
+    @return The entry if found, NULL if the ID is out of range or its chunk is not allocated (or
+            could not be allocated). (No ownership)
+*/
+static struct ot_entry *
+ot_entry_get(struct ot_table *t, int id, bool create)
+{
+    assert(t && t->magic == OT_MAGIC);
+    if (id <= OT_INVALID_ID || id >= t->maxID) {
+        return NULL;
+    }
+    struct ot_entry **chunk = &t->chunks[id >> OT_CHUNK_BITS];
+    if (!(*chunk)) {
+        if (!create) {
+            return NULL;
+        }
+        (*chunk) = kmalloc(sizeof(struct ot_entry) * OT_CHUNK_SIZE);
+        if (!(*chunk)) {
+            ROS_ERROR("ot_entry_get could not allocate chunk. Procserv out of memory.");
+            return NULL;
+        }
+        memset((*chunk), 0, sizeof(struct ot_entry) * OT_CHUNK_SIZE);
+    }
+    return &(*chunk)[id & (OT_CHUNK_SIZE - 1)];
+}
+
+void
+ot_init(struct ot_table *t, int maxID)
+{
+    assert(t);
+    assert(maxID > 1 && maxID <= (1 << OT_ID_BITS));
+    memset(t->chunks, 0, sizeof(t->chunks));
+    cpool_init(&t->pool, 1, maxID - 1);
+    t->maxID = maxID;
+    t->idLimit = 1;
+    t->magic = OT_MAGIC;
+}
+
+void
+ot_release(struct ot_table *t)
+{
+    assert(t && t->magic == OT_MAGIC);
+    for (int i = 0; i < OT_MAX_CHUNKS; i++) {
+        if (!t->chunks[i]) {
+            continue;
+        }
+        for (int j = 0; j < OT_CHUNK_SIZE; j++) {
+            if (t->chunks[i][j].obj && t->ot_delete) {
+                t->ot_delete(t, t->chunks[i][j].obj);
+            }
+        }
+        kfree(t->chunks[i]);
+        t->chunks[i] = NULL;
+    }
+    cpool_release(&t->pool);
+    t->magic = 0;
+}
+
+int
+ot_alloc(struct ot_table *t, uint32_t arg[OT_ARGS], void **outObj)
+{
+    assert(t && t->magic == OT_MAGIC);
+
+    /* Allocate new ID. */
+    int id = (int) cpool_alloc(&t->pool);
+    if (id == OT_INVALID_ID || id >= t->maxID) {
+        return OT_INVALID_ID;
+    }
+    struct ot_entry *e = ot_entry_get(t, id, true);
+    if (!e) {
+        goto exit1;
+    }
+    assert(!e->obj);
+    if (id >= t->idLimit) {
+        t->idLimit = id + 1;
+    }
+
+    /* Create the object. Its creation callback may already use ot_tag() on the ID. */
+    void *obj = NULL;
+    if (t->ot_create) {
+        obj = t->ot_create(t, id, arg);
+        if (!obj) {
+            goto exit1;
+        }
+    }
+    e->obj = obj;
+    if (outObj) {
+        (*outObj) = obj;
+    }
+    return id;
+
+    /* Exit stack. */
+exit1:
+    cpool_free(&t->pool, id);
+    return OT_INVALID_ID;
+}
+
+int
+ot_free(struct ot_table *t, int id)
+{
+    struct ot_entry *e = ot_entry_get(t, id, false);
+    if (!e || !e->obj) {
+        return EINVALIDPARAM;
+    }
+    void *obj = e->obj;
+    if (t->ot_delete) {
+        t->ot_delete(t, obj);
+    }
+    e->obj = NULL;
+    e->generation = (e->generation + 1) & OT_GEN_MASK;
+    cpool_free(&t->pool, id);
+    return ESUCCESS;
+}
+
+void *
+ot_get(struct ot_table *t, int id)
+{
+    struct ot_entry *e = ot_entry_get(t, id, false);
+    return e ? e->obj : NULL;
+}
+
+uint32_t
+ot_tag(struct ot_table *t, int id)
+{
+    struct ot_entry *e = ot_entry_get(t, id, false);
+    assert(e);
+    return ((e->generation & OT_GEN_MASK) << OT_ID_BITS) | ((uint32_t) id & OT_ID_MASK);
+}
+
+void *
+ot_get_tagged(struct ot_table *t, uint32_t tag)
+{
+    struct ot_entry *e = ot_entry_get(t, tag & OT_ID_MASK, false);
+    if (!e || e->generation != ((tag >> OT_ID_BITS) & OT_GEN_MASK)) {
+        return NULL;
+    }
+    return e->obj;
+}
+
+int
+ot_id_limit(struct ot_table *t)
+{
+    assert(t && t->magic == OT_MAGIC);
+    return t->idLimit;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief Dynamically growing object ID table for badged process server objects.
+
+    Allocates IDs for process server objects which clients name by badged capabilities, such as
+    windows and RAM dataspaces, and maps those IDs to the objects. The table is two-level: a fixed
+    directory of pointers to chunks of OT_CHUNK_SIZE entries. Chunks are allocated when an ID in
+    them is first handed out, and are never moved; growing the table never copies or relocates
+    anything, and its memory use follows the highest ID in use rather than the size of the ID
+    space.
+
+    Every entry keeps a generation counter, bumped each time its ID is freed. ot_tag() combines an
+    ID with its current generation for use in the object's badge; ot_get_tagged() then only
+    resolves tags of the current generation, so that a badge of a deleted object (eg. one in a
+    message which was already queued when the object went away) does not resolve to a new object
+    which has since reused its ID.
+
+    The creation / deletion callbacks follow <data_struct/coat.h>, so a table may be embedded as
+    the first member of a parent list structure, and the parent found by casting the table pointer
+    passed to the callbacks.
+*/
+
+#ifndef _REFOS_PROCESS_SERVER_SYSTEM_MEMSERV_OBJECT_TABLE_H_
+#define _REFOS_PROCESS_SERVER_SYSTEM_MEMSERV_OBJECT_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <data_struct/cpool.h>
+#include "../../badge.h"
+
+#define OT_INVALID_ID 0
+#define OT_ARGS 4
+#define OT_MAGIC 0x0B7AB1E5
+
+#define OT_ID_BITS PROCSERV_OBJ_ID_BITS
+#define OT_GEN_BITS PROCSERV_OBJ_GEN_BITS
+#define OT_ID_MASK ((1 << OT_ID_BITS) - 1)
+#define OT_GEN_MASK ((1 << OT_GEN_BITS) - 1)
+
+#define OT_CHUNK_BITS 8
+#define OT_CHUNK_SIZE (1 << OT_CHUNK_BITS)
+#define OT_MAX_CHUNKS (1 << (OT_ID_BITS - OT_CHUNK_BITS))
+
+struct ot_table;
+
+/*! @brief Object table entry. */
+struct ot_entry {
+    void *obj;
+    uint32_t generation;
+};
+
+/*! @brief Object table. */
+struct ot_table {
+    /* Config. */
+    void* (*ot_create)(struct ot_table *t, int id, uint32_t arg[OT_ARGS]);
+    void (*ot_delete)(struct ot_table *t, void *obj);
+
+    /* Members. */
+    struct ot_entry *chunks[OT_MAX_CHUNKS]; /* Has ownership. NULL until first used. */
+    cpool_t pool;
+    int maxID;
+    int idLimit; /* One past the highest ID ever allocated. */
+    uint32_t magic;
+};
+
+/*! @brief Initialise an empty object table. The ot_create and ot_delete callbacks should be set
+           before allocating anything from the table.
+    @param t The table to initialise.
+    @param maxID IDs are allocated from 1 to maxID - 1. Must be at most 1 << OT_ID_BITS.
+*/
+void ot_init(struct ot_table *t, int maxID);
+
+/*! @brief Release an object table, deleting every object left in it.
+    @param t The table to release.
+*/
+void ot_release(struct ot_table *t);
+
+/*! @brief Allocate an ID and create an object for it, using the ot_create callback.
+    @param t The table to allocate from.
+    @param arg Arguments passed on to the ot_create callback.
+    @param outObj Optional output created object. (No ownership)
+    @return The allocated ID if success, OT_INVALID_ID if out of IDs or memory.
+*/
+int ot_alloc(struct ot_table *t, uint32_t arg[OT_ARGS], void **outObj);
+
+/*! @brief Delete an object using the ot_delete callback, and free its ID.
+    @param t The table to free from.
+    @param id The ID of the object to delete.
+    @return ESUCCESS if success, EINVALIDPARAM if there is no such object.
+*/
+int ot_free(struct ot_table *t, int id);
+
+/*! @brief Get the object with the given ID.
+    @param t The table.
+    @param id The object ID.
+    @return The object if found, NULL otherwise. (No ownership)
+*/
+void *ot_get(struct ot_table *t, int id);
+
+/*! @brief Get the generation tagged ID of an allocated ID, for use in its object's badge.
+    @param t The table.
+    @param id The object ID.
+    @return The ID, with its current generation in the OT_GEN_BITS bits above it.
+*/
+uint32_t ot_tag(struct ot_table *t, int id);
+
+/*! @brief Get the object with the given generation tagged ID.
+    @param t The table.
+    @param tag The generation tagged ID, as given by ot_tag().
+    @return The object if found and the generation matches, NULL otherwise. (No ownership)
+*/
+void *ot_get_tagged(struct ot_table *t, uint32_t tag);
+
+/*! @brief Get an upper bound on the IDs currently allocated, for iterating over the table.
+    @param t The table.
+    @return One past the highest ID ever allocated from the table.
+*/
+int ot_id_limit(struct ot_table *t);
+
+#endif /* _REFOS_PROCESS_SERVER_SYSTEM_MEMSERV_OBJECT_TABLE_H_ */
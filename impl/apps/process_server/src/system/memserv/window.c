@@ -50,6 +50,7 @@ window_switch_mode(struct w_window* window, enum w_window_mode mode)
         ram_dspace_unref(window->ramDataspace->parentList, window->ramDataspace->ID);
         window->ramDataspace = NULL;
         window->ramDataspaceOffset = (vaddr_t) 0;
+        window->ramDataspaceOwned = false;
     }
 
     if (window->mode != W_MODE_EMPTY) {
@@ -68,13 +69,13 @@ window_switch_mode(struct w_window* window, enum w_window_mode mode)
 
 /*! @brief Window OAT creation callback function.
     
-    This callback function is called by the OAT allocation helper library in <data_struct/coat.h>,
-    in order to create window objects.
+    This callback function is called by the object table in "objtable.h", in order to create
+    window objects.
 */    
-static cvector_item_t
-window_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
+static void *
+window_oat_create(struct ot_table *oat, int id, uint32_t arg[OT_ARGS])
 {
-    struct w_window *nw = kmalloc(sizeof(struct w_window));
+    struct w_window *nw = cslab_alloc(&((struct w_list *) oat)->windowCache);
     if (!nw) {
         ROS_ERROR("window_oat_create out of memory!");
         return NULL;
@@ -87,22 +88,22 @@ window_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     assert(nw->parentList->magic == W_LIST_MAGIC);
 
     /* Mint the badged capability representing this window. */
-    nw->capability = procserv_mint_badge(W_BADGE_BASE + id);
+    nw->capability = procserv_mint_badge(W_BADGE_BASE + ot_tag(oat, id));
     if (!nw->capability.capPtr) {
         ROS_ERROR("window_oat_create could not mint cap!");
-        free(nw);
+        cslab_free(&nw->parentList->windowCache, nw);
         return NULL;
     }
-    return (cvector_item_t) nw;
+    return (void *) nw;
 }
 
 /*! @brief Window OAT deletion callback function.
     
-    This callback function is called by the OAT allocation helper library in <data_struct/coat.h>,
-    in order to delete window objects previously created by window_oat_create().
+    This callback function is called by the object table in "objtable.h", in order to delete
+    window objects previously created by window_oat_create().
 */  
 static void
-window_oat_delete(coat_t *oat, cvector_item_t *obj)
+window_oat_delete(struct ot_table *oat, void *obj)
 {
     struct w_window *window = (struct w_window *) obj;
     assert(window);
@@ -127,7 +128,7 @@ window_oat_delete(coat_t *oat, cvector_item_t *obj)
 
     /* Free the actual window structure. */
     memset(window, 0, sizeof(struct w_window));
-    kfree(window);
+    cslab_free(&((struct w_list *) oat)->windowCache, window);
 }
 
 /* --------------------------------------- Window functions ------------------------------------- */
@@ -139,20 +140,21 @@ w_init(struct w_list *wlist)
     dprintf("Initialising window allocation table (max %d windows).\n", W_MAX_WINDOWS);
 
     /* Configure the object allocation table creation / deletion callback func pointers. */
-    wlist->windows.oat_expand = NULL;
-    wlist->windows.oat_create = window_oat_create;
-    wlist->windows.oat_delete = window_oat_delete;
+    wlist->windows.ot_create = window_oat_create;
+    wlist->windows.ot_delete = window_oat_delete;
     wlist->magic = W_LIST_MAGIC;
 
     /* Initialise the allocation table. */
-    coat_init(&wlist->windows, 1, W_MAX_WINDOWS);
+    cslab_init(&wlist->windowCache, sizeof(struct w_window), 0, NULL, NULL);
+    ot_init(&wlist->windows, W_MAX_WINDOWS);
 }
 
 void
 w_deinit(struct w_list *wlist)
 {
     assert(wlist);
-    coat_release(&wlist->windows);
+    ot_release(&wlist->windows);
+    cslab_release(&wlist->windowCache);
 }
 
 struct w_window*
@@ -160,11 +162,11 @@ w_create_window(struct w_list *wlist, vaddr_t size, int ownerPID, seL4_Word perm
     vspace_t *vspace, reservation_t reservation, bool cacheable)
 {
     assert(wlist);
-    uint32_t arg[COAT_ARGS];
+    uint32_t arg[OT_ARGS];
     struct w_window* w = NULL;
 
     /* Allocate the window ID. */
-    int ID = coat_alloc(&wlist->windows, arg, (cvector_item_t *) &w);
+    int ID = ot_alloc(&wlist->windows, arg, (void **) &w);
     if (ID == W_INVALID_WINID) {
         ROS_ERROR("Could not allocate window.");
         return NULL;
@@ -185,7 +187,7 @@ w_create_window(struct w_list *wlist, vaddr_t size, int ownerPID, seL4_Word perm
 int
 w_delete_window(struct w_list *wlist, int windowID)
 {
-    coat_free(&wlist->windows, windowID);
+    ot_free(&wlist->windows, windowID);
     return ESUCCESS;
 }
 
@@ -196,7 +198,7 @@ w_get_window(struct w_list *wlist, int windowID)
         /* Invalid ID. */
         return NULL;
     }
-    struct w_window* window = (struct w_window*) coat_get(&wlist->windows, windowID);
+    struct w_window* window = (struct w_window*) ot_get(&wlist->windows, windowID);
     if (!window) {
         /* No such window ID exists. */
         return NULL;
@@ -205,6 +207,22 @@ w_get_window(struct w_list *wlist, int windowID)
     return window;
 }
 
+struct w_window*
+w_get_window_badge(struct w_list *wlist, seL4_Word badge)
+{
+    if (badge < W_BADGE_BASE || badge >= W_BADGE_END) {
+        return NULL;
+    }
+    struct w_window* window = (struct w_window*) ot_get_tagged(&wlist->windows,
+                                                               badge - W_BADGE_BASE);
+    if (!window) {
+        /* No such window, or a stale badge of a deleted window. */
+        return NULL;
+    }
+    assert(window->magic == W_MAGIC);
+    return window;
+}
+
 void
 w_set_pager_endpoint(struct w_window *window, cspacepath_t endpoint, uint32_t pid)
 {
@@ -237,7 +255,8 @@ void
 w_purge_dspace(struct w_list *wlist, struct ram_dspace *dspace)
 {
     assert(wlist);
-    for (int i = 1; i < W_MAX_WINDOWS; i++) {
+    int idLimit = ot_id_limit(&wlist->windows);
+    for (int i = 1; i < idLimit; i++) {
         struct w_window *window = w_get_window(wlist, i);
 
         if (window && window->ramDataspace) {
@@ -33,9 +33,10 @@
 #include <stdbool.h>
 #include <sel4/sel4.h>
 #include <data_struct/cvector.h>
-#include <data_struct/coat.h>
+#include <data_struct/cslab.h>
 #include <vspace/vspace.h>
 #include "../../common.h"
+#include "objtable.h"
 
 #define W_INVALID_WINID 0
 #define W_MAGIC 0x02B16401
@@ -93,15 +94,19 @@ struct w_window {
     /*! Ram dataspace. Shared ownership. Valid only if mode is W_MODE_ANONYMOUS */
     struct ram_dspace *ramDataspace;
     vaddr_t ramDataspaceOffset;
+
+    /*! True if the ram dataspace was created along with this window, and so grows with it. */
+    bool ramDataspaceOwned;
 };
 
 /*! @brief Window list.
 
     A window list structure that stores and amanges allocation for a window list. Keeps a
-    dynamic object allocation table of windows.
+    dynamic object table of windows, which grows as windows are allocated.
  */
 struct w_list {
-    coat_t windows; /* struct w_window* */
+    struct ot_table windows; /* struct w_window* */
+    cslab_t windowCache; /* struct w_window */
     uint32_t magic;
 };
 
@@ -167,6 +172,14 @@ int w_delete_window(struct w_list *wlist, int windowID);
  */
 struct w_window* w_get_window(struct w_list *wlist, int windowID);
 
+/*! @brief Retrieve the window structure represented by a window capability badge. Badges of
+           deleted windows do not resolve, even if their windowID has since been reused.
+    @param wlist The window list to find the window in.
+    @param badge The window badge.
+    @return The corresponding window structure if success, NULL otherwise.
+ */
+struct w_window* w_get_window_badge(struct w_list *wlist, seL4_Word badge);
+
 /*! @brief Helper function to convert window permission to seL4 capRights.
     @param permission Window permission bitmask.
     @return corresponding seL4_CapRights to given window permission bitmask.
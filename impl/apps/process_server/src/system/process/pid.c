@@ -6,12 +6,14 @@
 
 #include "pid.h"
 #include "process.h"
+#include "thread.h"
 
 /*! @file
     @brief Process server PID allocation.
 
-    Simple PID / ASID allocation module. Uses simple free-list based allocation defined in
-    <data_struct/cpool.h>. The PID module owns the PCBs it contains.
+    Simple PID / ASID allocation module. Uses the bitmap based ID allocation defined in
+    <data_struct/cpool.h>. The PID module owns the PCBs it contains, and keeps the slab caches
+    which PCBs and process thread structures are allocated from.
 */
 
 #define PID_START 1
@@ -23,6 +25,8 @@ pid_init(struct pid_list *p)
     assert(p);
     cpool_init(&p->pids, PID_START, PID_MAX);
     memset(p->pcbs, 0, sizeof(struct proc_pcb*) * PID_MAX);
+    cslab_init(&p->pcbCache, sizeof(struct proc_pcb), 0, NULL, NULL);
+    cslab_init(&p->threadCache, sizeof(struct proc_tcb), 0, NULL, NULL);
 }
 
 uint32_t
@@ -39,7 +43,7 @@ pid_alloc(struct pid_list *p)
     assert(p->pcbs[pid] == NULL);
 
     /* Allocate new PCB for this pID. */
-    p->pcbs[pid] = kmalloc(sizeof(struct proc_pcb));
+    p->pcbs[pid] = cslab_alloc(&p->pcbCache);
     if (p->pcbs[pid] == NULL) {
         ROS_ERROR("Could not allocate PCB structure. Procserv out of memory.\n");
         cpool_free(&p->pids, pid);
@@ -60,7 +64,7 @@ pid_free(struct pid_list *p, uint32_t pid)
         ROS_ERROR("PID already freed!\n");
         return;
     }
-    kfree(p->pcbs[pid]);
+    cslab_free(&p->pcbCache, p->pcbs[pid]);
     p->pcbs[pid] = NULL;
     cpool_free(&p->pids, pid);
 }
@@ -10,6 +10,7 @@
 #include "../../common.h"
 #include "../../badge.h"
 #include <data_struct/cpool.h>
+#include <data_struct/cslab.h>
 
 /*! @file
     @brief Process server PID allocation. */
@@ -26,6 +27,8 @@ struct proc_pcb;
 struct pid_list {
     cpool_t pids;
     struct proc_pcb* pcbs[PID_MAX];
+    cslab_t pcbCache; /* struct proc_pcb */
+    cslab_t threadCache; /* struct proc_tcb */
 };
 
 /*! @brief Callback function type, used for iteration through all PIDs. */
@@ -206,7 +206,7 @@ proc_config_new(struct proc_pcb *p, uint32_t pid, uint8_t priority, char *imageN
     /* Create thread. */
     dvprintf("Allocating thread structure for %s...\n", imageName);
     cvector_init(&p->threads);
-    struct proc_tcb *thread = kmalloc(sizeof(struct proc_tcb));
+    struct proc_tcb *thread = cslab_alloc(&procServ.PIDList.threadCache);
     if (!thread) {
         ROS_ERROR("Failed to malloc thread structure.\n");
         error = ENOMEM;
@@ -274,7 +274,7 @@ proc_config_new(struct proc_pcb *p, uint32_t pid, uint8_t priority, char *imageN
 
     /* Exit stack. */
 exit2:
-    kfree(thread);
+    cslab_free(&procServ.PIDList.threadCache, thread);
 exit1:
     vs_unref(&p->vspace);
 exit0:
@@ -380,10 +380,7 @@ proc_release(struct proc_pcb *p)
 
     /* Unreference the parameter buffer. */
     dvprintf("    unreffing parameter buffer...\n");
-    if (p->paramBuffer) {
-        ram_dspace_unref(p->paramBuffer->parentList, p->paramBuffer->ID);
-        p->paramBuffer = NULL;
-    }
+    proc_set_parambuffer(p, NULL);
 
     /* Release notification buffer. */
     dvprintf("    releasing notification buffer...\n");
@@ -412,7 +409,7 @@ proc_release(struct proc_pcb *p)
         struct proc_tcb *thread = (struct proc_tcb *) cvector_get(&p->threads, i);
         assert(thread && thread->magic == REFOS_PROCESS_THREAD_MAGIC);
         thread_release(thread);
-        kfree(thread);
+        cslab_free(&procServ.PIDList.threadCache, thread);
     }
     cvector_free(&p->threads);
 
@@ -441,12 +438,18 @@ proc_set_parambuffer(struct proc_pcb *p, struct ram_dspace *paramBuffer)
         return;
     } else if (p->paramBuffer != NULL) {
         /* We need to undeference the previous parameter buffer. */
+        ram_dspace_unmap_local(&p->paramBufferMap);
         ram_dspace_unref(p->paramBuffer->parentList, p->paramBuffer->ID);
         p->paramBuffer = NULL;
     }
     if (paramBuffer != NULL) {
-        /* Now reference the new parameter buffer. */
+        /* Now reference the new parameter buffer, and map it so syscalls can read it in place. */
         ram_dspace_ref(paramBuffer->parentList, paramBuffer->ID);
+        int error = ram_dspace_map_local(paramBuffer, REFOS_PCB_PARAMBUFFER_MAP_SIZE,
+                                         &p->paramBufferMap);
+        if (error != ESUCCESS) {
+            dvprintf("Parameter buffer not mapped, falling back to copying out of it.\n");
+        }
     }
     p->paramBuffer = paramBuffer;
 }
@@ -562,7 +565,7 @@ proc_clone(struct proc_pcb *p, int *threadID, vaddr_t stackAddr, vaddr_t entryPo
 
     /* Create the TCB struct for the clone thread. */
     dvprintf("Allocating thread structure...\n");
-    struct proc_tcb *thread = kmalloc(sizeof(struct proc_tcb));
+    struct proc_tcb *thread = cslab_alloc(&procServ.PIDList.threadCache);
     if (!thread) {
         ROS_ERROR("Failed to malloc thread structure.\n");
         return ENOMEM;
@@ -624,7 +627,7 @@ exit2:
     cvector_delete(&p->threads, tID);
     thread_release(thread);
 exit1:
-    kfree(thread);
+    cslab_free(&procServ.PIDList.threadCache, thread);
     assert(error != ESUCCESS);
     return error;
 }
@@ -32,6 +32,7 @@
 
 #define REFOS_PCB_MAGIC 0xB33FFEED
 #define REFOS_PCB_DEBUGNAME_LEN 32
+#define REFOS_PCB_PARAMBUFFER_MAP_SIZE (REFOS_PAGE_SIZE * 8)
 
 #define PROCESS_PERMISSION_DEVICE_MAP 0x0001
 #define PROCESS_PERMISSION_DEVICE_IRQ 0x0002
@@ -54,6 +55,7 @@ struct proc_pcb {
 
     struct proc_watch_list clientWatchList;
     struct ram_dspace *paramBuffer; /* Shared ownership. */
+    struct ram_dspace_local_map paramBufferMap; /* Has ownership. */
     struct rb_buffer *notificationBuffer; /* Has ownership. */
     uint32_t systemCapabilitiesMask;
 
@@ -141,6 +143,11 @@ void proc_queue_release(struct proc_pcb *p);
 int proc_nice(struct proc_pcb *p, int tindex, int priority);
 
 /*! @brief Set the parameter buffer for a process.
+
+    The first REFOS_PCB_PARAMBUFFER_MAP_SIZE bytes of the parameter buffer are kept mapped into the
+    process server's own vspace while it is set, so that syscalls can read their parameters in
+    place. If the mapping fails, parameters are copied out of the parameter buffer instead.
+
     @param p The process to set parameter buffer for.
     @param paramBuffer The parameter buffer anon dataspace structure. (Shared ownership)
     @return ESUCCESS on success, refos_err_t otherwise.
@@ -28,9 +28,9 @@ thread_config(struct proc_tcb *thread, uint8_t priority, vaddr_t entryPoint,
     thread->vspaceRef = vspace;
     vs_ref(vspace);
 
-    /* Configure the thread object. */
+    /* Configure the thread object, taking its TCB from the kernel object cache. */
     int error = sel4utils_configure_thread(
-            &procServ.vka, &procServ.vspace, &vspace->vspace, REFOS_PROCSERV_EP,
+            kcache_vka(&procServ.kcache), &procServ.vspace, &vspace->vspace, REFOS_PROCSERV_EP,
             priority, vspace->cspace.capPtr, vspace->cspaceGuardData,
             &thread->sel4utilsThread
     );
@@ -77,9 +77,9 @@ thread_release(struct proc_tcb *thread)
 {
     assert(thread);
     assert(thread->vspaceRef);
-    cspacepath_t path;
-    vka_cspace_make_path(&procServ.vka, thread_tcb_obj(thread), &path);
-    vka_cnode_revoke(&path);
+
+    /* Free the TCB; this clears it out of sel4utilsThread so sel4utils won't free it again. */
+    kcache_free(&procServ.kcache, KCACHE_TCB, &thread->sel4utilsThread.tcb);
     sel4utils_clean_up_thread(&procServ.vka, &thread->vspaceRef->vspace, &thread->sel4utilsThread);
     vs_unref(thread->vspaceRef);
     memset(thread, 0, sizeof(struct proc_tcb));
@@ -10,8 +10,12 @@
 #include <autoconf.h>
 #include <data_struct/cvector.h>
 #include <data_struct/cqueue.h>
+#include <data_struct/cring.h>
+#include <data_struct/clfring.h>
 #include <data_struct/chash.h>
 #include <data_struct/cbpool.h>
+#include <data_struct/cslab.h>
+#include <data_struct/clist.h>
 #include <refos/test.h>
 #include <refos-util/nameserv.h>
 #include "test_addrspace.h"
@@ -68,6 +72,59 @@ test_kalloc(void)
     return test_success();
 }
 
+/* ----------------------------------- Kernel object caches ------------------------------------- */
+
+static int
+test_kcache(void)
+{
+    test_start("kernel object caches");
+    struct kcache *c = &procServ.kcache.cache[KCACHE_ENDPOINT];
+    vka_object_t obj[KCACHE_MAX_OBJECTS * 2];
+    int n = KCACHE_MAX_OBJECTS * 2;
+
+    /* Allocating more endpoints than the cache holds should fall back to the allocator. */
+    uint32_t hits = c->hits, misses = c->misses;
+    int count = c->count;
+    for (int i = 0; i < n; i++) {
+        int error = kcache_alloc(&procServ.kcache, KCACHE_ENDPOINT, &obj[i]);
+        test_assert(error == ESUCCESS);
+        test_assert(obj[i].cptr != 0);
+        test_assert(obj[i].type == seL4_EndpointObject);
+    }
+    test_assert(c->count == 0);
+    test_assert((int) (c->hits - hits) == count);
+    test_assert((int) (c->misses - misses) == n - count);
+    for (int i = 0; i < n; i++) {
+        kcache_free(&procServ.kcache, KCACHE_ENDPOINT, &obj[i]);
+        test_assert(obj[i].cptr == 0);
+    }
+
+    /* Refilling should top the cache back up, in bounded batches. */
+    test_assert(kcache_needs_refill(&procServ.kcache));
+    while (kcache_needs_refill(&procServ.kcache)) {
+        test_assert(kcache_refill(&procServ.kcache) <= KCACHE_REFILL_BATCH);
+    }
+    test_assert(c->count == c->high);
+
+    /* TCBs allocated through the caching VKA come off the cache, but are never put back on it, so
+       no thread state carries over to the next process. */
+    struct kcache *tc = &procServ.kcache.cache[KCACHE_TCB];
+    vka_object_t tcb;
+    count = tc->count;
+    test_assert(count > 0);
+    int error = vka_alloc_tcb(kcache_vka(&procServ.kcache), &tcb);
+    test_assert(!error && tcb.cptr != 0);
+    test_assert(tc->count == count - 1);
+    uint32_t released = tc->released;
+    kcache_free(&procServ.kcache, KCACHE_TCB, &tcb);
+    test_assert(tcb.cptr == 0);
+    test_assert(tc->count == count - 1);
+    test_assert(tc->released == released + 1);
+
+    kcache_print(&procServ.kcache);
+    return test_success();
+}
+
 /* --------------------------------- Data structure lib tests ----------------------------------- */
 
 static int
@@ -93,6 +150,17 @@ test_cvector(void)
     test_assert(cvector_get(&v, 1) == (cvector_item_t)3);
     test_assert(cvector_get(&v, 2) == (cvector_item_t)4);
     cvector_free(&v);
+    for (int i = 0; i < 5; i++) {
+        cvector_add(&v, (cvector_item_t)(i + 1));
+    }
+    cvector_delete_unordered(&v, 1);
+    test_assert(cvector_count(&v) == (int)4);
+    test_assert(cvector_get(&v, 1) == (cvector_item_t)5);
+    cvector_delete_unordered(&v, 3);
+    test_assert(cvector_count(&v) == (int)3);
+    test_assert(cvector_get(&v, 0) == (cvector_item_t)1);
+    test_assert(cvector_get(&v, 2) == (cvector_item_t)3);
+    cvector_free(&v);
     int vcStress = 10000;
     for (int i = 0; i < vcStress; i++) {
         int data = ((i << 2) * 0xcafebabe) ^ 0xdeadbeef;
@@ -108,6 +176,69 @@ test_cvector(void)
     return test_success();
 }
 
+struct test_clist_item {
+    int value;
+    clist_node_t node;
+    chlist_node_t hnode;
+};
+
+static int
+test_clist(void)
+{
+    test_start("clist");
+    struct test_clist_item items[8];
+    clist_t l;
+    chlist_t h;
+    clist_init(&l);
+    chlist_init(&h);
+    test_assert(clist_empty(&l) && clist_first(&l) == NULL);
+    for (int i = 0; i < 8; i++) {
+        items[i].value = i;
+        clist_node_init(&items[i].node);
+        chlist_node_init(&items[i].hnode);
+        test_assert(!clist_linked(&items[i].node));
+        clist_add_tail(&l, &items[i].node);
+        chlist_add_head(&h, &items[i].hnode);
+    }
+    test_assert(clist_count(&l) == 8);
+
+    /* Remove from the middle and both ends, and check that the order is kept. */
+    clist_remove(&l, &items[0].node);
+    clist_remove(&l, &items[4].node);
+    clist_remove(&l, &items[7].node);
+    chlist_remove(&items[0].hnode);
+    chlist_remove(&items[4].hnode);
+    chlist_remove(&items[7].hnode);
+    test_assert(!clist_linked(&items[4].node) && !chlist_linked(&items[4].hnode));
+    test_assert(clist_count(&l) == 5);
+    int expected[] = {1, 2, 3, 5, 6};
+    int i = 0;
+    clist_node_t *n, *tmp;
+    clist_foreach_safe(&l, n, tmp) {
+        test_assert(clist_entry(n, struct test_clist_item, node)->value == expected[i++]);
+    }
+    test_assert(i == 5);
+    i = 5;
+    chlist_node_t *hn, *htmp;
+    chlist_foreach_safe(&h, hn, htmp) {
+        test_assert(clist_entry(hn, struct test_clist_item, hnode)->value == expected[--i]);
+        chlist_remove(hn);
+    }
+    test_assert(i == 0 && chlist_empty(&h));
+
+    /* Pop everything off the head, in order. */
+    clist_add_head(&l, &items[0].node);
+    test_assert(clist_entry(clist_last(&l), struct test_clist_item, node)->value == 6);
+    for (i = 0; i < 7; i++) {
+        if (i == 4) continue;
+        n = clist_pop_head(&l);
+        test_assert(n && clist_entry(n, struct test_clist_item, node)->value == i);
+    }
+    test_assert(clist_pop_head(&l) == NULL);
+    test_assert(clist_empty(&l) && clist_count(&l) == 0);
+    return test_success();
+}
+
 static int
 test_cqueue(void)
 {
@@ -127,6 +258,96 @@ test_cqueue(void)
     return test_success();
 }
 
+static int
+test_cring(void)
+{
+    test_start("cring");
+    cring_t r;
+    cring_item_t item;
+    cring_init(&r, 0);
+    test_assert(!cring_pop(&r, &item) && cring_peek(&r) == NULL);
+    for (int k = 0; k < 10; k++) {
+        /* Grow well past the initial size, with the ring wrapped around. */
+        for (int i = 0; i < 1000 + k; i++) {
+            test_assert(cring_push(&r, (cring_item_t) i));
+        }
+        for (int i = 0; i < 500; i++) {
+            test_assert(cring_pop(&r, &item) && (int) item == i);
+        }
+        for (int i = 0; i < 100; i++) {
+            test_assert(cring_push(&r, (cring_item_t) (i + 1000 + k)));
+        }
+        for (int i = 500; i < 1100 + k; i++) {
+            test_assert(cring_pop(&r, &item) && (int) item == i);
+        }
+        test_assert(cring_count(&r) == 0);
+        cring_shrink(&r);
+    }
+    cring_release(&r);
+
+    /* A bounded ring should refuse pushes once full. */
+    cring_init(&r, 10);
+    for (int i = 0; i < 10; i++) {
+        test_assert(cring_push(&r, (cring_item_t) i));
+    }
+    test_assert(cring_full(&r) && !cring_push(&r, (cring_item_t) 10));
+    test_assert((int) cring_peek(&r) == 0);
+    cring_release(&r);
+    return test_success();
+}
+
+static int
+test_clfring(void)
+{
+    test_start("clfring");
+    static char mem[1024] __attribute__((aligned(CLF_CACHE_LINE)));
+    uint32_t v;
+
+    /* Invalid geometry should be refused. */
+    cspsc_t s;
+    test_assert(cspsc_init(&s, mem, sizeof(mem), 12, sizeof(uint32_t)) != 0);
+    test_assert(cspsc_init(&s, mem, 16, 16, sizeof(uint32_t)) != 0);
+
+    /* Single producer / single consumer. */
+    test_assert(cspsc_mem_size(16, sizeof(uint32_t)) <= sizeof(mem));
+    test_assert(cspsc_init(&s, mem, sizeof(mem), 16, sizeof(uint32_t)) == 0);
+    cspsc_t s2;
+    test_assert(cspsc_attach(&s2, mem, sizeof(mem)) == 0);
+    for (uint32_t k = 0; k < 100; k++) {
+        for (uint32_t i = 0; i < 16; i++) {
+            v = k * 16 + i;
+            test_assert(cspsc_push(&s, &v));
+        }
+        test_assert(!cspsc_push(&s, &v));
+        test_assert(cspsc_count(&s2) == 16);
+        for (uint32_t i = 0; i < 16; i++) {
+            test_assert(cspsc_pop(&s2, &v) && v == k * 16 + i);
+        }
+        test_assert(!cspsc_pop(&s2, &v));
+    }
+
+    /* Multi producer / multi consumer; formatting over the old ring should replace it. */
+    cmpmc_t m, m2;
+    test_assert(cmpmc_attach(&m, mem, sizeof(mem)) != 0);
+    test_assert(cmpmc_mem_size(32, sizeof(uint32_t)) <= sizeof(mem));
+    test_assert(cmpmc_init(&m, mem, sizeof(mem), 32, sizeof(uint32_t)) == 0);
+    test_assert(cspsc_attach(&s2, mem, sizeof(mem)) != 0);
+    test_assert(cmpmc_attach(&m2, mem, sizeof(mem)) == 0);
+    for (uint32_t k = 0; k < 100; k++) {
+        for (uint32_t i = 0; i < 32; i++) {
+            v = k * 32 + i;
+            test_assert(cmpmc_push((i & 1) ? &m : &m2, &v));
+        }
+        test_assert(!cmpmc_push(&m, &v));
+        test_assert(cmpmc_count(&m) == 32);
+        for (uint32_t i = 0; i < 32; i++) {
+            test_assert(cmpmc_pop((i & 1) ? &m2 : &m, &v) && v == k * 32 + i);
+        }
+        test_assert(!cmpmc_pop(&m2, &v));
+    }
+    return test_success();
+}
+
 static int
 test_chash(void)
 {
@@ -165,6 +386,31 @@ test_cpool(void)
     cpool_free(&p, 1);
     int v = cpool_alloc(&p);
     test_assert(v == 1);
+
+    /* IDs should be handed out lowest first. */
+    cpool_free(&p, 700);
+    cpool_free(&p, 30);
+    test_assert(cpool_check(&p, 30) && cpool_check(&p, 700) && !cpool_check(&p, 31));
+    test_assert(cpool_alloc(&p) == 30);
+    test_assert(cpool_alloc(&p) == 700);
+
+    /* Freeing the top IDs should lower the high-water mark past every free ID below them. */
+    for (int i = 100; i < 5120; i++) {
+        cpool_free(&p, i);
+    }
+    test_assert(p.mx == 5121);
+    cpool_free(&p, 5120);
+    test_assert(p.mx == 100);
+    test_assert(cpool_check(&p, 4000) && cpool_check(&p, 10240) && !cpool_check(&p, 0));
+    test_assert(cpool_alloc(&p) == 100);
+    cpool_release(&p);
+
+    /* An exhausted pool should return 0. */
+    cpool_init(&p, 1, 40);
+    for (int i = 1; i <= 40; i++) {
+        test_assert(cpool_alloc(&p) == i);
+    }
+    test_assert(cpool_alloc(&p) == 0);
     cpool_release(&p);
     return test_success();
 }
@@ -199,6 +445,89 @@ test_cbpool(void)
     return test_success();
 }
 
+static int test_cslab_ctor_count = 0;
+
+static void
+test_cslab_ctor(void *obj)
+{
+    (*(int*) obj) = 0x5AB;
+    test_cslab_ctor_count++;
+}
+
+static void
+test_cslab_dtor(void *obj)
+{
+    test_cslab_ctor_count--;
+}
+
+static int
+test_cslab(void)
+{
+    test_start("cslab");
+    cslab_t c;
+    cslab_init(&c, 24, 8, NULL, NULL);
+    test_assert(c.objsPerSlab == 8);
+
+    /* Allocate a few slabs worth of objects, and check that they don't overlap. */
+    char *obj[64];
+    for (int i = 0; i < 64; i++) {
+        obj[i] = cslab_alloc(&c);
+        test_assert(obj[i] != NULL);
+        memset(obj[i], i, 24);
+    }
+    test_assert(c.numActive == 64);
+    test_assert(c.numSlabs == 8);
+    for (int i = 0; i < 64; i++) {
+        for (int j = 0; j < 24; j++) {
+            test_assert(obj[i][j] == (char) i);
+        }
+    }
+
+    /* Freed objects should be handed out again before any new slab is made. */
+    cslab_free(&c, obj[13]);
+    cslab_free(&c, obj[42]);
+    test_assert(c.numActive == 62);
+    char *a = cslab_alloc(&c);
+    char *b = cslab_alloc(&c);
+    test_assert((a == obj[13] && b == obj[42]) || (a == obj[42] && b == obj[13]));
+    test_assert(c.numSlabs == 8);
+
+    /* Freeing everything should give back all but one empty slab. */
+    for (int i = 0; i < 64; i++) {
+        cslab_free(&c, obj[i]);
+    }
+    test_assert(c.numActive == 0);
+    test_assert(c.numSlabs == CSLAB_MAX_EMPTY_SLABS);
+    test_assert(c.peakActive == 64);
+    cslab_shrink(&c);
+    test_assert(c.numSlabs == 0);
+
+    /* Repeatedly allocating and freeing a single object should not thrash slabs. */
+    for (int i = 0; i < 1000; i++) {
+        void *o = cslab_alloc(&c);
+        test_assert(o != NULL);
+        cslab_free(&c, o);
+        test_assert(c.numSlabs == 1);
+    }
+    cslab_release(&c);
+    test_assert(c.numSlabs == 0);
+
+    /* Constructed objects should stay constructed through alloc and free. */
+    test_cslab_ctor_count = 0;
+    cslab_init(&c, sizeof(int), 0, test_cslab_ctor, test_cslab_dtor);
+    test_assert(c.objsPerSlab >= CSLAB_MIN_SLAB_OBJS);
+    int *x = cslab_alloc(&c);
+    test_assert(x && (*x) == 0x5AB);
+    test_assert(test_cslab_ctor_count == (int) c.objsPerSlab);
+    cslab_free(&c, x);
+    x = cslab_alloc(&c);
+    test_assert(x && (*x) == 0x5AB);
+    cslab_free(&c, x);
+    cslab_release(&c);
+    test_assert(test_cslab_ctor_count == 0);
+    return test_success();
+}
+
 /* ----------------------------------- NameServ Library test ------------------------------------ */
 
 static void
@@ -286,11 +615,16 @@ test_run_all(void)
     test_title = "ROOT_TASK_TESTS";
 
     test_kalloc();
+    test_kcache();
     test_cvector();
+    test_clist();
     test_cqueue();
+    test_cring();
+    test_clfring();
     test_chash();
     test_cpool();
     test_cbpool();
+    test_cslab();
     test_pid();
     test_pd();
     test_vspace(0);
@@ -299,6 +633,7 @@ test_run_all(void)
     test_thread();
     test_window_list();
     test_window_associations();
+    test_object_table();
     test_ram_dspace_list();
     test_ram_dspace_read_write();
     test_proc_client_watch();
@@ -13,6 +13,7 @@
 #include "../state.h"
 #include "../system/memserv/window.h"
 #include "../system/memserv/dataspace.h"
+#include "../system/memserv/objtable.h"
 #include "../system/memserv/ringbuffer.h"
 #include <refos/test.h>
 
@@ -24,7 +25,7 @@ test_window_list(void)
     test_start("windows");
     struct w_list wlist;
     w_init(&wlist);
-    int nWindowTest = W_MAX_WINDOWS / 2;
+    int nWindowTest = 4096;
 
     /* Spam allocate all the windows. */
     for (int i = 1; i < nWindowTest; i++) {
@@ -137,6 +138,76 @@ test_window_associations(void)
     return test_success();
 }
 
+/* ----------------------------------- Object table module test --------------------------------- */
+
+static int testObjTableObjects[OT_CHUNK_SIZE * 3];
+
+static void*
+test_object_table_create(struct ot_table *t, int id, uint32_t arg[OT_ARGS])
+{
+    testObjTableObjects[id] = (int) arg[0];
+    return &testObjTableObjects[id];
+}
+
+static void
+test_object_table_delete(struct ot_table *t, void *obj)
+{
+    (*(int*) obj) = 0;
+}
+
+int
+test_object_table(void)
+{
+    test_start("object table");
+    struct ot_table t;
+    ot_init(&t, OT_CHUNK_SIZE * 3);
+    t.ot_create = test_object_table_create;
+    t.ot_delete = test_object_table_delete;
+    uint32_t arg[OT_ARGS] = {0};
+
+    /* Allocate across chunk boundaries. */
+    for (int i = 1; i < OT_CHUNK_SIZE * 3; i++) {
+        void *obj = NULL;
+        arg[0] = i;
+        int id = ot_alloc(&t, arg, &obj);
+        test_assert(id == i);
+        test_assert(obj == &testObjTableObjects[i]);
+        test_assert(ot_get(&t, id) == obj);
+        test_assert(ot_get_tagged(&t, ot_tag(&t, id)) == obj);
+    }
+    test_assert(ot_id_limit(&t) == OT_CHUNK_SIZE * 3);
+
+    /* Table is full. */
+    test_assert(ot_alloc(&t, arg, NULL) == OT_INVALID_ID);
+
+    /* Freeing an ID and reusing it must not let the old tag resolve to the new object. */
+    int id = OT_CHUNK_SIZE + 1;
+    uint32_t oldTag = ot_tag(&t, id);
+    test_assert(ot_free(&t, id) == ESUCCESS);
+    test_assert(testObjTableObjects[id] == 0);
+    test_assert(ot_get(&t, id) == NULL);
+    test_assert(ot_get_tagged(&t, oldTag) == NULL);
+    test_assert(ot_free(&t, id) == EINVALIDPARAM);
+
+    arg[0] = 1234;
+    test_assert(ot_alloc(&t, arg, NULL) == id);
+    uint32_t newTag = ot_tag(&t, id);
+    test_assert(newTag != oldTag);
+    test_assert(ot_get_tagged(&t, oldTag) == NULL);
+    test_assert(ot_get_tagged(&t, newTag) == &testObjTableObjects[id]);
+    test_assert(testObjTableObjects[id] == 1234);
+
+    /* Out of range lookups. */
+    test_assert(ot_get(&t, OT_INVALID_ID) == NULL);
+    test_assert(ot_get(&t, OT_CHUNK_SIZE * 3) == NULL);
+
+    ot_release(&t);
+    for (int i = 1; i < OT_CHUNK_SIZE * 3; i++) {
+        test_assert(testObjTableObjects[i] == 0);
+    }
+    return test_success();
+}
+
 /* --------------------------------- RAM dataspace module test ---------------------------------- */
 
 int
@@ -16,6 +16,8 @@ int test_window_list(void);
 
 int test_window_associations(void);
 
+int test_object_table(void);
+
 int test_ram_dspace_list(void);
 
 int test_ram_dspace_read_write(void);
@@ -85,8 +85,7 @@ sl_setup_elf_header(serv_connection_t* fsSession)
    @param windowSize The size of zero segment region window. Could be slightly different to the
                      dataspace region, due to page alignment.
    @param out[out] Optional output struct to store windows & dataspace capabilities. If this is
-                   set to NULL, the created window and dataspace caps are simply used then
-                   discarded.
+                   set to NULL, no capabilities to the created window and dataspace are kept.
    @return ESUCCESS on success, refos_err_t otherwise.
  */
 static int
@@ -103,42 +102,27 @@ sl_create_zero_segment(seL4_Word start, seL4_Word size, seL4_Word windowSize, sl
 
     dprintf("Loading zero segment 0x%08x --> 0x%08x \n", start, start + windowSize);
 
-    /* Open a anon ram dataspace on procserv. */
-    dvprintf("    Creating zero segment dataspace ...\n");
-    elfSegment->dataspace = data_open(REFOS_PROCSERV_EP, "anon", 0, 0, size, &error);
+    /* Open an anon ram dataspace on procserv, and map it into the zero-initialised window for
+       this segment. If we don't need to keep the segment, we don't need any caps to it either. */
+    dvprintf("    Creating zero segment ...\n");
+    error = proc_create_anon_segment(start, windowSize, size, out ? &elfSegment->dataspace : NULL);
     if (error != ESUCCESS) {
-        ROS_ERROR("Failed to open zero segment anon dspace.");
+        ROS_ERROR("Failed to create ELF zero segment.");
         return error;
     }
-
-    /* Create the zero-initalised window for this segment. */
-    dvprintf("    Creating zero segment window ...\n");
-    elfSegment->window = proc_create_mem_window(start, windowSize);
-    if (!elfSegment->window || ROS_ERRNO() != ESUCCESS) {
-        ROS_ERROR("Failed to create ELF zero segment window.");
-        return error;
+    if (!out) {
+        return ESUCCESS;
     }
 
-    /* Map the zero dataspace into the window. */
-    dvprintf("    Data mapping zero segment ...\n");
-    error = data_datamap(REFOS_PROCSERV_EP, elfSegment->dataspace, elfSegment->window, 0);
-    if (error != ESUCCESS) {
-        ROS_ERROR("Failed to datamap ELF zero segment.");
-        return error;
+    /* Retrieve the window of the segment we keep. */
+    elfSegment->window = proc_get_mem_window(start);
+    if (!elfSegment->window) {
+        ROS_ERROR("Failed to retrieve ELF zero segment window.");
+        return EINVALIDWINDOW;
     }
 
     elfSegment->vaddr = (uint32_t) start;
     elfSegment->size = (uint32_t) windowSize;
-    if (!out) {
-        /* Delete our caps as we no longer need them. */
-        csfree_delete(elfSegment->dataspace);
-        csfree_delete(elfSegment->window);
-        elfSegment->dataspace = 0;
-        elfSegment->window = 0;
-        elfSegment->vaddr = 0;
-        elfSegment->size = 0;
-    }
-
     return ESUCCESS;
 }
 
@@ -191,22 +175,16 @@ sl_elf_load_region(struct sl_elf_segment_info si, serv_connection_t* fsSession)
     int windowSize = windowEnd - si.vaddr;
     assert(((si.vaddr + windowSize) % REFOS_PAGE_SIZE) == 0);
 
-    /* Create the file-initialised window for this data initialised segment anon dspace. */
-    dvprintf("    Creating memory window ...");
-    elfSegment->window = proc_create_mem_window(REFOS_PAGE_ALIGN(si.vaddr), windowSize);
+    /* Create the file-initialised window for this data initialised segment anon dspace, and map
+       the dataspace into it. */
+    dvprintf("    Creating and mapping memory window ...\n");
+    elfSegment->window = proc_create_mem_window_map(REFOS_PAGE_ALIGN(si.vaddr), windowSize,
+                                                    elfSegment->dataspace, 0);
     if (!elfSegment->window || ROS_ERRNO() != ESUCCESS) {
-        ROS_ERROR("Failed to create ELF segment window.");
+        ROS_ERROR("Failed to create and map ELF segment window.");
         return ROS_ERRNO();
     }
 
-    /* Map the correct region of the file into this segment. */
-    dvprintf("    Mapping dataspace ...\n");
-    error = data_datamap(REFOS_PROCSERV_EP, elfSegment->dataspace, elfSegment->window, 0);
-    if (error) {
-        ROS_ERROR("Failed to datamap ELF initialised segment anon dataspace.");
-        return error;
-    }
-
     /* Clean up the capabilities to this segment so we can re-use the structure. */
     csfree_delete(elfSegment->window);
     csfree_delete(elfSegment->dataspace);
@@ -310,6 +288,36 @@ sl_setup_bootinfo_buffer(void)
     procInfo->stackRegion = selfloaderState.stackRegion;
 }
 
+/*! @brief Hand the file server session over to the loaded process, through the bootinfo buffer.
+
+    The process adopts the session the first time it opens a file on the same server, which saves
+    it from connecting to the file server again. Connectionless servers and prefixes too long to
+    fit are disconnected from as usual.
+
+    @param fsSession The file server connection to hand over. (Takes ownership)
+*/
+static void
+sl_handover_fileserv_session(serv_connection_t* fsSession)
+{
+    struct sl_procinfo_s *procInfo = refos_static_param_procinfo();
+    char *prefix = fsSession->serverMountPoint.nameservPathPrefix;
+    procInfo->fileservSession = 0;
+
+    if (fsSession->connectionLess || !fsSession->serverSession ||
+            strlen(prefix) >= SELFLOADER_PROCINFO_PREFIX_MAXLEN) {
+        serv_disconnect(fsSession);
+        return;
+    }
+
+    dprintf("    Handing over file server session for [%s]\n", prefix);
+    strcpy(procInfo->fileservPrefix, prefix);
+    procInfo->fileservSession = fsSession->serverSession;
+
+    /* Release everything but the session itself. */
+    fsSession->serverSession = 0;
+    serv_disconnect(fsSession);
+}
+
 /*! @brief Push onto the stack.
    @param stack_top The current top of the stack.
    @param buf The buffer to be pushed onto the stack.
@@ -493,7 +501,7 @@ main(void)
 
     /* Connect to the file server. */
     dprintf("    Connect to the server for [%s]\n", filePath);
-    selfloaderState.fileservConnection = serv_connect(filePath);
+    selfloaderState.fileservConnection = serv_connect_no_pbuffer(filePath);
     if (selfloaderState.fileservConnection.error != ESUCCESS) {
         ROS_ERROR("Error while connecting to file server.\n");
         return error;
@@ -513,8 +521,8 @@ main(void)
         return error;
     }
 
-    /* We don't need the file server session any more. */
-    serv_disconnect(&selfloaderState.fileservConnection);
+    /* We don't need the file server session any more, but the process likely will. */
+    sl_handover_fileserv_session(&selfloaderState.fileservConnection);
 
     /* Set up bootinfo and jump into ELF entry! */
     sl_setup_bootinfo_buffer();
@@ -47,10 +47,51 @@ test_anon_dspace()
     return test_success();
 }
 
+static int
+test_anon_window()
+{
+    test_start("anon window");
+    seL4_Word testBase = 0x20100000;
+
+    /* Create a window with its own anonymous dataspace, and check it is usable straight away. */
+    seL4_CPtr window = proc_create_anon_mem_window(testBase, 0x2000);
+    test_assert(window && ROS_ERRNO() == ESUCCESS);
+    strcpy((char*) testBase, "hello world!");
+    test_assert(strcmp((char*) testBase, "hello world!") == 0);
+    ((char*) testBase)[0x1FFF] = 'x';
+
+    /* The window's dataspace is retrievable, and sized to the window. */
+    refos_err_t error = -EINVALID;
+    seL4_CPtr dspace = proc_get_mem_window_dspace(window, &error);
+    test_assert(dspace && error == ESUCCESS);
+    test_assert(data_get_size(REFOS_PROCSERV_EP, dspace) == 0x2000);
+
+    /* Growing the window grows its dataspace, keeping the existing content. */
+    error = proc_resize_mem_window(window, 0x4000);
+    test_assert(error == ESUCCESS);
+    test_assert(data_get_size(REFOS_PROCSERV_EP, dspace) == 0x4000);
+    ((char*) testBase)[0x3FFF] = 'y';
+    test_assert(((char*) testBase)[0x1FFF] == 'x' && ((char*) testBase)[0x3FFF] == 'y');
+    test_assert(strcmp((char*) testBase, "hello world!") == 0);
+    csfree_delete(dspace);
+
+    /* Zero sized anon windows are not allowed. */
+    seL4_CPtr invalidWindow = proc_create_anon_mem_window(testBase + 0x10000, 0);
+    test_assert(invalidWindow == 0 && ROS_ERRNO() == EINVALIDPARAM);
+
+    /* Deleting the window releases its dataspace too. */
+    error = proc_delete_mem_window(window);
+    test_assert(error == ESUCCESS);
+    csfree_delete(window);
+
+    return test_success();
+}
+
 void
 test_anon_dataspace(void)
 {
     test_anon_dspace();
+    test_anon_window();
 }
 
 #endif /* CONFIG_REFOS_RUN_TESTS */
@@ -25,6 +25,7 @@
 #include <refos-rpc/proc_client_helper.h>
 #include <refos-rpc/data_client.h>
 #include <refos-rpc/data_client_helper.h>
+#include <refos-util/cspace.h>
 
 void test_anon_dataspace(void);
 
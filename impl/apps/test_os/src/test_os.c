@@ -46,6 +46,7 @@ extern uintptr_t __vsyscall_ptr;
 #define BSS_ARRAY_SIZE 0x20000
 #define TEST_KERNEL_VM_RESERVED_START 0xE0000000
 #define TEST_USERLAND_TEST_APP "/fileserv/test_user"
+#define TEST_IPC_BENCH_ITERATIONS 1000
 
 char bssArray[BSS_ARRAY_SIZE];
 int bssVar = BSS_MAGIC;
@@ -128,6 +129,49 @@ test_process_server_ping(void)
     return test_success();
 }
 
+/*! @brief Read the CPU cycle counter, or 0 if it is not readable from userland. */
+static inline uint64_t
+test_read_cycles(void)
+{
+#if defined(ARCH_IA32)
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t) hi << 32) | lo;
+#elif defined(CONFIG_ARCH_ARM) && defined(CONFIG_EXPORT_PMU_USER)
+    uint32_t ccnt;
+    asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r" (ccnt));
+    return ccnt;
+#else
+    return 0;
+#endif
+}
+
+static int
+test_process_server_ping_cycles(void)
+{
+    test_start("process server ping cycles");
+
+    /* Warm up the caches and TLB so the measured calls may take the kernel IPC fastpath. */
+    for (int i = 0; i < 16; i++) {
+        int error = proc_ping();
+        test_assert(error == ESUCCESS);
+    }
+
+    uint64_t start = test_read_cycles();
+    for (int i = 0; i < TEST_IPC_BENCH_ITERATIONS; i++) {
+        proc_ping();
+    }
+    uint64_t end = test_read_cycles();
+
+    if (end > start) {
+        tprintf("OS_TESTS | proc_ping round trip: %u cycles.\n",
+                (uint32_t) ((end - start) / TEST_IPC_BENCH_ITERATIONS));
+    } else {
+        tprintf("OS_TESTS | proc_ping round trip: cycle counter not available.\n");
+    }
+    return test_success();
+}
+
 static int
 test_process_server_endpoints(void)
 {
@@ -244,6 +288,87 @@ test_process_server_window_resize(void)
     return test_success();
 }
 
+static int
+test_process_server_multicall(void)
+{
+    test_start("process server multicall");
+    seL4_Word testBase = 0x20200000;
+    struct proc_multicall_ops ops;
+    struct proc_multicall_results results;
+    int nops = 0;
+
+    /* Open a dataspace, create a window, map one into the other and get the window ID. */
+    int dspace = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_OPEN_ANON, 0x2000, 0, 0, 0);
+    int window = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_CREATE_MEM_WINDOW, testBase,
+                                   0x2000, PROC_WINDOW_PERMISSION_READWRITE, 0x0);
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_DATAMAP, dspace, window, 0, 0);
+    int getID = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_WINDOW_GETID, window, 0, 0, 0);
+    seL4_CPtr windowCap = proc_multicall(0, &ops, nops, window, &results);
+    test_assert(windowCap && ROS_ERRNO() == ESUCCESS);
+    test_assert(results.result[getID] == proc_window_getID(windowCap));
+
+    /* The mapped window should be usable straight away. */
+    volatile uint32_t *mem = (volatile uint32_t *) testBase;
+    mem[0] = 0xF00D;
+    mem[0x1000 / sizeof(uint32_t)] = 0xBEEF;
+    test_assert(mem[0] == 0xF00D && mem[0x1000 / sizeof(uint32_t)] == 0xBEEF);
+
+    /* Referring to a later slot, or to a slot of the wrong type, should fail. */
+    nops = 0;
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_DATAMAP, 1, 0, 0, 0);
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_OPEN_ANON, 0x1000, 0, 0, 0);
+    proc_multicall(0, &ops, nops, PROCSERV_MULTICALL_SLOT_NONE, NULL);
+    test_assert(ROS_ERRNO() == EINVALIDPARAM);
+    nops = 0;
+    window = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_GET_MEM_WINDOW, testBase, 0, 0, 0);
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_DATAMAP, window, window, 0, 0);
+    proc_multicall(0, &ops, nops, PROCSERV_MULTICALL_SLOT_NONE, NULL);
+    test_assert(ROS_ERRNO() == EINVALIDPARAM);
+
+    /* A failing operation should delete the windows created before it; creating an overlapping
+       window fails, so the first window must be gone again for the next call to succeed. */
+    nops = 0;
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_CREATE_MEM_WINDOW, testBase + 0x4000,
+                      0x1000, PROC_WINDOW_PERMISSION_READWRITE, 0x0);
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_CREATE_MEM_WINDOW, testBase, 0x1000,
+                      PROC_WINDOW_PERMISSION_READWRITE, 0x0);
+    test_assert(proc_multicall(0, &ops, nops, 0, NULL) == 0);
+    test_assert(ROS_ERRNO() == EINVALIDWINDOW);
+    seL4_CPtr testWindow = proc_create_mem_window(testBase + 0x4000, 0x1000);
+    test_assert(testWindow && ROS_ERRNO() == ESUCCESS);
+    int error = proc_delete_mem_window(testWindow);
+    test_assert(error == ESUCCESS);
+    csfree_delete(testWindow);
+
+    /* The window map and anon segment helpers, passing in a dataspace cap. */
+    seL4_CPtr dspaceCap = 0;
+    error = proc_create_anon_segment(testBase + 0x4000, 0x1000, 0x2000, &dspaceCap);
+    test_assert(error == ESUCCESS && dspaceCap);
+    testWindow = proc_create_mem_window_map(testBase + 0x6000, 0x1000, dspaceCap, 0x1000);
+    test_assert(testWindow && ROS_ERRNO() == ESUCCESS);
+    mem = (volatile uint32_t *) (testBase + 0x6000);
+    mem[0] = 0xCAFE;
+    test_assert(mem[0] == 0xCAFE);
+
+    /* Clean up. */
+    error = proc_delete_mem_window(testWindow);
+    test_assert(error == ESUCCESS);
+    csfree_delete(testWindow);
+    testWindow = proc_get_mem_window(testBase + 0x4000);
+    test_assert(testWindow);
+    error = proc_delete_mem_window(testWindow);
+    test_assert(error == ESUCCESS);
+    csfree_delete(testWindow);
+    error = data_close(REFOS_PROCSERV_EP, dspaceCap);
+    test_assert(error == ESUCCESS);
+    csfree_delete(dspaceCap);
+    error = proc_delete_mem_window(windowCap);
+    test_assert(error == ESUCCESS);
+    csfree_delete(windowCap);
+
+    return test_success();
+}
+
 static int
 test_process_server_param_buffer(void)
 {
@@ -338,9 +463,11 @@ static void
 test_process_server(void)
 {
     test_process_server_ping();
+    test_process_server_ping_cycles();
     test_process_server_endpoints();
     test_process_server_window();
     test_process_server_window_resize();
+    test_process_server_multicall();
     test_process_server_param_buffer();
     test_process_server_nameserv();
 }
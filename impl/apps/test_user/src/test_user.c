@@ -14,9 +14,16 @@
 #include <math.h>
 #include <time.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include <refos/test.h>
+#include <refos/dirent.h>
 #include <refos-io/stdio.h>
+#include <refos-io/log.h>
+#include <refos-io/internal_state.h>
+#include <refos-io/filetable.h>
 #include <refos-util/init.h>
 #include <refos/sync.h>
 
@@ -307,6 +314,102 @@ test_filetable_read(void)
     return test_success();
 }
 
+static int
+test_filetable_read_cache(void)
+{
+    test_start("filetable read cache");
+
+    FILE * testFile = fopen("fileserv/hello.txt", "r");
+    test_assert(testFile);
+    int fd = fileno(testFile);
+
+    /* Byte at a time reads should be served from the read cache. */
+    char str[128], str2[128];
+    int n = 0;
+    while (n < sizeof(str) - 1 && read(fd, &str[n], 1) == 1) {
+        n++;
+    }
+    str[n] = '\0';
+    test_assert(strncmp(str, "hello world!", 12) == 0);
+
+    /* Seek within the cached block. */
+    test_assert(lseek(fd, 6, SEEK_SET) == 6);
+    test_assert(read(fd, str2, 6) == 6);
+    test_assert(strncmp(str2, "world!", 6) == 0);
+
+    /* Seek back and re-read the whole file in one go. */
+    test_assert(lseek(fd, 0, SEEK_SET) == 0);
+    test_assert(read(fd, str2, sizeof(str2)) == n);
+    test_assert(memcmp(str, str2, n) == 0);
+    test_assert(read(fd, str2, sizeof(str2)) == 0);
+
+    fclose(testFile);
+    return test_success();
+}
+
+#define TEST_FILE_CACHE_FILE "fileserv/test_file_cache"
+#define TEST_FILE_CACHE_SIZE 1000
+#define TEST_FILE_CACHE_CHUNK 77
+
+/*! @brief Read the whole cache test file in odd sized chunks.
+    @return The number of bytes read, or -1 if the file could not be opened.
+*/
+static int
+test_filetable_read_cache_file(int flags, char *buf)
+{
+    int fd = open(TEST_FILE_CACHE_FILE, flags);
+    if (fd < 0) {
+        return -1;
+    }
+    int total = 0, n;
+    while (total <= TEST_FILE_CACHE_SIZE &&
+           (n = read(fd, buf + total, TEST_FILE_CACHE_CHUNK)) > 0) {
+        total += n;
+    }
+    close(fd);
+    return total;
+}
+
+static int
+test_filetable_read_cache_large(void)
+{
+    test_start("filetable read cache large");
+
+    /* Write a file larger than one data_read() fill of the read cache. */
+    static char pattern[TEST_FILE_CACHE_SIZE];
+    static char cached[TEST_FILE_CACHE_SIZE + TEST_FILE_CACHE_CHUNK];
+    static char uncached[TEST_FILE_CACHE_SIZE + TEST_FILE_CACHE_CHUNK];
+    for (int i = 0; i < TEST_FILE_CACHE_SIZE; i++) {
+        pattern[i] = (char) (i * 7 + (i >> 8));
+    }
+    FILE * testFile = fopen(TEST_FILE_CACHE_FILE, "w");
+    test_assert(testFile);
+    test_assert(fwrite(pattern, 1, TEST_FILE_CACHE_SIZE, testFile) == TEST_FILE_CACHE_SIZE);
+    fclose(testFile);
+
+    /* Read-only and read-write opens must read the same contents. */
+    test_assert(test_filetable_read_cache_file(O_RDONLY, cached) == TEST_FILE_CACHE_SIZE);
+    test_assert(test_filetable_read_cache_file(O_RDWR, uncached) == TEST_FILE_CACHE_SIZE);
+    test_assert(memcmp(cached, uncached, TEST_FILE_CACHE_SIZE) == 0);
+    test_assert(memcmp(cached, pattern, TEST_FILE_CACHE_SIZE) == 0);
+
+    /* RAMFS files may be changed through another open file, so a reader must see the change
+       rather than a cached copy. */
+    int rfd = open(TEST_FILE_CACHE_FILE, O_RDONLY);
+    test_assert(rfd >= 0);
+    test_assert(read(rfd, cached, TEST_FILE_CACHE_CHUNK) == TEST_FILE_CACHE_CHUNK);
+    int wfd = open(TEST_FILE_CACHE_FILE, O_RDWR);
+    test_assert(wfd >= 0);
+    test_assert(lseek(wfd, TEST_FILE_CACHE_CHUNK, SEEK_SET) == TEST_FILE_CACHE_CHUNK);
+    test_assert(write(wfd, "changed", 7) == 7);
+    close(wfd);
+    test_assert(read(rfd, cached, 7) == 7);
+    test_assert(memcmp(cached, "changed", 7) == 0);
+    close(rfd);
+
+    return test_success();
+}
+
 static int
 test_filetable_write(void)
 {
@@ -348,6 +451,230 @@ test_filetable_write(void)
     return test_success();
 }
 
+static int
+test_filetable_readdir(void)
+{
+    test_start("filetable readdir");
+
+    DIR *dir = opendir("fileserv/");
+    test_assert(dir);
+
+    /* Both CPIO files and created RAMFS files are listed, each once. */
+    int n = 0, nHello = 0, nCreated = 0;
+    struct dirent *d;
+    while ((d = readdir(dir)) != NULL) {
+        tvprintf("entry [%s] type %d\n", d->d_name, d->d_type);
+        test_assert(strcmp(d->d_name, ".") && strcmp(d->d_name, ".."));
+        if (!strcmp(d->d_name, "hello.txt")) {
+            test_assert(d->d_type == DT_REG);
+            nHello++;
+        } else if (!strcmp(d->d_name, "test_file_abc")) {
+            nCreated++;
+        }
+        n++;
+    }
+    test_assert(nHello == 1);
+    test_assert(nCreated == 1);
+
+    /* Rewinding lists the same entries again. */
+    rewinddir(dir);
+    int n2 = 0;
+    while (readdir(dir) != NULL) {
+        n2++;
+    }
+    test_assert(n2 == n);
+    closedir(dir);
+    return test_success();
+}
+
+#define TEST_DIRENT_NFILES 8
+
+static int
+test_filetable_readdir_large(void)
+{
+    test_start("filetable readdir large");
+
+    /* Create enough long named files that the listing spans several data_read() chunks. */
+    char path[64];
+    for (int i = 0; i < TEST_DIRENT_NFILES; i++) {
+        snprintf(path, sizeof(path), "fileserv/test_dirent_%02d_abcdefghijklmn", i);
+        FILE * testFile = fopen(path, "w");
+        test_assert(testFile);
+        fclose(testFile);
+    }
+
+    /* Every file is listed exactly once. */
+    int seen[TEST_DIRENT_NFILES] = {0};
+    DIR *dir = opendir("fileserv/");
+    test_assert(dir);
+    struct dirent *d;
+    while ((d = readdir(dir)) != NULL) {
+        int i;
+        if (sscanf(d->d_name, "test_dirent_%02d_", &i) == 1) {
+            test_assert(i >= 0 && i < TEST_DIRENT_NFILES);
+            test_assert(!strcmp(d->d_name + 15, "abcdefghijklmn"));
+            seen[i]++;
+        }
+    }
+    closedir(dir);
+    for (int i = 0; i < TEST_DIRENT_NFILES; i++) {
+        test_assert(seen[i] == 1);
+    }
+    return test_success();
+}
+
+static int
+test_filetable_readdir_corrupt(void)
+{
+    test_start("filetable readdir corrupt");
+    struct dirent out[4];
+    int used, len = 0;
+    bool full = false;
+
+    /* A good record, followed by one claiming to be longer than the longest valid record, as a
+       broken or hostile server could hand out. The good record is unpacked, and unpacking stops
+       at the bad one without waiting on the rest of it. */
+    char src[8] = { 5, DT_REG, 'a', 'b', 'c', (char) 255, DT_REG, 'd' };
+    refos_err_t error = filetable_dirent_unpack(src, sizeof(src), 0, out, sizeof(out), &used,
+                                                &len, &full);
+    test_assert(error == EINVALID);
+    test_assert(used == 5 && len == out[0].d_reclen && !full);
+    test_assert(!strcmp(out[0].d_name, "abc") && out[0].d_type == DT_REG);
+
+    /* Picking up at the bad record fails straight away. So does a record shorter than its
+       header. */
+    int len2 = len;
+    error = filetable_dirent_unpack(src + used, sizeof(src) - used, used, out, sizeof(out),
+                                    &used, &len2, &full);
+    test_assert(error == EINVALID && used == 0 && len2 == len);
+    src[0] = REFOS_DIRENT_HEADER_SIZE - 1;
+    error = filetable_dirent_unpack(src, sizeof(src), 0, out, sizeof(out), &used, &len2, &full);
+    test_assert(error == EINVALID && used == 0 && len2 == len);
+
+    /* The longest valid record is still accepted. */
+    char longest[REFOS_DIRENT_HEADER_SIZE + REFOS_DIRENT_NAME_MAX];
+    memset(longest, 'x', sizeof(longest));
+    longest[0] = sizeof(longest);
+    longest[1] = DT_REG;
+    len = 0;
+    error = filetable_dirent_unpack(longest, sizeof(longest), 0, out, sizeof(out), &used, &len,
+                                    &full);
+    test_assert(error == ESUCCESS && used == sizeof(longest) && !full);
+    test_assert(strlen(out[0].d_name) == REFOS_DIRENT_NAME_MAX);
+    return test_success();
+}
+
+static int
+test_filetable_stat(void)
+{
+    test_start("filetable stat");
+
+    /* Stat a CPIO file by name, twice; the second stat is served from the stat cache. */
+    struct stat st, st2;
+    test_assert(stat("fileserv/hello.txt", &st) == 0);
+    test_assert(S_ISREG(st.st_mode));
+    test_assert(st.st_size > 0);
+    test_assert(stat("fileserv/hello.txt", &st2) == 0);
+    test_assert(st2.st_size == st.st_size && st2.st_mode == st.st_mode);
+    test_assert(access("fileserv/hello.txt", R_OK) == 0);
+
+    /* fstat agrees with stat. */
+    int fd = open("fileserv/hello.txt", O_RDONLY);
+    test_assert(fd >= 0);
+    test_assert(fstat(fd, &st2) == 0);
+    test_assert(S_ISREG(st2.st_mode));
+    test_assert(st2.st_size == st.st_size);
+    close(fd);
+
+    /* Created files and directories. */
+    test_assert(stat("fileserv/test_file_abc", &st) == 0);
+    test_assert(S_ISREG(st.st_mode));
+    test_assert(st.st_size > 0);
+    test_assert(access("fileserv/test_file_abc", R_OK | W_OK) == 0);
+    test_assert(stat("fileserv/", &st) == 0);
+    test_assert(S_ISDIR(st.st_mode));
+
+    return test_success();
+}
+
+static uint64_t
+test_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#define TEST_FILE_BENCH_FILE "fileserv/nhdat"
+#define TEST_FILE_BENCH_CHUNK 0x1000
+#define TEST_FILE_BENCH_ODD_CHUNK 1000
+
+static char testFileBuf[TEST_FILE_BENCH_CHUNK];
+
+static void
+test_file_report(const char *name, uint32_t nBytes, uint64_t ns)
+{
+    uint32_t us = (uint32_t) (ns / 1000);
+    printf("USER_TEST | file %s: %u bytes in %u us (%u KiB/s).\n", name, nBytes, us,
+           us ? (uint32_t) ((uint64_t) (nBytes / 1024) * 1000000 / us) : 0);
+}
+
+/*! @brief Read a whole file in chunks of the given size.
+    @return Checksum of the file content, or 0 if the file could not be read in full.
+*/
+static uint32_t
+test_file_read_all(const char *path, int chunk, uint32_t size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    uint32_t sum = 1, total = 0;
+    int n;
+    while ((n = read(fd, testFileBuf, chunk)) > 0) {
+        for (int i = 0; i < n; i++) {
+            sum = sum * 31 + (uint8_t) testFileBuf[i];
+        }
+        total += n;
+    }
+    close(fd);
+    return total == size ? sum : 0;
+}
+
+static int
+test_filetable_read_bench(void)
+{
+    test_start("filetable read bench");
+    struct stat st;
+    test_assert(stat(TEST_FILE_BENCH_FILE, &st) == 0);
+    test_assert(st.st_size > TEST_FILE_BENCH_CHUNK);
+
+    /* Page sized reads. The file is opened read-only, so every read here goes through the client
+       read cache, which fills each block with message register sized data_read() calls. With a
+       compressed boot archive those are partial block reads on the file server, so the first one
+       decompresses the block into the server's block cache and the rest copy out of it. The file
+       is much larger than the server's block cache, so a re-read decompresses every block again,
+       and costs the same. */
+    uint64_t start = test_time_ns();
+    uint32_t sum = test_file_read_all(TEST_FILE_BENCH_FILE, TEST_FILE_BENCH_CHUNK, st.st_size);
+    test_file_report("page sized read", st.st_size, test_time_ns() - start);
+    test_assert(sum != 0);
+
+    start = test_time_ns();
+    test_assert(test_file_read_all(TEST_FILE_BENCH_FILE, TEST_FILE_BENCH_CHUNK,
+                                   st.st_size) == sum);
+    test_file_report("page sized re-read", st.st_size, test_time_ns() - start);
+
+    /* Odd sized reads straddle blocks, but are served from the same client read cache fills, so
+       they cost the same IPCs as page sized reads. */
+    start = test_time_ns();
+    test_assert(test_file_read_all(TEST_FILE_BENCH_FILE, TEST_FILE_BENCH_ODD_CHUNK,
+                                   st.st_size) == sum);
+    test_file_report("odd sized read", st.st_size, test_time_ns() - start);
+
+    return test_success();
+}
+
 static int
 test_gettime(void)
 {
@@ -362,6 +689,228 @@ test_gettime(void)
     return test_success();
 }
 
+#ifdef CONFIG_APP_BLOCK_SERVER
+
+#define TEST_DISK_BENCH_FILE "disk/test_bench"
+#define TEST_DISK_BENCH_SIZE 0x40000
+#define TEST_DISK_BENCH_CHUNK 0x1000
+#define TEST_DISK_BENCH_NCHUNKS (TEST_DISK_BENCH_SIZE / TEST_DISK_BENCH_CHUNK)
+#define TEST_DISK_BENCH_RANDOM_OPS 128
+
+static char testDiskBuf[TEST_DISK_BENCH_CHUNK];
+
+static void
+test_disk_report(const char *name, uint32_t nOps, uint64_t ns)
+{
+    uint32_t us = (uint32_t) (ns / 1000);
+    uint32_t kib = nOps * (TEST_DISK_BENCH_CHUNK / 1024);
+    printf("USER_TEST | disk %s: %u x %u bytes in %u us (%u KiB/s).\n", name, nOps,
+           TEST_DISK_BENCH_CHUNK, us, us ? (uint32_t) ((uint64_t) kib * 1000000 / us) : 0);
+}
+
+/*! @brief Fill the chunk buffer with a pattern unique to the given chunk and generation. */
+static void
+test_disk_pattern(int chunk, int generation)
+{
+    for (int i = 0; i < TEST_DISK_BENCH_CHUNK; i++) {
+        testDiskBuf[i] = (char) (chunk * 31 + generation * 7 + i);
+    }
+}
+
+static bool
+test_disk_pattern_check(int chunk, int generation)
+{
+    for (int i = 0; i < TEST_DISK_BENCH_CHUNK; i++) {
+        if (testDiskBuf[i] != (char) (chunk * 31 + generation * 7 + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#define TEST_DISK_ODD_CHUNK 1000
+
+/*! @brief Read the whole bench file back in odd sized reads which straddle blocks, checking every
+           byte against the pattern of the generation last written to its chunk.
+    @param flags The open flags. O_RDONLY reads go through the client read cache; O_RDWR reads go
+                 straight to the block server.
+    @param generation The generation of each chunk, or NULL if every chunk is generation 0.
+    @return true if the file holds the expected content, false otherwise.
+*/
+static bool
+test_disk_check_file(int flags, const char *generation)
+{
+    int fd = open(TEST_DISK_BENCH_FILE, flags);
+    if (fd < 0) {
+        return false;
+    }
+    static char buf[TEST_DISK_ODD_CHUNK];
+    int pos = 0, n;
+    bool ok = true;
+    while (ok && (n = read(fd, buf, TEST_DISK_ODD_CHUNK)) > 0) {
+        for (int i = 0; i < n && ok; i++, pos++) {
+            int chunk = pos / TEST_DISK_BENCH_CHUNK;
+            int gen = generation ? generation[chunk] : 0;
+            ok = (chunk < TEST_DISK_BENCH_NCHUNKS) &&
+                 buf[i] == (char) (chunk * 31 + gen * 7 + pos % TEST_DISK_BENCH_CHUNK);
+        }
+    }
+    close(fd);
+    return ok && pos == TEST_DISK_BENCH_SIZE;
+}
+
+static int
+test_disk_sequential(void)
+{
+    test_start("disk sequential I/O");
+
+    /* Sequential write, including the write-back on close. */
+    int fd = open(TEST_DISK_BENCH_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    test_assert(fd >= 0);
+    uint64_t start = test_time_ns();
+    for (int i = 0; i < TEST_DISK_BENCH_NCHUNKS; i++) {
+        test_disk_pattern(i, 0);
+        test_assert(write(fd, testDiskBuf, TEST_DISK_BENCH_CHUNK) == TEST_DISK_BENCH_CHUNK);
+    }
+    close(fd);
+    test_disk_report("sequential write", TEST_DISK_BENCH_NCHUNKS, test_time_ns() - start);
+
+    /* Sequential read back. */
+    fd = open(TEST_DISK_BENCH_FILE, O_RDONLY);
+    test_assert(fd >= 0);
+    start = test_time_ns();
+    for (int i = 0; i < TEST_DISK_BENCH_NCHUNKS; i++) {
+        test_assert(read(fd, testDiskBuf, TEST_DISK_BENCH_CHUNK) == TEST_DISK_BENCH_CHUNK);
+        test_assert(test_disk_pattern_check(i, 0));
+    }
+    test_disk_report("sequential read", TEST_DISK_BENCH_NCHUNKS, test_time_ns() - start);
+    test_assert(read(fd, testDiskBuf, TEST_DISK_BENCH_CHUNK) == 0);
+    close(fd);
+
+    /* Odd sized reads, both cached and uncached, see the same content. */
+    test_assert(test_disk_check_file(O_RDONLY, NULL));
+    test_assert(test_disk_check_file(O_RDWR, NULL));
+
+    return test_success();
+}
+
+static int
+test_disk_random(void)
+{
+    test_start("disk random I/O");
+    static char generation[TEST_DISK_BENCH_NCHUNKS];
+    memset(generation, 0, sizeof(generation));
+
+    /* Uses the file left behind by test_disk_sequential(). */
+    int fd = open(TEST_DISK_BENCH_FILE, O_RDWR);
+    test_assert(fd >= 0);
+
+    /* Random chunk reads. */
+    uint32_t seed = 0x1234567;
+    uint64_t start = test_time_ns();
+    for (int i = 0; i < TEST_DISK_BENCH_RANDOM_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        int chunk = (seed >> 8) % TEST_DISK_BENCH_NCHUNKS;
+        int offset = chunk * TEST_DISK_BENCH_CHUNK;
+        test_assert(lseek(fd, offset, SEEK_SET) == offset);
+        test_assert(read(fd, testDiskBuf, TEST_DISK_BENCH_CHUNK) == TEST_DISK_BENCH_CHUNK);
+        test_assert(test_disk_pattern_check(chunk, 0));
+    }
+    test_disk_report("random read", TEST_DISK_BENCH_RANDOM_OPS, test_time_ns() - start);
+
+    /* Random chunk writes, including the write-back on close. */
+    start = test_time_ns();
+    for (int i = 0; i < TEST_DISK_BENCH_RANDOM_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        int chunk = (seed >> 8) % TEST_DISK_BENCH_NCHUNKS;
+        int offset = chunk * TEST_DISK_BENCH_CHUNK;
+        generation[chunk]++;
+        test_disk_pattern(chunk, generation[chunk]);
+        test_assert(lseek(fd, offset, SEEK_SET) == offset);
+        test_assert(write(fd, testDiskBuf, TEST_DISK_BENCH_CHUNK) == TEST_DISK_BENCH_CHUNK);
+    }
+    close(fd);
+    test_disk_report("random write", TEST_DISK_BENCH_RANDOM_OPS, test_time_ns() - start);
+
+    /* Check every chunk holds its latest write. */
+    fd = open(TEST_DISK_BENCH_FILE, O_RDONLY);
+    test_assert(fd >= 0);
+    for (int i = 0; i < TEST_DISK_BENCH_NCHUNKS; i++) {
+        test_assert(read(fd, testDiskBuf, TEST_DISK_BENCH_CHUNK) == TEST_DISK_BENCH_CHUNK);
+        test_assert(test_disk_pattern_check(i, generation[i]));
+    }
+    close(fd);
+    test_assert(test_disk_check_file(O_RDONLY, generation));
+    test_assert(test_disk_check_file(O_RDWR, generation));
+
+    return test_success();
+}
+
+#endif /* CONFIG_APP_BLOCK_SERVER */
+
+#ifdef CONFIG_APP_LOG_SERVER
+
+#define TEST_LOG_BENCH_RECORDS 32
+
+static int
+test_log(void)
+{
+    test_start("log ring");
+
+    /* refos_initialise() should have set up our log ring with the log server. */
+    test_assert(refos_log_connected());
+    test_assert(refos_log_set_level(REFOS_LOG_NUM_LEVELS) == EINVALIDPARAM);
+    test_assert(refos_log_set_level(REFOS_LOG_ERROR) == ESUCCESS);
+    test_assert(refos_log_printf(REFOS_LOG_DEBUG, __FUNCTION__, "filtered out.\n"));
+    test_assert(refos_log_set_level(REFOS_LOG_DEBUG) == ESUCCESS);
+
+    /* Fewer records than the ring holds, so none are dropped even if the log server is slow. */
+    uint64_t start = test_time_ns();
+    for (int i = 0; i < TEST_LOG_BENCH_RECORDS; i++) {
+        test_assert(refos_log_printf(REFOS_LOG_DEBUG, __FUNCTION__, "log record %d.\n", i));
+    }
+    uint32_t us = (uint32_t) ((test_time_ns() - start) / 1000);
+    printf("USER_TEST | log %u records in %u us.\n", TEST_LOG_BENCH_RECORDS, us);
+
+    return test_success();
+}
+
+#define TEST_LOG_CORRUPT_TRIES 1000
+
+static int
+test_log_corrupt(void)
+{
+    test_start("log ring corrupt");
+    refos_log_ring_t *r = &refosIOState.logRing;
+    test_assert(r->hdr);
+
+    /* Corrupt the sequence number of the next slot the log server will read, as a misbehaving
+       client could. MPMC slots start with their sequence number. */
+    uint32_t pos = __atomic_load_n(&r->queue.hdr->tail, __ATOMIC_ACQUIRE);
+    uint32_t *seq = (uint32_t *) (r->queue.slots + (pos & r->queue.mask) * r->queue.stride);
+    uint32_t oldSeq = *seq;
+    __atomic_store_n(seq, pos + 0x1000, __ATOMIC_RELEASE);
+    seL4_Signal(refosIOState.logDoorbell);
+
+    /* The log server must detach the ring, and keep answering requests. */
+    refos_err_t error = ESUCCESS;
+    for (int i = 0; i < TEST_LOG_CORRUPT_TRIES; i++) {
+        error = refos_log_set_level(REFOS_LOG_DEBUG);
+        if (error != ESUCCESS) {
+            break;
+        }
+        seL4_Yield();
+    }
+    test_assert(error == ENOPARAMBUFFER);
+
+    /* Put the slot back, and log to stdout from here on, as nobody drains the ring any more. */
+    __atomic_store_n(seq, oldSeq, __ATOMIC_RELEASE);
+    r->hdr = NULL;
+    return test_success();
+}
+
+#endif /* CONFIG_APP_LOG_SERVER */
+
 #endif /* CONFIG_REFOS_RUN_TESTS */
 
 int
@@ -392,8 +941,23 @@ main()
     test_threads();
     test_cvector();
     test_filetable_read();
+    test_filetable_read_cache();
+    test_filetable_read_cache_large();
     test_filetable_write();
+    test_filetable_readdir();
+    test_filetable_readdir_large();
+    test_filetable_readdir_corrupt();
+    test_filetable_stat();
+    test_filetable_read_bench();
     test_gettime();
+#ifdef CONFIG_APP_BLOCK_SERVER
+    test_disk_sequential();
+    test_disk_random();
+#endif
+#ifdef CONFIG_APP_LOG_SERVER
+    test_log();
+    test_log_corrupt();
+#endif
 
     test_print_log();
 #endif
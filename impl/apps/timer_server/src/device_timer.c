@@ -91,33 +91,22 @@ device_timer_update_sleepers(struct device_timer_state *s)
     uint64_t time = device_timer_get_time(s);
 
     /* Loop through and find any fired waiters to reply to. */
-    int count = cvector_count(&s->waiterList);
-    for (int i = 0; i < count; i++) {
-        struct device_timer_waiter *waiter = (struct device_timer_waiter*)
-                cvector_get(&s->waiterList, i);
-        assert(waiter && waiter->magic == TIMESERV_DEVICE_TIMER_WAITER_MAGIC);
-        assert(waiter->reply && waiter->client);
-
-        if (waiter->time > time) {
+    struct srv_reply_waiter *waiter = srv_reply_first(&s->waiterPool);
+    while (waiter) {
+        struct srv_reply_waiter *next = srv_reply_next(waiter);
+        assert(waiter->magic == SRV_REPLY_WAITER_MAGIC && waiter->client);
+
+        if (waiter->arg > time) {
             /* Not yet. */
+            waiter = next;
             continue;
         }
 
-        /* Reply to the waiter. */
-        waiter->client->rpcClient.skip_reply = false;
-        waiter->client->rpcClient.reply = waiter->reply;
+        /* Reply to the waiter, and return the waiter back to the pool. */
+        srv_reply_bind(waiter);
         reply_data_write((void*) waiter->client, sizeof(uint64_t));
-
-        /* Delete the saved reply cap, and free the structure. */
-        waiter->client->rpcClient.reply = 0;
-        csfree_delete(waiter->reply);
-        waiter->magic = 0x0;
-        free(waiter);
-
-        /* Remove the item from the waiter list. */
-        cvector_delete(&s->waiterList, i);
-        count = cvector_count(&s->waiterList);
-        i--;
+        srv_reply_free(waiter);
+        waiter = next;
     }
 }
 
@@ -325,8 +314,14 @@ device_timer_init(struct device_timer_state *s, dev_io_ops_t *io)
         }
     }
 
-    /* Initialise the sleep timer waiter list. */
-    cvector_init(&s->waiterList);
+    /* Initialise the sleep timer waiter pool. */
+    error = srv_reply_pool_init(&s->waiterPool, TIMESERV_DEVICE_TIMER_INITIAL_WAITERS,
+                                SRV_DEFAULT_MAX_CLIENTS);
+    if (error != ESUCCESS) {
+        ROS_ERROR("Could not initialise timer waiter pool.");
+        assert(!"Could not initialise timer waiter pool.");
+        return;
+    }
 
     s->initialised = true;
 }
@@ -351,50 +346,20 @@ device_timer_save_caller_as_waiter(struct device_timer_state *s, struct srv_clie
 {
     assert(s && s->magic == TIMESERV_DEVICE_TIMER_MAGIC);
     assert(c && c->magic == TIMESERV_CLIENT_MAGIC);
-    int error = EINVALID;
 
-    /* Allocate and fill out waiter structure. */
-    struct device_timer_waiter *waiter = malloc(sizeof(struct device_timer_waiter));
+    /* Save current caller into a pooled waiter. (Pool keeps ownership) */
+    struct srv_reply_waiter *waiter = srv_reply_save_caller(&s->waiterPool, c);
     if (!waiter) {
-        ROS_ERROR("device_timer_save_caller_as_waiter failed to alloc waiter struct.");
-        return ENOMEM;
-    }
-    waiter->magic = TIMESERV_DEVICE_TIMER_WAITER_MAGIC;
-    waiter->client = c;
-    waiter->time = (waitTime / TICK_TIMER_SCALE_NS) + device_timer_get_time(s);
-
-    /* Allocate a cslot to save the reply cap into. */
-    waiter->reply = csalloc();
-    if (!waiter->reply) {
-        ROS_ERROR("device_timer_save_caller_as_waiter failed to alloc cslot.");
-        error = ENOMEM;
-        goto exit1;
-    }
-
-    /* Save current caller into the reply cap. */
-    error = seL4_CNode_SaveCaller(REFOS_CSPACE, waiter->reply, REFOS_CDEPTH);
-    if (error != seL4_NoError) {
         ROS_ERROR("device_timer_save_caller_as_waiter failed to save caller.");
-        error = EINVALID;
-        goto exit2;
+        return ENOMEM;
     }
-
-    /* Add to waiter list. (Takes ownership) */
-    cvector_add(&s->waiterList, (cvector_item_t) waiter);
-
+    waiter->arg = (waitTime / TICK_TIMER_SCALE_NS) + device_timer_get_time(s);
     return ESUCCESS;
-
-    /* Exit stack. */
-exit2:
-    csfree(waiter->reply);
-exit1:
-    waiter->magic = 0;
-    free(waiter);
-    return error;
 }
 
 void
-device_timer_purge_client(struct device_timer_state *client)
+device_timer_purge_client(struct device_timer_state *s, struct srv_client *client)
 {
-    assert(!"not implemented.");
+    assert(s && s->magic == TIMESERV_DEVICE_TIMER_MAGIC);
+    srv_reply_cancel_client(client);
 }
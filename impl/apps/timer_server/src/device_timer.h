@@ -13,6 +13,7 @@
 #include <sel4/sel4.h>
 #include <data_struct/cvector.h>
 #include <refos-util/device_io.h>
+#include <refos-util/serv_reply.h>
 #include <platsupport/timer.h>
 #include <platsupport/plat/timer.h>
 
@@ -20,15 +21,7 @@
     @brief timer server timer device manager. */
 
 #define TIMESERV_DEVICE_TIMER_MAGIC 0x54F1A770
-#define TIMESERV_DEVICE_TIMER_WAITER_MAGIC 0x2F4401A9
-
-/*! @brief Timer device waiter structure. */
-struct device_timer_waiter {
-    uint32_t magic;
-    uint64_t time;
-    seL4_CPtr reply;
-    struct srv_client *client; /* No ownership. */
-};
+#define TIMESERV_DEVICE_TIMER_INITIAL_WAITERS 16
 
 /*! @brief Timer device state structure. */
 struct device_timer_state {
@@ -43,7 +36,7 @@ struct device_timer_state {
         Note that this may point to the exact same device as timerDev. */
     pstimer_t *tickDev; /* No ownership. Weak ref to static. */
 
-    cvector_t waiterList; /* struct device_timer_waiter */
+    struct srv_reply_pool waiterPool; /* srv_reply_waiter, arg is the wake up time. */
     uint64_t cumulativeTime; /*!< Current cumulative time. */
     uint64_t timerIRQPeriod;
 };
@@ -72,8 +65,9 @@ int device_timer_save_caller_as_waiter(struct device_timer_state *s, struct srv_
         uint64_t waitTime);
 
 /*! @brief Purge all weak references to client form waiting list. Used when client dies.
+    @param s The global timer device state structure (No ownership).
     @param client The dying client to be purged.
 */
-void device_timer_purge_client(struct device_timer_state *client);
+void device_timer_purge_client(struct device_timer_state *s, struct srv_client *client);
 
 #endif /* _TIMER_SERVER_DEVICE_TIMER_H_ */
\ No newline at end of file
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <fcntl.h>
+#include <sys/stat.h>
 #include "dspace.h"
 #include "timer_dspace.h"
 
@@ -34,6 +36,50 @@ data_open_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_m
     return 0;
 }
 
+seL4_CPtr
+data_open_stat_handler(void *rpc_userptr , char* rpc_name , int rpc_flags , int rpc_mode ,
+                       int rpc_size , uint32_t* rpc_dspaceSize , int* rpc_dspaceMode ,
+                       uint32_t* rpc_dspaceFlags , int* rpc_errno)
+{
+    seL4_CPtr dspace = data_open_handler(rpc_userptr, rpc_name, rpc_flags, rpc_mode, rpc_size,
+                                         rpc_errno);
+    if (!dspace) {
+        return 0;
+    }
+
+    /* Timer dataspaces have no size, are opened with the access mode asked for, and their
+       contents change all the time. */
+    if (rpc_dspaceSize) {
+        (*rpc_dspaceSize) = 0;
+    }
+    if (rpc_dspaceMode) {
+        (*rpc_dspaceMode) = rpc_flags & O_ACCMODE;
+    }
+    if (rpc_dspaceFlags) {
+        (*rpc_dspaceFlags) = 0;
+    }
+    return dspace;
+}
+
+refos_err_t
+data_stat_handler(void *rpc_userptr , char* rpc_name , uint32_t* rpc_size , uint32_t* rpc_mode ,
+                  uint32_t* rpc_mtime , uint32_t* rpc_flags)
+{
+    if (!rpc_name || !rpc_size || !rpc_mode || !rpc_mtime || !rpc_flags) {
+        return EINVALIDPARAM;
+    }
+    if (!(strcmp(rpc_name, "timer") == 0 || strcmp(rpc_name, "time") == 0)) {
+        return EFILENOTFOUND;
+    }
+
+    /* Timer dataspaces are character devices, which always exist and have no size. */
+    (*rpc_size) = 0;
+    (*rpc_mode) = S_IFCHR | S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+    (*rpc_mtime) = 0;
+    (*rpc_flags) = DATA_STAT_IMMUTABLE;
+    return ESUCCESS;
+}
+
 refos_err_t
 data_close_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
 {
@@ -170,6 +216,20 @@ data_provide_data_from_parambuffer_handler(void *rpc_userptr , seL4_CPtr rpc_dsp
     return EUNIMPLEMENTED;
 }
 
+int
+data_aio_bind_handler(void *rpc_userptr , seL4_CPtr rpc_dspace_fd)
+{
+    /* Asynchronous I/O rings are only served by the file server. Not an assert, as clients may
+       probe for ring support and fall back to data_read() and data_write(). */
+    return -EUNIMPLEMENTED;
+}
+
+int
+data_aio_enter_handler(void *rpc_userptr)
+{
+    return -EUNIMPLEMENTED;
+}
+
 int
 check_dispatch_data(srv_msg_t *m, void **userptr)
 {
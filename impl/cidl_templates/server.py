@@ -115,7 +115,7 @@ void reply_{{fname}}(void *rpc_userptr
     {{endfor}}
     ) {\n
 
-____rpc_reset_contents(rpc_userptr);\n
+____rpc_sv_reply_init(rpc_userptr);\n
 
 {{for type, itype, name, mode, dr, apfx, aref, apsfx in oalist}}
     ____rpc_sv_push_{{itype}}{{apfx}}(
@@ -8,6 +8,7 @@
 #define _CHASH_H_
 
 #include <data_struct/cvector.h>
+#include <data_struct/cslab.h>
 
 #ifndef kmalloc
     #include <stdlib.h>
@@ -27,6 +28,7 @@ typedef struct chash_entry_s {
 typedef struct chash_s {
     cvector_t* table;
     size_t tableSize;
+    cslab_t entryCache; // chash_entry_t
 } chash_t;
 
 void chash_init(chash_t *t, size_t sz);
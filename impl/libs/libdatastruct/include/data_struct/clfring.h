@@ -0,0 +1,119 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _CLFRING_H_
+#define _CLFRING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Bounded lock-free rings of fixed-size elements.
+//
+// cspsc_t is a single producer / single consumer ring; cmpmc_t is a multi producer / multi
+// consumer ring, where every slot carries a sequence number which tells producers and consumers
+// whose turn it is to use it. Neither ever blocks: push fails if the ring is full, and pop fails
+// if it is empty.
+//
+// A ring lives entirely inside the memory it is given, with no pointers in it, so it may be put
+// in memory shared between threads or between address spaces. One side formats the memory with
+// cxxx_init(), and any other side (eg. another process which has the memory mapped at a different
+// address) sets up its own handle to it with cxxx_attach(). Handles are local; never share them.
+// The ring geometry is read out of the shared memory once, when the handle is set up, and
+// indices are always masked, so the other side can not make a handle access memory outside of
+// the ring. A misbehaving other side can still corrupt the elements, of course.
+//
+// Indices are free running 32-bit counters, published with release stores and read with acquire
+// loads (the C11 memory model, through the GCC __atomic builtins, so this builds as gnu99 too),
+// which gives the barriers needed on ARMv7 and compiles to plain moves on x86. The head and tail
+// are kept on separate cache lines so the producer and consumer don't false share.
+//
+// Capacity must be a power of two.
+
+#define CLF_CACHE_LINE 64
+#define CLF_SPSC_MAGIC 0x5C5C0001
+#define CLF_MPMC_MAGIC 0x3C3C0001
+
+// Shared ring header, at the start of the ring memory.
+struct clf_header {
+    uint32_t magic;
+    uint32_t capacity;
+    uint32_t elemSize;
+    uint32_t stride;
+    uint32_t head __attribute__((aligned(CLF_CACHE_LINE))); // Consumer side.
+    uint32_t tail __attribute__((aligned(CLF_CACHE_LINE))); // Producer side.
+} __attribute__((aligned(CLF_CACHE_LINE)));
+
+typedef struct cspsc_s {
+    struct clf_header *hdr; // No ownership.
+    char *slots;
+    uint32_t mask;
+    uint32_t elemSize;
+    uint32_t stride;
+    uint32_t headCache; // Producer's last view of the head.
+    uint32_t tailCache; // Consumer's last view of the tail.
+} cspsc_t;
+
+typedef struct cmpmc_s {
+    struct clf_header *hdr; // No ownership.
+    char *slots;
+    uint32_t mask;
+    uint32_t elemSize;
+    uint32_t stride;
+} cmpmc_t;
+
+// ---------------------------- Single producer / single consumer -------------------------------
+
+// Returns the number of bytes of memory a ring needs.
+size_t cspsc_mem_size(uint32_t capacity, uint32_t elemSize);
+
+// Formats a new empty ring in mem, and sets up a handle to it. mem must be 8 byte aligned, and
+// should be CLF_CACHE_LINE aligned to avoid false sharing. Returns 0 on success, or -EINVAL if
+// the parameters are invalid or mem is too small.
+int cspsc_init(cspsc_t *q, void *mem, size_t size, uint32_t capacity, uint32_t elemSize);
+
+// Sets up a handle to a ring formatted by cspsc_init(). Returns 0 on success, or -EINVAL if mem
+// does not hold a valid ring.
+int cspsc_attach(cspsc_t *q, void *mem, size_t size);
+
+// Copies elem onto the ring. Producer only. Returns false if the ring is full.
+bool cspsc_push(cspsc_t *q, const void *elem);
+
+// Copies the oldest element off the ring into elem. Consumer only. Returns false if the ring is
+// empty.
+bool cspsc_pop(cspsc_t *q, void *elem);
+
+// Returns the number of elements on the ring. Only a snapshot, unless called by the producer
+// or consumer and the other side is idle.
+uint32_t cspsc_count(cspsc_t *q);
+
+// ----------------------------- Multi producer / multi consumer --------------------------------
+
+size_t cmpmc_mem_size(uint32_t capacity, uint32_t elemSize);
+
+int cmpmc_init(cmpmc_t *q, void *mem, size_t size, uint32_t capacity, uint32_t elemSize);
+
+int cmpmc_attach(cmpmc_t *q, void *mem, size_t size);
+
+// Safe to call from any number of producers at once. Returns false if the ring is full.
+bool cmpmc_push(cmpmc_t *q, const void *elem);
+
+// Safe to call from any number of consumers at once. Returns false if the ring is empty.
+bool cmpmc_pop(cmpmc_t *q, void *elem);
+
+// Pops as the only consumer of a ring whose producers are not trusted (eg. a ring shared with
+// another process). The consumer position is kept privately in *head, which starts at 0 for a
+// freshly formatted ring, rather than in the shared header, and each call reads the slot's
+// sequence number exactly once; so it never retries, and never spins on memory the producers can
+// write. Returns 1 if an element was popped, 0 if the ring is empty, or -EIO if the slot holds a
+// sequence number no well behaved producer could have left there. A ring which returned -EIO
+// should be given up on.
+int cmpmc_pop_private(cmpmc_t *q, uint32_t *head, void *elem);
+
+// Returns a snapshot of the number of elements on the ring.
+uint32_t cmpmc_count(cmpmc_t *q);
+
+#endif /* _CLFRING_H_ */
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _CLIST_H_
+#define _CLIST_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <assert.h>
+
+// Intrusive linked lists.
+//
+// The list node is embedded in the structure being listed, so adding and removing never
+// allocates, and a structure may be removed from whatever list it is on in O(1) given only a
+// pointer to it. Use clist_entry() to get from a node back to its containing structure.
+//
+// clist_t is a circular doubly linked list with a sentinel head, for FIFO queues which need
+// both ends. chlist_t is a doubly linked list with a single pointer head, for when there are
+// many lists (eg. one per client or per hash bucket) and the head should be as small as possible;
+// it can only be added to at the front.
+//
+// Nodes are NULL linked while not on any list, so clist_linked() / chlist_linked() tell whether
+// a structure is queued. A list head must not be moved in memory once initialised.
+
+#define clist_entry(node, type, member) \
+    ((type *) (((char *) (node)) - offsetof(type, member)))
+
+// ----------------------------------- Doubly linked list --------------------------------------
+
+typedef struct clist_node_s {
+    struct clist_node_s *next;
+    struct clist_node_s *prev;
+} clist_node_t;
+
+typedef struct clist_s {
+    clist_node_t head;
+    size_t count;
+} clist_t;
+
+static inline void
+clist_init(clist_t *l)
+{
+    assert(l);
+    l->head.next = l->head.prev = &l->head;
+    l->count = 0;
+}
+
+static inline void
+clist_node_init(clist_node_t *n)
+{
+    n->next = n->prev = NULL;
+}
+
+static inline bool
+clist_linked(clist_node_t *n)
+{
+    return n->next != NULL;
+}
+
+static inline bool
+clist_empty(clist_t *l)
+{
+    return l->head.next == &l->head;
+}
+
+static inline size_t
+clist_count(clist_t *l)
+{
+    return l->count;
+}
+
+static inline void
+clist_insert_between(clist_t *l, clist_node_t *n, clist_node_t *prev, clist_node_t *next)
+{
+    assert(!clist_linked(n));
+    n->prev = prev;
+    n->next = next;
+    prev->next = n;
+    next->prev = n;
+    l->count++;
+}
+
+static inline void
+clist_add_head(clist_t *l, clist_node_t *n)
+{
+    clist_insert_between(l, n, &l->head, l->head.next);
+}
+
+static inline void
+clist_add_tail(clist_t *l, clist_node_t *n)
+{
+    clist_insert_between(l, n, l->head.prev, &l->head);
+}
+
+static inline void
+clist_remove(clist_t *l, clist_node_t *n)
+{
+    assert(clist_linked(n) && l->count > 0);
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->next = n->prev = NULL;
+    l->count--;
+}
+
+// Returns NULL if the list is empty.
+static inline clist_node_t *
+clist_first(clist_t *l)
+{
+    return clist_empty(l) ? NULL : l->head.next;
+}
+
+static inline clist_node_t *
+clist_last(clist_t *l)
+{
+    return clist_empty(l) ? NULL : l->head.prev;
+}
+
+// Returns NULL at the end of the list.
+static inline clist_node_t *
+clist_next(clist_t *l, clist_node_t *n)
+{
+    return n->next == &l->head ? NULL : n->next;
+}
+
+static inline clist_node_t *
+clist_pop_head(clist_t *l)
+{
+    clist_node_t *n = clist_first(l);
+    if (n) {
+        clist_remove(l, n);
+    }
+    return n;
+}
+
+// Iterates over every node in the list, allowing the current node to be removed.
+#define clist_foreach_safe(l, n, tmp) \
+    for ((n) = clist_first(l), (tmp) = (n) ? clist_next((l), (n)) : NULL; (n); \
+         (n) = (tmp), (tmp) = (n) ? clist_next((l), (n)) : NULL)
+
+// ---------------------------------- Single headed list ---------------------------------------
+
+typedef struct chlist_node_s {
+    struct chlist_node_s *next;
+    struct chlist_node_s **pprev; // Points at the previous node's next, or at the list head.
+} chlist_node_t;
+
+typedef struct chlist_s {
+    chlist_node_t *first;
+} chlist_t;
+
+static inline void
+chlist_init(chlist_t *l)
+{
+    l->first = NULL;
+}
+
+static inline void
+chlist_node_init(chlist_node_t *n)
+{
+    n->next = NULL;
+    n->pprev = NULL;
+}
+
+static inline bool
+chlist_linked(chlist_node_t *n)
+{
+    return n->pprev != NULL;
+}
+
+static inline bool
+chlist_empty(chlist_t *l)
+{
+    return l->first == NULL;
+}
+
+static inline void
+chlist_add_head(chlist_t *l, chlist_node_t *n)
+{
+    assert(!chlist_linked(n));
+    n->next = l->first;
+    if (l->first) {
+        l->first->pprev = &n->next;
+    }
+    l->first = n;
+    n->pprev = &l->first;
+}
+
+static inline void
+chlist_remove(chlist_node_t *n)
+{
+    assert(chlist_linked(n));
+    (*n->pprev) = n->next;
+    if (n->next) {
+        n->next->pprev = n->pprev;
+    }
+    n->next = NULL;
+    n->pprev = NULL;
+}
+
+#define chlist_foreach_safe(l, n, tmp) \
+    for ((n) = (l)->first, (tmp) = (n) ? (n)->next : NULL; (n); \
+         (n) = (tmp), (tmp) = (n) ? (n)->next : NULL)
+
+#endif /* _CLIST_H_ */
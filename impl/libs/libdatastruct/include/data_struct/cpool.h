@@ -7,14 +7,31 @@
 #ifndef _CALLOCPOOL_H_
 #define _CALLOCPOOL_H_
 
+#include <stdint.h>
 #include <stdbool.h>
 #include <data_struct/cvector.h>
 
+// ID pool, handing out IDs from start to end inclusive. Allocation returns 0 when the pool is
+// exhausted.
+//
+// Free IDs are tracked in a bitmap (bit set = free), with a summary bitmap on top of it marking
+// which bitmap words have any free ID in them, so the lowest free ID is found by scanning
+// 1 / 1024th of the pool. IDs are always handed out lowest first, to keep whatever they index
+// packed together. The bitmap only covers IDs below the high-water mark mx (one past the highest
+// allocated ID), rounded up; it grows as mx does, and mx and the bitmap shrink back again as the
+// top IDs are freed.
+
+#define CPOOL_WORD_BITS 32
+#define CPOOL_MIN_WORDS 4
+
 typedef struct cpool_s {
     uint32_t start;
     uint32_t end;
-    uint32_t mx;
-    cvector_t freelist;
+    uint32_t mx; // IDs from mx onwards have never been allocated, or were freed.
+
+    uint32_t *bitmap; // Bit (id - start) set if id is free.
+    uint32_t *summary; // Bit i set if bitmap[i] has any free ID.
+    uint32_t numWords;
 } cpool_t;
 
 void cpool_init(cpool_t *p, uint32_t start, uint32_t end);
@@ -25,6 +42,7 @@ uint32_t cpool_alloc(cpool_t *p);
 
 void cpool_free(cpool_t *p, uint32_t obj);
 
+// Returns true if obj is in range and free.
 bool cpool_check(cpool_t *p, uint32_t obj);
 
 #endif /* _CALLOCPOOL_H_ */
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _CRING_H_
+#define _CRING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef kmalloc
+    #include <stdlib.h>
+    #include <stdint.h>
+    #define kmalloc malloc
+    #define krealloc realloc
+    #define kfree free
+#endif
+
+// Growable FIFO ring, for a single thread.
+//
+// Starts out with room for no items, and doubles its capacity whenever it is pushed to while full,
+// up to maxSize items (0 for no limit). Unlike cqueue, a push only fails once the ring is at
+// maxSize, or malloc fails; memory use follows the number of items actually queued rather than
+// the worst case.
+
+#define CRING_MIN_SIZE 8
+
+typedef void* cring_item_t;
+
+typedef struct cring_s {
+    cring_item_t* data;
+    uint32_t head; // Index of the oldest item.
+    uint32_t count;
+    uint32_t size; // Power of two, or 0.
+    uint32_t maxSize;
+} cring_t;
+
+void cring_init(cring_t *r, uint32_t maxSize);
+
+void cring_release(cring_t *r);
+
+// Returns false if the ring is at maxSize, or out of memory.
+bool cring_push(cring_t *r, cring_item_t e);
+
+// Returns false if the ring is empty.
+bool cring_pop(cring_t *r, cring_item_t *e);
+
+// Returns the oldest item without popping it, or NULL if the ring is empty.
+cring_item_t cring_peek(cring_t *r);
+
+static inline uint32_t cring_count(cring_t *r) {
+    return r->count;
+}
+
+static inline bool cring_full(cring_t *r) {
+    return r->maxSize && r->count >= r->maxSize;
+}
+
+// Frees memory the ring no longer needs, keeping room for at least twice its current items.
+void cring_shrink(cring_t *r);
+
+#endif /* _CRING_H_ */
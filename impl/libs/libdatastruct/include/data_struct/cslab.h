@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _CSLAB_H_
+#define _CSLAB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef kmalloc
+    #include <stdlib.h>
+    #include <stdint.h>
+    #define kmalloc malloc
+    #define krealloc realloc
+    #define kfree free
+#endif
+
+// Slab object cache for fixed-size structures.
+//
+// Objects are carved out of slabs of objsPerSlab objects each, allocated with kmalloc, and are
+// handed out and taken back through a per-slab free list without touching malloc. Partially used
+// slabs are allocated from before empty ones, to keep objects packed together. A slab is only
+// given back to malloc once it is completely free, and one such empty slab is kept around so
+// that a cache which repeatedly allocates and frees a single object does not thrash.
+//
+// The optional ctor is run on every object of a slab when the slab is created, and dtor on every
+// object when it is destroyed; objects must be freed back in their constructed state.
+//
+// Unless CSLAB_DEBUG is defined to 0 (the default when NDEBUG is set), freed objects of caches
+// without a ctor are filled with CSLAB_POISON, which is checked again when they are next
+// allocated to catch writes after free. Double frees are always caught.
+
+#ifndef CSLAB_DEBUG
+    #ifdef NDEBUG
+        #define CSLAB_DEBUG 0
+    #else
+        #define CSLAB_DEBUG 1
+    #endif
+#endif
+
+#define CSLAB_MAGIC 0x5AB5AB00
+#define CSLAB_POISON 0x6B
+#define CSLAB_MAX_EMPTY_SLABS 1
+#define CSLAB_DEFAULT_SLAB_SIZE 4096
+#define CSLAB_MIN_SLAB_OBJS 4
+
+typedef void (*cslab_ctor_t)(void *obj);
+
+struct cslab_slab;
+
+typedef struct cslab_s {
+    // Config.
+    size_t objSize;
+    size_t stride;
+    uint32_t objsPerSlab;
+    cslab_ctor_t ctor;
+    cslab_ctor_t dtor;
+
+    // Members.
+    struct cslab_slab *partial;
+    struct cslab_slab *full;
+    struct cslab_slab *empty;
+    uint32_t numEmpty;
+
+    // Statistics.
+    uint32_t numSlabs;
+    uint32_t numActive;
+    uint32_t peakActive;
+    uint32_t numAllocs;
+    uint32_t numFrees;
+} cslab_t;
+
+// An objsPerSlab of 0 fits as many objects as a CSLAB_DEFAULT_SLAB_SIZE slab holds, but at least
+// CSLAB_MIN_SLAB_OBJS.
+void cslab_init(cslab_t *c, size_t objSize, uint32_t objsPerSlab, cslab_ctor_t ctor,
+                cslab_ctor_t dtor);
+
+// Destroys every slab. Any object still allocated from the cache becomes invalid.
+void cslab_release(cslab_t *c);
+
+void *cslab_alloc(cslab_t *c);
+
+void cslab_free(cslab_t *c, void *obj);
+
+// Gives every empty slab back to malloc.
+void cslab_shrink(cslab_t *c);
+
+#endif /* _CSLAB_H_ */
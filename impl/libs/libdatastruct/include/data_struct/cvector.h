@@ -41,6 +41,9 @@ cvector_item_t cvector_get(cvector_t *v, int index);
 
 void cvector_delete(cvector_t *v, int index);
 
+// Deletes in O(1) by moving the last item into the deleted slot. Does not preserve item order.
+void cvector_delete_unordered(cvector_t *v, int index);
+
 void cvector_free(cvector_t *v);
 
 void cvector_reset(cvector_t *v);
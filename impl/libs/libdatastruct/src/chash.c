@@ -41,6 +41,7 @@ chash_init(chash_t *t, size_t sz)
     t->table = malloc(sizeof(cvector_t) * sz);
     assert(t->table);
     t->tableSize = sz;
+    cslab_init(&t->entryCache, sizeof(chash_entry_t), 0, NULL, NULL);
     for (int i = 0; i < t->tableSize; i++) {
         cvector_init(&t->table[i]);
     }
@@ -58,12 +59,13 @@ chash_release(chash_t *t)
             for (int j = 0; j < c; j++) {
                 chash_entry_t* entry = (chash_entry_t*) cvector_get(&t->table[i], j);
                 if (entry) {
-                    kfree(entry);
+                    cslab_free(&t->entryCache, entry);
                 }
             }
             cvector_free(&t->table[i]);
         }
         free(t->table);
+        cslab_release(&t->entryCache);
     }
     t->table = NULL;
     t->tableSize = 0;
@@ -114,7 +116,7 @@ chash_set(chash_t *t, uint32_t key, chash_item_t obj)
     }
 
     // No previous entry found. Create a new entry.
-    entry = kmalloc(sizeof(chash_entry_t));
+    entry = cslab_alloc(&t->entryCache);
     if (!entry) {
         return -ENOMEM;
     }
@@ -132,8 +134,8 @@ chash_remove(chash_t *t, uint32_t key)
     int index;
     chash_entry_t* entry = chash_get_entry(t, h, key, &index);
     if (entry) {
-        kfree(entry);
-        cvector_delete(&t->table[h], index);
+        cslab_free(&t->entryCache, entry);
+        cvector_delete_unordered(&t->table[h], index);
     }
 }
 
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <data_struct/clfring.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+
+#define CLF_ALIGN 8
+#define CLF_ROUND(x) (((x) + CLF_ALIGN - 1) & ~((uint32_t) CLF_ALIGN - 1))
+#define CLF_SLOTS_OFFSET (sizeof(struct clf_header))
+
+// MPMC slots start with their sequence number.
+#define CLF_MPMC_SEQ_SIZE CLF_ALIGN
+
+#define clf_load_relaxed(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define clf_load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define clf_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static inline bool
+clf_is_pow2(uint32_t x)
+{
+    return x && !(x & (x - 1));
+}
+
+static uint32_t
+clf_stride(uint32_t magic, uint32_t elemSize)
+{
+    uint32_t stride = CLF_ROUND(elemSize);
+    if (magic == CLF_MPMC_MAGIC) {
+        stride += CLF_MPMC_SEQ_SIZE;
+    }
+    return stride;
+}
+
+static size_t
+clf_mem_size(uint32_t magic, uint32_t capacity, uint32_t elemSize)
+{
+    if (!clf_is_pow2(capacity) || elemSize == 0 || elemSize > (1 << 24)) {
+        return 0;
+    }
+    uint64_t sz = CLF_SLOTS_OFFSET + (uint64_t) capacity * clf_stride(magic, elemSize);
+    if (sz != (size_t) sz) {
+        return 0;
+    }
+    return (size_t) sz;
+}
+
+// Formats the shared header. The magic is written last, so an attacher never sees a half
+// formatted ring.
+static int
+clf_format(void *mem, size_t size, uint32_t magic, uint32_t capacity, uint32_t elemSize)
+{
+    size_t need = clf_mem_size(magic, capacity, elemSize);
+    if (!mem || ((uintptr_t) mem % CLF_ALIGN) || !need || size < need) {
+        return -EINVAL;
+    }
+    struct clf_header *hdr = (struct clf_header *) mem;
+    clf_store_release(&hdr->magic, 0);
+    hdr->capacity = capacity;
+    hdr->elemSize = elemSize;
+    hdr->stride = clf_stride(magic, elemSize);
+    hdr->head = 0;
+    hdr->tail = 0;
+    if (magic == CLF_MPMC_MAGIC) {
+        char *slots = ((char *) mem) + CLF_SLOTS_OFFSET;
+        for (uint32_t i = 0; i < capacity; i++) {
+            *((uint32_t *) (slots + i * hdr->stride)) = i;
+        }
+    }
+    clf_store_release(&hdr->magic, magic);
+    return 0;
+}
+
+// Reads and checks the geometry of a formatted ring, exactly once.
+static int
+clf_read_geometry(void *mem, size_t size, uint32_t magic, uint32_t *capacity,
+                  uint32_t *elemSize, uint32_t *stride)
+{
+    if (!mem || ((uintptr_t) mem % CLF_ALIGN) || size < CLF_SLOTS_OFFSET) {
+        return -EINVAL;
+    }
+    struct clf_header *hdr = (struct clf_header *) mem;
+    if (clf_load_acquire(&hdr->magic) != magic) {
+        return -EINVAL;
+    }
+    (*capacity) = clf_load_relaxed(&hdr->capacity);
+    (*elemSize) = clf_load_relaxed(&hdr->elemSize);
+    (*stride) = clf_load_relaxed(&hdr->stride);
+    size_t need = clf_mem_size(magic, *capacity, *elemSize);
+    if (!need || size < need || (*stride) != clf_stride(magic, *elemSize)) {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+// ---------------------------- Single producer / single consumer -------------------------------
+
+size_t
+cspsc_mem_size(uint32_t capacity, uint32_t elemSize)
+{
+    return clf_mem_size(CLF_SPSC_MAGIC, capacity, elemSize);
+}
+
+int
+cspsc_init(cspsc_t *q, void *mem, size_t size, uint32_t capacity, uint32_t elemSize)
+{
+    assert(q);
+    int error = clf_format(mem, size, CLF_SPSC_MAGIC, capacity, elemSize);
+    if (error) {
+        memset(q, 0, sizeof(cspsc_t));
+        return error;
+    }
+    return cspsc_attach(q, mem, size);
+}
+
+int
+cspsc_attach(cspsc_t *q, void *mem, size_t size)
+{
+    assert(q);
+    memset(q, 0, sizeof(cspsc_t));
+    uint32_t capacity, elemSize, stride;
+    int error = clf_read_geometry(mem, size, CLF_SPSC_MAGIC, &capacity, &elemSize, &stride);
+    if (error) {
+        return error;
+    }
+    q->hdr = (struct clf_header *) mem;
+    q->slots = ((char *) mem) + CLF_SLOTS_OFFSET;
+    q->mask = capacity - 1;
+    q->elemSize = elemSize;
+    q->stride = stride;
+    q->headCache = q->tailCache = clf_load_acquire(&q->hdr->head);
+    return 0;
+}
+
+bool
+cspsc_push(cspsc_t *q, const void *elem)
+{
+    assert(q && q->hdr && elem);
+    uint32_t tail = clf_load_relaxed(&q->hdr->tail);
+    if (tail - q->headCache > q->mask) {
+        // Looks full; see how far the consumer has got since we last looked.
+        q->headCache = clf_load_acquire(&q->hdr->head);
+        if (tail - q->headCache > q->mask) {
+            return false;
+        }
+    }
+    memcpy(q->slots + (tail & q->mask) * q->stride, elem, q->elemSize);
+    clf_store_release(&q->hdr->tail, tail + 1);
+    return true;
+}
+
+bool
+cspsc_pop(cspsc_t *q, void *elem)
+{
+    assert(q && q->hdr && elem);
+    uint32_t head = clf_load_relaxed(&q->hdr->head);
+    if (head == q->tailCache) {
+        // Looks empty; see how far the producer has got since we last looked.
+        q->tailCache = clf_load_acquire(&q->hdr->tail);
+        if (head == q->tailCache) {
+            return false;
+        }
+    }
+    memcpy(elem, q->slots + (head & q->mask) * q->stride, q->elemSize);
+    clf_store_release(&q->hdr->head, head + 1);
+    return true;
+}
+
+uint32_t
+cspsc_count(cspsc_t *q)
+{
+    assert(q && q->hdr);
+    uint32_t head = clf_load_acquire(&q->hdr->head);
+    uint32_t n = clf_load_acquire(&q->hdr->tail) - head;
+    return n > q->mask + 1 ? q->mask + 1 : n;
+}
+
+// ----------------------------- Multi producer / multi consumer --------------------------------
+
+static inline uint32_t *
+cmpmc_seq(cmpmc_t *q, uint32_t pos)
+{
+    return (uint32_t *) (q->slots + (pos & q->mask) * q->stride);
+}
+
+static inline void *
+cmpmc_data(cmpmc_t *q, uint32_t pos)
+{
+    return q->slots + (pos & q->mask) * q->stride + CLF_MPMC_SEQ_SIZE;
+}
+
+size_t
+cmpmc_mem_size(uint32_t capacity, uint32_t elemSize)
+{
+    return clf_mem_size(CLF_MPMC_MAGIC, capacity, elemSize);
+}
+
+int
+cmpmc_init(cmpmc_t *q, void *mem, size_t size, uint32_t capacity, uint32_t elemSize)
+{
+    assert(q);
+    int error = clf_format(mem, size, CLF_MPMC_MAGIC, capacity, elemSize);
+    if (error) {
+        memset(q, 0, sizeof(cmpmc_t));
+        return error;
+    }
+    return cmpmc_attach(q, mem, size);
+}
+
+int
+cmpmc_attach(cmpmc_t *q, void *mem, size_t size)
+{
+    assert(q);
+    memset(q, 0, sizeof(cmpmc_t));
+    uint32_t capacity, elemSize, stride;
+    int error = clf_read_geometry(mem, size, CLF_MPMC_MAGIC, &capacity, &elemSize, &stride);
+    if (error) {
+        return error;
+    }
+    q->hdr = (struct clf_header *) mem;
+    q->slots = ((char *) mem) + CLF_SLOTS_OFFSET;
+    q->mask = capacity - 1;
+    q->elemSize = elemSize;
+    q->stride = stride;
+    return 0;
+}
+
+bool
+cmpmc_push(cmpmc_t *q, const void *elem)
+{
+    assert(q && q->hdr && elem);
+    uint32_t pos = clf_load_relaxed(&q->hdr->tail);
+    while (1) {
+        // A slot is free for the producer at pos once its sequence number reaches pos.
+        uint32_t seq = clf_load_acquire(cmpmc_seq(q, pos));
+        int32_t diff = (int32_t) (seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->hdr->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // Another producer claimed it; pos now holds the new tail.
+        } else if (diff < 0) {
+            // The slot still holds an element from the last time around; full.
+            return false;
+        } else {
+            pos = clf_load_relaxed(&q->hdr->tail);
+        }
+    }
+    memcpy(cmpmc_data(q, pos), elem, q->elemSize);
+    clf_store_release(cmpmc_seq(q, pos), pos + 1);
+    return true;
+}
+
+bool
+cmpmc_pop(cmpmc_t *q, void *elem)
+{
+    assert(q && q->hdr && elem);
+    uint32_t pos = clf_load_relaxed(&q->hdr->head);
+    while (1) {
+        // A slot holds an element for the consumer at pos once its sequence number is pos + 1.
+        uint32_t seq = clf_load_acquire(cmpmc_seq(q, pos));
+        int32_t diff = (int32_t) (seq - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->hdr->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Nothing has been pushed into the slot yet; empty.
+            return false;
+        } else {
+            pos = clf_load_relaxed(&q->hdr->head);
+        }
+    }
+    memcpy(elem, cmpmc_data(q, pos), q->elemSize);
+    // Hand the slot to the producer one time around the ring later.
+    clf_store_release(cmpmc_seq(q, pos), pos + q->mask + 1);
+    return true;
+}
+
+int
+cmpmc_pop_private(cmpmc_t *q, uint32_t *head, void *elem)
+{
+    assert(q && q->hdr && head && elem);
+    uint32_t pos = *head;
+    // Until the element at pos is popped, no producer can touch its slot other than the one
+    // which claimed pos, so the sequence number can only be pos (not yet pushed) or pos + 1.
+    uint32_t seq = clf_load_acquire(cmpmc_seq(q, pos));
+    if (seq == pos) {
+        return 0;
+    }
+    if (seq != pos + 1) {
+        return -EIO;
+    }
+    memcpy(elem, cmpmc_data(q, pos), q->elemSize);
+    clf_store_release(cmpmc_seq(q, pos), pos + q->mask + 1);
+    (*head) = pos + 1;
+    // Only published for cmpmc_count(); never read back.
+    clf_store_release(&q->hdr->head, pos + 1);
+    return 1;
+}
+
+uint32_t
+cmpmc_count(cmpmc_t *q)
+{
+    assert(q && q->hdr);
+    uint32_t head = clf_load_acquire(&q->hdr->head);
+    uint32_t n = clf_load_acquire(&q->hdr->tail) - head;
+    return n > q->mask + 1 ? q->mask + 1 : n;
+}
@@ -7,8 +7,56 @@
 #include <data_struct/cvector.h>
 #include <data_struct/cpool.h>
 #include <assert.h>
+#include <string.h>
 #include <errno.h>
 
+#define CPOOL_ALL_FREE 0xFFFFFFFF
+#define CPOOL_NUM_WORDS(nbits) (((nbits) + CPOOL_WORD_BITS - 1) / CPOOL_WORD_BITS)
+
+static inline void
+cpool_summary_update(cpool_t *p, uint32_t w)
+{
+    uint32_t bit = (1u << (w % CPOOL_WORD_BITS));
+    if (p->bitmap[w]) {
+        p->summary[w / CPOOL_WORD_BITS] |= bit;
+    } else {
+        p->summary[w / CPOOL_WORD_BITS] &= ~bit;
+    }
+}
+
+// Resizes the bitmap to the given number of words. New words are all free, and words cut off
+// when shrinking must be all free.
+static bool
+cpool_resize(cpool_t *p, uint32_t numWords)
+{
+    assert(numWords > 0);
+    uint32_t *summary = krealloc(p->summary, CPOOL_NUM_WORDS(numWords) * sizeof(uint32_t));
+    if (!summary) {
+        return false;
+    }
+    p->summary = summary;
+    uint32_t *bitmap = krealloc(p->bitmap, numWords * sizeof(uint32_t));
+    if (!bitmap) {
+        if (numWords > p->numWords) {
+            // The summary may have been made bigger than it needs to be, which is harmless.
+            return false;
+        }
+        // Shrinking in place failed; carry on using the front of the old bitmap.
+        bitmap = p->bitmap;
+    }
+    p->bitmap = bitmap;
+
+    for (uint32_t w = p->numWords; w < numWords; w++) {
+        p->bitmap[w] = CPOOL_ALL_FREE;
+    }
+    memset(p->summary, 0, CPOOL_NUM_WORDS(numWords) * sizeof(uint32_t));
+    p->numWords = numWords;
+    for (uint32_t w = 0; w < numWords; w++) {
+        cpool_summary_update(p, w);
+    }
+    return true;
+}
+
 void
 cpool_init(cpool_t *p, uint32_t start, uint32_t end)
 {
@@ -16,7 +64,9 @@ cpool_init(cpool_t *p, uint32_t start, uint32_t end)
     p->start = start;
     p->end = end;
     p->mx = start;
-    cvector_init(&p->freelist);
+    p->bitmap = NULL;
+    p->summary = NULL;
+    p->numWords = 0;
 }
 
 void
@@ -24,7 +74,8 @@ cpool_release(cpool_t *p) {
     if (!p) {
         return;
     }
-    cvector_free(&p->freelist);
+    if (p->bitmap) kfree(p->bitmap);
+    if (p->summary) kfree(p->summary);
     cpool_init(p, 0, 0);
 }
 
@@ -33,22 +84,38 @@ cpool_alloc(cpool_t *p)
 {
     assert(p);
 
-    // First try to allocate from the free list.
-    size_t fSz = cvector_count(&p->freelist);
-    if (fSz > 0) {
-        // Allocate the last item available on the free list.
-        cvector_item_t obj = cvector_get(&p->freelist, fSz - 1);
-        cvector_delete(&p->freelist, fSz - 1);
-        return (uint32_t) obj;
+    // Find the lowest free ID through the summary.
+    uint32_t numSummary = CPOOL_NUM_WORDS(p->numWords);
+    for (uint32_t s = 0; s < numSummary; s++) {
+        if (!p->summary[s]) {
+            continue;
+        }
+        uint32_t w = s * CPOOL_WORD_BITS + __builtin_ctz(p->summary[s]);
+        assert(w < p->numWords && p->bitmap[w]);
+        uint32_t b = __builtin_ctz(p->bitmap[w]);
+        uint32_t obj = p->start + w * CPOOL_WORD_BITS + b;
+        if (obj > p->end || obj < p->start) {
+            // Lowest free ID is past the end; out of IDs.
+            return 0;
+        }
+        p->bitmap[w] &= ~(1u << b);
+        cpool_summary_update(p, w);
+        if (obj >= p->mx) {
+            p->mx = obj + 1;
+        }
+        return obj;
     }
 
-    // Free list exhausted, allocate by increasing max obj ID..
-    if (p->mx <= p->end) {
-        return (uint32_t) p->mx++;
+    // Every ID the bitmap covers is allocated. Grow it, unless that would go past the end.
+    uint64_t covered = (uint64_t) p->numWords * CPOOL_WORD_BITS;
+    if (p->start + covered > p->end) {
+        return 0;
     }
-
-    // Out of object to allocate.
-    return 0;
+    uint32_t numWords = p->numWords ? p->numWords * 2 : CPOOL_MIN_WORDS;
+    if (!cpool_resize(p, numWords)) {
+        return 0;
+    }
+    return cpool_alloc(p);
 }
 
 void
@@ -58,16 +125,50 @@ cpool_free(cpool_t *p, uint32_t obj)
     if (obj < p->start || obj > p->end || obj >= p->mx) {
         return;
     }
-    if (obj == p->mx) {
-        // Decrease max obj ID.
-        // Note that this implementation doesn't decrease mx for all cases;
-        // decreasing mx properly would require a periodic sort of the freelist,
-        // and a O(n) loop from the end. Doesn't save _that_ much memory.
-        p->mx = (obj - 1);
+    uint32_t i = obj - p->start;
+    uint32_t w = i / CPOOL_WORD_BITS;
+    uint32_t bit = (1u << (i % CPOOL_WORD_BITS));
+    assert(w < p->numWords);
+    if (p->bitmap[w] & bit) {
+        // Already free.
+        return;
+    }
+    p->bitmap[w] |= bit;
+    cpool_summary_update(p, w);
+
+    if (obj + 1 != p->mx) {
         return;
     }
-    // Add to free list.
-    cvector_add(&p->freelist, (cvector_item_t)obj);
+
+    // Lower the high-water mark past every free ID at the top. This is amortised against the
+    // allocations that raised it.
+    i = p->mx - p->start;
+    while (i > 0) {
+        uint32_t j = i - 1;
+        if ((j % CPOOL_WORD_BITS) == CPOOL_WORD_BITS - 1 &&
+                p->bitmap[j / CPOOL_WORD_BITS] == CPOOL_ALL_FREE) {
+            i -= CPOOL_WORD_BITS;
+            continue;
+        }
+        if (!(p->bitmap[j / CPOOL_WORD_BITS] & (1u << (j % CPOOL_WORD_BITS)))) {
+            break;
+        }
+        i--;
+    }
+    p->mx = p->start + i;
+
+    // Give back bitmap memory once the high-water mark drops below a quarter of its size.
+    uint32_t usedWords = CPOOL_NUM_WORDS(i);
+    uint32_t numWords = p->numWords;
+    while (numWords > CPOOL_MIN_WORDS && usedWords * 4 <= numWords) {
+        numWords /= 2;
+    }
+    if (numWords < CPOOL_MIN_WORDS) {
+        numWords = CPOOL_MIN_WORDS;
+    }
+    if (numWords < p->numWords) {
+        cpool_resize(p, numWords);
+    }
 }
 
 bool cpool_check(cpool_t *p, uint32_t obj) {
@@ -75,16 +176,10 @@ bool cpool_check(cpool_t *p, uint32_t obj) {
         // Not free if out of range.
         return false;
     }
-    if (obj > p->mx) {
-        // Free if in the not-allocated-yet range.
+    if (obj >= p->mx) {
+        // Free if above the high-water mark.
         return true;
     }
-    size_t sz = cvector_count(&p->freelist);
-    for (int i = 0; i < sz; i++) {
-        uint32_t x = (uint32_t)cvector_get(&p->freelist, i);
-        if (x == obj) {
-            return true;
-        }
-    }
-    return false;
+    uint32_t i = obj - p->start;
+    return (p->bitmap[i / CPOOL_WORD_BITS] >> (i % CPOOL_WORD_BITS)) & 1;
 }
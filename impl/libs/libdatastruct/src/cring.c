@@ -0,0 +1,111 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <data_struct/cring.h>
+#include <assert.h>
+#include <string.h>
+
+// Moves the items into a new buffer of the given size, oldest first.
+static bool
+cring_resize(cring_t *r, uint32_t size)
+{
+    assert(size >= r->count && !(size & (size - 1)));
+    cring_item_t *data = kmalloc(sizeof(cring_item_t) * size);
+    if (!data) {
+        return false;
+    }
+    for (uint32_t i = 0; i < r->count; i++) {
+        data[i] = r->data[(r->head + i) & (r->size - 1)];
+    }
+    if (r->data) {
+        kfree(r->data);
+    }
+    r->data = data;
+    r->head = 0;
+    r->size = size;
+    return true;
+}
+
+void
+cring_init(cring_t *r, uint32_t maxSize)
+{
+    assert(r);
+    r->data = NULL;
+    r->head = 0;
+    r->count = 0;
+    r->size = 0;
+    r->maxSize = maxSize;
+}
+
+void
+cring_release(cring_t *r)
+{
+    if (!r) {
+        return;
+    }
+    if (r->data) {
+        kfree(r->data);
+    }
+    cring_init(r, r->maxSize);
+}
+
+bool
+cring_push(cring_t *r, cring_item_t e)
+{
+    assert(r);
+    if (cring_full(r)) {
+        return false;
+    }
+    if (r->count == r->size) {
+        uint32_t size = r->size ? r->size * 2 : CRING_MIN_SIZE;
+        if (size < r->size || !cring_resize(r, size)) {
+            return false;
+        }
+    }
+    r->data[(r->head + r->count) & (r->size - 1)] = e;
+    r->count++;
+    return true;
+}
+
+bool
+cring_pop(cring_t *r, cring_item_t *e)
+{
+    assert(r && e);
+    if (r->count == 0) {
+        return false;
+    }
+    (*e) = r->data[r->head];
+    r->head = (r->head + 1) & (r->size - 1);
+    r->count--;
+    return true;
+}
+
+cring_item_t
+cring_peek(cring_t *r)
+{
+    assert(r);
+    if (r->count == 0) {
+        return NULL;
+    }
+    return r->data[r->head];
+}
+
+void
+cring_shrink(cring_t *r)
+{
+    assert(r);
+    if (r->count == 0) {
+        cring_release(r);
+        return;
+    }
+    uint32_t size = r->size;
+    while (size > CRING_MIN_SIZE && r->count * 4 <= size) {
+        size /= 2;
+    }
+    if (size < r->size) {
+        cring_resize(r, size);
+    }
+}
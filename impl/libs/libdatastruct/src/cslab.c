@@ -0,0 +1,280 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <data_struct/cslab.h>
+
+#define CSLAB_ALIGN 8
+#define CSLAB_ROUND(x) (((x) + CSLAB_ALIGN - 1) & ~((size_t) CSLAB_ALIGN - 1))
+#define CSLAB_OBJ_ALLOCATED ((struct cslab_obj *) 1)
+
+// Hidden header in front of every object.
+struct cslab_obj {
+    struct cslab_slab *slab;
+    struct cslab_obj *nextFree; // CSLAB_OBJ_ALLOCATED while the object is allocated.
+};
+
+// Slab header, followed by objsPerSlab objects.
+struct cslab_slab {
+    uint32_t magic;
+    uint32_t numFree;
+    struct cslab_slab *prev;
+    struct cslab_slab *next;
+    struct cslab_obj *freeList;
+};
+
+#define CSLAB_SLAB_HDR_SIZE CSLAB_ROUND(sizeof(struct cslab_slab))
+#define CSLAB_OBJ_HDR_SIZE CSLAB_ROUND(sizeof(struct cslab_obj))
+
+static inline void *
+cslab_obj_data(struct cslab_obj *o)
+{
+    return ((char*) o) + CSLAB_OBJ_HDR_SIZE;
+}
+
+static inline struct cslab_obj *
+cslab_data_obj(void *data)
+{
+    return (struct cslab_obj *) (((char*) data) - CSLAB_OBJ_HDR_SIZE);
+}
+
+static inline struct cslab_obj *
+cslab_slab_obj(cslab_t *c, struct cslab_slab *s, uint32_t i)
+{
+    return (struct cslab_obj *) (((char*) s) + CSLAB_SLAB_HDR_SIZE + i * c->stride);
+}
+
+static void
+cslab_list_add(struct cslab_slab **head, struct cslab_slab *s)
+{
+    s->prev = NULL;
+    s->next = (*head);
+    if (*head) {
+        (*head)->prev = s;
+    }
+    (*head) = s;
+}
+
+static void
+cslab_list_remove(struct cslab_slab **head, struct cslab_slab *s)
+{
+    if (s->prev) {
+        s->prev->next = s->next;
+    } else {
+        assert((*head) == s);
+        (*head) = s->next;
+    }
+    if (s->next) {
+        s->next->prev = s->prev;
+    }
+    s->prev = s->next = NULL;
+}
+
+#if CSLAB_DEBUG
+
+static void
+cslab_poison(cslab_t *c, void *data)
+{
+    if (!c->ctor) {
+        memset(data, CSLAB_POISON, c->objSize);
+    }
+}
+
+static void
+cslab_check_poison(cslab_t *c, void *data)
+{
+    if (c->ctor) {
+        return;
+    }
+    unsigned char *p = (unsigned char*) data;
+    for (size_t i = 0; i < c->objSize; i++) {
+        if (p[i] != CSLAB_POISON) {
+            printf("cslab: object 0x%x written to after free (offset %u).\n",
+                   (uint32_t) (uintptr_t) data, (uint32_t) i);
+            assert(!"cslab: object written to after free.");
+            return;
+        }
+    }
+}
+
+#endif /* CSLAB_DEBUG */
+
+static struct cslab_slab *
+cslab_slab_create(cslab_t *c)
+{
+    struct cslab_slab *s = kmalloc(CSLAB_SLAB_HDR_SIZE + c->objsPerSlab * c->stride);
+    if (!s) {
+        return NULL;
+    }
+    s->magic = CSLAB_MAGIC;
+    s->numFree = c->objsPerSlab;
+    s->prev = s->next = NULL;
+    s->freeList = NULL;
+
+    // Thread the free list backwards, so objects get handed out in address order.
+    for (int i = c->objsPerSlab - 1; i >= 0; i--) {
+        struct cslab_obj *o = cslab_slab_obj(c, s, i);
+        o->slab = s;
+        o->nextFree = s->freeList;
+        s->freeList = o;
+        if (c->ctor) {
+            c->ctor(cslab_obj_data(o));
+        }
+        #if CSLAB_DEBUG
+        cslab_poison(c, cslab_obj_data(o));
+        #endif
+    }
+    c->numSlabs++;
+    return s;
+}
+
+static void
+cslab_slab_destroy(cslab_t *c, struct cslab_slab *s)
+{
+    assert(s && s->magic == CSLAB_MAGIC);
+    if (c->dtor) {
+        for (uint32_t i = 0; i < c->objsPerSlab; i++) {
+            c->dtor(cslab_obj_data(cslab_slab_obj(c, s, i)));
+        }
+    }
+    s->magic = 0;
+    kfree(s);
+    c->numSlabs--;
+}
+
+void
+cslab_init(cslab_t *c, size_t objSize, uint32_t objsPerSlab, cslab_ctor_t ctor,
+           cslab_ctor_t dtor)
+{
+    assert(c);
+    assert(objSize > 0);
+    memset(c, 0, sizeof(cslab_t));
+    c->objSize = objSize;
+    c->stride = CSLAB_OBJ_HDR_SIZE + CSLAB_ROUND(objSize);
+    if (!objsPerSlab) {
+        objsPerSlab = (CSLAB_DEFAULT_SLAB_SIZE - CSLAB_SLAB_HDR_SIZE) / c->stride;
+        if (objsPerSlab < CSLAB_MIN_SLAB_OBJS) {
+            objsPerSlab = CSLAB_MIN_SLAB_OBJS;
+        }
+    }
+    c->objsPerSlab = objsPerSlab;
+    c->ctor = ctor;
+    c->dtor = dtor;
+}
+
+void
+cslab_release(cslab_t *c)
+{
+    if (!c) {
+        return;
+    }
+    struct cslab_slab **lists[] = { &c->partial, &c->full, &c->empty };
+    for (int i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+        while (*lists[i]) {
+            struct cslab_slab *s = (*lists[i]);
+            cslab_list_remove(lists[i], s);
+            cslab_slab_destroy(c, s);
+        }
+    }
+    c->numEmpty = 0;
+    c->numActive = 0;
+}
+
+void *
+cslab_alloc(cslab_t *c)
+{
+    assert(c);
+
+    // Prefer partially used slabs, then the spare empty ones, and only then make a new one.
+    struct cslab_slab *s = c->partial;
+    if (!s) {
+        s = c->empty;
+        if (s) {
+            cslab_list_remove(&c->empty, s);
+            c->numEmpty--;
+        } else {
+            s = cslab_slab_create(c);
+            if (!s) {
+                return NULL;
+            }
+        }
+        cslab_list_add(&c->partial, s);
+    }
+    assert(s->magic == CSLAB_MAGIC && s->numFree > 0);
+
+    struct cslab_obj *o = s->freeList;
+    assert(o && o->slab == s);
+    s->freeList = o->nextFree;
+    o->nextFree = CSLAB_OBJ_ALLOCATED;
+    if (--s->numFree == 0) {
+        cslab_list_remove(&c->partial, s);
+        cslab_list_add(&c->full, s);
+    }
+
+    c->numAllocs++;
+    if (++c->numActive > c->peakActive) {
+        c->peakActive = c->numActive;
+    }
+
+    void *data = cslab_obj_data(o);
+    #if CSLAB_DEBUG
+    cslab_check_poison(c, data);
+    #endif
+    return data;
+}
+
+void
+cslab_free(cslab_t *c, void *obj)
+{
+    assert(c);
+    if (!obj) {
+        return;
+    }
+    struct cslab_obj *o = cslab_data_obj(obj);
+    struct cslab_slab *s = o->slab;
+    assert(s && s->magic == CSLAB_MAGIC);
+    if (o->nextFree != CSLAB_OBJ_ALLOCATED) {
+        printf("cslab: double free of object 0x%x.\n", (uint32_t) (uintptr_t) obj);
+        assert(!"cslab: double free.");
+        return;
+    }
+    #if CSLAB_DEBUG
+    cslab_poison(c, obj);
+    #endif
+
+    if (s->numFree++ == 0) {
+        cslab_list_remove(&c->full, s);
+        cslab_list_add(&c->partial, s);
+    }
+    o->nextFree = s->freeList;
+    s->freeList = o;
+    c->numFrees++;
+    c->numActive--;
+
+    if (s->numFree == c->objsPerSlab) {
+        cslab_list_remove(&c->partial, s);
+        if (c->numEmpty < CSLAB_MAX_EMPTY_SLABS) {
+            cslab_list_add(&c->empty, s);
+            c->numEmpty++;
+        } else {
+            cslab_slab_destroy(c, s);
+        }
+    }
+}
+
+void
+cslab_shrink(cslab_t *c)
+{
+    assert(c);
+    while (c->empty) {
+        struct cslab_slab *s = c->empty;
+        cslab_list_remove(&c->empty, s);
+        cslab_slab_destroy(c, s);
+    }
+    c->numEmpty = 0;
+}
@@ -79,6 +79,16 @@ cvector_delete(cvector_t *v, int index)
     cvector_delete_resize(v);
 }
 
+void
+cvector_delete_unordered(cvector_t *v, int index)
+{
+    assert(v);
+    assert(index < v->count);
+    v->data[index] = v->data[v->count - 1];
+    v->count--;
+    cvector_delete_resize(v);
+}
+
 void
 cvector_free(cvector_t *v)
 {
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+// Host stress test and throughput benchmark for the lock-free rings in src/clfring.c.
+//
+// Runs every ring flavour with real threads racing on it, and checks that every item pushed is
+// popped exactly once, and that each consumer sees each producer's items in the order they were
+// pushed. Then times a fixed number of items through each flavour. Exits non-zero on failure.
+//
+//   cc -O2 -pthread -I../include -o clfring_stress clfring_stress.c ../src/clfring.c
+//   ./clfring_stress [items per producer]
+
+#include <data_struct/clfring.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#define MAX_THREADS 8
+#define RING_CAPACITY 256
+#define DEFAULT_ITEMS 1000000
+
+// Ring element. Padded out to a realistic message size.
+struct item {
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t pad[6];
+};
+
+enum ring_kind {
+    RING_SPSC,
+    RING_MPMC,
+    RING_MPMC_PRIVATE, // cmpmc_push() producers, cmpmc_pop_private() consumer.
+};
+
+struct run {
+    enum ring_kind kind;
+    int producers;
+    int consumers;
+    uint32_t items; // Per producer.
+
+    cspsc_t spsc;
+    cmpmc_t mpmc;
+    void *mem;
+
+    uint8_t *seen; // Pop count of each item, indexed by producer * items + seq.
+    uint32_t popped; // Total popped; consumers stop once it reaches producers * items.
+    uint32_t errors;
+    pthread_barrier_t start;
+};
+
+struct thread_arg {
+    struct run *run;
+    uint32_t id;
+};
+
+static void
+fail(struct run *r, const char *what, uint32_t producer, uint32_t seq)
+{
+    if (__atomic_fetch_add(&r->errors, 1, __ATOMIC_RELAXED) < 10) {
+        fprintf(stderr, "FAIL: %s (producer %u seq %u)\n", what, producer, seq);
+    }
+}
+
+static void *
+producer_main(void *p)
+{
+    struct thread_arg *a = p;
+    struct run *r = a->run;
+    struct item it;
+    memset(&it, 0, sizeof(it));
+    it.producer = a->id;
+    pthread_barrier_wait(&r->start);
+
+    for (uint32_t i = 0; i < r->items; i++) {
+        it.seq = i;
+        while (!(r->kind == RING_SPSC ? cspsc_push(&r->spsc, &it) : cmpmc_push(&r->mpmc, &it))) {
+            // Full; let a consumer run, in case they share a CPU.
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *
+consumer_main(void *p)
+{
+    struct thread_arg *a = p;
+    struct run *r = a->run;
+    uint32_t total = r->producers * r->items;
+    uint32_t next[MAX_THREADS] = {0}; // Lowest seq this consumer may still see from each producer.
+    uint32_t head = 0;
+    struct item it;
+    pthread_barrier_wait(&r->start);
+
+    while (__atomic_load_n(&r->popped, __ATOMIC_RELAXED) < total) {
+        bool got;
+        if (r->kind == RING_SPSC) {
+            got = cspsc_pop(&r->spsc, &it);
+        } else if (r->kind == RING_MPMC) {
+            got = cmpmc_pop(&r->mpmc, &it);
+        } else {
+            int n = cmpmc_pop_private(&r->mpmc, &head, &it);
+            if (n < 0) {
+                fail(r, "cmpmc_pop_private found a well behaved ring corrupt", 0, head);
+                break;
+            }
+            got = n > 0;
+        }
+        if (!got) {
+            sched_yield();
+            continue;
+        }
+
+        if (it.producer >= (uint32_t) r->producers || it.seq >= r->items) {
+            fail(r, "item out of range", it.producer, it.seq);
+        } else {
+            if (it.seq < next[it.producer]) {
+                fail(r, "item out of order", it.producer, it.seq);
+            }
+            next[it.producer] = it.seq + 1;
+            if (__atomic_fetch_add(&r->seen[it.producer * r->items + it.seq], 1,
+                                   __ATOMIC_RELAXED) != 0) {
+                fail(r, "item popped twice", it.producer, it.seq);
+            }
+        }
+        __atomic_fetch_add(&r->popped, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Runs items through a ring with the given number of producer and consumer threads, checks the
+// result, and prints the throughput. Returns the number of errors.
+static uint32_t
+run_ring(enum ring_kind kind, int producers, int consumers, uint32_t items)
+{
+    static const char *names[] = { "spsc", "mpmc", "mpmc/private" };
+    struct run r;
+    memset(&r, 0, sizeof(r));
+    r.kind = kind;
+    r.producers = producers;
+    r.consumers = consumers;
+    r.items = items;
+
+    size_t size = (kind == RING_SPSC) ? cspsc_mem_size(RING_CAPACITY, sizeof(struct item)) :
+                  cmpmc_mem_size(RING_CAPACITY, sizeof(struct item));
+    if (posix_memalign(&r.mem, CLF_CACHE_LINE, size) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+    int error = (kind == RING_SPSC) ?
+                cspsc_init(&r.spsc, r.mem, size, RING_CAPACITY, sizeof(struct item)) :
+                cmpmc_init(&r.mpmc, r.mem, size, RING_CAPACITY, sizeof(struct item));
+    r.seen = calloc((size_t) producers * items, 1);
+    if (error || !r.seen) {
+        fprintf(stderr, "could not set up ring\n");
+        exit(2);
+    }
+    pthread_barrier_init(&r.start, NULL, producers + consumers + 1);
+
+    pthread_t threads[MAX_THREADS * 2];
+    struct thread_arg args[MAX_THREADS * 2];
+    for (int i = 0; i < producers + consumers; i++) {
+        args[i].run = &r;
+        args[i].id = (i < producers) ? i : i - producers;
+        pthread_create(&threads[i], NULL, (i < producers) ? producer_main : consumer_main,
+                       &args[i]);
+    }
+    pthread_barrier_wait(&r.start);
+    uint64_t start = now_ns();
+    for (int i = 0; i < producers + consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t ns = now_ns() - start;
+
+    // Every item popped exactly once.
+    uint64_t total = (uint64_t) producers * items;
+    for (uint64_t i = 0; i < total; i++) {
+        if (r.seen[i] != 1) {
+            fail(&r, "item lost or duplicated", (uint32_t) (i / items), (uint32_t) (i % items));
+        }
+    }
+
+    printf("%-13s %dP/%dC: %10llu items in %6llu ms, %6.1f Mitems/s %s\n", names[kind],
+           producers, consumers, (unsigned long long) total, (unsigned long long) (ns / 1000000),
+           ns ? (double) total * 1000.0 / ns : 0.0, r.errors ? "FAIL" : "ok");
+
+    pthread_barrier_destroy(&r.start);
+    free(r.seen);
+    free(r.mem);
+    return r.errors;
+}
+
+// A consumer of an untrusted ring must give up on a corrupted slot, rather than spin on it.
+static uint32_t
+check_pop_private_corrupt(void)
+{
+    size_t size = cmpmc_mem_size(RING_CAPACITY, sizeof(struct item));
+    void *mem;
+    if (posix_memalign(&mem, CLF_CACHE_LINE, size) != 0) {
+        exit(2);
+    }
+    cmpmc_t q;
+    cmpmc_init(&q, mem, size, RING_CAPACITY, sizeof(struct item));
+    struct item it;
+    memset(&it, 0, sizeof(it));
+    uint32_t head = 0;
+    uint32_t errors = 0;
+
+    errors += cmpmc_pop_private(&q, &head, &it) != 0;
+    errors += !cmpmc_push(&q, &it);
+    errors += cmpmc_pop_private(&q, &head, &it) != 1 || head != 1;
+
+    // Slots start with their sequence number. Scribble over the next one, as a hostile producer
+    // sharing the ring could.
+    uint32_t *seq = (uint32_t *) (q.slots + (head & q.mask) * q.stride);
+    for (uint32_t bad = head + 2; bad != head + 6; bad++) {
+        *seq = bad;
+        errors += cmpmc_pop_private(&q, &head, &it) != -EIO || head != 1;
+    }
+    *seq = head - 1;
+    errors += cmpmc_pop_private(&q, &head, &it) != -EIO || head != 1;
+
+    printf("mpmc/private corrupt slot: %s\n", errors ? "FAIL" : "ok");
+    free(mem);
+    return errors;
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32_t items = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 0) : DEFAULT_ITEMS;
+    if (items == 0) {
+        fprintf(stderr, "usage: %s [items per producer]\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t errors = 0;
+    errors += run_ring(RING_SPSC, 1, 1, items);
+    errors += run_ring(RING_MPMC, 1, 1, items);
+    errors += run_ring(RING_MPMC, 4, 1, items);
+    errors += run_ring(RING_MPMC, 1, 4, items);
+    errors += run_ring(RING_MPMC, 4, 4, items);
+    errors += run_ring(RING_MPMC, 8, 8, items / 4 ? items / 4 : 1);
+    errors += run_ring(RING_MPMC_PRIVATE, 1, 1, items);
+    errors += run_ring(RING_MPMC_PRIVATE, 4, 1, items);
+    errors += check_pop_private_corrupt();
+
+    if (errors) {
+        printf("%u errors.\n", errors);
+        return 1;
+    }
+    printf("All passed.\n");
+    return 0;
+}
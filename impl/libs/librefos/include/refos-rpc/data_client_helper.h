@@ -31,6 +31,11 @@
 #define DSPACE_FLAG_DEVICE_PADDR 0x10000000
 #define DSPACE_FLAG_UNCACHED     0x20000000
 
+/*! @brief data_stat() flag, set if the dataspace's metadata never changes while its server runs, so
+           the result may be cached by the client. Set by data_open_stat() only if the contents
+           never change either. */
+#define DATA_STAT_IMMUTABLE 0x1
+
 /*! @brief Structure containing state for a mapped dataspace. */
 typedef struct data_mapping {
     seL4_CPtr session; /* No ownership. */
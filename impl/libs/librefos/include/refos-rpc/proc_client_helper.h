@@ -140,6 +140,139 @@ proc_create_mem_window(uint32_t vaddr, uint32_t size)
     return proc_create_mem_window_ext(vaddr, size, PROC_WINDOW_PERMISSION_READWRITE, 0x0);
 }
 
+/*! @brief Create a new memory window segment backed by its own new anonymous dataspace. Helper
+           function for proc_create_anon_mem_window_internal(). Permission is set to
+           PROC_WINDOW_PERMISSION_READWRITE, and flags 0x0.
+    @param vaddr The window base address in the calling client's VSpace.
+    @param size The size of the mem window and its dataspace.
+    @return Capability to created window if success, 0 otherwise (errno will be set).
+*/
+static inline seL4_CPtr
+proc_create_anon_mem_window(uint32_t vaddr, uint32_t size)
+{
+    refos_err_t errnoRetVal = EINVALID;
+    seL4_CPtr tcap = proc_create_anon_mem_window_internal(vaddr, size,
+            PROC_WINDOW_PERMISSION_READWRITE, 0x0, &errnoRetVal);
+    if (errnoRetVal != ESUCCESS || tcap == 0) {
+        REFOS_SET_ERRNO(errnoRetVal);
+        return 0;
+    }
+    REFOS_SET_ERRNO(ESUCCESS);
+    return tcap;
+}
+
+/*! @brief Append an operation to a multicall operation table. Helper function for building the
+           operation table passed to proc_multicall().
+    @param ops The operation table to append to.
+    @param nops The number of operations in the table, incremented here.
+    @param opcode The operation (see enum proc_multicall_opcode).
+    @param a0 First argument of the operation, 0 if unused.
+    @param a1 Second argument of the operation, 0 if unused.
+    @param a2 Third argument of the operation, 0 if unused.
+    @param a3 Fourth argument of the operation, 0 if unused.
+    @return The slot of the appended operation, which later operations may refer to.
+*/
+static inline int
+proc_multicall_op(struct proc_multicall_ops *ops, int *nops, seL4_Word opcode, seL4_Word a0,
+                  seL4_Word a1, seL4_Word a2, seL4_Word a3)
+{
+    assert(ops && nops);
+    assert((*nops) >= 0 && (*nops) < PROCSERV_MULTICALL_MAX_OPS);
+    struct proc_multicall_op *op = &ops->op[*nops];
+    op->opcode = opcode;
+    op->arg[0] = a0;
+    op->arg[1] = a1;
+    op->arg[2] = a2;
+    op->arg[3] = a3;
+    return (*nops)++;
+}
+
+/*! @brief Run a batch of process server operations in a single call. Helper function for
+           proc_multicall_internal().
+    @param cap Window or dataspace capability operations may refer to as
+               PROCSERV_MULTICALL_SLOT_CAP, or 0 if none. (No ownership)
+    @param ops The operation table, built with proc_multicall_op().
+    @param nops The number of operations in the table.
+    @param retSlot The slot holding the window or dataspace to return a capability to, or
+                   PROCSERV_MULTICALL_SLOT_NONE.
+    @param results Optional output result values of the operations.
+    @return Capability to the object in retSlot if success and one was asked for, 0 otherwise
+            (errno will be set).
+*/
+static inline seL4_CPtr
+proc_multicall(seL4_CPtr cap, struct proc_multicall_ops *ops, int nops, int retSlot,
+               struct proc_multicall_results *results)
+{
+    refos_err_t errnoRetVal = EINVALID;
+    struct proc_multicall_results tresults;
+    seL4_CPtr tcap = proc_multicall_internal(cap, ops, nops, retSlot,
+            results ? results : &tresults, &errnoRetVal);
+    if (errnoRetVal != ESUCCESS) {
+        REFOS_SET_ERRNO(errnoRetVal);
+        return 0;
+    }
+    REFOS_SET_ERRNO(ESUCCESS);
+    return tcap;
+}
+
+/*! @brief Create a new memory window segment and map the given dataspace into it, in a single
+           call. Permission is set to PROC_WINDOW_PERMISSION_READWRITE, and flags 0x0.
+    @param vaddr The window base address in the calling client's VSpace.
+    @param size The size of the mem window.
+    @param dataspace The process server anonymous dataspace to map. (No ownership)
+    @param offset The offset into the dataspace to map from.
+    @return Capability to created window if success, 0 otherwise (errno will be set).
+*/
+static inline seL4_CPtr
+proc_create_mem_window_map(uint32_t vaddr, uint32_t size, seL4_CPtr dataspace, uint32_t offset)
+{
+    struct proc_multicall_ops ops;
+    int nops = 0;
+    int window = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_CREATE_MEM_WINDOW, vaddr, size,
+                                   PROC_WINDOW_PERMISSION_READWRITE, 0x0);
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_DATAMAP, PROCSERV_MULTICALL_SLOT_CAP,
+                      window, offset, 0);
+    return proc_multicall(dataspace, &ops, nops, window, NULL);
+}
+
+/*! @brief Open a new anonymous dataspace, create a memory window segment and map the dataspace
+           into it, in a single call. Permission is set to PROC_WINDOW_PERMISSION_READWRITE, and
+           flags 0x0.
+
+    Unlike proc_create_anon_mem_window(), the dataspace does not belong to the window; it may be
+    of a different size, and it is not expanded when the window is resized. If no dataspace
+    capability is asked for, the dataspace lives on only as long as the window does.
+
+    @param vaddr The window base address in the calling client's VSpace.
+    @param windowSize The size of the mem window.
+    @param dspaceSize The size of the dataspace.
+    @param dataspace Optional output capability to the opened dataspace, which should be closed
+                     with data_close() once no longer needed. (Gives ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static inline refos_err_t
+proc_create_anon_segment(uint32_t vaddr, uint32_t windowSize, uint32_t dspaceSize,
+                         seL4_CPtr *dataspace)
+{
+    struct proc_multicall_ops ops;
+    int nops = 0;
+    int dspace = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_OPEN_ANON, dspaceSize,
+                                   0, 0, 0);
+    int window = proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_CREATE_MEM_WINDOW, vaddr,
+                                   windowSize, PROC_WINDOW_PERMISSION_READWRITE, 0x0);
+    proc_multicall_op(&ops, &nops, PROCSERV_MULTICALL_DATAMAP, dspace, window, 0, 0);
+
+    seL4_CPtr tcap = proc_multicall(0, &ops, nops,
+            dataspace ? dspace : PROCSERV_MULTICALL_SLOT_NONE, NULL);
+    if (REFOS_GET_ERRNO() != ESUCCESS) {
+        return REFOS_GET_ERRNO();
+    }
+    if (dataspace) {
+        (*dataspace) = tcap;
+    }
+    return ESUCCESS;
+}
+
 /*! @brief Clones a new thread for process. Helper function for proc_clone_internal().
     @param func The entry point function of the new thread.
     @param childStack The stack vaddr of the new thread.
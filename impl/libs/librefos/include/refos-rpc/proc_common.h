@@ -21,6 +21,57 @@
 
 #define PROCSERV_NOTIFICATION_MAGIC 0xB0BA11CE
 
+/*! @brief Maximum number of frames which may be mapped by a single proc_window_map_range(). */
+#define PROCSERV_WINDOW_MAP_RANGE_MAX 64
+
+/*! @brief Maximum number of operations in a single proc_multicall_internal(). The operation and
+           result tables are sent whole, and have to fit into the IPC buffer. */
+#define PROCSERV_MULTICALL_MAX_OPS 8
+#define PROCSERV_MULTICALL_MAX_ARGS 4
+
+/*! @brief Multicall operation argument referring to the capability passed into the multicall,
+           rather than to the result of an earlier operation. */
+#define PROCSERV_MULTICALL_SLOT_CAP 0xFF
+
+/*! @brief Multicall return slot value for returning no capability. */
+#define PROCSERV_MULTICALL_SLOT_NONE -1
+
+/*! @brief Process server multicall operations.
+
+    Each operation takes up to PROCSERV_MULTICALL_MAX_ARGS arguments. Arguments which name a window
+    or dataspace are slots: the index of an earlier operation in the same multicall which produced
+    that object, or PROCSERV_MULTICALL_SLOT_CAP. Every other argument is a plain value.
+*/
+enum proc_multicall_opcode {
+    PROCSERV_MULTICALL_CREATE_MEM_WINDOW,     /* (vaddr, size, permissions, flags) -> window */
+    PROCSERV_MULTICALL_GET_MEM_WINDOW,        /* (vaddr) -> window */
+    PROCSERV_MULTICALL_RESIZE_MEM_WINDOW,     /* (window slot, size) */
+    PROCSERV_MULTICALL_WINDOW_GETID,          /* (window slot) -> window ID result */
+    PROCSERV_MULTICALL_OPEN_ANON,             /* (size) -> dataspace */
+    PROCSERV_MULTICALL_GET_MEM_WINDOW_DSPACE, /* (window slot) -> dataspace */
+    PROCSERV_MULTICALL_DATAMAP,               /* (dataspace slot, window slot, offset) */
+    PROCSERV_MULTICALL_SET_PARAMBUFFER,       /* (dataspace slot) */
+    PROCSERV_MULTICALL_NOTIFICATION_BUFFER,   /* (dataspace slot) */
+    PROCSERV_MULTICALL_NUM_OPCODES
+};
+
+/*! @brief A single process server multicall operation. */
+struct proc_multicall_op {
+    seL4_Word opcode;
+    seL4_Word arg[PROCSERV_MULTICALL_MAX_ARGS];
+};
+
+/*! @brief Process server multicall operation table. */
+struct proc_multicall_ops {
+    struct proc_multicall_op op[PROCSERV_MULTICALL_MAX_OPS];
+};
+
+/*! @brief Process server multicall result table. Holds the result value of each operation; 0 for
+           operations which have none. */
+struct proc_multicall_results {
+    seL4_Word result[PROCSERV_MULTICALL_MAX_OPS];
+};
+
 enum proc_notify_types {
     PROCSERV_NOTIFY_FAULT_DELEGATION,
     PROCSERV_NOTIFY_CONTENT_INIT,
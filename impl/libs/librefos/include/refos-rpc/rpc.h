@@ -57,6 +57,42 @@
 // ------------------------------------------- RPC Helper ------------------------------------------
 // -------------------------------------------------------------------------------------------------
 
+/**
+ * The per-thread RPC state. The state is otherwise global, so processes which RPC from more than
+ * one thread at once (e.g. multi-threaded servers) give each such thread its own state through
+ * @ref rpc_thread_state_init. The helper pool used by @ref rpc_malloc is shared by all threads.
+ */
+typedef struct rpc_thread_state_s {
+    uint32_t mr;
+    uint32_t cp;
+    cslot recv_cslot;
+    ENDPT dest_ep;
+    msginfo_t minfo;
+    uint32_t label;
+    const char *name;
+
+    /* Server reply state, used to combine the reply to the current caller and waiting for the
+       next message into a single seL4_ReplyRecv, which the kernel IPC fastpath can handle. */
+    bool sv_reply_recv;
+    bool sv_reply_pending;
+    msginfo_t sv_reply_minfo;
+    seL4_Word sv_reply_mr[seL4_MsgMaxLength];
+} rpc_thread_state_t;
+
+/**
+ * Use the given state for every subsequent RPC made from the calling thread. Must be called on the
+ * thread itself, before its first RPC, as the state is found through its IPC buffer.
+ * @param[in] state      The state to use. (No ownership, must outlive the thread)
+ * @param[in] recv_cslot CSpace slot to recieve caps into, or 0 to set it up on first RPC.
+ */
+void rpc_thread_state_init(rpc_thread_state_t *state, cslot recv_cslot);
+
+/**
+ * Retrieve the calling thread's RPC state.
+ * @return             The state given to @ref rpc_thread_state_init, or the process-wide default.
+ */
+rpc_thread_state_t* rpc_get_thread_state(void);
+
 /**
  * A helper function to allocate & manage the allocated memory for an RPC. Works like cstdlib
  * malloc().
@@ -319,13 +355,39 @@ void rpc_sv_push_cptr(void *cl, ENDPT v);
  */
 void rpc_sv_push_buf_array(void *cl, rpc_buffer_t v, size_t sz);
 
+/**
+ * Resets the data pointers in the send buffer, ready to build a reply. Replies carry no label, so
+ * unlike calls their contents start at MR0; this keeps small replies within the kernel IPC
+ * fastpath message length.
+ * @param[in] cl       Generic reference to caller client state structure.
+ */
+void rpc_sv_reply_init(void *cl);
+
 /**
  * Reply to the client RPC. Depending on whether the reply is immediate or saved-first then replied
  * later, this function should send to the correct corresponding reply endpoint in either case. 
+ * If the server loop uses @ref rpc_sv_reply_recv, a reply to the current caller which does not
+ * transfer caps is held back and sent by the next @ref rpc_sv_reply_recv instead.
  * @param[in] cl       Generic reference to caller client state structure.
  */
 void rpc_sv_reply(void* cl);
 
+/**
+ * Reply to the current caller if there is a held back reply, and wait for the next message, in a
+ * single seL4_ReplyRecv. Servers should call this in their main loop in place of seL4_Recv; the
+ * combined syscall with a short, cap-less message is eligible for the kernel IPC fastpath.
+ * @param[in] ep       The endpoint to receive the next message on.
+ * @param[out] badge   The badge of the received message.
+ * @return             The message info of the received message.
+ */
+seL4_MessageInfo_t rpc_sv_reply_recv(seL4_CPtr ep, seL4_Word *badge);
+
+/**
+ * Send the reply held back for the next @ref rpc_sv_reply_recv right away, if there is one. Lets
+ * a server do some housekeeping between messages without keeping the current caller waiting.
+ */
+void rpc_sv_reply_flush(void);
+
 /**
  * End the current RPC for the given client caller and release all tis allocated objects.
  * @param[in] cl       Generic reference to caller client state structure.
@@ -11,6 +11,7 @@
 #include <refos-rpc/rpc.h>
 #include <refos/refos.h>
 #include <refos/error.h>
+#include <refos/aio_ring.h>
 #include <refos-rpc/serv_client.h>
 #include <refos-rpc/data_client.h>
 #include <refos-rpc/data_client_helper.h>
@@ -39,6 +40,11 @@ typedef struct serv_connection_s {
     seL4_CPtr serverSession;  /* Has ownership. */
     data_mapping_t paramBuffer;  /* Has ownership. */
     bool connectionLess;
+
+    /* Asynchronous I/O ring, see serv_connect_aio(). Not set up if aioRing.hdr is NULL. */
+    data_mapping_t aioRingBuffer;  /* Has ownership. */
+    refos_aio_ring_t aioRing;
+    seL4_CPtr aioDoorbell;  /* Has ownership. */
 } serv_connection_t;
 
 /*! @brief Connect to server at the given path. Helper function for serv_connect_direct(). Set up
@@ -57,6 +63,32 @@ serv_connection_t serv_connect(char *serverPath);
 */
 serv_connection_t serv_connect_no_pbuffer(char *serverPath);
 
+/*! @brief Connect to server at the given path. Helper function for serv_connect_direct(). Does not
+           set up a parameter buffer, and does not ping the server after connecting; the first
+           call made on the session doubles as the check that the server is alive. Useful together
+           with compound calls such as data_open_stat(), where the connection is set up in order
+           to make a single call.
+    @param serverPath The namespace path of server to connect to.
+    @return Struct containing the open server connection info. Check the error member of the
+            struct in order to check for failure. (Gives ownership)
+*/
+serv_connection_t serv_connect_fast(char *serverPath);
+
+/*! @brief Set up an asynchronous I/O ring on an open server connection.
+
+    Creates and maps an anonymous dataspace, formats a submission / completion ring in it, and
+    hands it to the server. Operations may then be queued with refos_aio_sq_push() on sc->aioRing,
+    and handed to the server by signalling sc->aioDoorbell, or by calling data_aio_enter() to also
+    wait for them. The ring is released by serv_disconnect().
+
+    @param sc The open server connection. (No ownership)
+    @param entries The number of submission / completion entries.
+    @param size The size of the ring dataspace, including its data area.
+    @return ESUCCESS if success, refos_err_t otherwise. EUNIMPLEMENTED if the server does not
+            support asynchronous I/O rings.
+*/
+refos_err_t serv_connect_aio(serv_connection_t *sc, uint32_t entries, uint32_t size);
+
 /*! @brief Disconnect from the server, unmap and delete parameter buffer, and release the memory
            associated.
     @param sc The server connection state structure to disconnect. Does NOT free the structure
@@ -11,7 +11,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <sel4/sel4.h>
-#include <data_struct/chash.h>
 #include <refos-rpc/data_client.h>
 #include <refos-rpc/data_client_helper.h>
 #include <platsupport/io.h>
@@ -23,12 +22,34 @@
 #define DEVICE_IO_DEV_MAPPING_MAGIC 0x57545A05
 
 /* We don't need a huge table here; there aren't that many total devices on a system. */
-#define DEVICE_MMIO_MAPPING_HASHTABLE_SIZE 128
+#define DEVICE_MMIO_MAX_MAPPINGS 32
+
+/* Number of unused MMIO mappings kept around, so a driver which maps and unmaps the same registers
+   over and over again (eg. on every timer reconfiguration) does not go to the process server
+   every time. */
+#define DEVICE_MMIO_MAX_IDLE_MAPPINGS 4
+
+/*! @brief Device MMIO mapping cache entry.
+
+    Mappings are cached by page aligned physical range. Any map request which falls inside an
+    existing mapping with the same cache attribute shares it, and a mapping is only released once
+    it is no longer referenced and has been pushed out of the idle set.
+*/
+struct dev_io_mmio_mapping {
+    bool valid;
+    uintptr_t paddr;      /*!< Page aligned physical base address. */
+    size_t size;          /*!< Size in bytes, page aligned. */
+    bool cached;
+    int refCount;         /*!< Number of outstanding dev_io_map() users. 0 means idle. */
+    uint32_t lastUse;
+    data_mapping_t mapping;
+};
 
 /*! @brief Global Device IO state structure. */
 typedef struct dev_io_ops {
     struct ps_io_ops opsIO;
-    chash_t MMIOMappings; /*!< vaddr --> data_mapping_t */
+    struct dev_io_mmio_mapping MMIOMappings[DEVICE_MMIO_MAX_MAPPINGS];
+    uint32_t MMIOUseCounter;
     seL4_CPtr IOPorts;
     uint32_t magic;
 } dev_io_ops_t;
@@ -43,4 +64,50 @@ typedef struct dev_io_ops {
 */
 void devio_init(dev_io_ops_t *io);
 
+/* ------------------------------------ Batched IO ports ---------------------------------------- */
+
+/*! @brief Read a string of values from a single x86 IO port, like the rep insb / insw / insl
+           instructions. Avoids going through the libplatsupport port op callback and its checks
+           for every value, which matters for data ports such as the ATA data register.
+
+    seL4 has no string port IO invocation, so each value is still one kernel call.
+
+    @param io The initialised device IO manager. (No ownership)
+    @param port The IO port to read from.
+    @param ioSize The size of each value in bytes; 1, 2 or 4.
+    @param buf Output buffer of count values of ioSize bytes each. (No ownership)
+    @param count The number of values to read.
+    @return ESUCCESS if success, EUNIMPLEMENTED if there are no IO ports on this platform,
+            refos_err_t otherwise.
+*/
+int devio_port_in_string(dev_io_ops_t *io, uint32_t port, int ioSize, void *buf, uint32_t count);
+
+/*! @brief Write a string of values to a single x86 IO port, like the rep outsb / outsw / outsl
+           instructions.
+    @param io The initialised device IO manager. (No ownership)
+    @param port The IO port to write to.
+    @param ioSize The size of each value in bytes; 1, 2 or 4.
+    @param buf Buffer of count values of ioSize bytes each. (No ownership)
+    @param count The number of values to write.
+    @return ESUCCESS if success, EUNIMPLEMENTED if there are no IO ports on this platform,
+            refos_err_t otherwise.
+*/
+int devio_port_out_string(dev_io_ops_t *io, uint32_t port, int ioSize, const void *buf,
+                          uint32_t count);
+
+/*! @brief Poll an x86 IO port until (value & mask) == match, eg. a device status register until a
+           ready bit is set.
+    @param io The initialised device IO manager. (No ownership)
+    @param port The IO port to poll.
+    @param ioSize The size of the register in bytes; 1, 2 or 4.
+    @param mask The bits of the register to compare.
+    @param match The value the masked bits must have.
+    @param maxTries The maximum number of reads before giving up.
+    @param result Optional output last value read. (No ownership)
+    @return ESUCCESS if the register matched, EINVALID if it did not match within maxTries reads,
+            EUNIMPLEMENTED if there are no IO ports on this platform, refos_err_t otherwise.
+*/
+int devio_port_poll(dev_io_ops_t *io, uint32_t port, int ioSize, uint32_t mask, uint32_t match,
+                    uint32_t maxTries, uint32_t *result);
+
 #endif /* _REFOS_UTIL_DEVICE_IO_MANAGER_H_ */
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <sel4/sel4.h>
+#include <refos/log_ring.h>
 
 /*! @file
     @brief Common RefOS debugging output helper functions.
@@ -100,18 +101,33 @@ extern int dprintfServerColour;
     #define DLOG_VERBOSE 0
 #endif
 
-#define ROS_ERROR(...) printf(COLOUR "ERROR" COLOUR_RESET " %s(): ", \
-    31, __FUNCTION__); printf(__VA_ARGS__); printf("\n");
+/*! @brief Log a message through the process's log ring, when it has one (see refos-io/log.h).
+    Weak, as only processes linking librefossys have a log ring. Returns false if the process has
+    no log ring, in which case the message is printed to stdout as usual. */
+extern bool refos_log_printf(int level, const char *func, const char *fmt, ...)
+        __attribute__((weak, format(printf, 3, 4)));
 
-#define ROS_WARNING(...) printf(COLOUR "WARNING" COLOUR_RESET " %s(): ", \
-    33, __FUNCTION__); printf(__VA_ARGS__); printf("\n");
+#define ROS_ERROR(...) { \
+    if (!refos_log_printf || !refos_log_printf(REFOS_LOG_ERROR, __FUNCTION__, __VA_ARGS__)) { \
+        printf(COLOUR "ERROR" COLOUR_RESET " %s(): ", 31, __FUNCTION__); \
+        printf(__VA_ARGS__); printf("\n"); \
+    } }
+
+#define ROS_WARNING(...) { \
+    if (!refos_log_printf || !refos_log_printf(REFOS_LOG_WARNING, __FUNCTION__, __VA_ARGS__)) { \
+        printf(COLOUR "WARNING" COLOUR_RESET " %s(): ", 33, __FUNCTION__); \
+        printf(__VA_ARGS__); printf("\n"); \
+    } }
 
 #ifdef CONFIG_REFOS_DEBUG
-    #define dprintf(...) printf("[00.%u] " COLOUR "%s | " \
-        COLOUR_RESET " %s(): ", \
-        faketime ? faketime() : 0, \
-        dprintfServerColour, dprintfServerName, __FUNCTION__); \
-        printf(__VA_ARGS__);
+    #define dprintf(...) { \
+        if (!refos_log_printf || !refos_log_printf(REFOS_LOG_DEBUG, __FUNCTION__, __VA_ARGS__)) { \
+            printf("[00.%u] " COLOUR "%s | " \
+                COLOUR_RESET " %s(): ", \
+                faketime ? faketime() : 0, \
+                dprintfServerColour, dprintfServerName, __FUNCTION__); \
+            printf(__VA_ARGS__); \
+        } }
 #else
     #define dprintf(...)
 #endif
@@ -21,7 +21,9 @@
 
 #define SELFLOADER_PROCINFO_MAGIC 0xD174A029
 #define REFOS_DEFAULT_TIMER_DSPACE "/dev_timer/time"
+#define REFOS_DEFAULT_LOG_PATH "/dev_log/log"
 #define REFOS_DEFAULT_DSPACE_IPC_MAXLEN 64
+#define SELFLOADER_PROCINFO_PREFIX_MAXLEN 64
 
 #if defined(CONFIG_REFOS_STDIO_DSPACE_SERIAL)
     #define REFOS_DEFAULT_STDIO_DSPACE "/dev_console/serial"
@@ -47,6 +49,12 @@ typedef struct sl_procinfo_s {
 
     sl_dataspace_t heapRegion;
     sl_dataspace_t stackRegion;
+
+    /* File server session the selfloader loaded the ELF file through, handed over to the
+       process. 0 if there is none. The process adopts it the first time it opens a file on the
+       server mounted at fileservPrefix, instead of connecting again. */
+    seL4_CPtr fileservSession;
+    char fileservPrefix[SELFLOADER_PROCINFO_PREFIX_MAXLEN];
 } sl_procinfo_t;
 
 /*! @brief Point the selfloaded process to the parent's system call table. */
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _REFOS_UTIL_SERV_AIO_H_
+#define _REFOS_UTIL_SERV_AIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sel4/sel4.h>
+#include <refos/refos.h>
+#include <refos/aio_ring.h>
+
+/*! @file
+    @brief Server asynchronous I/O ring helper module.
+
+    Server side of the shared submission / completion rings described in refos/aio_ring.h. A client
+    hands the server a ring dataspace through serv_set_aio_ring(), which this module maps and hangs
+    off the client's struct srv_client. The client table keeps a list of the clients with rings, so
+    that a doorbell notification only needs to walk those.
+
+    Submissions refer to server objects (eg. dataspaces) through small per-ring binding handles, as
+    ring entries can not carry capabilities. This module tracks the binding's current position and
+    resolves REFOS_AIO_OFFSET_CURRENT and SEEK_CUR before handing each submission to the server's
+    operation callback, so the callback only sees absolute offsets.
+*/
+
+#define SRV_AIO_RING_MAGIC 0x3A10C5E1
+#define SRV_AIO_MAX_BINDINGS 16
+#define SRV_AIO_MAX_RING_SIZE 0x40000
+
+struct srv_client;
+struct srv_client_table;
+
+/*! @brief Asynchronous I/O ring binding. */
+struct srv_aio_binding {
+    bool used;
+    uint32_t object; /*!< Server defined object ID. */
+    int32_t pos;
+};
+
+/*! @brief Server side asynchronous I/O ring state. */
+struct srv_aio_ring {
+    uint32_t magic;
+    seL4_CPtr dataspace; /*!< Has ownership. */
+    seL4_CPtr window; /*!< Has ownership. */
+    char *vaddr;
+    int sizeNPages;
+    refos_aio_ring_t ring; /*!< Validated view of the ring mapped at vaddr. */
+    struct srv_aio_binding bindings[SRV_AIO_MAX_BINDINGS];
+    struct srv_aio_ring *next; /*!< On the client table's list of rings left to free. */
+};
+
+/*! @brief Server asynchronous I/O operation callback.
+
+    Called for each submission popped off the ring. The offset of a read / write submission is
+    always absolute, and a lseek submission has a whence of either SEEK_SET or SEEK_END.
+
+    @param c The client owning the ring. (No ownership)
+    @param object The server defined object ID of the submission's binding.
+    @param sqe The submission entry. (No ownership)
+    @param buf The submission's buffer in the ring data area, already bounds checked against the
+               submission length. NULL for lseek and nop submissions. (No ownership)
+    @return Bytes read / written, the new absolute lseek offset, or negative refos_err_t.
+*/
+typedef int32_t (*srv_aio_op_fn_t)(struct srv_client *c, uint32_t object,
+                                   struct refos_aio_sqe *sqe, char *buf);
+
+/*! @brief Map a client's ring dataspace, and attach it to the client. Replaces any previous ring.
+    @param ct The client table the client belongs to.
+    @param c The client to set the ring for.
+    @param ringDataspace The copied out ring dataspace cap. (Takes ownership, also on failure)
+    @param ringSize The size of the ring dataspace.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int srv_aio_ring_create(struct srv_client_table *ct, struct srv_client *c,
+                        seL4_CPtr ringDataspace, uint32_t ringSize);
+
+/*! @brief Unmap and release a client's ring, if it has one.
+    @param ct The client table the client belongs to.
+    @param c The client whose ring to release.
+*/
+void srv_aio_ring_release(struct srv_client_table *ct, struct srv_client *c);
+
+/*! @brief Take a client's ring off the client, without unmapping it. Called by the client table
+           when a client is deleted, with the table locked; the ring is freed with
+           srv_aio_ring_free() once the table is unlocked again.
+    @param ct The client table the client belongs to.
+    @param c The client whose ring to take.
+    @return The client's ring, or NULL if it has none. (Gives ownership)
+*/
+struct srv_aio_ring *srv_aio_ring_detach(struct srv_client_table *ct, struct srv_client *c);
+
+/*! @brief Unmap and free a ring taken off its client with srv_aio_ring_detach(). Makes an IPC to
+           the process server, so must not be called with the client table locked.
+    @param r The ring to free. (Takes ownership)
+*/
+void srv_aio_ring_free(struct srv_aio_ring *r);
+
+/*! @brief Bind a server object to a client's ring.
+    @param c The client owning the ring.
+    @param object The server defined object ID.
+    @return Non-negative binding handle if success, negative refos_err_t otherwise.
+*/
+int srv_aio_bind(struct srv_client *c, uint32_t object);
+
+/*! @brief Remove every binding to a server object, from the rings of all clients. Should be called
+           when the object is deleted, so a recycled object ID is never reached through a stale
+           binding.
+    @param ct The client table.
+    @param object The server defined object ID.
+*/
+void srv_aio_unbind_object(struct srv_client_table *ct, uint32_t object);
+
+/*! @brief Process the pending submissions on a client's ring, and post their completions. At most
+           one ring's worth of submissions is processed per call.
+    @param c The client owning the ring.
+    @param op The server's operation callback.
+    @return The number of completions waiting on the completion ring if success, negative
+            refos_err_t otherwise.
+*/
+int srv_aio_process(struct srv_client *c, srv_aio_op_fn_t op);
+
+/*! @brief Process the pending submissions of every client with a ring, up to one ring's worth each.
+           Called when the ring doorbell notification is received.
+    @param ct The client table.
+    @param op The server's operation callback.
+    @return The number of clients with submissions left that could be processed now. The caller
+            should signal its own doorbell to come back for them after serving other requests.
+*/
+int srv_aio_process_all(struct srv_client_table *ct, srv_aio_op_fn_t op);
+
+#endif /* _REFOS_UTIL_SERV_AIO_H_ */
@@ -85,6 +85,10 @@ typedef struct srv_common_config {
 
     /*! @brief Fault / death async notification badge number. */
     uint32_t faultDeathNotifyBadge;
+    /*! @brief Asynchronous I/O ring doorbell notification badge. Must be a bit that no other
+               notification badge uses, as notification badges are ORed together. Set to 0 to
+               disable asynchronous I/O rings. */
+    uint32_t aioNotifyBadge;
 } srv_common_config_t;
 
 struct srv_common;
@@ -99,6 +103,7 @@ struct srv_common {
     seL4_CPtr anonEP;
     seL4_CPtr notifyAsyncEP;
     seL4_CPtr notifyClientFaultDeathAsyncEP;
+    seL4_CPtr notifyAioAsyncEP;
 
     /* Mapped shared buffers. */
     data_mapping_t notifyBuffer;
@@ -117,6 +122,12 @@ struct srv_common {
     refos_err_t (*ctable_set_param_buffer_handler) (srv_common_t *srv, struct srv_client *c,
             srv_msg_t *m, seL4_CPtr parambufferDataspace, uint32_t parambufferSize);
 
+    seL4_CPtr (*ctable_set_aio_ring_handler) (srv_common_t *srv, struct srv_client *c,
+            srv_msg_t *m, seL4_CPtr ringDataspace, uint32_t ringSize, int* _errno);
+
+    seL4_CPtr (*ctable_get_log_ring_handler) (srv_common_t *srv, struct srv_client *c,
+            srv_msg_t *m, seL4_CPtr doorbell, uint32_t* ringSize, int* _errno);
+
     void (*ctable_disconnect_direct_handler) (srv_common_t *srv, struct srv_client *c);
 };
 
@@ -19,11 +19,18 @@
 #include <assert.h>
 #include <data_struct/cvector.h>
 #include <data_struct/coat.h>
+#include <data_struct/cslab.h>
+#include <data_struct/clist.h>
 #include <refos/refos.h>
+#include <refos/sync.h>
 #include <refos-rpc/rpc.h>
 
+struct srv_aio_ring;
+
 #define SRC_CLIENT_LIST_MAGIC 0x26B7B92A
 #define SRC_CLIENT_INVALID_ID COAT_INVALID_ID
+#define SRC_CLIENT_TABLE_MAX_DEFERRED 16
+#define SRC_CLIENT_TABLE_MAX_PENDING 8
 
 /*! @brief Server client session structure,
 
@@ -43,17 +50,31 @@ struct srv_client {
     uint32_t paramBufferStart;
     seL4_CPtr paramBuffer;
     seL4_CPtr paramBufferSize;
+
+    chlist_t replyWaiters; /*!< struct srv_reply_waiter. Deferred replies, see serv_reply.h. */
+    struct srv_aio_ring *aioRing; /*!< Asynchronous I/O ring, see serv_aio.h. */
+    clist_node_t pendingNode; /*!< Linked while queued on srv_client_table.pendingFreeList. */
 };
 
 struct srv_client_table {
     coat_t allocTable; /* Inherited struct, must be first. */
-    cvector_t pendingFreeList;
+    cslab_t clientCache; /* struct srv_client */
+    clist_t pendingFreeList; /* struct srv_client. No ownership. */
+    cvector_t aioClientList; /* struct srv_client with an aioRing. No ownership. */
+    struct srv_aio_ring *deadAioRings; /* Rings of deleted clients, left to free. Has ownership. */
     uint32_t magic;
 
     uint32_t clientMagic;
     int maxClients;
     int badgeBase;
     seL4_CPtr sessionSrcEP;
+
+    /* Shared by server worker threads, see client_table_enable_locking(). */
+    sync_mutex_t lock; /* NULL if single threaded. */
+    int numActive; /* Number of IPCs in flight between client_table_enter() and postaction. */
+    int numPending; /* Number of clients on the pending free list. */
+    int numDeferred; /* Postactions in a row which could not delete the pending clients. */
+    bool draining; /* New IPCs wait in client_table_enter() until the pending clients are gone. */
 };
 
 /*! @brief Initialise client allocation table. */
@@ -63,12 +84,34 @@ void client_table_init(struct srv_client_table *ct, int maxClients, int badgeBas
 /*! @brief Release the client allocation table. */
 void client_table_release(struct srv_client_table *ct);
 
+/*! @brief Make the client table safe to share between server worker threads.
+
+    Every client table function takes the table lock from then on. Clients queued for deletion are
+    only deleted once no IPC is in flight, so that a worker never has a client structure freed from
+    under it by another worker. Each worker must call client_table_enter() when it recieves a
+    message, and client_table_postaction() when it is done with it.
+
+    Under load there may never be a moment with no IPC in flight. So once the deletion has been put
+    off SRC_CLIENT_TABLE_MAX_DEFERRED times, or SRC_CLIENT_TABLE_MAX_PENDING clients are waiting
+    to be deleted, the table drains: new IPCs wait in client_table_enter() until those in flight
+    are done and the pending clients have been deleted.
+
+    @param ct The client table. (No ownership)
+    @return ESUCCESS if success, ENOMEM if the lock could not be created.
+*/
+int client_table_enable_locking(struct srv_client_table *ct);
+
+/*! @brief Mark the start of an IPC on a shared client table. Waits while the table is draining.
+           Does nothing on a table without locking enabled. */
+void client_table_enter(struct srv_client_table *ct);
+
 /*! @brief Perform client table post IPC actions.
 
     Actually frees the client IDs that need to be freed. Should be called
     at the end of every IPC. The reason for having this is so that a client deletion syscall may
     be implemented; there is no way to reply to the client if we delete the client in the middle of
-    the client's syscall to delete itself.
+    the client's syscall to delete itself. On a table with locking enabled, this marks the end of
+    the IPC started by client_table_enter(), and the deletion waits for the last IPC in flight.
 */
 void client_table_postaction(struct srv_client_table *ct);
 
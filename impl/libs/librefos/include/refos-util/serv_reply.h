@@ -0,0 +1,148 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _REFOS_UTIL_SERV_DEFERRED_REPLY_H_
+#define _REFOS_UTIL_SERV_DEFERRED_REPLY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <data_struct/cvector.h>
+#include <data_struct/clist.h>
+#include <refos/refos.h>
+
+/*! @file
+    @brief Server deferred reply helper module.
+
+    Servers which block a calling client (eg. sleep() on the timer server, or a blocking getc()
+    on the console server) need to save the client's reply cap and reply to it later. Allocating
+    and freeing a cslot for every blocked call is wasteful, and easily leaks the cslot when the
+    blocked client dies before the reply.
+
+    This module keeps a pool of waiter records, each owning a pre-allocated cslot that is reused
+    for the lifetime of the pool. Waiters are kept on a FIFO list for the server to walk, and on a
+    per-client chain hanging off struct srv_client, so that all waiters of a client may be cancelled
+    in O(1) per waiter. The client table cancels a client's waiters automatically when the client
+    structure is deleted.
+
+    Typical usage:
+    > w = srv_reply_save_caller(&pool, client);
+    > ...later...
+    > srv_reply_bind(w); reply_data_xxx(w->client, ...); srv_reply_free(w);
+*/
+
+#define SRV_REPLY_POOL_MAGIC 0x1E4A77D3
+#define SRV_REPLY_WAITER_MAGIC 0x6B00A2E1
+#define SRV_REPLY_POOL_BATCH 16
+
+struct srv_client;
+struct srv_reply_pool;
+
+/*! @brief Deferred reply waiter structure. */
+struct srv_reply_waiter {
+    uint32_t magic;
+    seL4_CPtr reply; /*!< Pre-allocated cslot, owned by the pool. */
+    struct srv_reply_pool *pool; /*!< No ownership, parent pool. */
+    struct srv_client *client; /*!< No ownership, Weak Reference. NULL if free. */
+
+    /* Server defined waiter information. */
+    uint64_t arg;
+    uint32_t type;
+
+    clist_node_t node; /*!< Pool FIFO list / pool free list. */
+    chlist_node_t clientNode; /*!< Per-client waiter chain, srv_client.replyWaiters. */
+};
+
+/*! @brief Deferred reply waiter pool structure. */
+struct srv_reply_pool {
+    uint32_t magic;
+    int count; /*!< Number of waiter records allocated so far. */
+    int maxWaiters;
+
+    clist_t freeList; /*!< struct srv_reply_waiter */
+    clist_t waitList; /*!< struct srv_reply_waiter, oldest first. */
+    cvector_t batchList; /*!< struct srv_reply_waiter[SRV_REPLY_POOL_BATCH] */
+};
+
+/*! @brief Initialise a deferred reply waiter pool.
+    @param p The pool structure to initialise. (No ownership)
+    @param initialWaiters The number of waiters (and their reply cslots) to pre-allocate.
+    @param maxWaiters The maximum number of waiters the pool may grow to. Since a blocked client
+                      may only have a single outstanding call, the server's maximum client count
+                      is usually a good upper bound.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int srv_reply_pool_init(struct srv_reply_pool *p, int initialWaiters, int maxWaiters);
+
+/*! @brief Release a deferred reply waiter pool. Any still blocked clients are never replied to.
+    @param p The pool structure to release. (No ownership, does NOT free the structure)
+*/
+void srv_reply_pool_release(struct srv_reply_pool *p);
+
+/*! @brief Save the current caller's reply cap into a waiter record.
+    @param p The pool to allocate the waiter from.
+    @param c The client structure of the calling client. (No ownership)
+    @return Waiter record if success, NULL otherwise. (No ownership, release with
+            srv_reply_free()).
+*/
+struct srv_reply_waiter *srv_reply_save_caller(struct srv_reply_pool *p, struct srv_client *c);
+
+/*! @brief Point the waiting client's RPC state at the saved reply cap, so that the next
+           generated reply_*() call for this client goes to the waiter.
+    @param w The waiter to reply to.
+*/
+void srv_reply_bind(struct srv_reply_waiter *w);
+
+/*! @brief Return a waiter back to its pool. The saved reply cap is deleted (if it is still there)
+           and the cslot is kept for reuse.
+    @param w The waiter to free.
+*/
+void srv_reply_free(struct srv_reply_waiter *w);
+
+/*! @brief Cancel every waiter belonging to a client, without replying. Called by the client table
+           when a client is deleted.
+    @param c The client whose waiters are to be cancelled.
+*/
+void srv_reply_cancel_client(struct srv_client *c);
+
+/*! @brief Get the oldest waiter in the pool. Walk the rest using srv_reply_next().
+    @param p The pool to get the waiter from.
+    @return The oldest waiter if there is one, NULL otherwise. (No ownership)
+*/
+static inline struct srv_reply_waiter *
+srv_reply_first(struct srv_reply_pool *p)
+{
+    assert(p && p->magic == SRV_REPLY_POOL_MAGIC);
+    clist_node_t *n = clist_first(&p->waitList);
+    return n ? clist_entry(n, struct srv_reply_waiter, node) : NULL;
+}
+
+/*! @brief Get the next oldest waiter in the pool. The next waiter must be fetched before freeing
+           the current one.
+    @param w The current waiter.
+    @return The next oldest waiter if there is one, NULL otherwise. (No ownership)
+*/
+static inline struct srv_reply_waiter *
+srv_reply_next(struct srv_reply_waiter *w)
+{
+    assert(w && w->magic == SRV_REPLY_WAITER_MAGIC && w->client);
+    clist_node_t *n = clist_next(&w->pool->waitList, &w->node);
+    return n ? clist_entry(n, struct srv_reply_waiter, node) : NULL;
+}
+
+/*! @brief Get the number of waiters currently blocked in the pool.
+    @param p The pool.
+    @return The number of waiters.
+*/
+static inline int
+srv_reply_num_waiting(struct srv_reply_pool *p)
+{
+    assert(p && p->magic == SRV_REPLY_POOL_MAGIC);
+    return (int) clist_count(&p->waitList);
+}
+
+#endif /* _REFOS_UTIL_SERV_DEFERRED_REPLY_H_ */
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _REFOS_UTIL_SERV_RUNTIME_H_
+#define _REFOS_UTIL_SERV_RUNTIME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/refos.h>
+#include <refos/sync.h>
+#include <refos-rpc/rpc.h>
+#include <refos-util/serv_connect.h>
+#include <refos-util/serv_common.h>
+
+/*! @file
+    @brief Multi-threaded server runtime.
+
+    Runs a server's message loop on a pool of worker threads, all recieving on the server's
+    anonymous endpoint. Each worker has its own RPC state (see rpc_thread_state_init()), its own
+    cap recieve slot and its own anonymous client structure, and the server's client table is made
+    safe to share between them (see client_table_enable_locking()).
+
+    The process' main thread becomes worker 0. The server notification endpoint is bound to the
+    main thread, so worker 0 is the only worker which recieves notifications; client RPCs go to
+    whichever worker is waiting.
+
+    Servers whose own state is not thread safe may ask for their handler to be serialised; the
+    workers then still overlap their kernel IPC, but only one of them runs the handler at a time.
+
+    Typical usage:
+    > srv_common_init(&srv, ...);
+    > srv_runtime_init(&rt, &srv, config);
+    > srv_runtime_run(&rt);
+*/
+
+#define SRV_RUNTIME_MAGIC 0x4E27C1B0
+#define SRV_WORKER_MAGIC 0x4E27C1B1
+#define SRV_RUNTIME_MAX_WORKERS 8
+#define SRV_RUNTIME_WORKER_STACK_SIZE 0x4000
+
+typedef struct srv_runtime srv_runtime_t;
+
+/*! @brief Server message handler callback type. Should return DISPATCH_SUCCESS if the message was
+           handled, or DISPATCH_ERROR otherwise. */
+typedef int (*srv_runtime_handler_fn_t)(srv_msg_t *m);
+
+/*! @brief Server runtime configuration. */
+typedef struct srv_runtime_config {
+    /*! @brief Number of worker threads, including the main thread. */
+    int numWorkers;
+    /*! @brief Run the handler on one worker at a time. */
+    bool serialise;
+    /*! @brief Server message handler. */
+    srv_runtime_handler_fn_t handler;
+} srv_runtime_config_t;
+
+/*! @brief Server worker thread structure. */
+struct srv_worker {
+    uint32_t magic;
+    int index;
+    srv_runtime_t *runtime; /* No ownership. */
+
+    rpc_thread_state_t rpcState;
+    seL4_CPtr recvSlot; /* Has ownership, except on the main thread. */
+    char *stack; /* Has ownership. NULL for the main thread. */
+
+    /*! Anonymous client structure of this worker, used for unbadged messages from clients which
+        have not connected yet. */
+    struct srv_client anonClient;
+    srv_msg_t msg;
+};
+
+/*! @brief Server runtime structure. */
+struct srv_runtime {
+    uint32_t magic;
+    srv_common_t *srv; /* No ownership. */
+    srv_runtime_config_t config;
+
+    sync_mutex_t serialLock; /* NULL unless serialising. */
+
+    volatile int numStarted;
+    struct srv_worker workers[SRV_RUNTIME_MAX_WORKERS];
+};
+
+/*! @brief Initialise the server runtime. Only one runtime may exist per process.
+    @param rt The runtime structure to initialise. (No ownership, must never be freed)
+    @param srv The initialised common server state. Its client table is made thread safe.
+               (No ownership)
+    @param config The runtime configuration.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+int srv_runtime_init(srv_runtime_t *rt, srv_common_t *srv, srv_runtime_config_t config);
+
+/*! @brief Start the worker threads, and turn the calling main thread into worker 0. Does not
+           return. If some worker threads could not be started, the server runs with fewer.
+    @param rt The initialised runtime structure. (No ownership)
+*/
+void srv_runtime_run(srv_runtime_t *rt);
+
+/*! @brief Get the worker structure of the calling thread.
+    @return The calling thread's worker structure, or NULL if the calling thread is not a worker.
+*/
+struct srv_worker *srv_worker_current(void);
+
+#endif /* _REFOS_UTIL_SERV_RUNTIME_H_ */
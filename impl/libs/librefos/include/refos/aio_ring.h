@@ -0,0 +1,146 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief RefOS asynchronous I/O submission / completion ring library.
+
+    Shared memory layout and helper functions for asynchronous dataspace I/O rings. A ring lives
+    in a single dataspace mapped into both the client and the server. The client queues operations
+    onto the submission ring, and the server posts results onto the completion ring. The rest of
+    the dataspace is a data area which operations use to pass their read / write buffers.
+
+    Each ring has exactly one producer and one consumer, so the indices need no locking; they are
+    free running counters, and an entry lives at (index % entries).
+
+    Layout:
+    > [ header ][ submission entries ][ completion entries ][ data area ... ]
+*/
+
+#ifndef _REFOS_AIO_RING_H_
+#define _REFOS_AIO_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "refos.h"
+
+#define REFOS_AIO_RING_MAGIC 0x7A1B05E0
+
+#define REFOS_AIO_OP_NOP 0
+#define REFOS_AIO_OP_READ 1
+#define REFOS_AIO_OP_WRITE 2
+#define REFOS_AIO_OP_LSEEK 3
+
+/*! @brief Read / write at the ring's current position, and advance it. */
+#define REFOS_AIO_OFFSET_CURRENT (-1)
+
+/*! @brief Submission ring entry. */
+struct refos_aio_sqe {
+    uint32_t opcode;     /*!< REFOS_AIO_OP_*. */
+    uint32_t userData;   /*!< Passed back untouched in the completion. */
+    uint32_t handle;     /*!< Server binding handle of the object to operate on. */
+    int32_t offset;      /*!< Dataspace offset, REFOS_AIO_OFFSET_CURRENT, or lseek offset. */
+    uint32_t len;        /*!< Length of the read / write. */
+    uint32_t bufOffset;  /*!< Offset of the read / write buffer in the ring data area. */
+    int32_t whence;      /*!< lseek whence. */
+};
+
+/*! @brief Completion ring entry. */
+struct refos_aio_cqe {
+    uint32_t userData;
+    int32_t result;      /*!< Bytes read / written, new lseek offset, or negative refos_err_t. */
+};
+
+/*! @brief Shared ring header, at the start of the ring dataspace. */
+struct refos_aio_ring_header {
+    uint32_t magic;
+    uint32_t entries;    /*!< Number of entries in each of the two rings. */
+    uint32_t dataOffset; /*!< Offset of the data area from the start of the header. */
+    uint32_t dataSize;
+
+    volatile uint32_t sqHead; /*!< Written by the server. */
+    volatile uint32_t sqTail; /*!< Written by the client. */
+    volatile uint32_t cqHead; /*!< Written by the client. */
+    volatile uint32_t cqTail; /*!< Written by the server. */
+};
+
+/*! @brief Local view of a mapped ring.
+
+    The ring geometry is kept locally when the ring is initialised or validated, and is never read
+    back out of the shared header, so that the other side can not point either side outside the
+    mapped buffer.
+*/
+typedef struct refos_aio_ring {
+    struct refos_aio_ring_header *hdr; /*!< Points into the mapped buffer. NULL if invalid. */
+    struct refos_aio_sqe *sq;
+    struct refos_aio_cqe *cq;
+    char *data;
+    uint32_t entries;
+    uint32_t dataSize;
+} refos_aio_ring_t;
+
+/*! @brief Format a new ring in the given shared buffer. Done by the client before handing the ring
+           dataspace to the server.
+    @param r Output local view of the ring.
+    @param vaddr The mapped ring buffer. (No ownership)
+    @param size The size of the ring buffer.
+    @param entries The number of submission / completion entries.
+    @return ESUCCESS if success, EINVALIDPARAM if the buffer is too small.
+*/
+int refos_aio_ring_init(refos_aio_ring_t *r, char *vaddr, size_t size, uint32_t entries);
+
+/*! @brief Check that a mapped ring buffer has a sane header. Done by the server, as the contents
+           of the buffer are not trusted.
+    @param r Output local view of the ring.
+    @param vaddr The mapped ring buffer. (No ownership)
+    @param size The size of the ring buffer.
+    @return ESUCCESS if valid, EINVALIDPARAM otherwise.
+*/
+int refos_aio_ring_validate(refos_aio_ring_t *r, char *vaddr, size_t size);
+
+/*! @brief Push a submission entry. Client side.
+    @return 0 if success, -1 if the submission ring is full.
+*/
+int refos_aio_sq_push(refos_aio_ring_t *r, const struct refos_aio_sqe *sqe);
+
+/*! @brief Pop a submission entry. Server side.
+    @return 0 if success, -1 if the submission ring is empty.
+*/
+int refos_aio_sq_pop(refos_aio_ring_t *r, struct refos_aio_sqe *sqe);
+
+/*! @brief Push a completion entry. Server side.
+    @return 0 if success, -1 if the completion ring is full.
+*/
+int refos_aio_cq_push(refos_aio_ring_t *r, const struct refos_aio_cqe *cqe);
+
+/*! @brief Pop a completion entry. Client side.
+    @return 0 if success, -1 if the completion ring is empty.
+*/
+int refos_aio_cq_pop(refos_aio_ring_t *r, struct refos_aio_cqe *cqe);
+
+/*! @brief Number of submissions that the server has not yet picked up. */
+static inline uint32_t
+refos_aio_sq_pending(refos_aio_ring_t *r)
+{
+    return r->hdr->sqTail - r->hdr->sqHead;
+}
+
+/*! @brief Number of completions that the client has not yet picked up. */
+static inline uint32_t
+refos_aio_cq_ready(refos_aio_ring_t *r)
+{
+    return r->hdr->cqTail - r->hdr->cqHead;
+}
+
+/*! @brief Whether there is room on the completion ring. */
+static inline bool
+refos_aio_cq_space(refos_aio_ring_t *r)
+{
+    return refos_aio_cq_ready(r) < r->entries;
+}
+
+#endif /* _REFOS_AIO_RING_H_ */
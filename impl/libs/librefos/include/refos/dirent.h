@@ -0,0 +1,38 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief RefOS directory dataspace record format.
+
+    Opening a directory on a dataserver which supports directories gives a read-only dataspace
+    whose contents are a packed listing of the directory's immediate children. Each child is one
+    variable length record; a single data_read() can return many of them. The listing is read like
+    any other dataspace content, so a read may end part way through a record, and a record may be
+    longer than a single read. Clients stitch records back together, and resume a listing from the
+    offset just past the last whole record they consumed.
+
+    The "." and ".." entries are not listed.
+*/
+
+#ifndef _REFOS_DIRENT_H_
+#define _REFOS_DIRENT_H_
+
+#include <stdint.h>
+
+#define REFOS_DIRENT_NAME_MAX 250
+
+/*! @brief Packed directory dataspace record header. The name follows immediately after the header,
+           and is NOT NUL terminated. */
+struct refos_dirent {
+    uint8_t reclen; /*!< Total record length, header included. */
+    uint8_t type;   /*!< The entry type, as a DT_* value from <dirent.h>. */
+    char name[];
+} __attribute__((packed));
+
+#define REFOS_DIRENT_HEADER_SIZE 2
+#define REFOS_DIRENT_NAMELEN(d) ((d)->reclen - REFOS_DIRENT_HEADER_SIZE)
+
+#endif /* _REFOS_DIRENT_H_ */
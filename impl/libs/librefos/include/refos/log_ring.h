@@ -0,0 +1,157 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/*! @file
+    @brief RefOS log ring library.
+
+    Shared memory layout and helper functions for the per-process log rings drained by the log
+    server. A ring lives in a single anonymous dataspace, formatted by the client and mapped into
+    both the client and the log server. Any thread of the client appends fixed size records to it
+    without IPC; the log server is the only consumer.
+
+    The records are kept on a lock-free multi producer ring (see data_struct/clfring.h). So that
+    the server does not have to poll, it sets the header's waiting flag before it goes to sleep,
+    and whichever producer next sees the flag clears it and signals the server's doorbell
+    notification. Both sides put a full barrier between publishing their own write and reading the
+    other side's, so either the server sees the new record, or the producer sees the flag; a wakeup
+    can not be lost.
+
+    The client can write anything it likes to the ring, so the server pops with
+    cmpmc_pop_private(): its read position is its own, and each pop is a single look at a slot. A
+    slot no well behaved client could have left behind marks the ring corrupt, and the server gives
+    up on it, rather than waiting on it.
+
+    Layout:
+    > [ header ][ cmpmc ring of struct refos_log_record ... ]
+*/
+
+#ifndef _REFOS_LOG_RING_H_
+#define _REFOS_LOG_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <data_struct/clfring.h>
+
+#include "refos.h"
+
+#define REFOS_LOG_RING_MAGIC 0x106B1A6E
+#define REFOS_LOG_RING_DEFAULT_ENTRIES 64
+#define REFOS_LOG_RECORD_SIZE 256
+#define REFOS_LOG_MSG_MAXLEN (REFOS_LOG_RECORD_SIZE - 4)
+
+/*! @brief Log severity levels, most severe first. */
+enum refos_log_level {
+    REFOS_LOG_ERROR = 0,
+    REFOS_LOG_WARNING,
+    REFOS_LOG_INFO,
+    REFOS_LOG_DEBUG,
+    REFOS_LOG_NUM_LEVELS
+};
+
+/*! @brief The message was cut short to fit in the record. */
+#define REFOS_LOG_FLAG_TRUNCATED 0x1
+
+/*! @brief Log ring record. */
+struct refos_log_record {
+    uint8_t level;     /*!< enum refos_log_level. */
+    uint8_t flags;     /*!< REFOS_LOG_FLAG_*. */
+    uint16_t len;      /*!< Length of msg. Not NULL terminated. */
+    char msg[REFOS_LOG_MSG_MAXLEN];
+};
+
+/*! @brief Shared log ring header, at the start of the ring dataspace. */
+struct refos_log_ring_header {
+    uint32_t magic;
+    uint32_t entries;
+    uint32_t level;    /*!< Written by the server. Records less severe than this are not logged. */
+    uint32_t waiting;  /*!< Set by the server before sleeping, cleared by the waking producer. */
+    uint32_t dropped;  /*!< Records lost to a full ring. Counted by clients, taken by the server. */
+} __attribute__((aligned(CLF_CACHE_LINE)));
+
+/*! @brief Local view of a mapped log ring. */
+typedef struct refos_log_ring {
+    struct refos_log_ring_header *hdr; /*!< Points into the mapped buffer. NULL if invalid. */
+    cmpmc_t queue;
+    uint32_t head;  /*!< Server side; the private read position. */
+    bool corrupt;   /*!< Server side; set once a pop found the ring corrupted. */
+} refos_log_ring_t;
+
+/*! @brief Size in bytes of a log ring dataspace with the given number of entries.
+    @param entries The number of records the ring holds. Must be a power of two.
+    @return The ring size, or 0 if entries is invalid.
+*/
+size_t refos_log_ring_size(uint32_t entries);
+
+/*! @brief Format a new empty log ring in the given shared buffer. Done by the client before
+           handing the ring dataspace to the log server.
+    @param r Output local view of the ring.
+    @param vaddr The mapped ring buffer. (No ownership)
+    @param size The size of the ring buffer.
+    @param entries The number of records the ring holds. Must be a power of two.
+    @return ESUCCESS if success, EINVALIDPARAM if the buffer is too small or entries is invalid.
+*/
+int refos_log_ring_init(refos_log_ring_t *r, char *vaddr, size_t size, uint32_t entries);
+
+/*! @brief Check that a mapped log ring has a sane header, and set up a local view of it. Done by
+           the log server, as the contents of the buffer are not trusted.
+    @param r Output local view of the ring.
+    @param vaddr The mapped ring buffer. (No ownership)
+    @param size The size of the ring buffer.
+    @return ESUCCESS if valid, EINVALIDPARAM otherwise.
+*/
+int refos_log_ring_attach(refos_log_ring_t *r, char *vaddr, size_t size);
+
+/*! @brief Append a record. Client side; safe to call from any number of threads at once.
+
+    Costs a copy of the message and an atomic update of the ring; no IPC. Messages longer than
+    REFOS_LOG_MSG_MAXLEN are truncated.
+
+    @param r The log ring.
+    @param level The severity of the message.
+    @param msg The message. Need not be NULL terminated. (No ownership)
+    @param len The length of the message.
+    @param wake Output; set to true if the log server is asleep and the caller should signal its
+                doorbell.
+    @return true if the record was appended, false if it was filtered out or the ring was full.
+*/
+bool refos_log_ring_append(refos_log_ring_t *r, int level, const char *msg, size_t len,
+                           bool *wake);
+
+/*! @brief Pop the oldest record. Server side. The record is sanitised, so its len and level are
+           always in range. Never waits on the client.
+    @return true if a record was popped, false if the ring is empty or corrupt. Once the ring is
+            found corrupt, r->corrupt is set and every later pop fails.
+*/
+bool refos_log_ring_pop(refos_log_ring_t *r, struct refos_log_record *rec);
+
+/*! @brief Mark the server as about to sleep. Server side. The server must try to pop from the
+           ring once more after this, and may only sleep if that finds it empty. */
+void refos_log_ring_arm(refos_log_ring_t *r);
+
+/*! @brief Take the count of records lost to a full ring since the last call. Server side. */
+static inline uint32_t
+refos_log_ring_take_dropped(refos_log_ring_t *r)
+{
+    return __atomic_exchange_n(&r->hdr->dropped, 0, __ATOMIC_RELAXED);
+}
+
+/*! @brief Set the least severe level the client should log. Server side. */
+static inline void
+refos_log_ring_set_level(refos_log_ring_t *r, int level)
+{
+    __atomic_store_n(&r->hdr->level, (uint32_t) level, __ATOMIC_RELAXED);
+}
+
+/*! @brief Whether a message of the given level would be logged. Client side; lets callers skip
+           formatting messages that would be filtered out anyway. */
+static inline bool
+refos_log_ring_enabled(refos_log_ring_t *r, int level)
+{
+    return level >= 0 && (uint32_t) level <= __atomic_load_n(&r->hdr->level, __ATOMIC_RELAXED);
+}
+
+#endif /* _REFOS_LOG_RING_H_ */
@@ -52,6 +52,7 @@
 #define MEMSERV_METHODS_BASE    0x1300
 #define SERV_METHODS_BASE       0x1400
 #define DEVICE_METHODS_BASE     0x1500
+#define LOGSERV_METHODS_BASE    0x1600
 
 #define PROCSERV_NOTIFY_TAG 0xA82D2
 #define PROCSERV_MAX_PROCESSES 2048
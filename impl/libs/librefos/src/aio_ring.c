@@ -0,0 +1,137 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "refos/aio_ring.h"
+
+/*! @file
+    @brief RefOS asynchronous I/O submission / completion ring library. */
+
+#define AIO_RING_ALIGN(x) (((x) + sizeof(seL4_Word) - 1) & ~(sizeof(seL4_Word) - 1))
+
+/*! @brief Offset of the data area for a ring of the given number of entries. */
+static size_t
+refos_aio_ring_data_offset(uint32_t entries)
+{
+    return AIO_RING_ALIGN(sizeof(struct refos_aio_ring_header) +
+            entries * (sizeof(struct refos_aio_sqe) + sizeof(struct refos_aio_cqe)));
+}
+
+/*! @brief Fill in the local view of a ring, from its trusted geometry. */
+static void
+refos_aio_ring_set_view(refos_aio_ring_t *r, char *vaddr, uint32_t entries, size_t size)
+{
+    r->hdr = (struct refos_aio_ring_header *) vaddr;
+    r->sq = (struct refos_aio_sqe *) (vaddr + sizeof(struct refos_aio_ring_header));
+    r->cq = (struct refos_aio_cqe *) (r->sq + entries);
+    r->data = vaddr + refos_aio_ring_data_offset(entries);
+    r->entries = entries;
+    r->dataSize = size - refos_aio_ring_data_offset(entries);
+}
+
+int
+refos_aio_ring_init(refos_aio_ring_t *r, char *vaddr, size_t size, uint32_t entries)
+{
+    assert(r && vaddr);
+    memset(r, 0, sizeof(refos_aio_ring_t));
+    if (entries == 0 || entries > size || refos_aio_ring_data_offset(entries) >= size) {
+        return EINVALIDPARAM;
+    }
+
+    struct refos_aio_ring_header *hdr = (struct refos_aio_ring_header *) vaddr;
+    memset(hdr, 0, sizeof(struct refos_aio_ring_header));
+    hdr->entries = entries;
+    hdr->dataOffset = refos_aio_ring_data_offset(entries);
+    hdr->dataSize = size - hdr->dataOffset;
+    __sync_synchronize();
+    hdr->magic = REFOS_AIO_RING_MAGIC;
+
+    refos_aio_ring_set_view(r, vaddr, entries, size);
+    return ESUCCESS;
+}
+
+int
+refos_aio_ring_validate(refos_aio_ring_t *r, char *vaddr, size_t size)
+{
+    assert(r);
+    memset(r, 0, sizeof(refos_aio_ring_t));
+    if (!vaddr || size < sizeof(struct refos_aio_ring_header)) {
+        return EINVALIDPARAM;
+    }
+
+    /* Read the geometry exactly once. */
+    struct refos_aio_ring_header *hdr = (struct refos_aio_ring_header *) vaddr;
+    uint32_t magic = hdr->magic;
+    uint32_t entries = hdr->entries;
+    __sync_synchronize();
+    if (magic != REFOS_AIO_RING_MAGIC || entries == 0 || entries > size ||
+            refos_aio_ring_data_offset(entries) >= size) {
+        return EINVALIDPARAM;
+    }
+
+    refos_aio_ring_set_view(r, vaddr, entries, size);
+    return ESUCCESS;
+}
+
+int
+refos_aio_sq_push(refos_aio_ring_t *r, const struct refos_aio_sqe *sqe)
+{
+    assert(r && r->hdr && sqe);
+    uint32_t tail = r->hdr->sqTail;
+    if (tail - r->hdr->sqHead >= r->entries) {
+        return -1;
+    }
+    r->sq[tail % r->entries] = *sqe;
+    __sync_synchronize();
+    r->hdr->sqTail = tail + 1;
+    return 0;
+}
+
+int
+refos_aio_sq_pop(refos_aio_ring_t *r, struct refos_aio_sqe *sqe)
+{
+    assert(r && r->hdr && sqe);
+    uint32_t head = r->hdr->sqHead;
+    if (head == r->hdr->sqTail) {
+        return -1;
+    }
+    __sync_synchronize();
+    *sqe = r->sq[head % r->entries];
+    __sync_synchronize();
+    r->hdr->sqHead = head + 1;
+    return 0;
+}
+
+int
+refos_aio_cq_push(refos_aio_ring_t *r, const struct refos_aio_cqe *cqe)
+{
+    assert(r && r->hdr && cqe);
+    uint32_t tail = r->hdr->cqTail;
+    if (tail - r->hdr->cqHead >= r->entries) {
+        return -1;
+    }
+    r->cq[tail % r->entries] = *cqe;
+    __sync_synchronize();
+    r->hdr->cqTail = tail + 1;
+    return 0;
+}
+
+int
+refos_aio_cq_pop(refos_aio_ring_t *r, struct refos_aio_cqe *cqe)
+{
+    assert(r && r->hdr && cqe);
+    uint32_t head = r->hdr->cqHead;
+    if (head == r->hdr->cqTail) {
+        return -1;
+    }
+    __sync_synchronize();
+    *cqe = r->cq[head % r->entries];
+    __sync_synchronize();
+    r->hdr->cqHead = head + 1;
+    return 0;
+}
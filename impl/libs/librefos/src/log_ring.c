@@ -0,0 +1,137 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "refos/log_ring.h"
+
+/*! @file
+    @brief RefOS log ring library. */
+
+#define LOG_RING_QUEUE_OFFSET (sizeof(struct refos_log_ring_header))
+
+size_t
+refos_log_ring_size(uint32_t entries)
+{
+    size_t qsize = cmpmc_mem_size(entries, sizeof(struct refos_log_record));
+    if (!qsize) {
+        return 0;
+    }
+    return LOG_RING_QUEUE_OFFSET + qsize;
+}
+
+int
+refos_log_ring_init(refos_log_ring_t *r, char *vaddr, size_t size, uint32_t entries)
+{
+    assert(r && vaddr);
+    memset(r, 0, sizeof(refos_log_ring_t));
+    size_t need = refos_log_ring_size(entries);
+    if (!need || size < need) {
+        return EINVALIDPARAM;
+    }
+
+    struct refos_log_ring_header *hdr = (struct refos_log_ring_header *) vaddr;
+    memset(hdr, 0, sizeof(struct refos_log_ring_header));
+    hdr->entries = entries;
+    hdr->level = REFOS_LOG_DEBUG;
+    int error = cmpmc_init(&r->queue, vaddr + LOG_RING_QUEUE_OFFSET, size - LOG_RING_QUEUE_OFFSET,
+                           entries, sizeof(struct refos_log_record));
+    if (error) {
+        return EINVALIDPARAM;
+    }
+    __sync_synchronize();
+    hdr->magic = REFOS_LOG_RING_MAGIC;
+    r->hdr = hdr;
+    return ESUCCESS;
+}
+
+int
+refos_log_ring_attach(refos_log_ring_t *r, char *vaddr, size_t size)
+{
+    assert(r && vaddr);
+    memset(r, 0, sizeof(refos_log_ring_t));
+    if (size <= LOG_RING_QUEUE_OFFSET) {
+        return EINVALIDPARAM;
+    }
+    struct refos_log_ring_header *hdr = (struct refos_log_ring_header *) vaddr;
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != REFOS_LOG_RING_MAGIC) {
+        return EINVALIDPARAM;
+    }
+
+    /* The queue checks its own geometry against the size we give it, and keeps its own copy. */
+    int error = cmpmc_attach(&r->queue, vaddr + LOG_RING_QUEUE_OFFSET,
+                             size - LOG_RING_QUEUE_OFFSET);
+    if (error || r->queue.elemSize != sizeof(struct refos_log_record)) {
+        memset(r, 0, sizeof(refos_log_ring_t));
+        return EINVALIDPARAM;
+    }
+    r->hdr = hdr;
+    return ESUCCESS;
+}
+
+bool
+refos_log_ring_append(refos_log_ring_t *r, int level, const char *msg, size_t len, bool *wake)
+{
+    assert(r && r->hdr && msg && wake);
+    (*wake) = false;
+    if (!refos_log_ring_enabled(r, level)) {
+        return false;
+    }
+
+    struct refos_log_record rec;
+    rec.level = (uint8_t) level;
+    rec.flags = 0;
+    if (len > REFOS_LOG_MSG_MAXLEN) {
+        len = REFOS_LOG_MSG_MAXLEN;
+        rec.flags |= REFOS_LOG_FLAG_TRUNCATED;
+    }
+    rec.len = (uint16_t) len;
+    memcpy(rec.msg, msg, len);
+
+    bool pushed = cmpmc_push(&r->queue, &rec);
+    if (!pushed) {
+        __atomic_fetch_add(&r->hdr->dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    /* Pairs with the barrier in refos_log_ring_arm(). */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->hdr->waiting, __ATOMIC_RELAXED)) {
+        /* Only one of the producers racing here gets to wake the server. */
+        (*wake) = __atomic_exchange_n(&r->hdr->waiting, 0, __ATOMIC_RELAXED) != 0;
+    }
+    return pushed;
+}
+
+bool
+refos_log_ring_pop(refos_log_ring_t *r, struct refos_log_record *rec)
+{
+    assert(r && r->hdr && rec);
+    if (r->corrupt) {
+        return false;
+    }
+    int n = cmpmc_pop_private(&r->queue, &r->head, rec);
+    if (n <= 0) {
+        r->corrupt = (n < 0);
+        return false;
+    }
+    if (rec->len > REFOS_LOG_MSG_MAXLEN) {
+        rec->len = REFOS_LOG_MSG_MAXLEN;
+    }
+    if (rec->level >= REFOS_LOG_NUM_LEVELS) {
+        rec->level = REFOS_LOG_DEBUG;
+    }
+    return true;
+}
+
+void
+refos_log_ring_arm(refos_log_ring_t *r)
+{
+    assert(r && r->hdr);
+    __atomic_store_n(&r->hdr->waiting, 1, __ATOMIC_RELAXED);
+    /* Pairs with the barrier in refos_log_ring_append(). */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
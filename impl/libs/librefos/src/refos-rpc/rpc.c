@@ -16,21 +16,32 @@
 // require an RPC, resulting in unexpected behaviour.
 #define RPC_STATIC_MEMPOOL_OBJ_SIZE 4096
 static char _rpc_static_mempool[RPC_MAX_TRACKED_OBJS][RPC_STATIC_MEMPOOL_OBJ_SIZE];
-static bool _rpc_static_mempool_table[RPC_MAX_TRACKED_OBJS];
+static volatile bool _rpc_static_mempool_table[RPC_MAX_TRACKED_OBJS];
 
-// Current global MR and cap index, used for setmr and getmr.
-uint32_t _rpc_mr;
-uint32_t _rpc_cp;
-
-// Other global rpc state.
-static seL4_CPtr _rpc_recv_cslot;
-ENDPT _rpc_dest_ep;
-seL4_MessageInfo_t _rpc_minfo;
-uint32_t _rpc_label;
-const char* _rpc_name;
+// RPC state of threads which never called rpc_thread_state_init, which in single threaded
+// processes is every RPC.
+static rpc_thread_state_t _rpc_default_state;
 
 // ------------------------------------------- RPC Helper ------------------------------------------
 
+void
+rpc_thread_state_init(rpc_thread_state_t *state, cslot recv_cslot)
+{
+    assert(state);
+    memset(state, 0, sizeof(rpc_thread_state_t));
+    seL4_GetIPCBuffer()->userData = (seL4_Word) state;
+    if (recv_cslot) {
+        rpc_setup_recv(recv_cslot);
+    }
+}
+
+rpc_thread_state_t*
+rpc_get_thread_state(void)
+{
+    rpc_thread_state_t *state = (rpc_thread_state_t*) seL4_GetIPCBuffer()->userData;
+    return state ? state : &_rpc_default_state;
+}
+
 void*
 rpc_malloc(size_t sz)
 {
@@ -38,14 +49,14 @@ rpc_malloc(size_t sz)
     // Note that we cannot malloc here, as malloc could call mmap which could call us back,
     // resulting in a cyclic dependency.
     assert(sz <= RPC_STATIC_MEMPOOL_OBJ_SIZE);
+    // Slots are claimed atomically, as server worker threads share the pool.
     int i;
     for (i = 0; i < RPC_MAX_TRACKED_OBJS; i++) {
-        if (!_rpc_static_mempool_table[i]) {
+        if (__sync_bool_compare_and_swap(&_rpc_static_mempool_table[i], false, true)) {
             break;
         }
     }
     assert(i < RPC_MAX_TRACKED_OBJS);
-    _rpc_static_mempool_table[i] = true;
     return _rpc_static_mempool[i];
 }
 
@@ -55,7 +66,7 @@ rpc_free(void *addr)
     int i = (((char*)addr) - (&_rpc_static_mempool[0][0])) / RPC_STATIC_MEMPOOL_OBJ_SIZE;
     assert(i >= 0 && i < RPC_MAX_TRACKED_OBJS);
     assert(_rpc_static_mempool_table[i]);
-    _rpc_static_mempool_table[i] = false;
+    __sync_lock_release(&_rpc_static_mempool_table[i]);
 }
 
 uint32_t
@@ -100,25 +111,28 @@ rpc_unmarshall(uint32_t cur_mr, char *str, uint32_t slen)
 void
 rpc_setup_recv(seL4_CPtr recv_cslot)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
 	assert(recv_cslot);
 	seL4_SetCapReceivePath(REFOS_CSPACE, recv_cslot, REFOS_CSPACE_DEPTH);
-	_rpc_recv_cslot = recv_cslot;
+	s->recv_cslot = recv_cslot;
 }
 
 void
 rpc_setup_recv_cspace(seL4_CPtr cspace, seL4_CPtr recv_cslot, seL4_Word depth)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     assert(recv_cslot);
     seL4_SetCapReceivePath(cspace, recv_cslot, depth);
-    _rpc_recv_cslot = recv_cslot;
+    s->recv_cslot = recv_cslot;
 }
 
 void
 rpc_reset_contents(void *cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     (void) cl;
-    _rpc_mr = 1;
-    _rpc_cp = 0;
+    s->mr = 1;
+    s->cp = 0;
 }
 
 // ------------------------------------------- Client RPC ------------------------------------------
@@ -126,7 +140,8 @@ rpc_reset_contents(void *cl)
 static seL4_CPtr
 rpc_get_endpoint(int32_t label)
 {
-    if (_rpc_dest_ep) return _rpc_dest_ep;
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    if (s->dest_ep) return s->dest_ep;
     assert(!"rpc_get_endpoint: unknown label.");
     return (seL4_CPtr)0;
 }
@@ -134,16 +149,17 @@ rpc_get_endpoint(int32_t label)
 void
 rpc_init(const char* name_str, int32_t label)
 {
-    _rpc_label = label;
-    _rpc_name = name_str;
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    s->label = label;
+    s->name = name_str;
 
 	rpc_reset_contents(NULL);
 
-    if (!_rpc_recv_cslot) {
+    if (!s->recv_cslot) {
         rpc_setup_recv(REFOS_THREAD_CAP_RECV);
-    } else if (seL4_MessageInfo_get_extraCaps(_rpc_minfo) > 0) {
+    } else if (seL4_MessageInfo_get_extraCaps(s->minfo) > 0) {
         // Flush recieving path of previous recieved caps.
-        seL4_CNode_Delete(REFOS_CSPACE, _rpc_recv_cslot, REFOS_CDEPTH);
+        seL4_CNode_Delete(REFOS_CSPACE, s->recv_cslot, REFOS_CDEPTH);
     }
 
     seL4_SetMR(0, label);
@@ -152,23 +168,26 @@ rpc_init(const char* name_str, int32_t label)
 void
 rpc_push_uint(uint32_t v)
 {
-    seL4_SetMR(_rpc_mr++, v);
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    seL4_SetMR(s->mr++, v);
 }
 
 void
 rpc_push_str(const char* v)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     uint32_t slen = strlen(v);
     rpc_push_uint(slen);
-    _rpc_mr = rpc_marshall(_rpc_mr, v, slen);
+    s->mr = rpc_marshall(s->mr, v, slen);
 }
 
 void
 rpc_push_buf(void* v, size_t sz)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     if (!sz) return;
     if (!v) sz = 0;
-    _rpc_mr = rpc_marshall(_rpc_mr, v, sz);
+    s->mr = rpc_marshall(s->mr, v, sz);
 }
 
 void
@@ -184,47 +203,53 @@ rpc_push_buf_array(void* v, size_t sz, uint32_t count)
 void
 rpc_push_cptr(ENDPT v)
 {
-	seL4_SetCap(_rpc_cp++, v);
+    rpc_thread_state_t *s = rpc_get_thread_state();
+	seL4_SetCap(s->cp++, v);
 }
 
 void
 rpc_set_dest(ENDPT dest)
 {
-    _rpc_dest_ep = dest;
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    s->dest_ep = dest;
 }
 
 uint32_t
 rpc_pop_uint()
 {
-    return seL4_GetMR(_rpc_mr++);
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    return seL4_GetMR(s->mr++);
 }  
 
 void
 rpc_pop_str(char* v)
 {
     // WARNING: Outputting to a C char string is never a safe thing to do.
+    rpc_thread_state_t *s = rpc_get_thread_state();
     uint32_t slen = rpc_pop_uint();
-    _rpc_mr = rpc_unmarshall(_rpc_mr, v, slen);
+    s->mr = rpc_unmarshall(s->mr, v, slen);
     v[slen] = '\0';
 }
 
 void
 rpc_pop_buf(void* v, size_t sz)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     if (!sz) return;
     assert(v);
-    _rpc_mr = rpc_unmarshall(_rpc_mr, v, sz);
+    s->mr = rpc_unmarshall(s->mr, v, sz);
 }
 
 ENDPT
 rpc_pop_cptr()
 {
-   assert(_rpc_recv_cslot);
-   if (seL4_MessageInfo_get_extraCaps(_rpc_minfo) < 1) {
+    rpc_thread_state_t *s = rpc_get_thread_state();
+   assert(s->recv_cslot);
+   if (seL4_MessageInfo_get_extraCaps(s->minfo) < 1) {
        //assert(!"RPC Failed to recieve the cap");
        return 0;
    }
-   return _rpc_recv_cslot;
+   return s->recv_cslot;
 }
 
 void
@@ -240,17 +265,22 @@ rpc_pop_buf_array(void* v, size_t sz, uint32_t count)
 int
 rpc_call_server()
 {
-    seL4_MessageInfo_t tag = seL4_MessageInfo_new(0, 0, _rpc_cp, _rpc_mr);
-    int ept = rpc_get_endpoint(_rpc_label);
-    _rpc_minfo = seL4_Call(ept, tag);
-    rpc_reset_contents(NULL);
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    seL4_MessageInfo_t tag = seL4_MessageInfo_new(0, 0, s->cp, s->mr);
+    int ept = rpc_get_endpoint(s->label);
+    s->minfo = seL4_Call(ept, tag);
+
+    // Replies carry no label, so their contents start at MR0.
+    s->mr = 0;
+    s->cp = 0;
     return 0;
 }
 
 void
 rpc_release()
 {
-    _rpc_dest_ep = 0;
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    s->dest_ep = 0;
 }
 
 
@@ -259,8 +289,9 @@ rpc_release()
 void
 rpc_sv_init(void *cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     rpc_reset_contents(cl);
-    if (!_rpc_recv_cslot) rpc_setup_recv(REFOS_THREAD_CAP_RECV);
+    if (!s->recv_cslot) rpc_setup_recv(REFOS_THREAD_CAP_RECV);
 	if (!cl) {
         return;
     }
@@ -272,17 +303,19 @@ rpc_sv_init(void *cl)
 uint32_t
 rpc_sv_pop_uint(void *cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     (void)cl;
-    return seL4_GetMR(_rpc_mr++);
+    return seL4_GetMR(s->mr++);
 }
 
 char*
 rpc_sv_pop_str(void *cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     uint32_t slen = rpc_sv_pop_uint(cl);
     char *str = rpc_malloc((slen + 1) * sizeof(char));
     assert(str);
-    _rpc_mr = rpc_unmarshall(_rpc_mr, str, slen);
+    s->mr = rpc_unmarshall(s->mr, str, slen);
     str[slen] = '\0';
     return str;
 }
@@ -290,17 +323,19 @@ rpc_sv_pop_str(void *cl)
 void
 rpc_sv_pop_buf(void *cl, void *v, size_t sz)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     if (!sz) return;
-    _rpc_mr = rpc_unmarshall(_rpc_mr, v, sz);
+    s->mr = rpc_unmarshall(s->mr, v, sz);
 }
 
 rpc_buffer_t
 rpc_sv_pop_buf_array(void *cl, size_t sz)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     uint32_t count = rpc_sv_pop_uint(cl);
     char *v = rpc_malloc(count * sz);
     for (uint32_t i = 0; i < count; i++) {
-        _rpc_mr = rpc_unmarshall(_rpc_mr, v + i * sz, sz);
+        s->mr = rpc_unmarshall(s->mr, v + i * sz, sz);
     }
     rpc_buffer_t buffer;
     buffer.data = v;
@@ -311,38 +346,42 @@ rpc_sv_pop_buf_array(void *cl, size_t sz)
 ENDPT
 rpc_sv_pop_cptr(void *cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     rpc_client_state_t* c = (rpc_client_state_t*)cl;
-    if (_rpc_cp >= seL4_MessageInfo_get_extraCaps(c->minfo)) { 
+    if (s->cp >= seL4_MessageInfo_get_extraCaps(c->minfo)) {
         return 0;
     }
     seL4_Word unw = seL4_MessageInfo_get_capsUnwrapped(c->minfo);
-    if (unw & (1 << _rpc_cp)) {
-        return seL4_CapData_Badge_get_Badge(seL4_GetBadge(_rpc_cp++));
+    if (unw & (1 << s->cp)) {
+        return seL4_CapData_Badge_get_Badge(seL4_GetBadge(s->cp++));
     }
-    _rpc_cp++;
-    assert(_rpc_recv_cslot);
-    return _rpc_recv_cslot;
+    s->cp++;
+    assert(s->recv_cslot);
+    return s->recv_cslot;
 }
 
 void
 rpc_sv_push_uint(void *cl, uint32_t v)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     (void)cl;
-    seL4_SetMR(_rpc_mr++, v);
+    seL4_SetMR(s->mr++, v);
 }
 
 void
 rpc_sv_push_buf(void *cl, void* v, size_t sz)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     if (!sz) return;
-    _rpc_mr = rpc_marshall(_rpc_mr, v, sz);
+    s->mr = rpc_marshall(s->mr, v, sz);
 }
 
 void
 rpc_sv_push_cptr(void *cl, ENDPT v)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     if (!v) return;
-    seL4_SetCap(_rpc_cp++, v);
+    seL4_SetCap(s->cp++, v);
 }
 
 void
@@ -354,30 +393,83 @@ rpc_sv_push_buf_array(void *cl, rpc_buffer_t v, size_t sz)
     }
 }
 
+void
+rpc_sv_reply_init(void *cl)
+{
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    (void) cl;
+    s->mr = 0;
+    s->cp = 0;
+}
+
 void
 rpc_sv_reply(void* cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     if (rpc_sv_skip_reply(cl)) return;
     seL4_CPtr reply_endpoint = rpc_sv_get_reply_endpoint(cl);
-    seL4_MessageInfo_t reply = seL4_MessageInfo_new(0, 0, _rpc_cp, _rpc_mr);
+    seL4_MessageInfo_t reply = seL4_MessageInfo_new(0, 0, s->cp, s->mr);
     if (reply_endpoint) {
         seL4_Send(reply_endpoint, reply);
+    } else if (s->sv_reply_recv && s->cp == 0) {
+        // Hold on to the reply until the server loop calls rpc_sv_reply_recv. The MRs are saved
+        // here since the server may still IPC (eg. dprintf) before it gets back to the loop.
+        assert(!s->sv_reply_pending);
+        for (uint32_t i = 0; i < s->mr; i++) {
+            s->sv_reply_mr[i] = seL4_GetMR(i);
+        }
+        s->sv_reply_minfo = reply;
+        s->sv_reply_pending = true;
     } else {
         seL4_Reply(reply);
     }
 }
 
+seL4_MessageInfo_t
+rpc_sv_reply_recv(seL4_CPtr ep, seL4_Word *badge)
+{
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    s->sv_reply_recv = true;
+    if (!s->sv_reply_pending) {
+        return seL4_Recv(ep, badge);
+    }
+
+    uint32_t len = seL4_MessageInfo_get_length(s->sv_reply_minfo);
+    for (uint32_t i = 0; i < len; i++) {
+        seL4_SetMR(i, s->sv_reply_mr[i]);
+    }
+    s->sv_reply_pending = false;
+    return seL4_ReplyRecv(ep, s->sv_reply_minfo, badge);
+}
+
+void
+rpc_sv_reply_flush(void)
+{
+    rpc_thread_state_t *s = rpc_get_thread_state();
+    if (!s->sv_reply_pending) {
+        return;
+    }
+
+    uint32_t len = seL4_MessageInfo_get_length(s->sv_reply_minfo);
+    for (uint32_t i = 0; i < len; i++) {
+        seL4_SetMR(i, s->sv_reply_mr[i]);
+    }
+    s->sv_reply_pending = false;
+    seL4_Reply(s->sv_reply_minfo);
+}
+
 void
 rpc_sv_release(void *cl)
 {
+    rpc_thread_state_t *s = rpc_get_thread_state();
     rpc_client_state_t* c = (rpc_client_state_t*)cl;
     (void)c;
 
-    _rpc_dest_ep = 0;
+    s->dest_ep = 0;
 
     if (seL4_MessageInfo_get_extraCaps(c->minfo) > 0) {
         // Flush recieving path of previous recieved caps.
-        seL4_CNode_Delete(REFOS_CSPACE, _rpc_recv_cslot, REFOS_CSPACE_DEPTH);
+        seL4_CNode_Delete(REFOS_CSPACE, s->recv_cslot, REFOS_CSPACE_DEPTH);
     }
 }
 
@@ -24,7 +24,7 @@ serv_special_connectless_server(seL4_CPtr anon) {
 }
 
 static serv_connection_t
-serv_connect_internal(char *serverPath, bool paramBuffer)
+serv_connect_internal(char *serverPath, bool paramBuffer, bool ping)
 {
     _svprintf("Connecting to server [%s]...\n", serverPath);
     serv_connection_t sc;
@@ -63,7 +63,7 @@ serv_connect_internal(char *serverPath, bool paramBuffer)
     }
 
     /* Try pinging the server. */
-    int error = serv_ping(sc.serverSession);
+    int error = ping ? serv_ping(sc.serverSession) : ESUCCESS;
     if (error) {
         _svprintf("    WARNING: Failed to ping file server.\n");
         sc.error = error;
@@ -119,13 +119,64 @@ exit1:
 serv_connection_t
 serv_connect(char *serverPath)
 {
-    return serv_connect_internal(serverPath, true);
+    return serv_connect_internal(serverPath, true, true);
 }
 
 serv_connection_t
 serv_connect_no_pbuffer(char *serverPath)
 {
-    return serv_connect_internal(serverPath, false);
+    return serv_connect_internal(serverPath, false, true);
+}
+
+serv_connection_t
+serv_connect_fast(char *serverPath)
+{
+    return serv_connect_internal(serverPath, false, false);
+}
+
+refos_err_t
+serv_connect_aio(serv_connection_t *sc, uint32_t entries, uint32_t size)
+{
+    assert(sc);
+    if (sc->error != ESUCCESS || sc->connectionLess) {
+        return EINVALIDPARAM;
+    }
+    if (sc->aioRing.hdr) {
+        /* Ring already set up. */
+        return ESUCCESS;
+    }
+
+    /* Create and map the ring dataspace. */
+    sc->aioRingBuffer = data_open_map(REFOS_PROCSERV_EP, "anon", 0, 0, size, -1);
+    if (sc->aioRingBuffer.err != ESUCCESS) {
+        _svprintf("    WARNING: Failed to create aio ring dspace.\n");
+        return sc->aioRingBuffer.err;
+    }
+
+    /* Format the ring before the server gets to see it. */
+    refos_aio_ring_t ring;
+    int error = refos_aio_ring_init(&ring, sc->aioRingBuffer.vaddr, size, entries);
+    if (error != ESUCCESS) {
+        goto exit1;
+    }
+
+    /* Set this ring on the server. */
+    sc->aioDoorbell = serv_set_aio_ring(sc->serverSession, sc->aioRingBuffer.dataspace, size,
+                                        &error);
+    if (error != ESUCCESS || !sc->aioDoorbell) {
+        _svprintf("    Failed to set remote server aio ring.\n");
+        error = (error != ESUCCESS) ? error : EINVALID;
+        goto exit1;
+    }
+    sc->aioRing = ring;
+    return ESUCCESS;
+
+    /* Exit stack. */
+exit1:
+    data_mapping_release(sc->aioRingBuffer);
+    memset(&sc->aioRingBuffer, 0, sizeof(data_mapping_t));
+    sc->aioDoorbell = 0;
+    return error;
 }
 
 void 
@@ -146,6 +197,12 @@ serv_disconnect(serv_connection_t *sc)
         csfree_delete(sc->serverSession);
     }
 
+    /* Clean up the asynchronous I/O ring, after the server has dropped its side of it. */
+    if (sc->aioRing.hdr) {
+        csfree_delete(sc->aioDoorbell);
+        data_mapping_release(sc->aioRingBuffer);
+    }
+
     /* Release the mountpoint. */
     nsv_mountpoint_release(&sc->serverMountPoint);
     memset(sc, 0, sizeof(serv_connection_t));
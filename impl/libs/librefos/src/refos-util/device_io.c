@@ -6,9 +6,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <autoconf.h>
 
+#include <refos/error.h>
 #include <refos-util/device_io.h>
 #include <refos-util/dprintf.h>
 
@@ -19,14 +21,57 @@
     This helper library is responsible for implementing that interface which libplatsupport relies
     on, so we can use the device drivers in libplatsupport. This includes device MMIO mapping /
     unmapping, DMA allocation, and x86 IO port operations.
+
+    Drivers written against this library directly may also use the batched IO port helpers, which
+    move string and polling loops over a port into one call.
 */
 
 /* ---------------------------------------- Device mapping -------------------------------------- */
 
+/*! @brief Release a cached MMIO mapping back to the process server.
+    @param m The unreferenced mapping cache entry to release.
+*/
+static void
+dev_io_mmio_release(struct dev_io_mmio_mapping *m)
+{
+    assert(m && m->valid && m->refCount == 0);
+    dvprintf("dev_io releasing paddr 0x%x sz 0x%x.\n", (uint32_t) m->paddr, m->size);
+    data_mapping_release(m->mapping);
+    memset(m, 0, sizeof(struct dev_io_mmio_mapping));
+}
+
+/*! @brief Find the least recently used idle MMIO mapping.
+    @param io The deviceIO state.
+    @param nIdle Optional output number of idle mappings.
+    @return The least recently used idle mapping, or NULL if there are none. (No ownership)
+*/
+static struct dev_io_mmio_mapping *
+dev_io_mmio_find_idle(dev_io_ops_t *io, int *nIdle)
+{
+    struct dev_io_mmio_mapping *lru = NULL;
+    int n = 0;
+    for (int i = 0; i < DEVICE_MMIO_MAX_MAPPINGS; i++) {
+        struct dev_io_mmio_mapping *m = &io->MMIOMappings[i];
+        if (!m->valid || m->refCount > 0) {
+            continue;
+        }
+        n++;
+        if (!lru || m->lastUse < lru->lastUse) {
+            lru = m;
+        }
+    }
+    if (nIdle) {
+        (*nIdle) = n;
+    }
+    return lru;
+}
+
 /*! @brief Map device MMIO frame(s)
     
     The actual mapping is done via an IPC to the process server. This function is simply a wrapper
-    on that, book-keeping the allocated vspace window so we can unmap it.
+    on that, book-keeping the allocated vspace window so we can unmap it. Mappings are cached by
+    physical range; a request which lies inside an existing mapping with the same cache attribute
+    reuses it without any IPC.
 
     @param cookie The deviceIO state (dev_io_ops_t).
     @param paddr The physical address of the device to be mapped.
@@ -45,39 +90,67 @@ dev_io_map(void* cookie, uintptr_t paddr, size_t size, int cached, ps_mem_flags_
     assert(io && io->magic == DEVICE_IO_TABLE_MAGIC);
     (void) flags;
 
-    /* Allocate mapping structure. */
-    data_mapping_t *deviceMapping = malloc(sizeof(data_mapping_t));
-    if (!deviceMapping) {
-        ROS_ERROR("Could not allocate device IO structure. Out of memory.");
-        return NULL;
+    uintptr_t base = REFOS_PAGE_ALIGN(paddr);
+    size_t mapSize = REFOS_PAGE_ALIGN(paddr + size + REFOS_PAGE_SIZE - 1) - base;
+    struct dev_io_mmio_mapping *m = NULL;
+
+    /* Look for an existing mapping covering this physical range. */
+    for (int i = 0; i < DEVICE_MMIO_MAX_MAPPINGS; i++) {
+        m = &io->MMIOMappings[i];
+        if (m->valid && m->cached == (cached != 0) && base >= m->paddr &&
+                base + mapSize <= m->paddr + m->size) {
+            m->refCount++;
+            m->lastUse = ++io->MMIOUseCounter;
+            dvprintf("dev_io_map paddr 0x%x cached --> vaddr 0x%x.\n", (uint32_t) paddr,
+                     (uint32_t) m->mapping.vaddr + (paddr - m->paddr));
+            return m->mapping.vaddr + (paddr - m->paddr);
+        }
+    }
+
+    /* Find a free mapping slot, or make one by releasing the least recently used idle mapping. */
+    m = NULL;
+    for (int i = 0; i < DEVICE_MMIO_MAX_MAPPINGS; i++) {
+        if (!io->MMIOMappings[i].valid) {
+            m = &io->MMIOMappings[i];
+            break;
+        }
+    }
+    if (!m) {
+        m = dev_io_mmio_find_idle(io, NULL);
+        if (!m) {
+            ROS_ERROR("Could not map device. Too many device mappings.");
+            return NULL;
+        }
+        dev_io_mmio_release(m);
     }
 
     /* Open and map the device MMIO dataspace. */
-    (*deviceMapping) = data_open_map(REFOS_PROCSERV_EP, "anon",
+    m->mapping = data_open_map(REFOS_PROCSERV_EP, "anon",
             DSPACE_FLAG_DEVICE_PADDR | (cached ? 0 : DSPACE_FLAG_UNCACHED),
-            (int) paddr, size, size);
-    if (deviceMapping->err) {
+            (int) base, mapSize, mapSize);
+    if (m->mapping.err) {
         ROS_ERROR("Could not open and map device dataspace.");
-        goto exit1;
+        memset(m, 0, sizeof(struct dev_io_mmio_mapping));
+        return NULL;
     }
-
-    /* Add to vaddr --> mapping table to book-keep deletion on unmap(). */
-    chash_set(&io->MMIOMappings, (uint32_t) deviceMapping->vaddr, (chash_item_t) deviceMapping);
+    m->valid = true;
+    m->paddr = base;
+    m->size = mapSize;
+    m->cached = (cached != 0);
+    m->refCount = 1;
+    m->lastUse = ++io->MMIOUseCounter;
 
     dvprintf("dev_io_map paddr 0x%x OK --> vaddr 0x%x.\n",
-             (uint32_t) paddr, (uint32_t) deviceMapping->vaddr);
+             (uint32_t) paddr, (uint32_t) m->mapping.vaddr + (paddr - base));
 
-    return deviceMapping->vaddr;
-
-    /* Exit stack. */
-exit1:
-    assert(deviceMapping);
-    free(deviceMapping);
-
-    return NULL;
+    return m->mapping.vaddr + (paddr - base);
 }
 
 /*! @brief Unmap a previous MMIO mapped device frame(s).
+
+    The mapping is kept around idle until DEVICE_MMIO_MAX_IDLE_MAPPINGS newer mappings have become
+    idle, in case the driver maps it again.
+
     @param cookie The deviceIO state (dev_io_ops_t).
     @param vaddr The previous mapped vaddr of device frame(s).
     @param size The size of previous mapped device frame(s) 
@@ -90,21 +163,33 @@ dev_io_unmap(void *cookie, void *vaddr, size_t size)
     assert(io && io->magic == DEVICE_IO_TABLE_MAGIC);
 
     /* Retrieve the previously mapped MMIO entry. */
-    data_mapping_t *deviceMapping = (data_mapping_t *)
-        chash_get(&io->MMIOMappings, (uint32_t) vaddr);
-    if (!deviceMapping) {
+    struct dev_io_mmio_mapping *m = NULL;
+    for (int i = 0; i < DEVICE_MMIO_MAX_MAPPINGS; i++) {
+        struct dev_io_mmio_mapping *e = &io->MMIOMappings[i];
+        if (e->valid && e->refCount > 0 && (char*) vaddr >= e->mapping.vaddr &&
+                (char*) vaddr < e->mapping.vaddr + e->size) {
+            m = e;
+            break;
+        }
+    }
+    if (!m) {
         ROS_ERROR("dev_io_unmap failed, no such mapping exists.");
         return;
     }
-    assert(deviceMapping && deviceMapping->vaddr == vaddr);
-
-    /* Delete this mapping. */
-    data_mapping_release(*deviceMapping);
-    memset(deviceMapping, 0, sizeof(data_mapping_t));
-    free(deviceMapping);
 
-    /* Delete from vaddr hash table. */
-    chash_remove(&io->MMIOMappings, (uint32_t) vaddr);
+    m->refCount--;
+    if (m->refCount > 0) {
+        return;
+    }
+    m->lastUse = ++io->MMIOUseCounter;
+
+    /* Trim the idle set. */
+    int nIdle = 0;
+    struct dev_io_mmio_mapping *lru = dev_io_mmio_find_idle(io, &nIdle);
+    if (nIdle > DEVICE_MMIO_MAX_IDLE_MAPPINGS) {
+        assert(lru);
+        dev_io_mmio_release(lru);
+    }
 }
 
 /* --------------------------------------- Device IO Ports -------------------------------------- */
@@ -178,6 +263,162 @@ dev_io_port_out(void* cookie, uint32_t port, int io_size, uint32_t val)
     return -1;
 }
 
+/* ------------------------------------ Batched IO ports ---------------------------------------- */
+
+#if defined(PLAT_PC99)
+
+/*! @brief Read a single value from an IO port, without the libplatsupport callback.
+    @return ESUCCESS if success, EINVALID if the kernel refused the read.
+*/
+static int
+devio_port_read(seL4_CPtr IOPorts, uint32_t port, int ioSize, uint32_t *result)
+{
+    switch (ioSize) {
+        case 1: {
+            seL4_X86_IOPort_In8_t res = seL4_X86_IOPort_In8(IOPorts, port);
+            (*result) = (uint32_t) res.result;
+            return res.error ? EINVALID : ESUCCESS;
+        }
+        case 2: {
+            seL4_X86_IOPort_In16_t res = seL4_X86_IOPort_In16(IOPorts, port);
+            (*result) = (uint32_t) res.result;
+            return res.error ? EINVALID : ESUCCESS;
+        }
+        case 4: {
+            seL4_X86_IOPort_In32_t res = seL4_X86_IOPort_In32(IOPorts, port);
+            (*result) = (uint32_t) res.result;
+            return res.error ? EINVALID : ESUCCESS;
+        }
+    }
+    return EINVALIDPARAM;
+}
+
+#endif /* PLAT_PC99 */
+
+int
+devio_port_in_string(dev_io_ops_t *io, uint32_t port, int ioSize, void *buf, uint32_t count)
+{
+    assert(io && io->magic == DEVICE_IO_TABLE_MAGIC);
+    if (!buf || (ioSize != 1 && ioSize != 2 && ioSize != 4)) {
+        return EINVALIDPARAM;
+    }
+
+#if defined(PLAT_PC99)
+    if (io->IOPorts) {
+        /* The size switch is hoisted out of the loop. */
+        uint32_t i = 0;
+        switch (ioSize) {
+            case 1:
+                for (; i < count; i++) {
+                    seL4_X86_IOPort_In8_t res = seL4_X86_IOPort_In8(io->IOPorts, port);
+                    if (res.error) {
+                        return EINVALID;
+                    }
+                    ((uint8_t *) buf)[i] = res.result;
+                }
+                break;
+            case 2:
+                for (; i < count; i++) {
+                    seL4_X86_IOPort_In16_t res = seL4_X86_IOPort_In16(io->IOPorts, port);
+                    if (res.error) {
+                        return EINVALID;
+                    }
+                    ((uint16_t *) buf)[i] = res.result;
+                }
+                break;
+            case 4:
+                for (; i < count; i++) {
+                    seL4_X86_IOPort_In32_t res = seL4_X86_IOPort_In32(io->IOPorts, port);
+                    if (res.error) {
+                        return EINVALID;
+                    }
+                    ((uint32_t *) buf)[i] = res.result;
+                }
+                break;
+        }
+        return ESUCCESS;
+    }
+#endif
+
+    (void) port;
+    (void) count;
+    return EUNIMPLEMENTED;
+}
+
+int
+devio_port_out_string(dev_io_ops_t *io, uint32_t port, int ioSize, const void *buf,
+                      uint32_t count)
+{
+    assert(io && io->magic == DEVICE_IO_TABLE_MAGIC);
+    if (!buf || (ioSize != 1 && ioSize != 2 && ioSize != 4)) {
+        return EINVALIDPARAM;
+    }
+
+#if defined(PLAT_PC99)
+    if (io->IOPorts) {
+        uint32_t i = 0;
+        switch (ioSize) {
+            case 1:
+                for (; i < count; i++) {
+                    seL4_X86_IOPort_Out8(io->IOPorts, port, ((const uint8_t *) buf)[i]);
+                }
+                break;
+            case 2:
+                for (; i < count; i++) {
+                    seL4_X86_IOPort_Out16(io->IOPorts, port, ((const uint16_t *) buf)[i]);
+                }
+                break;
+            case 4:
+                for (; i < count; i++) {
+                    seL4_X86_IOPort_Out32(io->IOPorts, port, ((const uint32_t *) buf)[i]);
+                }
+                break;
+        }
+        return ESUCCESS;
+    }
+#endif
+
+    (void) port;
+    (void) count;
+    return EUNIMPLEMENTED;
+}
+
+int
+devio_port_poll(dev_io_ops_t *io, uint32_t port, int ioSize, uint32_t mask, uint32_t match,
+                uint32_t maxTries, uint32_t *result)
+{
+    assert(io && io->magic == DEVICE_IO_TABLE_MAGIC);
+    if (ioSize != 1 && ioSize != 2 && ioSize != 4) {
+        return EINVALIDPARAM;
+    }
+
+#if defined(PLAT_PC99)
+    if (io->IOPorts) {
+        uint32_t val = 0;
+        for (uint32_t i = 0; i < maxTries; i++) {
+            int error = devio_port_read(io->IOPorts, port, ioSize, &val);
+            if (error != ESUCCESS) {
+                return error;
+            }
+            if ((val & mask) == match) {
+                break;
+            }
+        }
+        if (result) {
+            (*result) = val;
+        }
+        return (val & mask) == match ? ESUCCESS : EINVALID;
+    }
+#endif
+
+    (void) port;
+    (void) mask;
+    (void) match;
+    (void) maxTries;
+    (void) result;
+    return EUNIMPLEMENTED;
+}
+
 /* ----------------------------------------- Device DMA ----------------------------------------- */
 
 static void*
@@ -246,6 +487,5 @@ devio_init(dev_io_ops_t *io)
     dmaManager->dma_unpin_fn = dev_dma_unpin;
     dmaManager->dma_cache_op_fn = dev_dma_cache_op;
 
-    /* Initialise MMIO mapping table. */
-    chash_init(&io->MMIOMappings, DEVICE_MMIO_MAPPING_HASHTABLE_SIZE);
+    /* The MMIO mapping cache starts out empty, from the memset above. */
 }
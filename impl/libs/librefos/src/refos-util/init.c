@@ -25,7 +25,10 @@
 /* Forward declarations to avoid spectacular circular library dependency header soup. */
 extern void refosio_init_morecore(struct sl_procinfo_s *procInfo);
 extern void refos_init_timer(char *dspacePath);
+extern void refos_init_timer_lazy(char *dspacePath);
+extern void refos_setup_log(char *logPath);
 extern void filetable_init_default(void);
+extern void filetable_init_handover(struct sl_procinfo_s *procInfo);
 
 /* Static buffer for the cspace allocator, to avoid malloc() circular dependency disaster. */
 #define REFOS_UTIL_CSPACE_STATIC_SIZE 0x8000
@@ -795,15 +798,22 @@ refos_initialise(void)
     /* Initialise userspace allocator helper libraries. */
     walloc_init(PROCESS_WALLOC_START, PROCESS_WALLOC_END);
 
-    /* Write to the STDIO output device. */
+    /* Write to the STDIO output device. The console server is connected to on the first read or
+       write, so processes which never print don't pay for it. */
     refos_override_stdio(NULL, NULL);
-    refos_setup_dataspace_stdio(REFOS_DEFAULT_STDIO_DSPACE);
+    refos_setup_dataspace_stdio_lazy(REFOS_DEFAULT_STDIO_DSPACE);
 
-    /* Initialise file descriptor table. */
+    /* Initialise file descriptor table, taking over the selfloader's file server session. */
     filetable_init_default();
+    filetable_init_handover(refos_static_param_procinfo());
 
-    /* Initialise timer so we can sleep. */
-    refos_init_timer(REFOS_DEFAULT_TIMER_DSPACE);
+    /* Initialise timer so we can sleep. The timer is opened on first use. */
+    refos_init_timer_lazy(REFOS_DEFAULT_TIMER_DSPACE);
+
+    /* Send debug and error output through the log server, when there is one. */
+    #ifdef CONFIG_APP_LOG_SERVER
+        refos_setup_log(REFOS_DEFAULT_LOG_PATH);
+    #endif
 
     /* Initialise default environment variables. */
     _refosEnv[0] = NULL;
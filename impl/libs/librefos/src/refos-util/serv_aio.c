@@ -0,0 +1,274 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/refos.h>
+#include <refos-rpc/data_client.h>
+#include <refos-util/cspace.h>
+#include <refos-util/dprintf.h>
+#include <refos-util/walloc.h>
+#include <refos-util/serv_connect.h>
+#include <refos-util/serv_aio.h>
+
+/*! @file
+    @brief Server asynchronous I/O ring helper module. */
+
+int
+srv_aio_ring_create(struct srv_client_table *ct, struct srv_client *c,
+                    seL4_CPtr ringDataspace, uint32_t ringSize)
+{
+    assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC);
+    assert(c && ringDataspace);
+    int error = EINVALIDPARAM;
+
+    if (ringSize == 0 || ringSize > SRV_AIO_MAX_RING_SIZE) {
+        goto exit0;
+    }
+    /* The ring size comes from the client. Anything past the end of the dataspace it hands us
+       would fault when we touch it, so it must cover the whole ring. */
+    if (data_get_size(REFOS_PROCSERV_EP, ringDataspace) < ringSize) {
+        ROS_WARNING("srv_aio_ring_create: ring dataspace smaller than ring size.");
+        goto exit0;
+    }
+    srv_aio_ring_release(ct, c);
+
+    struct srv_aio_ring *r = malloc(sizeof(struct srv_aio_ring));
+    if (!r) {
+        ROS_ERROR("srv_aio_ring_create out of memory.");
+        error = ENOMEM;
+        goto exit0;
+    }
+    memset(r, 0, sizeof(struct srv_aio_ring));
+    r->dataspace = ringDataspace;
+
+    /* Map the client's ring dataspace into our own vspace. */
+    r->sizeNPages = (ringSize / REFOS_PAGE_SIZE) + ((ringSize % REFOS_PAGE_SIZE) ? 1 : 0);
+    r->vaddr = (char*) walloc(r->sizeNPages, &r->window);
+    if (!r->vaddr || !r->window) {
+        ROS_ERROR("srv_aio_ring_create failed to allocate window.");
+        error = ENOMEM;
+        goto exit1;
+    }
+    error = data_datamap(REFOS_PROCSERV_EP, r->dataspace, r->window, 0);
+    if (error != ESUCCESS) {
+        ROS_WARNING("srv_aio_ring_create failed to datamap ring dataspace.");
+        goto exit2;
+    }
+
+    /* The ring contents come from the client, and are not trusted. */
+    error = refos_aio_ring_validate(&r->ring, r->vaddr, ringSize);
+    if (error != ESUCCESS) {
+        ROS_WARNING("srv_aio_ring_create: invalid ring header.");
+        goto exit3;
+    }
+
+    r->magic = SRV_AIO_RING_MAGIC;
+    c->aioRing = r;
+    cvector_add(&ct->aioClientList, (cvector_item_t) c);
+    return ESUCCESS;
+
+    /* Exit stack. */
+exit3:
+    data_dataunmap(REFOS_PROCSERV_EP, r->window);
+exit2:
+    walloc_free((uint32_t) r->vaddr, r->sizeNPages);
+exit1:
+    free(r);
+exit0:
+    csfree_delete(ringDataspace);
+    return error;
+}
+
+struct srv_aio_ring *
+srv_aio_ring_detach(struct srv_client_table *ct, struct srv_client *c)
+{
+    assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC && c);
+    struct srv_aio_ring *r = c->aioRing;
+    if (!r) {
+        return NULL;
+    }
+    assert(r->magic == SRV_AIO_RING_MAGIC);
+
+    int n = cvector_count(&ct->aioClientList);
+    for (int i = 0; i < n; i++) {
+        if ((struct srv_client *) cvector_get(&ct->aioClientList, i) == c) {
+            cvector_delete_unordered(&ct->aioClientList, i);
+            break;
+        }
+    }
+    c->aioRing = NULL;
+    r->next = NULL;
+    return r;
+}
+
+void
+srv_aio_ring_free(struct srv_aio_ring *r)
+{
+    assert(r && r->magic == SRV_AIO_RING_MAGIC);
+    data_dataunmap(REFOS_PROCSERV_EP, r->window);
+    walloc_free((uint32_t) r->vaddr, r->sizeNPages);
+    csfree_delete(r->dataspace);
+    r->magic = 0;
+    free(r);
+}
+
+void
+srv_aio_ring_release(struct srv_client_table *ct, struct srv_client *c)
+{
+    struct srv_aio_ring *r = srv_aio_ring_detach(ct, c);
+    if (r) {
+        srv_aio_ring_free(r);
+    }
+}
+
+int
+srv_aio_bind(struct srv_client *c, uint32_t object)
+{
+    assert(c);
+    struct srv_aio_ring *r = c->aioRing;
+    if (!r) {
+        return -ENOPARAMBUFFER;
+    }
+    assert(r->magic == SRV_AIO_RING_MAGIC);
+    for (int i = 0; i < SRV_AIO_MAX_BINDINGS; i++) {
+        if (!r->bindings[i].used) {
+            r->bindings[i].used = true;
+            r->bindings[i].object = object;
+            r->bindings[i].pos = 0;
+            return i;
+        }
+    }
+    return -ENOMEM;
+}
+
+void
+srv_aio_unbind_object(struct srv_client_table *ct, uint32_t object)
+{
+    assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC);
+    int n = cvector_count(&ct->aioClientList);
+    for (int i = 0; i < n; i++) {
+        struct srv_client *c = (struct srv_client *) cvector_get(&ct->aioClientList, i);
+        assert(c && c->aioRing && c->aioRing->magic == SRV_AIO_RING_MAGIC);
+        for (int j = 0; j < SRV_AIO_MAX_BINDINGS; j++) {
+            struct srv_aio_binding *b = &c->aioRing->bindings[j];
+            if (b->used && b->object == object) {
+                b->used = false;
+            }
+        }
+    }
+}
+
+/*! @brief Resolve and carry out a single submission.
+    @param c The client owning the ring.
+    @param r The client's ring.
+    @param sqe The submission. The offset and whence are resolved in place.
+    @param op The server's operation callback.
+    @return The completion result.
+*/
+static int32_t
+srv_aio_process_sqe(struct srv_client *c, struct srv_aio_ring *r, struct refos_aio_sqe *sqe,
+                    srv_aio_op_fn_t op)
+{
+    if (sqe->opcode == REFOS_AIO_OP_NOP) {
+        return 0;
+    }
+    if (sqe->handle >= SRV_AIO_MAX_BINDINGS || !r->bindings[sqe->handle].used) {
+        return -EINVALIDPARAM;
+    }
+    struct srv_aio_binding *b = &r->bindings[sqe->handle];
+    int32_t result;
+
+    switch (sqe->opcode) {
+    case REFOS_AIO_OP_READ:
+    case REFOS_AIO_OP_WRITE: {
+        if (sqe->bufOffset > r->ring.dataSize || sqe->len > r->ring.dataSize - sqe->bufOffset) {
+            return -EINVALIDPARAM;
+        }
+        bool current = (sqe->offset == REFOS_AIO_OFFSET_CURRENT);
+        if (current) {
+            sqe->offset = b->pos;
+        } else if (sqe->offset < 0) {
+            return -EINVALIDPARAM;
+        }
+        result = op(c, b->object, sqe, r->ring.data + sqe->bufOffset);
+        if (current && result > 0) {
+            b->pos += result;
+        }
+        return result;
+    }
+    case REFOS_AIO_OP_LSEEK:
+        if (sqe->whence == SEEK_CUR) {
+            sqe->offset += b->pos;
+            sqe->whence = SEEK_SET;
+        }
+        if (sqe->whence != SEEK_SET && sqe->whence != SEEK_END) {
+            return -EINVALIDPARAM;
+        }
+        result = op(c, b->object, sqe, NULL);
+        if (result >= 0) {
+            b->pos = result;
+        }
+        return result;
+    default:
+        break;
+    }
+    return -EUNIMPLEMENTED;
+}
+
+int
+srv_aio_process(struct srv_client *c, srv_aio_op_fn_t op)
+{
+    assert(c && op);
+    struct srv_aio_ring *r = c->aioRing;
+    if (!r) {
+        return -ENOPARAMBUFFER;
+    }
+    assert(r->magic == SRV_AIO_RING_MAGIC);
+
+    /* Submissions stay on the ring while there is no room to post their completion. Bounded to a
+       ring's worth, as the client controls both the submission tail and the completion head, and
+       could otherwise keep refilling one and draining the other to hold us here forever. */
+    struct refos_aio_sqe sqe;
+    struct refos_aio_cqe cqe;
+    uint32_t n = 0;
+    while (n < r->ring.entries && refos_aio_cq_space(&r->ring) &&
+            refos_aio_sq_pop(&r->ring, &sqe) == 0) {
+        n++;
+        cqe.userData = sqe.userData;
+        cqe.result = srv_aio_process_sqe(c, r, &sqe, op);
+        if (refos_aio_cq_push(&r->ring, &cqe) != 0) {
+            /* Only possible if the client has corrupted its completion ring indices. */
+            ROS_WARNING("srv_aio_process: client cID = %d completion ring overrun.", c->cID);
+            return -EINVALIDPARAM;
+        }
+    }
+    return (int) refos_aio_cq_ready(&r->ring);
+}
+
+int
+srv_aio_process_all(struct srv_client_table *ct, srv_aio_op_fn_t op)
+{
+    assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC);
+    int n = cvector_count(&ct->aioClientList);
+    int left = 0;
+    for (int i = 0; i < n; i++) {
+        struct srv_client *c = (struct srv_client *) cvector_get(&ct->aioClientList, i);
+        assert(c && c->aioRing);
+        if (srv_aio_process(c, op) < 0) {
+            continue;
+        }
+        /* A client with a full completion ring will signal again once it has drained it. */
+        refos_aio_ring_t *ring = &c->aioRing->ring;
+        if (refos_aio_sq_pending(ring) > 0 && refos_aio_cq_space(ring)) {
+            left++;
+        }
+    }
+    return left;
+}
@@ -16,12 +16,17 @@
 #include <refos-util/cspace.h>
 #include <refos-util/serv_common.h>
 #include <refos-util/serv_connect.h>
+#include <refos-util/serv_aio.h>
 
 #include <refos-rpc/proc_client.h>
 #include <refos-rpc/proc_client_helper.h>
 #include <refos-rpc/name_client.h>
 #include <refos-rpc/name_client_helper.h>
 
+/* From librefossys. See refos-io/log.h. */
+extern refos_err_t refos_log_share_ring(seL4_CPtr doorbell, seL4_CPtr *ringDataspace,
+                                        uint32_t *ringSize);
+
 /* -------------------- Server Default Client Table Handler Helpers ----------------------------- */
 
 struct srv_client*
@@ -113,6 +118,84 @@ srv_ctable_set_param_buffer_handler(srv_common_t *srv, struct srv_client *c,
 
 }
 
+seL4_CPtr
+srv_ctable_set_aio_ring_handler(srv_common_t *srv, struct srv_client *c,
+        srv_msg_t *m, seL4_CPtr ringDataspace, uint32_t ringSize, int* _errno)
+{
+    assert(srv && srv->magic == SRV_MAGIC);
+    assert(c && m);
+
+    if (!srv->notifyAioAsyncEP) {
+        SET_ERRNO_PTR(_errno, EUNIMPLEMENTED);
+        return 0;
+    }
+
+    /* Special case: unset the ring. */
+    if (!ringDataspace && ringSize == 0) {
+        srv_aio_ring_release(&srv->clientTable, c);
+        SET_ERRNO_PTR(_errno, ESUCCESS);
+        return 0;
+    }
+
+    /* Sanity check parameters. */
+    if (!srv_check_dispatch_caps(m, 0x00000000, 1)) {
+        SET_ERRNO_PTR(_errno, EINVALIDPARAM);
+        return 0;
+    }
+
+    /* Copyout the ring dataspace cap. Do not printf before copyout. */
+    seL4_CPtr ringDS = rpc_copyout_cptr(ringDataspace);
+    if (!ringDS) {
+        ROS_ERROR("Failed to copyout the cap.");
+        SET_ERRNO_PTR(_errno, ENOMEM);
+        return 0;
+    }
+
+    int error = srv_aio_ring_create(&srv->clientTable, c, ringDS, ringSize);
+    if (error != ESUCCESS) {
+        SET_ERRNO_PTR(_errno, error);
+        return 0;
+    }
+    dprintf("Set aio ring for client cID = %d...\n", c->cID);
+
+    /* Every client shares the same doorbell badge, so give out a copy of the one minted cap. */
+    SET_ERRNO_PTR(_errno, ESUCCESS);
+    return srv->notifyAioAsyncEP;
+}
+
+seL4_CPtr
+srv_ctable_get_log_ring_handler(srv_common_t *srv, struct srv_client *c,
+        srv_msg_t *m, seL4_CPtr doorbell, uint32_t* ringSize, int* _errno)
+{
+    assert(srv && srv->magic == SRV_MAGIC);
+    assert(c && m && ringSize);
+
+    /* Sanity check parameters. */
+    if (!srv_check_dispatch_caps(m, 0x00000000, 1)) {
+        SET_ERRNO_PTR(_errno, EINVALIDPARAM);
+        return 0;
+    }
+
+    /* Copyout the doorbell cap. Do not printf before copyout. */
+    seL4_CPtr ringDoorbell = rpc_copyout_cptr(doorbell);
+    if (!ringDoorbell) {
+        ROS_ERROR("Failed to copyout the cap.");
+        SET_ERRNO_PTR(_errno, ENOMEM);
+        return 0;
+    }
+
+    seL4_CPtr ringDS = 0;
+    int error = refos_log_share_ring(ringDoorbell, &ringDS, ringSize);
+    if (error != ESUCCESS) {
+        SET_ERRNO_PTR(_errno, error);
+        return 0;
+    }
+    dprintf("Gave log ring to client cID = %d...\n", c->cID);
+
+    SET_ERRNO_PTR(_errno, ESUCCESS);
+    return ringDS;
+}
+
 void
 srv_ctable_disconnect_direct_handler(srv_common_t *srv, struct srv_client *c)
 {
@@ -157,6 +240,16 @@ srv_common_init(srv_common_t *s, srv_common_config_t config)
         return EINVALID;
     }
 
+    /* Mint badged async I/O ring doorbell EP. */
+    if (config.aioNotifyBadge) {
+        dprintf("    creating async I/O ring doorbell badged EP...\n");
+        s->notifyAioAsyncEP = srv_mint(config.aioNotifyBadge, s->notifyAsyncEP);
+        if (!s->notifyAioAsyncEP) {
+            ROS_ERROR("srv_common_init could not create minted doorbell async endpoint.");
+            return EINVALID;
+        }
+    }
+
     /* Bind the notification AEP. */
     dprintf("    binding notification AEP...\n");
     int error = seL4_TCB_BindNotification(REFOS_THREAD_TCB, s->notifyAsyncEP);
@@ -184,6 +277,8 @@ srv_common_init(srv_common_t *s, srv_common_config_t config)
         dprintf("    initialising client table default handlers for %s...\n", config.serverName);
         s->ctable_connect_direct_handler = srv_ctable_connect_direct_handler;
         s->ctable_set_param_buffer_handler = srv_ctable_set_param_buffer_handler;
+        s->ctable_set_aio_ring_handler = srv_ctable_set_aio_ring_handler;
+        s->ctable_get_log_ring_handler = srv_ctable_get_log_ring_handler;
         s->ctable_disconnect_direct_handler = srv_ctable_disconnect_direct_handler;
     }
 
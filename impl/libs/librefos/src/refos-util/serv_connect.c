@@ -9,12 +9,106 @@
 #include <assert.h>
 #include <sel4/sel4.h>
 #include <refos/refos.h>
+#include <refos/error.h>
+#include <refos/sync.h>
 #include <refos-util/serv_connect.h>
 #include <refos-util/cspace.h>
+#include <refos-util/serv_reply.h>
+#include <refos-util/serv_aio.h>
 
 /*! @file
     @brief Server client connection module implementation. */
 
+static inline void
+client_table_lock(struct srv_client_table *ct)
+{
+    if (ct->lock) {
+        sync_acquire(ct->lock);
+    }
+}
+
+static inline void
+client_table_unlock(struct srv_client_table *ct)
+{
+    if (ct->lock) {
+        sync_release(ct->lock);
+    }
+}
+
+/*! @brief Gets the associated client structure given an ID. The table lock must be held. */
+static struct srv_client*
+client_get_locked(struct srv_client_table *ct, int id)
+{
+    if (id < 0 || id >= ct->maxClients) {
+        /* Invalid ID. */
+        return NULL;
+    }
+    struct srv_client* nclient = (struct srv_client*) coat_get(&ct->allocTable, id);
+    if (!nclient) {
+        /* No such client ID exists. */
+        return NULL;
+    }
+    assert(nclient->magic == ct->clientMagic);
+    return nclient;
+}
+
+/*! @brief Queue this client up for deletion. The table lock must be held. */
+static void
+client_queue_delete_locked(struct srv_client_table *ct, int id)
+{
+    /* Sanity check on the given ID. */
+    struct srv_client *c = client_get_locked(ct, id);
+    if (!c) {
+        return;
+    }
+    if (clist_linked(&c->pendingNode)) {
+        /* Client already queued for deletion. Ignore. */
+        return;
+    }
+    /* Queue this client up to be deleted. */
+    clist_add_tail(&ct->pendingFreeList, &c->pendingNode);
+    ct->numPending++;
+}
+
+/*! @brief Delete all the clients on the pending free list. The table lock must be held, and no
+           IPC may be in flight.
+    @return The deleted clients' asynchronous I/O rings, to free with client_table_free_rings()
+            once the table lock is released. (Gives ownership)
+*/
+static struct srv_aio_ring *
+client_table_reap_locked(struct srv_client_table *ct)
+{
+    assert(ct->numActive == 0);
+    clist_node_t *n;
+    while ((n = clist_pop_head(&ct->pendingFreeList)) != NULL) {
+        struct srv_client *c = clist_entry(n, struct srv_client, pendingNode);
+        if (client_get_locked(ct, c->cID) != c) {
+            assert(!"Client in pending free list doesn't exist. Book keeping error.");
+            continue;
+        }
+        coat_free(&ct->allocTable, c->cID);
+    }
+    ct->numPending = 0;
+    ct->numDeferred = 0;
+    ct->draining = false;
+
+    struct srv_aio_ring *rings = ct->deadAioRings;
+    ct->deadAioRings = NULL;
+    return rings;
+}
+
+/*! @brief Free the rings returned by client_table_reap_locked(). Unmapping a ring is an IPC to the
+           process server, which would hold up every other worker if made with the table locked. */
+static void
+client_table_free_rings(struct srv_aio_ring *r)
+{
+    while (r) {
+        struct srv_aio_ring *next = r->next;
+        srv_aio_ring_free(r);
+        r = next;
+    }
+}
+
 static cvector_item_t
 client_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
 {
@@ -22,7 +116,7 @@ client_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC);
 
     /* Allocate and set up new client structure. */
-    struct srv_client *nclient = malloc(sizeof(struct srv_client));
+    struct srv_client *nclient = cslab_alloc(&ct->clientCache);
     if (!nclient) {
         printf("ERROR: client_oat_create out of memory!\n");
         return NULL;
@@ -34,6 +128,10 @@ client_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     nclient->deathID = -1;
     nclient->paramBufferStart = 0;
     nclient->paramBuffer = 0;
+    nclient->paramBufferSize = 0;
+    chlist_init(&nclient->replyWaiters);
+    nclient->aioRing = NULL;
+    clist_node_init(&nclient->pendingNode);
 
     /* Mint a session cap. */
     nclient->session = csalloc();
@@ -59,7 +157,7 @@ exit2:
     csfree(nclient->session);
 exit1:
     assert(nclient);
-    free(nclient);
+    cslab_free(&ct->clientCache, nclient);
     return NULL;
 }
 
@@ -68,11 +166,20 @@ client_oat_delete(coat_t *oat, cvector_item_t *obj)
 {
     struct srv_client_table *ct = ((struct srv_client_table*) oat);
     assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC);
-    (void) ct;
 
     struct srv_client *client = (struct srv_client *) obj;
     assert(client && client->magic == ct->clientMagic);
 
+    /* Cancel any deferred replies still pending on this client. */
+    srv_reply_cancel_client(client);
+
+    /* Take the client's asynchronous I/O ring, to be unmapped once the table is unlocked. */
+    struct srv_aio_ring *r = srv_aio_ring_detach(ct, client);
+    if (r) {
+        r->next = ct->deadAioRings;
+        ct->deadAioRings = r;
+    }
+
     /* Clean up client info from cspace. */
     if (client->liveness) {
         //seL4_CNode_Revoke(REFOS_CSPACE, client->liveness, REFOS_CDEPTH); // FIXME REVOKE BUG
@@ -92,7 +199,7 @@ client_oat_delete(coat_t *oat, cvector_item_t *obj)
     }
 
     /* Finally, free the entire structure. */
-    free(client);
+    cslab_free(&ct->clientCache, client);
 }
 
 void
@@ -104,6 +211,12 @@ client_table_init(struct srv_client_table *ct, int maxClients, int badgeBase, ui
     ct->clientMagic = magic;
     ct->badgeBase = badgeBase;
     ct->sessionSrcEP = sessionSrcEP;
+    ct->lock = NULL;
+    ct->numActive = 0;
+    ct->numPending = 0;
+    ct->numDeferred = 0;
+    ct->draining = false;
+    ct->deadAioRings = NULL;
 
     /* Configure the object allocation table creation / deletion callback func pointers. */
     ct->allocTable.oat_expand = NULL;
@@ -111,33 +224,88 @@ client_table_init(struct srv_client_table *ct, int maxClients, int badgeBase, ui
     ct->allocTable.oat_delete = client_oat_delete;
 
     /* Initialise our data structures. */
+    cslab_init(&ct->clientCache, sizeof(struct srv_client), 0, NULL, NULL);
     coat_init(&ct->allocTable, 1, ct->maxClients);
-    cvector_init(&ct->pendingFreeList);
+    clist_init(&ct->pendingFreeList);
+    cvector_init(&ct->aioClientList);
 }
 
 void
 client_table_release(struct srv_client_table *ct)
 {
     coat_release(&ct->allocTable);
-    cvector_free(&ct->pendingFreeList);
+    client_table_free_rings(ct->deadAioRings);
+    ct->deadAioRings = NULL;
+    cslab_release(&ct->clientCache);
+    clist_init(&ct->pendingFreeList);
+    ct->numPending = 0;
+    cvector_free(&ct->aioClientList);
+    if (ct->lock) {
+        sync_destroy_mutex(ct->lock);
+        ct->lock = NULL;
+    }
+}
+
+int
+client_table_enable_locking(struct srv_client_table *ct)
+{
+    assert(ct && ct->magic == SRC_CLIENT_LIST_MAGIC);
+    if (ct->lock) {
+        return ESUCCESS;
+    }
+    ct->lock = sync_create_mutex();
+    if (!ct->lock) {
+        printf("ERROR: client_table_enable_locking could not create lock.\n");
+        return ENOMEM;
+    }
+    return ESUCCESS;
+}
+
+void
+client_table_enter(struct srv_client_table *ct)
+{
+    if (!ct->lock) {
+        return;
+    }
+    struct srv_aio_ring *rings = NULL;
+    sync_acquire(ct->lock);
+    while (ct->draining) {
+        if (ct->numActive == 0) {
+            rings = client_table_reap_locked(ct);
+            break;
+        }
+        /* Let the IPCs in flight finish; the last one deletes the pending clients. */
+        sync_release(ct->lock);
+        seL4_Yield();
+        sync_acquire(ct->lock);
+    }
+    ct->numActive++;
+    sync_release(ct->lock);
+    client_table_free_rings(rings);
 }
 
 void
 client_table_postaction(struct srv_client_table *ct)
 {
-    /* Actually delete all the clients on the pending free list. */
-    int len = cvector_count(&ct->pendingFreeList);
-    for (int i = 0; i < len; i++) {
-        /* Actually delete this client. */
-        int id = (int) cvector_get(&ct->pendingFreeList, i);
-        if (!client_get(ct, id)) {
-            assert(!"Client in pending free list doesn't exist. Book keeping error.");
-            continue;
+    client_table_lock(ct);
+    if (ct->numActive > 0) {
+        ct->numActive--;
+    }
+    if (ct->numActive > 0) {
+        /* Another worker may still be using a client on the pending free list. Don't let that put
+           off deleting it for ever. */
+        if (ct->numPending > 0 && (++ct->numDeferred >= SRC_CLIENT_TABLE_MAX_DEFERRED ||
+                ct->numPending >= SRC_CLIENT_TABLE_MAX_PENDING)) {
+            ct->draining = true;
         }
-        coat_free(&ct->allocTable, id);
+        client_table_unlock(ct);
+        return;
     }
-    /* Clear the pending free list. */
-    cvector_reset(&ct->pendingFreeList);
+
+    /* Actually delete all the clients on the pending free list. */
+    struct srv_aio_ring *rings = client_table_reap_locked(ct);
+    client_table_unlock(ct);
+    client_table_free_rings(rings);
 }
 
 struct srv_client*
@@ -148,7 +316,9 @@ client_alloc(struct srv_client_table *ct, seL4_CPtr liveness)
     arg[0] = liveness;
 
     /* Allocate an ID, and the client structure associated with it. */
+    client_table_lock(ct);
     int ID = coat_alloc(&ct->allocTable, arg, (cvector_item_t *) &nclient);
+    client_table_unlock(ct);
     if (!nclient) {
         printf("ERROR: client_alloc couldn't allocate a client ID.\n");
         return NULL;
@@ -163,16 +333,9 @@ client_alloc(struct srv_client_table *ct, seL4_CPtr liveness)
 struct srv_client*
 client_get(struct srv_client_table *ct, int id)
 {
-    if (id < 0 || id >= ct->maxClients) {
-        /* Invalid ID. */
-        return NULL;
-    }
-    struct srv_client* nclient = (struct srv_client*) coat_get(&ct->allocTable, id);
-    if (!nclient) {
-        /* No such client ID exists. */
-        return NULL;
-    }
-    assert(nclient->magic == ct->clientMagic);
+    client_table_lock(ct);
+    struct srv_client* nclient = client_get_locked(ct, id);
+    client_table_unlock(ct);
     return nclient;
 }
 
@@ -188,31 +351,23 @@ client_get_badge(struct srv_client_table *ct, int badge)
 void
 client_queue_delete(struct srv_client_table *ct, int id)
 {
-    /* Sanity check on the given ID. */
-    if (!client_get(ct, id)) {
-        return;
-    }
-    int len = cvector_count(&ct->pendingFreeList);
-    for (int i = 0; i < len; i++) {
-        int cid = (int) cvector_get(&ct->pendingFreeList, i);
-        if (id == cid) {
-            /* Client already queued for deletion. Ignore. */
-            return;
-        }
-    }
-    /* Queue this client ID up to be deleted. */
-    cvector_add(&ct->pendingFreeList, (cvector_item_t) id);
+    client_table_lock(ct);
+    client_queue_delete_locked(ct, id);
+    client_table_unlock(ct);
 }
 
 int
 client_queue_delete_deathID(struct srv_client_table *ct, int deathID)
 {
+    client_table_lock(ct);
     for (int i = 0; i < ct->maxClients; i++) {
-        struct srv_client *c = client_get(ct, i);
+        struct srv_client *c = client_get_locked(ct, i);
         if (c && c->deathID == deathID) {
-            client_queue_delete(ct, c->cID);
+            client_queue_delete_locked(ct, c->cID);
+            client_table_unlock(ct);
             return 0;
         }
     }
+    client_table_unlock(ct);
     return -1;
 }
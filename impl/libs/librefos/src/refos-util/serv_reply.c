@@ -0,0 +1,181 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/refos.h>
+#include <refos-util/cspace.h>
+#include <refos-util/serv_connect.h>
+#include <refos-util/serv_reply.h>
+
+/*! @file
+    @brief Server deferred reply helper module. */
+
+/*! @brief Allocate another batch of waiter records and their reply cslots onto the free list.
+    @param p The pool to grow.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+srv_reply_pool_grow(struct srv_reply_pool *p)
+{
+    if (p->count >= p->maxWaiters) {
+        return ENOMEM;
+    }
+
+    struct srv_reply_waiter *batch = malloc(sizeof(struct srv_reply_waiter) *
+                                            SRV_REPLY_POOL_BATCH);
+    if (!batch) {
+        ROS_ERROR("srv_reply_pool_grow out of memory.");
+        return ENOMEM;
+    }
+    memset(batch, 0, sizeof(struct srv_reply_waiter) * SRV_REPLY_POOL_BATCH);
+
+    int n = 0;
+    for (; n < SRV_REPLY_POOL_BATCH && p->count < p->maxWaiters; n++) {
+        struct srv_reply_waiter *w = &batch[n];
+        w->reply = csalloc();
+        if (!w->reply) {
+            ROS_ERROR("srv_reply_pool_grow failed to alloc cslot.");
+            break;
+        }
+        w->magic = SRV_REPLY_WAITER_MAGIC;
+        w->pool = p;
+        clist_add_head(&p->freeList, &w->node);
+        p->count++;
+    }
+
+    if (n == 0) {
+        free(batch);
+        return ENOMEM;
+    }
+    cvector_add(&p->batchList, (cvector_item_t) batch);
+    return ESUCCESS;
+}
+
+int
+srv_reply_pool_init(struct srv_reply_pool *p, int initialWaiters, int maxWaiters)
+{
+    assert(p);
+    memset(p, 0, sizeof(struct srv_reply_pool));
+    p->magic = SRV_REPLY_POOL_MAGIC;
+    p->maxWaiters = maxWaiters;
+    clist_init(&p->freeList);
+    clist_init(&p->waitList);
+    cvector_init(&p->batchList);
+
+    while (p->count < initialWaiters) {
+        int error = srv_reply_pool_grow(p);
+        if (error != ESUCCESS) {
+            return error;
+        }
+    }
+    return ESUCCESS;
+}
+
+void
+srv_reply_pool_release(struct srv_reply_pool *p)
+{
+    assert(p && p->magic == SRV_REPLY_POOL_MAGIC);
+
+    /* Unlink any remaining waiters from their clients. */
+    struct srv_reply_waiter *w;
+    while ((w = srv_reply_first(p)) != NULL) {
+        srv_reply_free(w);
+    }
+
+    int nbatch = cvector_count(&p->batchList);
+    for (int i = 0; i < nbatch; i++) {
+        struct srv_reply_waiter *batch = (struct srv_reply_waiter *)
+                cvector_get(&p->batchList, i);
+        for (int j = 0; j < SRV_REPLY_POOL_BATCH; j++) {
+            if (batch[j].reply) {
+                csfree_delete(batch[j].reply);
+            }
+            batch[j].magic = 0;
+        }
+        free(batch);
+    }
+    cvector_free(&p->batchList);
+    clist_init(&p->freeList);
+    p->count = 0;
+    p->magic = 0;
+}
+
+struct srv_reply_waiter *
+srv_reply_save_caller(struct srv_reply_pool *p, struct srv_client *c)
+{
+    assert(p && p->magic == SRV_REPLY_POOL_MAGIC);
+    assert(c);
+
+    if (clist_empty(&p->freeList) && srv_reply_pool_grow(p) != ESUCCESS) {
+        ROS_ERROR("srv_reply_save_caller out of waiters.");
+        return NULL;
+    }
+    struct srv_reply_waiter *w = clist_entry(clist_first(&p->freeList), struct srv_reply_waiter,
+                                             node);
+    assert(w && w->magic == SRV_REPLY_WAITER_MAGIC && !w->client);
+
+    /* Save current caller into the pooled reply cslot. */
+    int error = seL4_CNode_SaveCaller(REFOS_CSPACE, w->reply, REFOS_CDEPTH);
+    if (error != seL4_NoError) {
+        ROS_ERROR("srv_reply_save_caller failed to save caller.");
+        return NULL;
+    }
+    clist_remove(&p->freeList, &w->node);
+
+    w->client = c;
+    w->arg = 0;
+    w->type = 0;
+
+    /* Append to the pool FIFO list, and push onto the client's waiter chain. */
+    clist_add_tail(&p->waitList, &w->node);
+    chlist_add_head(&c->replyWaiters, &w->clientNode);
+
+    return w;
+}
+
+void
+srv_reply_bind(struct srv_reply_waiter *w)
+{
+    assert(w && w->magic == SRV_REPLY_WAITER_MAGIC && w->client);
+    w->client->rpcClient.skip_reply = false;
+    w->client->rpcClient.reply = w->reply;
+}
+
+void
+srv_reply_free(struct srv_reply_waiter *w)
+{
+    assert(w && w->magic == SRV_REPLY_WAITER_MAGIC && w->client);
+    struct srv_reply_pool *p = w->pool;
+    struct srv_client *c = w->client;
+    assert(p && p->magic == SRV_REPLY_POOL_MAGIC);
+
+    if (c->rpcClient.reply == w->reply) {
+        c->rpcClient.reply = 0;
+    }
+
+    /* The kernel consumes the reply cap when it is replied to, but it is still there if the
+       waiter is being cancelled. */
+    seL4_CNode_Delete(REFOS_CSPACE, w->reply, REFOS_CDEPTH);
+
+    /* Unlink from the client's waiter chain and the pool FIFO list, and return to the free list. */
+    chlist_remove(&w->clientNode);
+    clist_remove(&p->waitList, &w->node);
+    w->client = NULL;
+    clist_add_head(&p->freeList, &w->node);
+}
+
+void
+srv_reply_cancel_client(struct srv_client *c)
+{
+    assert(c);
+    while (!chlist_empty(&c->replyWaiters)) {
+        srv_reply_free(clist_entry(c->replyWaiters.first, struct srv_reply_waiter, clientNode));
+    }
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sel4/sel4.h>
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos/sync.h>
+#include <refos-rpc/rpc.h>
+#include <refos-rpc/proc_client.h>
+#include <refos-rpc/proc_client_helper.h>
+#include <refos-util/cspace.h>
+#include <refos-util/dprintf.h>
+#include <refos-util/serv_runtime.h>
+
+/*! @file
+    @brief Multi-threaded server runtime. */
+
+/*! @brief The runtime of this process. Worker threads are started without an argument, so they
+           find their runtime here. */
+static srv_runtime_t *_srvRuntime = NULL;
+
+/*! @brief Release the worker threads' recieve slots and stacks.
+    @param rt The runtime structure. (No ownership)
+*/
+static void
+srv_runtime_free_workers(srv_runtime_t *rt)
+{
+    for (int i = 1; i < SRV_RUNTIME_MAX_WORKERS; i++) {
+        struct srv_worker *w = &rt->workers[i];
+        if (w->recvSlot) {
+            csfree(w->recvSlot);
+            w->recvSlot = 0;
+        }
+        if (w->stack) {
+            free(w->stack);
+            w->stack = NULL;
+        }
+    }
+}
+
+/*! @brief The worker message loop. Recieves, dispatches and replies to messages forever.
+    @param w The calling thread's worker structure. (No ownership)
+*/
+static void
+srv_worker_loop(struct srv_worker *w)
+{
+    assert(w && w->magic == SRV_WORKER_MAGIC);
+    srv_runtime_t *rt = w->runtime;
+    srv_common_t *srv = rt->srv;
+    srv_msg_t *m = &w->msg;
+
+    /* Every RPC from now on uses this worker's state. */
+    rpc_thread_state_init(&w->rpcState, w->recvSlot);
+
+    while (1) {
+        m->message = rpc_sv_reply_recv(srv->anonEP, &m->badge);
+        client_table_enter(&srv->clientTable);
+        if (rt->serialLock) {
+            sync_acquire(rt->serialLock);
+        }
+        rt->config.handler(m);
+
+        /* Client deletion frees memory and may RPC, so it is serialised with the handler too. */
+        client_table_postaction(&srv->clientTable);
+        if (rt->serialLock) {
+            sync_release(rt->serialLock);
+        }
+    }
+}
+
+/*! @brief Worker thread entry point. Claims the next free worker structure. */
+static int
+srv_worker_entry(void *arg)
+{
+    (void) arg;
+    srv_runtime_t *rt = _srvRuntime;
+    assert(rt && rt->magic == SRV_RUNTIME_MAGIC);
+
+    int index = __sync_fetch_and_add(&rt->numStarted, 1);
+    assert(index > 0 && index < rt->config.numWorkers);
+    srv_worker_loop(&rt->workers[index]);
+    return 0;
+}
+
+int
+srv_runtime_init(srv_runtime_t *rt, srv_common_t *srv, srv_runtime_config_t config)
+{
+    assert(rt && srv && srv->magic == SRV_MAGIC);
+    assert(config.handler);
+    int error;
+
+    if (_srvRuntime) {
+        ROS_ERROR("srv_runtime_init: only one server runtime is supported per process.");
+        return EINVALID;
+    }
+    if (config.numWorkers < 1 || config.numWorkers > SRV_RUNTIME_MAX_WORKERS) {
+        ROS_ERROR("srv_runtime_init: invalid number of workers %d.", config.numWorkers);
+        return EINVALIDPARAM;
+    }
+
+    memset(rt, 0, sizeof(srv_runtime_t));
+    rt->srv = srv;
+    rt->config = config;
+    rt->numStarted = 1;
+
+    /* Make the client table safe to share between workers. */
+    if (srv->config.maxClients > 0) {
+        error = client_table_enable_locking(&srv->clientTable);
+        if (error != ESUCCESS) {
+            ROS_ERROR("srv_runtime_init could not enable client table locking.");
+            return error;
+        }
+    }
+
+    /* Create the handler lock. */
+    error = ENOMEM;
+    if (config.serialise) {
+        rt->serialLock = sync_create_mutex();
+        if (!rt->serialLock) {
+            ROS_ERROR("srv_runtime_init could not create handler lock.");
+            goto exit1;
+        }
+    }
+
+    /* Set up the workers. Worker 0 is the main thread, which uses its default recieve slot. */
+    for (int i = 0; i < config.numWorkers; i++) {
+        struct srv_worker *w = &rt->workers[i];
+        w->magic = SRV_WORKER_MAGIC;
+        w->index = i;
+        w->runtime = rt;
+        if (i == 0) {
+            w->recvSlot = REFOS_THREAD_CAP_RECV;
+            continue;
+        }
+        w->recvSlot = csalloc();
+        w->stack = malloc(SRV_RUNTIME_WORKER_STACK_SIZE);
+        if (!w->recvSlot || !w->stack) {
+            ROS_ERROR("srv_runtime_init could not allocate worker %d.", i);
+            goto exit2;
+        }
+    }
+
+    rt->magic = SRV_RUNTIME_MAGIC;
+    _srvRuntime = rt;
+    return ESUCCESS;
+
+    /* Exit stack. */
+exit2:
+    srv_runtime_free_workers(rt);
+    if (rt->serialLock) {
+        sync_destroy_mutex(rt->serialLock);
+    }
+exit1:
+    memset(rt, 0, sizeof(srv_runtime_t));
+    return error;
+}
+
+void
+srv_runtime_run(srv_runtime_t *rt)
+{
+    assert(rt && rt->magic == SRV_RUNTIME_MAGIC);
+
+    for (int i = 1; i < rt->config.numWorkers; i++) {
+        struct srv_worker *w = &rt->workers[i];
+        int threadID = proc_clone(srv_worker_entry, w->stack + SRV_RUNTIME_WORKER_STACK_SIZE,
+                                  0, NULL);
+        if (threadID < 0) {
+            ROS_WARNING("srv_runtime_run could only start %d of %d workers.", i,
+                        rt->config.numWorkers);
+            break;
+        }
+    }
+
+    srv_worker_loop(&rt->workers[0]);
+}
+
+struct srv_worker *
+srv_worker_current(void)
+{
+    srv_runtime_t *rt = _srvRuntime;
+    if (!rt) {
+        return NULL;
+    }
+    rpc_thread_state_t *state = rpc_get_thread_state();
+    for (int i = 0; i < rt->config.numWorkers; i++) {
+        if (&rt->workers[i].rpcState == state) {
+            return &rt->workers[i];
+        }
+    }
+    return NULL;
+}
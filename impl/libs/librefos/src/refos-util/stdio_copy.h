@@ -14,6 +14,7 @@
 */
 
 #include <stdio.h>
+#include <stdbool.h>
 #include <stdlib.h>
 
 typedef size_t (*stdio_read_fn_t)(void *data, size_t count);
@@ -26,6 +27,10 @@ void refos_seL4_debug_override_stdout(void);
 
 void refos_setup_dataspace_stdio(char *dspacePath);
 
+void refos_setup_dataspace_stdio_lazy(char *dspacePath);
+
+bool refos_stdio_connected(void);
+
 int refos_async_getc(void);
 
 int refos_getc(void);
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _REFOS_IO_AIO_H_
+#define _REFOS_IO_AIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos/aio_ring.h>
+#include <refos-rpc/serv_client_helper.h>
+
+/*! @file
+    @brief RefOS IO asynchronous dataspace I/O.
+
+    Client side of the asynchronous I/O rings (see refos/aio_ring.h). Every open dataspace file
+    descriptor has its own server connection, so the ring is set up on that connection the first
+    time the file descriptor is used asynchronously (see filetable_aio_get()).
+
+    The ring data area is split into one fixed size buffer slot per ring entry. Submitting an
+    operation takes a slot; write data is copied into the slot when the operation is queued, and
+    read data is copied out of it when the completion is reaped. Operations are only handed to the
+    server by refosio_aio_kick() or refosio_aio_wait(), so a batch of operations may be queued and
+    handed over with a single notification.
+
+    The POSIX aio_*() and lio_listio() functions are implemented on top of this.
+*/
+
+#define REFOSIO_AIO_MAGIC 0x7A10F1D5
+#define REFOSIO_AIO_RING_ENTRIES 32
+#define REFOSIO_AIO_RING_SIZE 0x10000
+
+enum refosio_aio_slot_state {
+    REFOSIO_AIO_SLOT_FREE = 0,
+    REFOSIO_AIO_SLOT_QUEUED,
+    REFOSIO_AIO_SLOT_DONE
+};
+
+/*! @brief Asynchronous I/O operation slot. */
+typedef struct refosio_aio_slot {
+    int state; /*!< enum refosio_aio_slot_state. */
+    uint32_t opcode;
+    char *buf; /*!< Read destination. (No ownership) */
+    uint32_t len;
+    int32_t result;
+    void *cookie; /*!< Caller defined. (No ownership) */
+} refosio_aio_slot_t;
+
+/*! @brief Per file descriptor asynchronous I/O state. */
+typedef struct refosio_aio {
+    uint32_t magic;
+    serv_connection_t *connection; /*!< No ownership. */
+    int handle; /*!< Server binding handle of the file descriptor's dataspace. */
+    uint32_t slotSize;
+    int numQueued;
+    refosio_aio_slot_t slots[REFOSIO_AIO_RING_ENTRIES];
+} refosio_aio_t;
+
+/*! @brief Set up asynchronous I/O on a dataspace connection.
+    @param connection The dataspace server connection. (No ownership)
+    @param dspace The opened dataspace to bind to the ring. (No ownership)
+    @return The asynchronous I/O state if success, NULL otherwise. (Gives ownership, release with
+            refosio_aio_release())
+*/
+refosio_aio_t *refosio_aio_create(serv_connection_t *connection, seL4_CPtr dspace);
+
+/*! @brief Release asynchronous I/O state. Operations still queued are dropped.
+    @param a The state to release. (Takes ownership)
+*/
+void refosio_aio_release(refosio_aio_t *a);
+
+/*! @brief Queue an operation onto the submission ring, without handing it to the server.
+    @param a The asynchronous I/O state.
+    @param opcode REFOS_AIO_OP_READ, REFOS_AIO_OP_WRITE, REFOS_AIO_OP_LSEEK or REFOS_AIO_OP_NOP.
+    @param offset The dataspace offset, REFOS_AIO_OFFSET_CURRENT, or the lseek offset.
+    @param whence The lseek whence.
+    @param buf The read destination / write source. (No ownership, a read destination must stay
+               valid until the operation is reaped)
+    @param len The read / write length. Clipped to the slot size, as POSIX allows short transfers.
+    @param cookie Caller defined pointer, kept with the slot.
+    @return Non-negative slot number if success, negative refos_err_t otherwise. -ENOMEM if every
+            slot is taken.
+*/
+int refosio_aio_queue(refosio_aio_t *a, uint32_t opcode, int32_t offset, int whence, char *buf,
+                      uint32_t len, void *cookie);
+
+/*! @brief Hand every queued operation to the server, by signalling the ring doorbell. Does not
+           block.
+    @param a The asynchronous I/O state.
+*/
+void refosio_aio_kick(refosio_aio_t *a);
+
+/*! @brief Reap every posted completion, copying out read data into the read destinations.
+    @param a The asynchronous I/O state.
+    @return The number of completions reaped.
+*/
+int refosio_aio_reap(refosio_aio_t *a);
+
+/*! @brief Hand every queued operation to the server and wait for them all to complete.
+    @param a The asynchronous I/O state.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+refos_err_t refosio_aio_wait(refosio_aio_t *a);
+
+/*! @brief Find the slot of a queued or completed operation by its cookie.
+    @return The slot number if found, -1 otherwise.
+*/
+int refosio_aio_find(refosio_aio_t *a, void *cookie);
+
+/*! @brief Free a completed slot.
+    @param a The asynchronous I/O state.
+    @param slot The slot to free.
+*/
+void refosio_aio_free(refosio_aio_t *a, int slot);
+
+#endif /* _REFOS_IO_AIO_H_ */
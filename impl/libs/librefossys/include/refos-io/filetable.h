@@ -8,15 +8,18 @@
 #define _REFOS_IO_FILETABLE_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <refos/refos.h>
 #include <refos/error.h>
 #include <data_struct/coat.h>
+#include <data_struct/cslab.h>
 
 #define FD_TABLE_MAGIC 0xA6B1063F
 #define FD_TABLE_BASE 3 /* 0, 1 and 2 are stdin, stdout and stderr. */
 
 typedef struct fd_table_s {
     coat_t table; /* fd_table_entry_*_t, Inherited, must be first. */
+    cslab_t dspaceEntryCache; /* fd_table_entry_dataspace_t */
     uint32_t tableSize;
     uint32_t magic;
 } fd_table_t;
@@ -35,10 +38,70 @@ int filetable_read(fd_table_t *fdt, int fd, char *bufferDest, int bufferLen);
 
 int filetable_write(fd_table_t *fdt, int fd, char *bufferSrc, int bufferLen);
 
+struct refosio_stat_info;
+
+/*! @brief Get the size, type and modification time of an open file descriptor. The file type and
+           modification time are looked up once and then kept with the file descriptor; the size
+           is the file descriptor's own idea of the dataspace size.
+    @param fdt The file table.
+    @param fd The file descriptor.
+    @param info Output metadata. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+refos_err_t filetable_fstat(fd_table_t *fdt, int fd, struct refosio_stat_info *info);
+
+struct dirent;
+
+/*! @brief Read directory entries from a directory file descriptor, in the libc struct dirent
+           layout (as returned by the getdents64 system call).
+    @param fdt The file table.
+    @param fd The directory file descriptor, opened with O_DIRECTORY.
+    @param dirp Output buffer of directory entries. (No ownership)
+    @param count Size of the output buffer in bytes.
+    @return Number of bytes written to the buffer, 0 at the end of the directory, or negative
+            refos_err_t. -EINVALID if the file descriptor is not a directory, and -EINVALIDPARAM
+            if the buffer is too small for the next entry.
+*/
+int filetable_getdents(fd_table_t *fdt, int fd, struct dirent *dirp, int count);
+
+/*! @brief Unpack the whole packed directory dataspace records (struct refos_dirent) at the start
+           of a buffer into libc struct dirent records. Stops at a partial record, or at the first
+           record that does not fit in the output buffer.
+    @param src The packed records.
+    @param srcLen Number of bytes in src.
+    @param srcPos Directory dataspace offset of the start of src.
+    @param dirp Output buffer of directory entries. (No ownership)
+    @param count Size of the output buffer in bytes.
+    @param used Output number of bytes of src unpacked.
+    @param len Input and output number of bytes of dirp used.
+    @param full Output, set to true if a whole record did not fit in dirp.
+    @return ESUCCESS if success, or EINVALID if unpacking stopped at a record whose length is
+            shorter than its header or longer than the longest valid record.
+*/
+refos_err_t filetable_dirent_unpack(const char *src, int srcLen, uint32_t srcPos,
+                                    struct dirent *dirp, int count, int *used, int *len,
+                                    bool *full);
+
 seL4_CPtr filetable_dspace_get(fd_table_t *fdt, int fd);
 
+struct refosio_aio;
+
+/*! @brief Get the asynchronous I/O state of a dataspace file descriptor, setting up the
+           asynchronous I/O ring on the file descriptor's connection on first use.
+    @return The asynchronous I/O state if success, NULL otherwise. (No ownership)
+*/
+struct refosio_aio *filetable_aio_get(fd_table_t *fdt, int fd);
+
+struct sl_procinfo_s;
+
 void filetable_init_default(void);
 
+/*! @brief Take over the file server session handed over by the selfloader, if any. The next file
+           opened on that file server uses the session instead of connecting again.
+    @param procInfo The selfloader boot info struct. (No ownership)
+*/
+void filetable_init_handover(struct sl_procinfo_s *procInfo);
+
 void filetable_deinit_default(void);
 
 #endif /* _REFOS_IO_FILETABLE_H_ */
@@ -14,8 +14,11 @@
 #include "morecore.h"
 #include "mmap_segment.h"
 #include "filetable.h"
+#include "statcache.h"
 
+#include <refos/log_ring.h>
 #include <refos-util/walloc.h>
+#include <refos-util/init.h>
 #include <refos-rpc/serv_client.h>
 #include <refos-rpc/serv_client_helper.h>
 
@@ -37,13 +40,23 @@ typedef struct refos_io_internal_state {
     uintptr_t staticMoreCoreOverrideBase;
     uintptr_t staticMoreCoreOverrideTop;
 
-    /*! The STDIO dataspace, owned by Console server. */
+    /*! The STDIO dataspace, owned by Console server. If stdioPath is set, the session is
+        connected on first use, see refos_stdio_connected(). */
     serv_connection_t stdioSession;
     seL4_CPtr stdioDataspace;
+    char *stdioPath; /* No ownership. */
 
     /*! File descriptor table. */
     fd_table_t fdTable;
 
+    /*! Path metadata cache, and its server sessions. See refosio_stat(). */
+    refosio_stat_cache_t statCache;
+
+    /*! File server session handed over by the selfloader, until a file open on the server
+        mounted at fileservHandoverPrefix adopts it. See filetable_init_handover(). */
+    seL4_CPtr fileservHandover;
+    char fileservHandoverPrefix[SELFLOADER_PROCINFO_PREFIX_MAXLEN];
+
     /*! Dynamic morecore heap state. */
     bool dynamicHeap;
     struct sl_procinfo_s *procInfo;
@@ -52,8 +65,16 @@ typedef struct refos_io_internal_state {
     bool dynamicMMap;
     refos_io_mmap_segment_state_t mmapState;
 
-    /*! Timer state. */
+    /*! Timer state. If timerPath is set, the timer is opened on first use. */
     FILE * timerFD;
+    char *timerPath; /* No ownership. */
+
+    /*! Log server session and the log ring set on it. Logging goes to stdout while logRing.hdr
+        is NULL. See refos_setup_log(). */
+    serv_connection_t logSession;
+    data_mapping_t logRingBuffer;
+    refos_log_ring_t logRing;
+    seL4_CPtr logDoorbell;
 } refos_io_internal_state_t;
 
 extern refos_io_internal_state_t refosIOState;
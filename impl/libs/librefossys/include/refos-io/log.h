@@ -0,0 +1,86 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _REFOS_IO_LOG_H_
+#define _REFOS_IO_LOG_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos/log_ring.h>
+
+/*! @file
+    @brief RefOS IO logging through the log server.
+
+    Client side of the per-process log rings (see refos/log_ring.h). refos_initialise() connects to
+    the log server and registers the process's ring at startup, when the log server is configured.
+
+    The system servers started before the log server, or which the log server itself calls to
+    write out the log, do not connect to it; a synchronous call either way could then deadlock
+    the two. Instead the log server asks each of them for a ring with serv_get_log_ring(), which
+    they answer with refos_log_share_ring(), so calls only ever go from the log server to them.
+
+    From then on, logging a message only costs formatting it and copying it onto the ring; the log
+    server drains the rings in the background, and writes them out to the console or a log file.
+
+    The ROS_ERROR(), ROS_WARNING() and dprintf() debug macros go through the log ring when the
+    process has one. Plain printf() output is left alone, as it is the program's actual output.
+
+    When there is no log server, or the process could not register a ring with it, the functions
+    here report failure and the caller prints the message to stdout instead.
+*/
+
+/*! @brief Connect to the log server at the given path, and register a log ring with it. Does
+           nothing if the log server can not be reached, leaving logging through stdout.
+    @param logPath The namespace path of the log server.
+*/
+void refos_setup_log(char *logPath);
+
+/*! @brief Create a log ring for the log server, which asked for it with serv_get_log_ring(), and
+           start logging through it. Used by the servers which do not connect to the log server
+           themselves.
+    @param doorbell The log server's doorbell to ring when it is asleep. (Takes ownership)
+    @param ringDataspace Output ring dataspace to hand to the log server. (No ownership)
+    @param ringSize Output size of the ring dataspace.
+    @return ESUCCESS if success, EINVALID if this process already has a log ring, refos_err_t
+            otherwise.
+*/
+refos_err_t refos_log_share_ring(seL4_CPtr doorbell, seL4_CPtr *ringDataspace,
+                                 uint32_t *ringSize);
+
+/*! @brief Whether this process is logging through a log ring. */
+bool refos_log_connected(void);
+
+/*! @brief Log a message. Costs one copy of the message, and no IPC unless the log server is asleep.
+    @param level The enum refos_log_level severity of the message.
+    @param msg The message, without a trailing newline. (No ownership)
+    @param len The length of the message.
+    @return true if the message was handled by the log ring (logged, filtered out, or dropped on
+            a full ring and counted), false if the process has no log ring.
+*/
+bool refos_log_write(int level, const char *msg, size_t len);
+
+/*! @brief Format and log a message. The trailing newline, if any, is stripped.
+    @param level The enum refos_log_level severity of the message.
+    @param func The name of the calling function to prefix the message with, or NULL.
+    @param fmt The printf format string.
+    @return Same as refos_log_write().
+*/
+bool refos_log_printf(int level, const char *func, const char *fmt, ...)
+        __attribute__((format(printf, 3, 4)));
+
+/*! @brief va_list version of refos_log_printf(). */
+bool refos_log_vprintf(int level, const char *func, const char *fmt, va_list ap);
+
+/*! @brief Set the least severe level of message this process logs.
+    @param level The least severe enum refos_log_level to log.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+refos_err_t refos_log_set_level(int level);
+
+#endif /* _REFOS_IO_LOG_H_ */
@@ -15,8 +15,10 @@
 #include <refos/vmlayout.h>
 
 #define PROCESS_MMAP_LIMIT_SIZE_NPAGES (PROCESS_MMAP_LIMIT_SIZE / REFOS_PAGE_SIZE)
-#define PROCESS_MMAP_SEGMENT_SIZE_NPAGES (128UL)
-#define PROCESS_MMAP_SEGMENTS (PROCESS_MMAP_LIMIT_SIZE_NPAGES / PROCESS_MMAP_SEGMENT_SIZE_NPAGES)
+
+/* Maximum number of live anonymous mappings. Adjacent mmaps share a mapping, so this is far more
+   than the number of separate regions a process normally has. */
+#define PROCESS_MMAP_MAX_MAPPINGS 512
 
 /*! @file
     @brief MMap implementation for RefOS userland.
@@ -27,44 +29,69 @@
 
     RefOS userland dynamic MMap works as follows:
 
-              bitmap (1 bit per 4096 page) 
+              bitmap (1 bit per 4096 page)
                         ▼
-         1 0 0 1 0 1 1 0 1 ... 1 1 1 1 1 1 1 1 0 0 0 0 0 0 . . .
-         |_________________________________|_____________ . . .
-         ◀―――――――――――― segment ――――――――――――▶ 
-                (128 pages per segment)
-
-    Pages are tracked using a bitmap, and segments are allocated via a bitmap allocator. This forms
-    a crude 2 level page table. When a segment is allocated, all the page bits contained at flipped
-    to 1. When unmap occurs, all the page bits are flipped to zero, and any segments with their
-    entire contents unmapped would be deleted.
-
-    Note that we do not book-keep the dataspace and window caps here. We reply on the get functions
-    from process server to book keep them, to avoid the inefficient double book-keeping.
+         1 1 1 1 1 1 1 0 0 1 1 1 1 1 0 0 0 0 . . .
+         |_____________|   |_______|
+            mapping 0      mapping 1
+        (window + dspace) (window + dspace)
+
+    Pages are tracked using a bitmap, and allocated via a bitmap allocator, growing upwards from
+    PROCESS_MMAP_BOT. Each allocated page range is backed by a mapping; a memory window with its
+    own anonymous dataspace, sized exactly to the pages it covers and created with a single
+    proc_create_anon_mem_window() call. When a new page range starts exactly where an existing
+    mapping ends (the common case when a heap grows), that mapping's window is resized to cover it
+    instead, which grows its dataspace too.
+
+    Each mapping counts its live pages. When munmap releases the last live page of a mapping, the
+    window is deleted, releasing its dataspace along with it. Pages unmapped from a mapping which
+    still has other live pages stay backed until the whole mapping goes; if they are mmapped again
+    in the meantime they are simply reused.
 
     ref: http://gcc.gnu.org/onlinedocs/libstdc++/manual/bitmap_allocator.html
          http://en.wikipedia.org/wiki/Free_space_bitmap
 
 */
 
+/*! @brief An anonymous mmap mapping; a window and its dataspace covering a page range. */
+struct refos_io_mmap_mapping {
+    uint32_t startPage;  /*!< First page index, counting up from PROCESS_MMAP_BOT. */
+    uint32_t npages;     /*!< Size of the window in pages. */
+    uint32_t livePages;  /*!< Number of pages in the window currently allocated by mmap. */
+    seL4_CPtr window;    /*!< Has ownership. */
+};
+
 typedef struct refos_io_mmap_segment_state {
 
     /*! 524288 page bitmap. Not much memory, only 16384 bytes. */
     cbpool_t mmapRegionPageStatus;
 
-    /*! 4096 segment bitmap. Negligible memory, only 128 bytes. */
-    cbpool_t mmapRegionSegmentStatus;
+    /*! Live mappings, sorted by startPage. These can not be malloced, as malloc itself relies on
+        mmap for large allocations. */
+    struct refos_io_mmap_mapping mappings[PROCESS_MMAP_MAX_MAPPINGS];
+    int numMappings;
 
 } refos_io_mmap_segment_state_t;
 
+/*! @brief Initialise the mmap state.
+    @param s The mmap state to initialise. (No ownership)
+*/
 void refosio_mmap_init(refos_io_mmap_segment_state_t *s);
 
-int refosio_mmap_segment_fill(refos_io_mmap_segment_state_t *s, uint32_t vaddrOffsetPage);
-
-int refosio_mmap_segment_release(refos_io_mmap_segment_state_t *s, uint32_t vaddrOffsetPage);
-
+/*! @brief Allocate and map a range of anonymous memory pages.
+    @param s The mmap state. (No ownership)
+    @param npages The number of pages to map.
+    @param vaddrDest Output base address of the mapped pages. (No ownership)
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
 int refosio_mmap_anon(refos_io_mmap_segment_state_t *s, int npages, uint32_t *vaddrDest);
 
+/*! @brief Unmap a range of anonymous memory pages previously mapped by refosio_mmap_anon().
+    @param s The mmap state. (No ownership)
+    @param vaddr The base address of the pages to unmap.
+    @param npages The number of pages to unmap.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
 int refosio_munmap_anon(refos_io_mmap_segment_state_t *s, uint32_t vaddr, int npages);
 
-#endif /* _REFOS_IO_MMAP_SEGMENT_H_ */
\ No newline at end of file
+#endif /* _REFOS_IO_MMAP_SEGMENT_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef _REFOS_IO_STATCACHE_H_
+#define _REFOS_IO_STATCACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos-rpc/serv_client_helper.h>
+
+/*! @file
+    @brief Path metadata lookup with a name-keyed cache.
+
+    Looks up the size, type and modification time of a path with a single data_stat() call, over
+    a session to the path's server which is kept open for later lookups on the same server. Results
+    which the server marks as DATA_STAT_IMMUTABLE are cached by path, so that repeated stat() and
+    access() calls on them do not leave the process at all. The server decides what may be cached;
+    everything else is looked up again on every call.
+*/
+
+#define REFOSIO_STAT_CACHE_SIZE 64
+#define REFOSIO_STAT_CACHE_PATH_MAXLEN 96
+#define REFOSIO_STAT_MAX_SESSIONS 4
+
+/*! @brief Path metadata, as returned by data_stat(). */
+typedef struct refosio_stat_info {
+    uint32_t size;
+    uint32_t mode; /* As the st_mode member of struct stat. */
+    uint32_t mtime;
+} refosio_stat_info_t;
+
+typedef struct refosio_stat_cache_entry {
+    bool valid;
+    uint32_t hash;
+    uint32_t lastUse;
+    char path[REFOSIO_STAT_CACHE_PATH_MAXLEN];
+    refosio_stat_info_t info;
+} refosio_stat_cache_entry_t;
+
+typedef struct refosio_stat_cache {
+    refosio_stat_cache_entry_t entry[REFOSIO_STAT_CACHE_SIZE];
+    uint32_t useCounter;
+
+    /* Open sessions to servers, looked up by their mountpoint path prefix. */
+    bool sessionValid[REFOSIO_STAT_MAX_SESSIONS];
+    serv_connection_t session[REFOSIO_STAT_MAX_SESSIONS]; /* Has ownership. */
+    int nextSession;
+
+    /* Statistics. */
+    uint32_t hits;
+    uint32_t misses;
+} refosio_stat_cache_t;
+
+/*! @brief Look up the metadata of a path, from the cache if possible.
+    @param path The full namespace path to look up (eg. "fileserv/hello.txt").
+    @param info Output metadata of the path. (No ownership)
+    @return ESUCCESS if success, EFILENOTFOUND if there is no such file, ESERVERNOTFOUND if no
+            server serves the path, refos_err_t otherwise.
+*/
+refos_err_t refosio_stat(char *path, refosio_stat_info_t *info);
+
+#endif /* _REFOS_IO_STATCACHE_H_ */
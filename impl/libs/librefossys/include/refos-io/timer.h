@@ -9,4 +9,6 @@
 
 void refos_init_timer(char *dspacePath);
 
+void refos_init_timer_lazy(char *dspacePath);
+
 #endif /* _REFOS_IO_TIMER_H_ */
\ No newline at end of file
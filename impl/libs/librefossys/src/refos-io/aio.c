@@ -0,0 +1,194 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sel4/sel4.h>
+
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos-io/aio.h>
+#include <refos-rpc/data_client.h>
+#include <refos-rpc/serv_client_helper.h>
+#include <refos-util/dprintf.h>
+
+/*! @file
+    @brief RefOS IO asynchronous dataspace I/O. */
+
+refosio_aio_t *
+refosio_aio_create(serv_connection_t *connection, seL4_CPtr dspace)
+{
+    assert(connection && dspace);
+
+    refos_err_t error = serv_connect_aio(connection, REFOSIO_AIO_RING_ENTRIES,
+                                         REFOSIO_AIO_RING_SIZE);
+    if (error != ESUCCESS) {
+        return NULL;
+    }
+    int handle = data_aio_bind(connection->serverSession, dspace);
+    if (handle < 0) {
+        return NULL;
+    }
+
+    refosio_aio_t *a = malloc(sizeof(refosio_aio_t));
+    if (!a) {
+        printf("refosio_aio_create out of memory.\n");
+        return NULL;
+    }
+    memset(a, 0, sizeof(refosio_aio_t));
+    a->magic = REFOSIO_AIO_MAGIC;
+    a->connection = connection;
+    a->handle = handle;
+    a->slotSize = connection->aioRing.dataSize / REFOSIO_AIO_RING_ENTRIES;
+    assert(a->slotSize > 0);
+    return a;
+}
+
+void
+refosio_aio_release(refosio_aio_t *a)
+{
+    if (!a) {
+        return;
+    }
+    assert(a->magic == REFOSIO_AIO_MAGIC);
+    /* The binding and the ring go away with the dataspace and the connection. */
+    a->magic = 0;
+    free(a);
+}
+
+int
+refosio_aio_queue(refosio_aio_t *a, uint32_t opcode, int32_t offset, int whence, char *buf,
+                  uint32_t len, void *cookie)
+{
+    assert(a && a->magic == REFOSIO_AIO_MAGIC);
+    if ((opcode == REFOS_AIO_OP_READ || opcode == REFOS_AIO_OP_WRITE) && !buf && len) {
+        return -EINVALIDPARAM;
+    }
+
+    int slot = 0;
+    for (; slot < REFOSIO_AIO_RING_ENTRIES; slot++) {
+        if (a->slots[slot].state == REFOSIO_AIO_SLOT_FREE) {
+            break;
+        }
+    }
+    if (slot >= REFOSIO_AIO_RING_ENTRIES) {
+        return -ENOMEM;
+    }
+    if (len > a->slotSize) {
+        len = a->slotSize;
+    }
+
+    refos_aio_ring_t *r = &a->connection->aioRing;
+    char *slotBuf = r->data + slot * a->slotSize;
+    if (opcode == REFOS_AIO_OP_WRITE) {
+        memcpy(slotBuf, buf, len);
+    }
+
+    struct refos_aio_sqe sqe = {
+        .opcode = opcode,
+        .userData = slot,
+        .handle = a->handle,
+        .offset = offset,
+        .len = len,
+        .bufOffset = slot * a->slotSize,
+        .whence = whence
+    };
+    if (refos_aio_sq_push(r, &sqe) != 0) {
+        /* Can not happen, as there is a submission entry for every slot. */
+        assert(!"refosio_aio_queue submission ring overrun.");
+        return -EINVALID;
+    }
+
+    refosio_aio_slot_t *s = &a->slots[slot];
+    s->state = REFOSIO_AIO_SLOT_QUEUED;
+    s->opcode = opcode;
+    s->buf = buf;
+    s->len = len;
+    s->result = 0;
+    s->cookie = cookie;
+    a->numQueued++;
+    return slot;
+}
+
+void
+refosio_aio_kick(refosio_aio_t *a)
+{
+    assert(a && a->magic == REFOSIO_AIO_MAGIC);
+    if (refos_aio_sq_pending(&a->connection->aioRing) > 0) {
+        seL4_Signal(a->connection->aioDoorbell);
+    }
+}
+
+int
+refosio_aio_reap(refosio_aio_t *a)
+{
+    assert(a && a->magic == REFOSIO_AIO_MAGIC);
+    refos_aio_ring_t *r = &a->connection->aioRing;
+    struct refos_aio_cqe cqe;
+    int n = 0;
+
+    while (refos_aio_cq_pop(r, &cqe) == 0) {
+        if (cqe.userData >= REFOSIO_AIO_RING_ENTRIES ||
+                a->slots[cqe.userData].state != REFOSIO_AIO_SLOT_QUEUED) {
+            printf("refosio_aio_reap: unexpected completion %u.\n", cqe.userData);
+            continue;
+        }
+        refosio_aio_slot_t *s = &a->slots[cqe.userData];
+        if (s->opcode == REFOS_AIO_OP_READ && cqe.result > 0) {
+            uint32_t count = (uint32_t) cqe.result;
+            if (count > s->len) {
+                count = s->len;
+            }
+            memcpy(s->buf, r->data + cqe.userData * a->slotSize, count);
+        }
+        s->result = cqe.result;
+        s->state = REFOSIO_AIO_SLOT_DONE;
+        a->numQueued--;
+        n++;
+    }
+    return n;
+}
+
+refos_err_t
+refosio_aio_wait(refosio_aio_t *a)
+{
+    assert(a && a->magic == REFOSIO_AIO_MAGIC);
+    refosio_aio_reap(a);
+    while (a->numQueued > 0) {
+        int n = data_aio_enter(a->connection->serverSession);
+        if (n < 0) {
+            return -n;
+        }
+        if (refosio_aio_reap(a) == 0) {
+            /* The server made no progress. */
+            return EINVALID;
+        }
+    }
+    return ESUCCESS;
+}
+
+int
+refosio_aio_find(refosio_aio_t *a, void *cookie)
+{
+    assert(a && a->magic == REFOSIO_AIO_MAGIC);
+    for (int i = 0; i < REFOSIO_AIO_RING_ENTRIES; i++) {
+        if (a->slots[i].state != REFOSIO_AIO_SLOT_FREE && a->slots[i].cookie == cookie) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void
+refosio_aio_free(refosio_aio_t *a, int slot)
+{
+    assert(a && a->magic == REFOSIO_AIO_MAGIC);
+    assert(slot >= 0 && slot < REFOSIO_AIO_RING_ENTRIES);
+    assert(a->slots[slot].state == REFOSIO_AIO_SLOT_DONE);
+    memset(&a->slots[slot], 0, sizeof(refosio_aio_slot_t));
+}
@@ -9,14 +9,23 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include <sel4/sel4.h>
+#include <utils/arith.h>
 
 #include <refos/refos.h>
 #include <refos/error.h>
+#include <refos/dirent.h>
 #include <refos-io/filetable.h>
+#include <refos-io/statcache.h>
+#include <refos-io/aio.h>
 #include <refos-io/internal_state.h>
 #include <refos-rpc/serv_client.h>
 #include <refos-rpc/serv_client_helper.h>
+#include <refos-util/cspace.h>
 #include <refos-util/dprintf.h>
 
 #define FD_TABLE_DEFAULT_SIZE 1024
@@ -26,6 +35,29 @@
 #define FD_TABLE_ENTRY_DATASPACE_MAGIC 0x4E6CC517
 #define FD_TABLE_DATASPACE_IPC_MAXLEN 32
 
+/* Read cache of dataspace file descriptors whose contents never change. Sequential reads fill it
+   with a readahead window of page-sized blocks; other reads only fill the chunks they cover. It
+   is filled with data_read() calls of FD_TABLE_CACHE_IPC_MAXLEN bytes. data_read() replies with one
+   message register per byte, so along with the reply header words this has to stay well within
+   seL4_MsgMaxLength (120). */
+#define FD_TABLE_CACHE_BLOCK_SIZE REFOS_PAGE_SIZE
+#define FD_TABLE_CACHE_MAX_BLOCKS 8
+#define FD_TABLE_CACHE_IPC_MAXLEN 96
+
+/* Directory listings are read in FD_TABLE_CACHE_IPC_MAXLEN chunks too, into a buffer with room for
+   the longest record plus a chunk. */
+#define FD_TABLE_DIRENT_BUFFER_SIZE \
+        (REFOS_DIRENT_HEADER_SIZE + REFOS_DIRENT_NAME_MAX + FD_TABLE_CACHE_IPC_MAXLEN)
+
+typedef struct fd_table_cache_s {
+    char *data; /* Has ownership. NULL until the first read. */
+    uint32_t capacityBlocks;
+    int32_t start; /* Dataspace offset of the cached data. */
+    uint32_t len; /* Number of valid bytes cached. 0 if invalid. */
+    uint32_t windowBlocks; /* Number of blocks the next sequential fill reads ahead. */
+    int32_t nextPos; /* The position a sequential read would continue from. */
+} fd_table_cache_t;
+
 typedef struct fd_table_entry_dataspace_s {
     char type; /* FD_TABLE_ENTRY_TYPE. Inherited, must be first. */
     int magic;
@@ -35,13 +67,133 @@ typedef struct fd_table_entry_dataspace_s {
     seL4_CPtr dspace;
     int32_t dspacePos;
     uint32_t dspaceSize;
+    int dspaceMode; /* Access mode granted by the dataspace server. */
+
+    /* File type, permissions and modification time, looked up on the first fstat. The size is
+       dspaceSize, which is kept up to date as we write. */
+    bool statValid;
+    uint32_t statMode;
+    uint32_t statMtime;
+
+    refosio_aio_t *aio; /* Has ownership. NULL until first asynchronous use. */
+
+    bool cacheEnabled;
+    fd_table_cache_t cache;
 } fd_table_entry_dataspace_t;
 
+/* ----------------------------- Filetable read cache functions --------------------------------- */
+
+/*! @brief Drop the cached contents. The cache buffer is kept for refilling. */
+static inline void
+filetable_cache_invalidate(fd_table_cache_t *c)
+{
+    c->len = 0;
+}
+
+static void
+filetable_cache_release(fd_table_cache_t *c)
+{
+    if (c->data) {
+        free(c->data);
+    }
+    memset(c, 0, sizeof(fd_table_cache_t));
+}
+
+/*! @brief Fill the cache from the given position.
+
+    Reads which continue where the previous read left off are sequential. Each sequential fill
+    reads ahead a window of blocks, and doubles the window for the next one, up to
+    FD_TABLE_CACHE_MAX_BLOCKS. Any other read only fetches the chunks covering the bytes asked for,
+    as it is likely to be followed by a seek elsewhere, and starts the window back at one block.
+
+    @param e The dataspace file descriptor entry. (No ownership)
+    @param pos The dataspace position to fill from.
+    @param len The number of bytes being read.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+filetable_cache_fill(fd_table_entry_dataspace_t *e, int32_t pos, int len)
+{
+    fd_table_cache_t *c = &e->cache;
+    bool sequential = (pos == c->nextPos);
+    if (!sequential || !c->windowBlocks) {
+        c->windowBlocks = 1;
+    }
+    uint32_t nBlocks = c->windowBlocks;
+
+    /* Grow the cache buffer to fit the readahead window. */
+    if (nBlocks > c->capacityBlocks) {
+        char *data = realloc(c->data, nBlocks * FD_TABLE_CACHE_BLOCK_SIZE);
+        if (!data) {
+            return ENOMEM;
+        }
+        c->data = data;
+        c->capacityBlocks = nBlocks;
+    }
+
+    uint32_t size = nBlocks * FD_TABLE_CACHE_BLOCK_SIZE;
+    if (!sequential) {
+        uint32_t nChunks = (len + FD_TABLE_CACHE_IPC_MAXLEN - 1) / FD_TABLE_CACHE_IPC_MAXLEN;
+        size = MIN(nChunks * FD_TABLE_CACHE_IPC_MAXLEN, size);
+    }
+    size = MIN(size, e->dspaceSize - pos);
+    c->start = pos;
+    c->len = 0;
+    while (c->len < size) {
+        int nr = data_read(e->connection.serverSession, e->dspace, pos + c->len,
+                           c->data + c->len, MIN(size - c->len, FD_TABLE_CACHE_IPC_MAXLEN));
+        if (nr < 0) {
+            c->len = 0;
+            return -nr;
+        }
+        if (nr == 0) {
+            break;
+        }
+        c->len += nr;
+    }
+
+    if (sequential) {
+        c->windowBlocks = MIN(nBlocks * 2, FD_TABLE_CACHE_MAX_BLOCKS);
+    }
+    return ESUCCESS;
+}
+
+/*! @brief Read from the current position of a dataspace file descriptor through its cache.
+    @param e The dataspace file descriptor entry. (No ownership)
+    @param buffer The buffer to read into.
+    @param bufferLen The length of the buffer.
+    @return Number of bytes read if success, negative refos_err_t otherwise.
+*/
+static int
+filetable_cache_read(fd_table_entry_dataspace_t *e, char *buffer, int bufferLen)
+{
+    fd_table_cache_t *c = &e->cache;
+    int32_t pos = e->dspacePos;
+    if (pos >= e->dspaceSize) {
+        return 0;
+    }
+
+    if (!c->len || pos < c->start || pos >= c->start + c->len) {
+        int error = filetable_cache_fill(e, pos, bufferLen);
+        if (error != ESUCCESS) {
+            return -error;
+        }
+        if (pos >= c->start + c->len) {
+            return 0;
+        }
+    }
+
+    int n = MIN(bufferLen, c->start + c->len - pos);
+    memcpy(buffer, c->data + (pos - c->start), n);
+    return n;
+}
+
 /* ----------------------------- Filetable OAT functions ---------------------------------------- */
 
 static cvector_item_t
 filetable_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
 {
+    fd_table_t *fdt = (fd_table_t *) oat;
     char type = (char) arg[0];
     cvector_item_t item = NULL;
 
@@ -50,7 +202,7 @@ filetable_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
     switch (type) {
         case FD_TABLE_ENTRY_TYPE_DATASPACE:
             /* Allocate and set a new dataspace FD entry struct. */
-            e = (fd_table_entry_dataspace_t*) malloc(sizeof(fd_table_entry_dataspace_t));
+            e = (fd_table_entry_dataspace_t*) cslab_alloc(&fdt->dspaceEntryCache);
             if (e){
                 memset(e, 0, sizeof(fd_table_entry_dataspace_t));
                 e->type = type;
@@ -75,6 +227,7 @@ filetable_oat_create(coat_t *oat, int id, uint32_t arg[COAT_ARGS])
 static void
 filetable_oat_delete(coat_t *oat, cvector_item_t *obj)
 {
+    fd_table_t *fdt = (fd_table_t *) oat;
     char type = *((char*) obj);
     fd_table_entry_dataspace_t *e = NULL;
 
@@ -84,6 +237,11 @@ filetable_oat_delete(coat_t *oat, cvector_item_t *obj)
             assert(e->type == FD_TABLE_ENTRY_TYPE_DATASPACE);
             assert(e->magic == FD_TABLE_ENTRY_DATASPACE_MAGIC);
 
+            /* Release asynchronous I/O state. */
+            refosio_aio_release(e->aio);
+            e->aio = NULL;
+            filetable_cache_release(&e->cache);
+
             /* Delete dataspace. */
             if (e->connection.serverSession && e->dspace) {
                 refos_err_t error = data_close(e->connection.serverSession, e->dspace);
@@ -102,7 +260,7 @@ filetable_oat_delete(coat_t *oat, cvector_item_t *obj)
             }
 
             e->magic = 0x0;
-            free(e);
+            cslab_free(&fdt->dspaceEntryCache, e);
             break;
         default:
             printf("filetable_oat_delete error: Unknown type.\n");
@@ -125,6 +283,7 @@ filetable_init(fd_table_t *fdt, uint32_t tableSize)
     memset(&fdt->table, 0, sizeof(coat_t));
     fdt->table.oat_create = filetable_oat_create;
     fdt->table.oat_delete = filetable_oat_delete;
+    cslab_init(&fdt->dspaceEntryCache, sizeof(fd_table_entry_dataspace_t), 0, NULL, NULL);
     coat_init(&fdt->table, FD_TABLE_BASE, tableSize);
 }
 
@@ -133,9 +292,47 @@ filetable_release(fd_table_t *fdt)
 {
     assert(fdt && fdt->magic == FD_TABLE_MAGIC);
     coat_release(&fdt->table);
+    cslab_release(&fdt->dspaceEntryCache);
     fdt->magic = 0x0;
 }
 
+/*! @brief Use the file server session handed over by the selfloader for a new connection, if it
+           is to the server that the given path is on. The handed over session is used at most
+           once, after which it belongs to the connection.
+    @param filePath The path of the file being opened.
+    @param sc Output connection. (No ownership)
+    @return true if the handed over session was used, false otherwise.
+*/
+static bool
+filetable_adopt_handover(char *filePath, serv_connection_t *sc)
+{
+    char *prefix = refosIOState.fileservHandoverPrefix;
+    size_t prefixLen = strlen(prefix);
+    if (!refosIOState.fileservHandover || prefixLen == 0 ||
+            strncmp(filePath, prefix, prefixLen) != 0) {
+        return false;
+    }
+    if (strchr(filePath + prefixLen, '/') != NULL ||
+            strlen(filePath + prefixLen) >= NAMESERV_PATH_MAXLEN) {
+        /* May be on a server mounted further down; leave that to the name server. */
+        return false;
+    }
+
+    /* Fill in the connection as if serv_connect_fast() had resolved the path. The mountpoint has no
+       anon cap, which serv_disconnect() copes with. */
+    memset(sc, 0, sizeof(serv_connection_t));
+    sc->serverMountPoint.success = true;
+    sc->serverMountPoint.nameservRoot = REFOS_NAMESERV_EP;
+    strcpy(sc->serverMountPoint.dspaceName, filePath + prefixLen);
+    strcpy(sc->serverMountPoint.nameservPathPrefix, prefix);
+    sc->serverSession = refosIOState.fileservHandover;
+    sc->paramBuffer.err = -1;
+    sc->error = ESUCCESS;
+
+    refosIOState.fileservHandover = 0;
+    return true;
+}
+
 int
 filetable_dspace_open(fd_table_t *fdt, char* filePath, int flags, int mode, int size)
 {
@@ -156,24 +353,36 @@ filetable_dspace_open(fd_table_t *fdt, char* filePath, int flags, int mode, int
         return -ENOMEM;
     }
 
-    /* Connect to the dataspace server. */
+    /* Connect to the dataspace server. The server is not pinged; the open call below tells us
+       whether it is alive. */
     assert(e->magic == FD_TABLE_ENTRY_DATASPACE_MAGIC);
-    e->connection = serv_connect_no_pbuffer(filePath);
+    if (!filetable_adopt_handover(filePath, &e->connection)) {
+        e->connection = serv_connect_fast(filePath);
+    }
     if (e->connection.error != ESUCCESS || !e->connection.serverSession) {
         error = -ESERVERNOTFOUND;
         goto exit1;
     }
 
-    /* Open the dataspace on the server. */
-    e->dspace = data_open(e->connection.serverSession,
-            e->connection.serverMountPoint.dspaceName, flags, mode, size, &error);
+    /* Open the dataspace on the server, getting its size, access mode and flags in the same
+       call. */
+    e->dspaceSize = 0;
+    e->dspaceMode = flags & O_ACCMODE;
+    uint32_t dspaceFlags = 0;
+    e->dspace = data_open_stat(e->connection.serverSession,
+            e->connection.serverMountPoint.dspaceName, flags, mode, size, &e->dspaceSize,
+            &e->dspaceMode, &dspaceFlags, &error);
     if (error || !e->dspace) {
         error = -EFILENOTFOUND;
         goto exit2;
     }
-
-    e->dspaceSize = data_get_size(e->connection.serverSession, e->dspace);
     e->dspacePos = 0;
+    e->statValid = false;
+
+    /* Only cache reads of dataspaces whose contents never change. Anything else, such as a RAMFS
+       or disk file, or a device dataspace, may be changed underneath us by someone else. */
+    e->cacheEnabled = (dspaceFlags & DATA_STAT_IMMUTABLE) && e->dspaceMode == O_RDONLY &&
+                      e->dspaceSize > 0;
     return e->fd;
 
     /* Exit stack. */
@@ -248,6 +457,12 @@ filetable_lseek(fd_table_t *fdt, int fd, int *offset, int whence)
         fdEntry->dspacePos = fdEntry->dspaceSize;
     }
 
+    /* Seeking outside of the cached blocks drops the cache. */
+    fd_table_cache_t *c = &fdEntry->cache;
+    if (c->len && (fdEntry->dspacePos < c->start || fdEntry->dspacePos > c->start + c->len)) {
+        filetable_cache_invalidate(c);
+    }
+
     (*offset) = fdEntry->dspacePos;
     return ESUCCESS;
 }
@@ -287,17 +502,20 @@ filetable_internal_read_write(fd_table_t *fdt, int fd, char *buffer, int bufferL
        Currently read / write is implemented over IPC, and this is inefficient and somewhat hacky.
        In the future, file read / write using mapped shared memory should be implemented.
     */
-    if (bufferLen > FD_TABLE_DATASPACE_IPC_MAXLEN) {
+    if (bufferLen > FD_TABLE_DATASPACE_IPC_MAXLEN && !(read && fdEntry->cacheEnabled)) {
         bufferLen = FD_TABLE_DATASPACE_IPC_MAXLEN;
     }
 
     /* Perform the actual dataspace read / write operation. */
     assert(fdEntry->dspace);
     int nr = -EINVALID;
-    if (read) {
+    if (read && fdEntry->cacheEnabled) {
+        nr = filetable_cache_read(fdEntry, buffer, bufferLen);
+    } else if (read) {
         nr = data_read(fdEntry->connection.serverSession, fdEntry->dspace, fdEntry->dspacePos,
                        buffer, bufferLen);
     } else {
+        filetable_cache_invalidate(&fdEntry->cache);
         nr = data_write(fdEntry->connection.serverSession, fdEntry->dspace, fdEntry->dspacePos,
                        buffer, bufferLen);
     }
@@ -315,6 +533,7 @@ filetable_internal_read_write(fd_table_t *fdt, int fd, char *buffer, int bufferL
         if (fdEntry->dspacePos > fdEntry->dspaceSize) {
             fdEntry->dspacePos = fdEntry->dspaceSize;
         }
+        fdEntry->cache.nextPos = fdEntry->dspacePos;
     } else {
         fdEntry->dspaceSize = data_get_size(fdEntry->connection.serverSession, fdEntry->dspace);
     }
@@ -335,6 +554,168 @@ filetable_write(fd_table_t *fdt, int fd, char *bufferSrc, int bufferLen)
     return filetable_internal_read_write(fdt, fd, bufferSrc, bufferLen, false);
 }
 
+refos_err_t
+filetable_dirent_unpack(const char *src, int srcLen, uint32_t srcPos, struct dirent *dirp,
+                        int count, int *used, int *len, bool *full)
+{
+    assert(src && dirp && used && len && full);
+    int off = 0;
+    *used = 0;
+    while (off + REFOS_DIRENT_HEADER_SIZE <= srcLen) {
+        const struct refos_dirent *d = (const struct refos_dirent *) (src + off);
+        if (d->reclen < REFOS_DIRENT_HEADER_SIZE ||
+                d->reclen > REFOS_DIRENT_HEADER_SIZE + REFOS_DIRENT_NAME_MAX) {
+            /* Corrupt listing. Callers size their buffers for the longest valid record, so this
+               must be caught before waiting on the rest of the record. */
+            return EINVALID;
+        }
+        if (off + d->reclen > srcLen) {
+            break;
+        }
+        int nameLen = REFOS_DIRENT_NAMELEN(d);
+        int reclen = (offsetof(struct dirent, d_name) + nameLen + 1 + 7) & ~7;
+        if (*len + reclen > count) {
+            *full = true;
+            break;
+        }
+
+        struct dirent *out = (struct dirent *) ((char*) dirp + *len);
+        out->d_ino = srcPos + off + 1;
+        out->d_off = srcPos + off + d->reclen;
+        out->d_reclen = reclen;
+        out->d_type = d->type;
+        memcpy(out->d_name, d->name, nameLen);
+        out->d_name[nameLen] = '\0';
+
+        *len += reclen;
+        off += d->reclen;
+        *used = off;
+    }
+    return ESUCCESS;
+}
+
+int
+filetable_getdents(fd_table_t *fdt, int fd, struct dirent *dirp, int count)
+{
+    assert(fdt && fdt->magic == FD_TABLE_MAGIC);
+    if (!dirp) {
+        return -EINVALIDPARAM;
+    }
+    if (fd < FD_TABLE_BASE || fd >= fdt->tableSize) {
+        return -EFILENOTFOUND;
+    }
+
+    /* Retrieve the file descr entry. */
+    cvector_item_t entry = coat_get(&fdt->table, fd);
+    if (!entry) {
+        return -EFILENOTFOUND;
+    }
+    char type = *((char*) entry);
+    if (type != FD_TABLE_ENTRY_TYPE_DATASPACE) {
+        return -EUNIMPLEMENTED;
+    }
+
+    fd_table_entry_dataspace_t *fdEntry = (fd_table_entry_dataspace_t*) entry;
+    assert(fdEntry->magic == FD_TABLE_ENTRY_DATASPACE_MAGIC);
+    if (!(fdEntry->dspaceMode & O_DIRECTORY)) {
+        return -EINVALID;
+    }
+
+    /* Read packed records from the directory dataspace in message register sized chunks, and
+       unpack them into the caller's buffer until it is full or the listing ends. A record may be
+       longer than a chunk, so partial records are kept at the front of buf and completed by the
+       next read. filetable_dirent_unpack() rejects records longer than the longest valid one, so
+       what is kept is always less than a record, and the next chunk fits. The position only moves
+       past whole records that were handed out. */
+    char buf[FD_TABLE_DIRENT_BUFFER_SIZE];
+    int have = 0;
+    int len = 0;
+    bool full = false;
+    while (!full) {
+        assert(have + FD_TABLE_CACHE_IPC_MAXLEN <= FD_TABLE_DIRENT_BUFFER_SIZE);
+        int nr = data_read(fdEntry->connection.serverSession, fdEntry->dspace,
+                           fdEntry->dspacePos + have, buf + have, FD_TABLE_CACHE_IPC_MAXLEN);
+        if (nr < 0) {
+            return len ? len : nr;
+        }
+        have += nr;
+
+        int used = 0;
+        refos_err_t error = filetable_dirent_unpack(buf, have, fdEntry->dspacePos, dirp, count,
+                                                    &used, &len, &full);
+        fdEntry->dspacePos += used;
+        have -= used;
+        memmove(buf, buf + used, have);
+        if (error != ESUCCESS) {
+            /* Corrupt listing. Hand out what we have so far; the next call starts at the corrupt
+               record and fails. */
+            return len ? len : -error;
+        }
+
+        if (nr < FD_TABLE_CACHE_IPC_MAXLEN) {
+            /* Short read; end of the listing. */
+            break;
+        }
+    }
+
+    if (len == 0 && full) {
+        /* Buffer too small for the next entry. */
+        return -EINVALIDPARAM;
+    }
+    return len;
+}
+
+refos_err_t
+filetable_fstat(fd_table_t *fdt, int fd, refosio_stat_info_t *info)
+{
+    assert(fdt && fdt->magic == FD_TABLE_MAGIC);
+    if (!info) {
+        return EINVALIDPARAM;
+    }
+    if (fd < FD_TABLE_BASE || fd >= fdt->tableSize) {
+        return EFILENOTFOUND;
+    }
+
+    /* Retrieve the file descr entry. */
+    cvector_item_t entry = coat_get(&fdt->table, fd);
+    if (!entry) {
+        return EFILENOTFOUND;
+    }
+    char type = *((char*) entry);
+    if (type != FD_TABLE_ENTRY_TYPE_DATASPACE) {
+        return EUNIMPLEMENTED;
+    }
+
+    fd_table_entry_dataspace_t *fdEntry = (fd_table_entry_dataspace_t*) entry;
+    assert(fdEntry->magic == FD_TABLE_ENTRY_DATASPACE_MAGIC);
+
+    if (!fdEntry->statValid) {
+        uint32_t size, flags;
+        int error = data_stat(fdEntry->connection.serverSession,
+                              fdEntry->connection.serverMountPoint.dspaceName, &size,
+                              &fdEntry->statMode, &fdEntry->statMtime, &flags);
+        if (error != ESUCCESS) {
+            /* The server can't stat this dataspace by name; go by what the open told us. */
+            fdEntry->statMtime = 0;
+            if (fdEntry->dspaceMode & O_DIRECTORY) {
+                fdEntry->statMode = S_IFDIR | S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH |
+                                    S_IXOTH;
+            } else {
+                fdEntry->statMode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+                if ((fdEntry->dspaceMode & O_ACCMODE) != O_RDONLY) {
+                    fdEntry->statMode |= S_IWUSR | S_IWGRP | S_IWOTH;
+                }
+            }
+        }
+        fdEntry->statValid = true;
+    }
+
+    info->size = fdEntry->dspaceSize;
+    info->mode = fdEntry->statMode;
+    info->mtime = fdEntry->statMtime;
+    return ESUCCESS;
+}
+
 seL4_CPtr
 filetable_dspace_get(fd_table_t *fdt, int fd)
 {
@@ -364,6 +745,42 @@ filetable_dspace_get(fd_table_t *fdt, int fd)
     return fdEntry->dspace;
 }
 
+refosio_aio_t *
+filetable_aio_get(fd_table_t *fdt, int fd)
+{
+    assert(fdt && fdt->magic == FD_TABLE_MAGIC);
+    if (fd < FD_TABLE_BASE || fd >= fdt->tableSize) {
+        ROS_SET_ERRNO(EFILENOTFOUND);
+        return NULL;
+    }
+
+    /* Retrieve the file descr entry. */
+    cvector_item_t entry = coat_get(&fdt->table, fd);
+    if (!entry) {
+        ROS_SET_ERRNO(EFILENOTFOUND);
+        return NULL;
+    }
+    char type = *((char*) entry);
+
+    /* Asynchronous I/O only supported for dataspace entries. */
+    if (type != FD_TABLE_ENTRY_TYPE_DATASPACE) {
+        ROS_SET_ERRNO(EUNIMPLEMENTED);
+        return NULL;
+    }
+
+    fd_table_entry_dataspace_t *fdEntry = (fd_table_entry_dataspace_t*) entry;
+    assert(fdEntry->magic == FD_TABLE_ENTRY_DATASPACE_MAGIC);
+    if (!fdEntry->aio) {
+        fdEntry->aio = refosio_aio_create(&fdEntry->connection, fdEntry->dspace);
+        if (!fdEntry->aio) {
+            ROS_SET_ERRNO(EUNIMPLEMENTED);
+            return NULL;
+        }
+    }
+    ROS_SET_ERRNO(ESUCCESS);
+    return fdEntry->aio;
+}
+
 /* ----------------------- Refos IO default filetable functions --------------------------------- */
 
 void
@@ -372,6 +789,34 @@ filetable_init_default(void)
     filetable_init(&refosIOState.fdTable, FD_TABLE_DEFAULT_SIZE);
 }
 
+void
+filetable_init_handover(struct sl_procinfo_s *procInfo)
+{
+    assert(procInfo);
+    refosIOState.fileservHandover = 0;
+    if (procInfo->magic != SELFLOADER_PROCINFO_MAGIC || !procInfo->fileservSession) {
+        return;
+    }
+
+    /* The session cap lives in the selfloader's part of the cspace; move it into ours. */
+    seL4_CPtr session = csalloc();
+    if (!session) {
+        return;
+    }
+    int error = seL4_CNode_Move(REFOS_CSPACE, session, REFOS_CDEPTH,
+                                REFOS_CSPACE, procInfo->fileservSession, REFOS_CDEPTH);
+    procInfo->fileservSession = 0;
+    if (error != seL4_NoError) {
+        csfree(session);
+        return;
+    }
+
+    strncpy(refosIOState.fileservHandoverPrefix, procInfo->fileservPrefix,
+            SELFLOADER_PROCINFO_PREFIX_MAXLEN - 1);
+    refosIOState.fileservHandoverPrefix[SELFLOADER_PROCINFO_PREFIX_MAXLEN - 1] = '\0';
+    refosIOState.fileservHandover = session;
+}
+
 void
 filetable_deinit_default(void)
 {
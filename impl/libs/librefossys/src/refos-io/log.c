@@ -0,0 +1,210 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sel4/sel4.h>
+
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos-io/log.h>
+#include <refos-io/internal_state.h>
+#include <refos-rpc/log_client.h>
+#include <refos-rpc/data_client_helper.h>
+#include <refos-util/cspace.h>
+
+/*! @file
+    @brief RefOS IO logging through the log server.
+
+    Nothing in here may use dprintf() or ROS_ERROR(), as those log through this file. */
+
+/* Provided by the process, for tagging its log records. See refos-util/dprintf.h. */
+extern const char* dprintfServerName;
+
+/*! @brief Create, map and format a new log ring of the default size in logRingBuffer.
+    @param ring Output local view of the ring.
+    @param size Output size of the ring dataspace.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+refos_log_ring_new(refos_log_ring_t *ring, uint32_t *size)
+{
+    assert(ring && size);
+    *size = refos_log_ring_size(REFOS_LOG_RING_DEFAULT_ENTRIES);
+    assert(*size);
+
+    refosIOState.logRingBuffer = data_open_map(REFOS_PROCSERV_EP, "anon", 0, 0, *size, -1);
+    int error = refosIOState.logRingBuffer.err;
+    if (error == ESUCCESS) {
+        error = refos_log_ring_init(ring, refosIOState.logRingBuffer.vaddr, *size,
+                                    REFOS_LOG_RING_DEFAULT_ENTRIES);
+        if (error != ESUCCESS) {
+            data_mapping_release(refosIOState.logRingBuffer);
+        }
+    }
+    if (error != ESUCCESS) {
+        memset(&refosIOState.logRingBuffer, 0, sizeof(data_mapping_t));
+    }
+    return error;
+}
+
+/*! @brief Start logging through a ring the log server now has. The debug macros log as soon as
+           logRing.hdr is set, possibly from other threads, so it is stored last. */
+static void
+refos_log_ring_publish(refos_log_ring_t *ring, seL4_CPtr doorbell)
+{
+    assert(ring && ring->hdr && doorbell);
+    refosIOState.logDoorbell = doorbell;
+    refosIOState.logRing.queue = ring->queue;
+    refosIOState.logRing.head = ring->head;
+    refosIOState.logRing.corrupt = ring->corrupt;
+    __atomic_store_n(&refosIOState.logRing.hdr, ring->hdr, __ATOMIC_RELEASE);
+}
+
+void
+refos_setup_log(char *logPath)
+{
+    assert(logPath);
+    if (refosIOState.logRing.hdr) {
+        return;
+    }
+
+    /* Connect to the log server. Not having one is fine; logging then goes to stdout. */
+    refosIOState.logSession = serv_connect_no_pbuffer(logPath);
+    if (refosIOState.logSession.error != ESUCCESS || !refosIOState.logSession.serverSession) {
+        memset(&refosIOState.logSession, 0, sizeof(serv_connection_t));
+        return;
+    }
+
+    /* Create the ring, then hand it to the log server. */
+    refos_log_ring_t ring;
+    uint32_t size;
+    int error = refos_log_ring_new(&ring, &size);
+    if (error != ESUCCESS) {
+        goto exit1;
+    }
+    seL4_CPtr doorbell = log_set_ring(refosIOState.logSession.serverSession,
+            refosIOState.logRingBuffer.dataspace, size, (char*) dprintfServerName, &error);
+    if (error != ESUCCESS || !doorbell) {
+        seL4_DebugPrintf("Failed to set log ring on [%s]. Error: %d.\n", logPath, error);
+        goto exit2;
+    }
+
+    /* Only publish the ring once the server has it. */
+    refos_log_ring_publish(&ring, doorbell);
+    return;
+
+    /* Exit stack. */
+exit2:
+    data_mapping_release(refosIOState.logRingBuffer);
+    memset(&refosIOState.logRingBuffer, 0, sizeof(data_mapping_t));
+exit1:
+    serv_disconnect(&refosIOState.logSession);
+}
+
+refos_err_t
+refos_log_share_ring(seL4_CPtr doorbell, seL4_CPtr *ringDataspace, uint32_t *ringSize)
+{
+    assert(doorbell && ringDataspace && ringSize);
+    if (refosIOState.logRing.hdr) {
+        csfree_delete(doorbell);
+        return EINVALID;
+    }
+
+    refos_log_ring_t ring;
+    int error = refos_log_ring_new(&ring, ringSize);
+    if (error != ESUCCESS) {
+        csfree_delete(doorbell);
+        return error;
+    }
+
+    /* The log server maps the ring while handling our reply, and anything logged before then
+       just waits on the ring. */
+    *ringDataspace = refosIOState.logRingBuffer.dataspace;
+    refos_log_ring_publish(&ring, doorbell);
+    return ESUCCESS;
+}
+
+bool
+refos_log_connected(void)
+{
+    return refosIOState.logRing.hdr != NULL;
+}
+
+bool
+refos_log_write(int level, const char *msg, size_t len)
+{
+    if (!refosIOState.logRing.hdr) {
+        return false;
+    }
+    bool wake;
+    refos_log_ring_append(&refosIOState.logRing, level, msg, len, &wake);
+    if (wake) {
+        seL4_Signal(refosIOState.logDoorbell);
+    }
+    return true;
+}
+
+bool
+refos_log_vprintf(int level, const char *func, const char *fmt, va_list ap)
+{
+    refos_log_ring_t *r = &refosIOState.logRing;
+    if (!r->hdr) {
+        return false;
+    }
+    if (!refos_log_ring_enabled(r, level)) {
+        /* Filtered out; don't bother formatting it. */
+        return true;
+    }
+
+    /* One byte over the record size, so that vsnprintf() tells us when the message was cut. */
+    char msg[REFOS_LOG_MSG_MAXLEN + 1];
+    int n = 0;
+    if (func) {
+        n = snprintf(msg, sizeof(msg), "%s(): ", func);
+        if (n < 0) {
+            n = 0;
+        } else if (n >= sizeof(msg)) {
+            n = sizeof(msg) - 1;
+        }
+    }
+    int m = vsnprintf(msg + n, sizeof(msg) - n, fmt, ap);
+    if (m < 0) {
+        m = 0;
+    }
+    size_t len = n + m;
+    if (len >= sizeof(msg)) {
+        /* Longer than the record; let refos_log_ring_append() mark it truncated. */
+        len = sizeof(msg) - 1;
+    } else if (len > 0 && msg[len - 1] == '\n') {
+        len--;
+    }
+    return refos_log_write(level, msg, len);
+}
+
+bool
+refos_log_printf(int level, const char *func, const char *fmt, ...)
+{
+    if (!refosIOState.logRing.hdr) {
+        return false;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    bool logged = refos_log_vprintf(level, func, fmt, ap);
+    va_end(ap);
+    return logged;
+}
+
+refos_err_t
+refos_log_set_level(int level)
+{
+    if (!refosIOState.logRing.hdr || !refosIOState.logSession.serverSession) {
+        /* No ring, or the log server asked us for it and we have no session to it. */
+        return ESERVERNOTFOUND;
+    }
+    return log_set_level(refosIOState.logSession.serverSession, level);
+}
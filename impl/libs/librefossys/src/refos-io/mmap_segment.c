@@ -5,6 +5,8 @@
  */
 
 #include <assert.h>
+#include <string.h>
+#include <utils/arith.h>
 #include <refos/vmlayout.h>
 #include <refos/error.h>
 #include <refos-io/mmap_segment.h>
@@ -17,132 +19,115 @@
 #define REFOS_IO_INTERNAL_MMAP_PAGE_STATUS_BUFFER_SIZE 0x11000
 static char _refosioMMapPageStatusBuffer[REFOS_IO_INTERNAL_MMAP_PAGE_STATUS_BUFFER_SIZE];
 
-#define REFOS_IO_INTERNAL_MMAP_SEGMENT_BUFFER_SIZE 0x1000
-static char _refosioMMapSegmentStatusBuffer[REFOS_IO_INTERNAL_MMAP_SEGMENT_BUFFER_SIZE];
-
-void
-refosio_mmap_init(refos_io_mmap_segment_state_t *s)
+/*! @brief Get the virtual address of an mmap page index. */
+static inline uint32_t
+refosio_mmap_page_vaddr(uint32_t page)
 {
-    cbpool_init_static(&s->mmapRegionPageStatus, PROCESS_MMAP_LIMIT_SIZE_NPAGES,
-            _refosioMMapPageStatusBuffer, REFOS_IO_INTERNAL_MMAP_PAGE_STATUS_BUFFER_SIZE);
-    cbpool_init_static(&s->mmapRegionSegmentStatus, PROCESS_MMAP_SEGMENTS,
-            _refosioMMapSegmentStatusBuffer, REFOS_IO_INTERNAL_MMAP_SEGMENT_BUFFER_SIZE);
+    return PROCESS_MMAP_BOT + page * REFOS_PAGE_SIZE;
 }
 
-int
-refosio_mmap_segment_fill(refos_io_mmap_segment_state_t *s, uint32_t vaddrOffsetPage)
+/*! @brief Find the first mapping which ends after the given page.
+    @param s The mmap state.
+    @param page The page index.
+    @return Index of the mapping containing the page, or of the first mapping after it if no mapping
+            contains it (which may be numMappings).
+*/
+static int
+refosio_mmap_find(refos_io_mmap_segment_state_t *s, uint32_t page)
 {
-    int error = EINVALID;
-    assert(vaddrOffsetPage >= PROCESS_MMAP_BOT && vaddrOffsetPage < PROCESS_MMAP_TOP);
-    uint32_t segmentID = (PROCESS_MMAP_TOP - vaddrOffsetPage) /
-        (PROCESS_MMAP_SEGMENT_SIZE_NPAGES * REFOS_PAGE_SIZE);
-    assert(segmentID < PROCESS_MMAP_SEGMENTS);
-
-    if (cbpool_check_single(&s->mmapRegionSegmentStatus, segmentID)) {
-        /* This segment is already filled. Nothing to do here. */
-        return ESUCCESS;
-    }
-
-    /* Create the window. */
-    uint32_t vaddr = PROCESS_MMAP_TOP -
-            ((segmentID + 1) * (PROCESS_MMAP_SEGMENT_SIZE_NPAGES * REFOS_PAGE_SIZE));
-    assert(vaddr >= PROCESS_MMAP_BOT && vaddr < PROCESS_MMAP_TOP);
-
-    seL4_CPtr window = proc_create_mem_window(vaddr,
-            PROCESS_MMAP_SEGMENT_SIZE_NPAGES * REFOS_PAGE_SIZE);
-    if (!window || REFOS_GET_ERRNO() != ESUCCESS) {
-        seL4_DebugPrintf("mmap_segment_fill: Could not create window.\n");
-        return EINVALIDWINDOW;
+    int lo = 0, hi = s->numMappings;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        struct refos_io_mmap_mapping *m = &s->mappings[mid];
+        if (m->startPage + m->npages <= page) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
+    return lo;
+}
 
-    /* Create the dataspace. */
-    seL4_CPtr dataspace = data_open(REFOS_PROCSERV_EP, "anon", 0, 0,
-            PROCESS_MMAP_SEGMENT_SIZE_NPAGES * REFOS_PAGE_SIZE, &error);
-    if (error) {
-        seL4_DebugPrintf("mmap_segment_fill: Could not create anon dspace.\n");
-        error = ENOMEM;
-        goto exit1;
+/*! @brief Back a range of newly allocated pages not covered by any mapping, by growing the mapping
+           just before them if it ends right where they start, or else by creating a new mapping.
+    @param s The mmap state.
+    @param idx The index the new mapping would be inserted at; ie. refosio_mmap_find(s, page).
+    @param page The first page index of the range.
+    @param npages The number of pages in the range.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+refosio_mmap_back(refos_io_mmap_segment_state_t *s, int idx, uint32_t page, uint32_t npages)
+{
+    assert(idx >= 0 && idx <= s->numMappings);
+
+    if (idx > 0) {
+        struct refos_io_mmap_mapping *prev = &s->mappings[idx - 1];
+        if (prev->startPage + prev->npages == page) {
+            int error = proc_resize_mem_window(prev->window,
+                    (prev->npages + npages) * REFOS_PAGE_SIZE);
+            if (error == ESUCCESS) {
+                prev->npages += npages;
+                prev->livePages += npages;
+                return ESUCCESS;
+            }
+            /* Fall back to a separate mapping. */
+        }
     }
 
-    /* Map the segment dataspace into the window. */
-    error = data_datamap(REFOS_PROCSERV_EP, dataspace, window, 0);
-    if (error != ESUCCESS) {
-        seL4_DebugPrintf("mmap_segment_fill: Could not map anon dspace.\n");
-        goto exit2;
+    if (s->numMappings >= PROCESS_MMAP_MAX_MAPPINGS) {
+        seL4_DebugPrintf("mmap_back: Too many mappings.\n");
+        return ENOMEM;
     }
 
-    /* Set the segment allocated status to TRUE. */
-    cbpool_set_single(&s->mmapRegionSegmentStatus, segmentID, true);
-
-    csfree_delete(dataspace);
-    csfree_delete(window);
+    /* Create the window and its dataspace. */
+    seL4_CPtr window = proc_create_anon_mem_window(refosio_mmap_page_vaddr(page),
+            npages * REFOS_PAGE_SIZE);
+    if (!window || REFOS_GET_ERRNO() != ESUCCESS) {
+        seL4_DebugPrintf("mmap_back: Could not create anon window.\n");
+        return REFOS_GET_ERRNO() != ESUCCESS ? REFOS_GET_ERRNO() : EINVALIDWINDOW;
+    }
+
+    memmove(&s->mappings[idx + 1], &s->mappings[idx],
+            (s->numMappings - idx) * sizeof(struct refos_io_mmap_mapping));
+    struct refos_io_mmap_mapping *m = &s->mappings[idx];
+    m->startPage = page;
+    m->npages = npages;
+    m->livePages = npages;
+    m->window = window;
+    s->numMappings++;
     return ESUCCESS;
-
-    /* Exit stack. */
-exit2:
-    data_close(REFOS_PROCSERV_EP, dataspace);
-    csfree_delete(dataspace);
-exit1:
-    proc_delete_mem_window(window);
-    csfree_delete(window);
-    return error;
 }
 
-int
-refosio_mmap_segment_release(refos_io_mmap_segment_state_t *s, uint32_t vaddrOffsetPage)
+/*! @brief Release a mapping with no live pages left, deleting its window and dataspace.
+    @param s The mmap state.
+    @param idx The index of the mapping to release.
+*/
+static void
+refosio_mmap_release(refos_io_mmap_segment_state_t *s, int idx)
 {
-    assert(vaddrOffsetPage >= PROCESS_MMAP_BOT && vaddrOffsetPage < PROCESS_MMAP_TOP);
-    uint32_t segmentID = (PROCESS_MMAP_TOP - vaddrOffsetPage) /
-        (PROCESS_MMAP_SEGMENT_SIZE_NPAGES * REFOS_PAGE_SIZE);
-    assert(segmentID < PROCESS_MMAP_SEGMENTS);
-
-    if (!cbpool_check_single(&s->mmapRegionSegmentStatus, segmentID)) {
-        /* This segment is already released. Nothing to do here. */
-        return ESUCCESS;
-    }
-
-    /* Check that every page associated has neem release. Otherwise we don't unmap yet. */
-    for (int i = 0; i < PROCESS_MMAP_SEGMENT_SIZE_NPAGES; i++) {
-        uint32_t page = ( (PROCESS_MMAP_TOP - vaddrOffsetPage) / REFOS_PAGE_SIZE ) + i;
-        if (cbpool_check_single(&s->mmapRegionPageStatus, page)) {
-            /* A page is still mapped here. */
-            return EUNMAPFIRST;
-        }
-    }
+    assert(idx >= 0 && idx < s->numMappings);
+    struct refos_io_mmap_mapping *m = &s->mappings[idx];
+    assert(m->livePages == 0);
 
-    /* Get the window. */
-    seL4_CPtr window = proc_get_mem_window(vaddrOffsetPage);
-    if (!window) {
-        /* Nothing mapped here. Nothing to do. */
-        seL4_DebugPrintf("mmap_segment_release: No window to release. Doing nothing.\n");
-        return ESUCCESS;
-    }
-
-    /* Get the associated dataspace and release it. */
-    refos_err_t refos_err = -EINVALID;
-    seL4_CPtr dspace = proc_get_mem_window_dspace(window, &refos_err);
-    if (refos_err != ESUCCESS) {
-        seL4_DebugPrintf("mmap_segment_fill: Failed to get window dataspace, error occued.\n");
-        return (int) refos_err;
-    }
-    if (dspace) {
-        int error = data_close(REFOS_PROCSERV_EP, dspace);
-        if (error) {
-            seL4_DebugPrintf("mmap_segment_fill: Failed delete dataspace.\n");
-        }
-        csfree_delete(dspace);
-    }
-
-    /* Finally, delete the window. */
-    int error = proc_delete_mem_window(window);
+    int error = proc_delete_mem_window(m->window);
     if (error) {
-        seL4_DebugPrintf("mmap_segment_fill: Failed to delete window, error occued.\n");
+        /* Best and easiest thing we can do here is just leak memory. */
+        seL4_DebugPrintf("mmap_release: Failed to delete window. Leaked memory.\n");
     }
-    csfree_delete(window);
+    csfree_delete(m->window);
 
-    /* Set the segment allocated status back to FALSE. */
-    cbpool_set_single(&s->mmapRegionSegmentStatus, segmentID, false);
-    return ESUCCESS;
+    memmove(&s->mappings[idx], &s->mappings[idx + 1],
+            (s->numMappings - idx - 1) * sizeof(struct refos_io_mmap_mapping));
+    s->numMappings--;
+}
+
+void
+refosio_mmap_init(refos_io_mmap_segment_state_t *s)
+{
+    cbpool_init_static(&s->mmapRegionPageStatus, PROCESS_MMAP_LIMIT_SIZE_NPAGES,
+            _refosioMMapPageStatusBuffer, REFOS_IO_INTERNAL_MMAP_PAGE_STATUS_BUFFER_SIZE);
+    s->numMappings = 0;
 }
 
 int
@@ -155,32 +140,42 @@ refosio_mmap_anon(refos_io_mmap_segment_state_t *s, int npages, uint32_t *vaddrD
     assert(s);
 
     /* Allocate the mmap pages from the page bitmap allocator. */
-    uint32_t vaddrOffsetPage = cbpool_alloc(&s->mmapRegionPageStatus, npages);
-    if (vaddrOffsetPage == CBPOOL_INVALID) {
+    uint32_t startPage = cbpool_alloc(&s->mmapRegionPageStatus, npages);
+    if (startPage == CBPOOL_INVALID) {
         seL4_DebugPrintf("mmap_anon: Could not allocate page region. Out of virtual memory.\n");
         return ENOMEM;
     }
+    uint32_t endPage = startPage + npages;
 
-    /* Loop through every segment and fill it in. */
-    for (int i = 0; i < npages; i++) {
-        uint32_t vaddr = PROCESS_MMAP_TOP - ((vaddrOffsetPage + i + 1) * REFOS_PAGE_SIZE);
-
-        /* Fill in the segment. If the segment already is filled then it does nothing. */
-        int error = refosio_mmap_segment_fill(s, vaddr);
-        if (error != ESUCCESS) {
-            seL4_DebugPrintf("mmap_segment_fill failed. Cannot fully recover from this.\n");
+    /* Walk the range, reusing pages of existing mappings and backing the gaps between them. */
+    uint32_t page = startPage;
+    while (page < endPage) {
+        int idx = refosio_mmap_find(s, page);
+        struct refos_io_mmap_mapping *m = (idx < s->numMappings) ? &s->mappings[idx] : NULL;
 
-            /* All the segments up to this point have been allocated. All the segments here and
-               after have not been, so unset them. This prevents inconsistent state between the page
-               bitmap and actually mapped pages. */
+        if (m && m->startPage <= page) {
+            /* Pages which were unmapped from a mapping still in use. They're still backed. */
+            uint32_t n = MIN(endPage, m->startPage + m->npages) - page;
+            m->livePages += n;
+            page += n;
+            continue;
+        }
 
-            cbpool_free(&s->mmapRegionPageStatus, vaddrOffsetPage + i, npages - i);
+        uint32_t gapEnd = m ? MIN(endPage, m->startPage) : endPage;
+        int error = refosio_mmap_back(s, idx, page, gapEnd - page);
+        if (error != ESUCCESS) {
+            /* Undo the part of the range done so far, and give back the rest of the pages. */
+            if (page > startPage) {
+                refosio_munmap_anon(s, refosio_mmap_page_vaddr(startPage), page - startPage);
+            }
+            cbpool_free(&s->mmapRegionPageStatus, page, endPage - page);
             return error;
         }
+        page = gapEnd;
     }
 
     if (vaddrDest) {
-        (*vaddrDest) = PROCESS_MMAP_TOP - ((vaddrOffsetPage + npages) * REFOS_PAGE_SIZE);
+        (*vaddrDest) = refosio_mmap_page_vaddr(startPage);
     }
     return ESUCCESS;
 }
@@ -200,21 +195,36 @@ refosio_munmap_anon(refos_io_mmap_segment_state_t *s, uint32_t vaddr, int npages
         seL4_DebugPrintf("unmap_anon: invalid vaddr, too low.");
         return EINVALIDPARAM;
     }
+    uint32_t startPage = (vaddr - PROCESS_MMAP_BOT) / REFOS_PAGE_SIZE;
+    if (npages < 0 || startPage + npages > PROCESS_MMAP_LIMIT_SIZE_NPAGES) {
+        seL4_DebugPrintf("unmap_anon: invalid size.");
+        return EINVALIDPARAM;
+    }
+
+    /* Free every allocated page in the range, releasing mappings which have no live pages left. */
+    int idx = refosio_mmap_find(s, startPage);
+    for (uint32_t page = startPage; page < startPage + npages; page++) {
+        if (!cbpool_check_single(&s->mmapRegionPageStatus, page)) {
+            continue;
+        }
+        cbpool_set_single(&s->mmapRegionPageStatus, page, false);
 
-    /* Free every page in the range. */
-    uint32_t vaddrOffsetPage = (PROCESS_MMAP_TOP - vaddr) / REFOS_PAGE_SIZE;
-    assert(vaddrOffsetPage < PROCESS_MMAP_LIMIT_SIZE_NPAGES);
-    cbpool_free(&s->mmapRegionPageStatus, vaddrOffsetPage, npages);
-
-    /* Loop through every segment and check for affected. */
-    for (int i = 0; i < npages; i++) {
-        uint32_t vaddr = PROCESS_MMAP_TOP - ((vaddrOffsetPage + i + 1) * REFOS_PAGE_SIZE);
-        int error = refosio_mmap_segment_release(s, vaddr);
-        if (error != ESUCCESS && error != EUNMAPFIRST) {
-            /* Best and easiest thing we can do here is just leak memory. */
-            seL4_DebugPrintf("refosio_mmap_segment_release failed. Leaked memory.\n");
+        while (idx < s->numMappings &&
+                s->mappings[idx].startPage + s->mappings[idx].npages <= page) {
+            idx++;
+        }
+        if (idx >= s->numMappings || s->mappings[idx].startPage > page) {
+            assert(!"Allocated mmap page with no mapping. Book-keeping bug.");
+            continue;
+        }
+        struct refos_io_mmap_mapping *m = &s->mappings[idx];
+        assert(m->livePages > 0);
+        m->livePages--;
+        if (m->livePages == 0) {
+            /* The mapping slides out of the array, so idx now points at the next one. */
+            refosio_mmap_release(s, idx);
         }
     }
 
     return ESUCCESS;
-}
\ No newline at end of file
+}
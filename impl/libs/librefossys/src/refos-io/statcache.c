@@ -0,0 +1,182 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <refos/refos.h>
+#include <refos/error.h>
+#include <refos-io/statcache.h>
+#include <refos-io/internal_state.h>
+#include <refos-rpc/data_client.h>
+#include <refos-rpc/data_client_helper.h>
+#include <refos-util/dprintf.h>
+
+/* ------------------------------- Stat cache helper functions ---------------------------------- */
+
+/*! @brief FNV-1a hash of a path. */
+static uint32_t
+refosio_stat_hash(const char *path)
+{
+    uint32_t h = 2166136261u;
+    for (; *path; path++) {
+        h = (h ^ (uint8_t) *path) * 16777619u;
+    }
+    return h;
+}
+
+/*! @brief Find the cache entry of a path.
+    @return The cache entry if found, NULL otherwise. (No ownership)
+*/
+static refosio_stat_cache_entry_t *
+refosio_stat_cache_find(refosio_stat_cache_t *sc, const char *path, uint32_t hash)
+{
+    for (int i = 0; i < REFOSIO_STAT_CACHE_SIZE; i++) {
+        refosio_stat_cache_entry_t *e = &sc->entry[i];
+        if (e->valid && e->hash == hash && !strcmp(e->path, path)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/*! @brief Cache the metadata of a path, replacing the least recently used entry if the cache is
+           full. Paths too long for the cache are not cached. */
+static void
+refosio_stat_cache_insert(refosio_stat_cache_t *sc, const char *path, uint32_t hash,
+                          refosio_stat_info_t *info)
+{
+    if (strlen(path) >= REFOSIO_STAT_CACHE_PATH_MAXLEN) {
+        return;
+    }
+    refosio_stat_cache_entry_t *victim = &sc->entry[0];
+    for (int i = 0; i < REFOSIO_STAT_CACHE_SIZE; i++) {
+        refosio_stat_cache_entry_t *e = &sc->entry[i];
+        if (!e->valid) {
+            victim = e;
+            break;
+        }
+        if (e->lastUse < victim->lastUse) {
+            victim = e;
+        }
+    }
+    victim->valid = true;
+    victim->hash = hash;
+    victim->lastUse = ++sc->useCounter;
+    strcpy(victim->path, path);
+    victim->info = (*info);
+}
+
+/*! @brief Find an open stat session to the server of the given path.
+    @return The session's connection if found, NULL otherwise. (No ownership)
+*/
+static serv_connection_t *
+refosio_stat_session_find(refosio_stat_cache_t *sc, const char *path)
+{
+    for (int i = 0; i < REFOSIO_STAT_MAX_SESSIONS; i++) {
+        if (!sc->sessionValid[i]) {
+            continue;
+        }
+        const char *prefix = sc->session[i].serverMountPoint.nameservPathPrefix;
+        size_t plen = strlen(prefix);
+        if (plen > 0 && !strncmp(path, prefix, plen)) {
+            return &sc->session[i];
+        }
+    }
+    return NULL;
+}
+
+/*! @brief Connect a new stat session to the server of the given path, replacing the oldest open
+           session if there are no free session slots.
+    @return The new session's connection if success, NULL otherwise. (No ownership)
+*/
+static serv_connection_t *
+refosio_stat_session_connect(refosio_stat_cache_t *sc, char *path)
+{
+    int i = sc->nextSession;
+    sc->nextSession = (sc->nextSession + 1) % REFOSIO_STAT_MAX_SESSIONS;
+    if (sc->sessionValid[i]) {
+        serv_disconnect(&sc->session[i]);
+        sc->sessionValid[i] = false;
+    }
+
+    sc->session[i] = serv_connect_fast(path);
+    if (sc->session[i].error != ESUCCESS || !sc->session[i].serverSession) {
+        return NULL;
+    }
+    sc->sessionValid[i] = true;
+    return &sc->session[i];
+}
+
+/*! @brief Drop an open stat session, eg. after its server stopped answering. */
+static void
+refosio_stat_session_drop(refosio_stat_cache_t *sc, serv_connection_t *conn)
+{
+    int i = conn - sc->session;
+    assert(i >= 0 && i < REFOSIO_STAT_MAX_SESSIONS && sc->sessionValid[i]);
+    serv_disconnect(conn);
+    sc->sessionValid[i] = false;
+}
+
+/* ----------------------------------- Stat cache functions ------------------------------------- */
+
+refos_err_t
+refosio_stat(char *path, refosio_stat_info_t *info)
+{
+    refosio_stat_cache_t *sc = &refosIOState.statCache;
+    if (!path || !info) {
+        return EINVALIDPARAM;
+    }
+
+    /* Try the cache first. */
+    uint32_t hash = refosio_stat_hash(path);
+    refosio_stat_cache_entry_t *e = refosio_stat_cache_find(sc, path, hash);
+    if (e) {
+        sc->hits++;
+        e->lastUse = ++sc->useCounter;
+        (*info) = e->info;
+        return ESUCCESS;
+    }
+    sc->misses++;
+
+    /* Ask the server, over an already open session if there is one. */
+    bool fresh = false;
+    serv_connection_t *conn = refosio_stat_session_find(sc, path);
+    if (!conn) {
+        conn = refosio_stat_session_connect(sc, path);
+        if (!conn) {
+            return ESERVERNOTFOUND;
+        }
+        fresh = true;
+    }
+
+    char *name = path + strlen(conn->serverMountPoint.nameservPathPrefix);
+    uint32_t flags = 0;
+    refos_err_t error = data_stat(conn->serverSession, name, &info->size, &info->mode,
+                                  &info->mtime, &flags);
+    if (error == EFILENOTFOUND || error == EUNIMPLEMENTED) {
+        return error;
+    }
+    if (error != ESUCCESS && !fresh) {
+        /* The session may have gone stale; try again over a new one. */
+        refosio_stat_session_drop(sc, conn);
+        conn = refosio_stat_session_connect(sc, path);
+        if (!conn) {
+            return ESERVERNOTFOUND;
+        }
+        name = path + strlen(conn->serverMountPoint.nameservPathPrefix);
+        error = data_stat(conn->serverSession, name, &info->size, &info->mode, &info->mtime,
+                          &flags);
+    }
+    if (error != ESUCCESS) {
+        return error;
+    }
+
+    if (flags & DATA_STAT_IMMUTABLE) {
+        refosio_stat_cache_insert(sc, path, hash, info);
+    }
+    return ESUCCESS;
+}
@@ -39,21 +39,20 @@ refos_override_stdio(stdio_read_fn_t readfn, stdio_write_fn_t writefn)
     refosIOState.stdioWriteOverride = writefn;
 }
 
-void
-refos_setup_dataspace_stdio(char *dspacePath)
+/*! @brief Connect to the console server and open the STDIO dataspace at the given path.
+    @param dspacePath The namespace path of the STDIO dataspace.
+    @return ESUCCESS if success, refos_err_t otherwise.
+*/
+static int
+refos_connect_dataspace_stdio(char *dspacePath)
 {
-#if defined(SEL4_DEBUG_KERNEL) && defined(CONFIG_REFOS_SYS_FORCE_DEBUGPUTCHAR)
-    return;
-#else
     /* Find the path and connect to it. */
     refosIOState.stdioSession = serv_connect_no_pbuffer(dspacePath);
-    if (!refosIOState.stdioSession.error == ESUCCESS || !refosIOState.stdioSession.serverSession) {
+    if (refosIOState.stdioSession.error != ESUCCESS ||
+            !refosIOState.stdioSession.serverSession) {
         seL4_DebugPrintf("Failed to connect to [%s]. Error: %d %s.\n", dspacePath,
                 refosIOState.stdioSession.error, refos_error_str(refosIOState.stdioSession.error));
-        #if defined(SEL4_DEBUG_KERNEL)
-        seL4_DebugHalt();
-        #endif
-        while (1);
+        return ESERVERNOTFOUND;
     }
 
     /* Open the dataspace at the Resolved mount point. */
@@ -63,6 +62,21 @@ refos_setup_dataspace_stdio(char *dspacePath)
     if (error || !refosIOState.stdioDataspace) {
         seL4_DebugPrintf("Failed to open dataspace [%s].\n",
                 refosIOState.stdioSession.serverMountPoint.dspaceName);
+        serv_disconnect(&refosIOState.stdioSession);
+        refosIOState.stdioDataspace = 0;
+        return EFILENOTFOUND;
+    }
+    return ESUCCESS;
+}
+
+void
+refos_setup_dataspace_stdio(char *dspacePath)
+{
+#if defined(SEL4_DEBUG_KERNEL) && defined(CONFIG_REFOS_SYS_FORCE_DEBUGPUTCHAR)
+    return;
+#else
+    refosIOState.stdioPath = NULL;
+    if (refos_connect_dataspace_stdio(dspacePath) != ESUCCESS) {
         #if defined(SEL4_DEBUG_KERNEL)
         seL4_DebugHalt();
         #endif
@@ -71,10 +85,37 @@ refos_setup_dataspace_stdio(char *dspacePath)
 #endif
 }
 
+void
+refos_setup_dataspace_stdio_lazy(char *dspacePath)
+{
+#if defined(SEL4_DEBUG_KERNEL) && defined(CONFIG_REFOS_SYS_FORCE_DEBUGPUTCHAR)
+    return;
+#else
+    refosIOState.stdioPath = dspacePath;
+#endif
+}
+
+bool
+refos_stdio_connected(void)
+{
+    if (refosIOState.stdioDataspace && refosIOState.stdioSession.serverSession) {
+        return true;
+    }
+    if (!refosIOState.stdioPath) {
+        return false;
+    }
+
+    /* First use of a lazily set up STDIO. Only try once; if the console server can't be reached
+       now, it won't be reachable later either. */
+    char *dspacePath = refosIOState.stdioPath;
+    refosIOState.stdioPath = NULL;
+    return refos_connect_dataspace_stdio(dspacePath) == ESUCCESS;
+}
+
 int
 refos_async_getc(void)
 {
-    if (!refosIOState.stdioDataspace || !refosIOState.stdioSession.serverSession) {
+    if (!refos_stdio_connected()) {
         seL4_DebugPrintf("refos_async_getc used without setting up stdin. Ignoring.\n");
         return -1;
     }
@@ -88,7 +129,7 @@ refos_async_getc(void)
 int
 refos_getc(void)
 {
-    if (!refosIOState.stdioDataspace || !refosIOState.stdioSession.serverSession) {
+    if (!refos_stdio_connected()) {
         seL4_DebugPrintf("refos_getc used without setting up stdin. Ignoring.\n");
         return -1;
     }
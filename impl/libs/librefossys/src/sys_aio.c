@@ -0,0 +1,233 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <refos/error.h>
+#include <refos/aio_ring.h>
+#include <refos-io/internal_state.h>
+#include <refos-io/filetable.h>
+#include <refos-io/aio.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <aio.h>
+#include <time.h>
+
+/*! @file
+    @brief POSIX asynchronous I/O on top of the RefOS IO asynchronous dataspace rings.
+
+    These replace the C library's thread based implementation. Every one of the C library's aio
+    functions is defined here, so that its implementation is never linked in alongside. Only
+    SIGEV_NONE completion notification is supported, and aio_suspend() ignores its timeout, as
+    waiting on the server always completes every queued operation.
+*/
+
+/*! @brief Look up the asynchronous I/O state of the file descriptor of a control block. */
+static refosio_aio_t *
+sys_aio_get(const struct aiocb *cb)
+{
+    if (!cb) {
+        return NULL;
+    }
+    return filetable_aio_get(&refosIOState.fdTable, cb->aio_fildes);
+}
+
+/*! @brief Queue a control block onto its file descriptor's ring. */
+static int
+sys_aio_queue(struct aiocb *cb, uint32_t opcode)
+{
+    refosio_aio_t *a = sys_aio_get(cb);
+    if (!a) {
+        errno = EBADF;
+        return -1;
+    }
+    if (cb->aio_offset < 0 || cb->aio_offset > INT32_MAX ||
+            cb->aio_sigevent.sigev_notify != SIGEV_NONE) {
+        errno = EINVAL;
+        return -1;
+    }
+    int slot = refosio_aio_queue(a, opcode, (int32_t) cb->aio_offset, SEEK_SET,
+                                 (char*) cb->aio_buf, cb->aio_nbytes, cb);
+    if (slot < 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return 0;
+}
+
+/*! @brief Find the slot of a control block, reaping any completions first. */
+static int
+sys_aio_find(refosio_aio_t *a, const struct aiocb *cb)
+{
+    refosio_aio_reap(a);
+    return refosio_aio_find(a, (void*) cb);
+}
+
+int
+aio_read(struct aiocb *cb)
+{
+    if (sys_aio_queue(cb, REFOS_AIO_OP_READ) < 0) {
+        return -1;
+    }
+    refosio_aio_kick(sys_aio_get(cb));
+    return 0;
+}
+
+int
+aio_write(struct aiocb *cb)
+{
+    if (sys_aio_queue(cb, REFOS_AIO_OP_WRITE) < 0) {
+        return -1;
+    }
+    refosio_aio_kick(sys_aio_get(cb));
+    return 0;
+}
+
+int
+aio_fsync(int op, struct aiocb *cb)
+{
+    /* Dataspace writes are complete once their completion is posted. */
+    if (op != O_SYNC && op != O_DSYNC) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (sys_aio_queue(cb, REFOS_AIO_OP_NOP) < 0) {
+        return -1;
+    }
+    refosio_aio_kick(sys_aio_get(cb));
+    return 0;
+}
+
+int
+aio_error(const struct aiocb *cb)
+{
+    refosio_aio_t *a = sys_aio_get(cb);
+    if (!a) {
+        return EINVAL;
+    }
+    int slot = sys_aio_find(a, cb);
+    if (slot < 0) {
+        return EINVAL;
+    }
+    if (a->slots[slot].state != REFOSIO_AIO_SLOT_DONE) {
+        return EINPROGRESS;
+    }
+    return (a->slots[slot].result < 0) ? EIO : 0;
+}
+
+ssize_t
+aio_return(struct aiocb *cb)
+{
+    refosio_aio_t *a = sys_aio_get(cb);
+    if (!a) {
+        errno = EINVAL;
+        return -1;
+    }
+    int slot = sys_aio_find(a, cb);
+    if (slot < 0 || a->slots[slot].state != REFOSIO_AIO_SLOT_DONE) {
+        errno = EINVAL;
+        return -1;
+    }
+    int32_t result = a->slots[slot].result;
+    refosio_aio_free(a, slot);
+    if (result < 0) {
+        errno = EIO;
+        return -1;
+    }
+    return result;
+}
+
+int
+aio_cancel(int fd, struct aiocb *cb)
+{
+    /* Operations handed to the server can not be recalled. */
+    refosio_aio_t *a = filetable_aio_get(&refosIOState.fdTable, fd);
+    if (!a) {
+        errno = EBADF;
+        return -1;
+    }
+    refosio_aio_reap(a);
+    for (int i = 0; i < REFOSIO_AIO_RING_ENTRIES; i++) {
+        if (a->slots[i].state == REFOSIO_AIO_SLOT_QUEUED && (!cb || a->slots[i].cookie == cb)) {
+            return AIO_NOTCANCELED;
+        }
+    }
+    return AIO_ALLDONE;
+}
+
+int
+aio_suspend(const struct aiocb *const cbs[], int n, const struct timespec *timeout)
+{
+    (void) timeout;
+    for (int i = 0; i < n; i++) {
+        if (!cbs[i]) {
+            continue;
+        }
+        refosio_aio_t *a = sys_aio_get(cbs[i]);
+        if (!a) {
+            continue;
+        }
+        int slot = sys_aio_find(a, cbs[i]);
+        if (slot < 0) {
+            continue;
+        }
+        if (a->slots[slot].state == REFOSIO_AIO_SLOT_QUEUED &&
+                refosio_aio_wait(a) != ESUCCESS) {
+            errno = EINTR;
+            return -1;
+        }
+        return 0;
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+int
+lio_listio(int mode, struct aiocb *restrict const cbs[restrict], int n,
+           struct sigevent *restrict sev)
+{
+    if ((mode != LIO_WAIT && mode != LIO_NOWAIT) || n < 0 ||
+            (sev && sev->sigev_notify != SIGEV_NONE)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Queue the whole list before handing any of it to the servers, so each file descriptor's
+       batch costs a single notification. */
+    int error = 0;
+    for (int i = 0; i < n; i++) {
+        if (!cbs[i] || cbs[i]->aio_lio_opcode == LIO_NOP) {
+            continue;
+        }
+        uint32_t opcode = (cbs[i]->aio_lio_opcode == LIO_READ) ?
+                REFOS_AIO_OP_READ : REFOS_AIO_OP_WRITE;
+        if (sys_aio_queue(cbs[i], opcode) < 0) {
+            error = errno;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (!cbs[i] || cbs[i]->aio_lio_opcode == LIO_NOP) {
+            continue;
+        }
+        refosio_aio_t *a = sys_aio_get(cbs[i]);
+        if (!a) {
+            continue;
+        }
+        if (mode == LIO_WAIT) {
+            refosio_aio_wait(a);
+        } else {
+            refosio_aio_kick(a);
+        }
+    }
+
+    if (error) {
+        errno = (error == EAGAIN) ? EAGAIN : EIO;
+        return -1;
+    }
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <refos-io/internal_state.h>
 #include <refos-io/ipc_state.h>
 #include <refos-io/filetable.h>
+#include <refos-io/statcache.h>
 #include <refos-util/init.h>
 #include <refos-rpc/data_client.h>
 #include <refos-rpc/data_client_helper.h>
@@ -21,6 +22,11 @@
 #include <sel4/sel4.h>
 #include <stdarg.h>
 #include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
 #include <refos-util/dprintf.h>
 
 #define STDIN_FD 0
@@ -45,9 +51,13 @@ sys_platform_stdout_write(void *data, size_t count)
         return refosIOState.stdioWriteOverride(data, count);
     }
 
-    /* Use serial dataspace on Console server. */
-    if (refosIOState.stdioDataspace && refosIOState.stdioSession.serverSession) {
+    /* Use serial dataspace on Console server, connecting to it on first use. */
+    if (refosIOState.stdioDataspace || refosIOState.stdioPath) {
         refosio_internal_save_IPC_buffer();
+        if (!refos_stdio_connected()) {
+            refosio_internal_restore_IPC_buffer();
+            return count;
+        }
         for (size_t i = 0; i < count;) {
             int c = MIN(REFOS_DEFAULT_DSPACE_IPC_MAXLEN, count - i);
             int n = data_write(refosIOState.stdioSession.serverSession, refosIOState.stdioDataspace,
@@ -242,20 +252,31 @@ sys_read(va_list ap) {
     return _sys_readv(fildes, &iov, 1);
 }
 
+/*! @brief Handle the PWD environment variable.
+    @param pathname The path given to the syscall.
+    @return The path with PWD prepended if PWD is set, pathname otherwise. (No ownership, valid
+            until the next call)
+*/
+static char *
+sys_io_pwd_path(char *pathname)
+{
+    static char tempBufferPath[REFOS_SYSIO_MAX_PATHLEN];
+    char *pwd = getenv("PWD");
+    if (pwd && strlen(pwd) > 0) {
+        snprintf(tempBufferPath, REFOS_SYSIO_MAX_PATHLEN, "%s%s", pwd, pathname);
+        return tempBufferPath;
+    }
+    return pathname;
+}
+
 long
 sys_open(va_list ap)
 {
     char *pathname = va_arg(ap, char*);
     int flags = va_arg(ap, int);
     int fd = -1;
-    static char tempBufferPath[REFOS_SYSIO_MAX_PATHLEN];
 
-    /* Handle the PWD environment variable. */
-    char *pwd = getenv("PWD");
-    if (pwd && strlen(pwd) > 0) {
-        snprintf(tempBufferPath, REFOS_SYSIO_MAX_PATHLEN, "%s%s", getenv("PWD"), pathname);
-        pathname = tempBufferPath;
-    }
+    pathname = sys_io_pwd_path(pathname);
 
     /* Open dataspace file. */
     fd = filetable_dspace_open(&refosIOState.fdTable, pathname, flags, 0, 0x1000);
@@ -325,6 +346,158 @@ sys__llseek(va_list ap)
     return 0;
 }
 
+long
+sys_getdents64(va_list ap)
+{
+    int fildes = va_arg(ap, int);
+    struct dirent *dirp = va_arg(ap, struct dirent*);
+    unsigned int count = va_arg(ap, unsigned int);
+
+    int nr = filetable_getdents(&refosIOState.fdTable, fildes, dirp, (int) MIN(count, INT_MAX));
+    switch (-nr) {
+        case EINVALID: return -ENOTDIR;
+        case EINVALIDPARAM: return -EINVAL;
+        case EFILENOTFOUND: return -EBADF;
+        default: break;
+    }
+    if (nr < 0) {
+        return -EIO;
+    }
+    return nr;
+}
+
+long
+sys_getdents(va_list ap)
+{
+    /* Directory entries always use the libc struct dirent layout, which matches getdents64. */
+    return sys_getdents64(ap);
+}
+
+/*! @brief Fill in a struct stat from dataspace metadata. */
+static void
+sys_io_fill_stat(struct stat *st, refosio_stat_info_t *info)
+{
+    memset(st, 0, sizeof(struct stat));
+    st->st_mode = info->mode;
+    st->st_nlink = 1;
+    st->st_size = info->size;
+    st->st_blksize = REFOS_PAGE_SIZE;
+    st->st_blocks = (info->size + 511) / 512;
+    st->st_atime = st->st_mtime = st->st_ctime = info->mtime;
+}
+
+/*! @brief Translate a refos_err_t stat error into a negative errno value. */
+static long
+sys_io_stat_error(int error)
+{
+    switch (error) {
+        case EFILENOTFOUND: return -ENOENT;
+        case ESERVERNOTFOUND: return -ENOENT;
+        case EINVALIDPARAM: return -EINVAL;
+        case EUNIMPLEMENTED: return -ENOSYS;
+        default: return -EIO;
+    }
+}
+
+static long
+_sys_stat(char *pathname, struct stat *st)
+{
+    if (!pathname || !st) {
+        return -EFAULT;
+    }
+    refosio_stat_info_t info;
+    int error = refosio_stat(sys_io_pwd_path(pathname), &info);
+    if (error != ESUCCESS) {
+        return sys_io_stat_error(error);
+    }
+    sys_io_fill_stat(st, &info);
+    return 0;
+}
+
+static long
+_sys_fstat(int fildes, struct stat *st)
+{
+    if (!st) {
+        return -EFAULT;
+    }
+    refosio_stat_info_t info;
+    if (fildes == STDOUT_FD || fildes == STDERR_FD || fildes == STDIN_FD) {
+        info.size = info.mtime = 0;
+        info.mode = S_IFCHR | S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+    } else {
+        int error = filetable_fstat(&refosIOState.fdTable, fildes, &info);
+        if (error != ESUCCESS) {
+            return error == EFILENOTFOUND ? -EBADF : sys_io_stat_error(error);
+        }
+    }
+    sys_io_fill_stat(st, &info);
+    return 0;
+}
+
+/* There is only one struct stat layout; musl's struct stat is laid out as the kernel's struct
+   stat64, so the stat and stat64 families are the same. There are no symbolic links. */
+
+long
+sys_stat(va_list ap)
+{
+    char *pathname = va_arg(ap, char*);
+    struct stat *st = va_arg(ap, struct stat*);
+    return _sys_stat(pathname, st);
+}
+
+long
+sys_lstat(va_list ap)
+{
+    char *pathname = va_arg(ap, char*);
+    struct stat *st = va_arg(ap, struct stat*);
+    return _sys_stat(pathname, st);
+}
+
+long
+sys_fstat(va_list ap)
+{
+    int fildes = va_arg(ap, int);
+    struct stat *st = va_arg(ap, struct stat*);
+    return _sys_fstat(fildes, st);
+}
+
+long
+sys_stat64(va_list ap)
+{
+    return sys_stat(ap);
+}
+
+long
+sys_lstat64(va_list ap)
+{
+    return sys_lstat(ap);
+}
+
+long
+sys_fstat64(va_list ap)
+{
+    return sys_fstat(ap);
+}
+
+long
+sys_access(va_list ap)
+{
+    char *pathname = va_arg(ap, char*);
+    int mode = va_arg(ap, int);
+
+    struct stat st;
+    long error = _sys_stat(pathname, &st);
+    if (error) {
+        return error;
+    }
+    if (((mode & R_OK) && !(st.st_mode & S_IRUSR)) ||
+            ((mode & W_OK) && !(st.st_mode & S_IWUSR)) ||
+            ((mode & X_OK) && !(st.st_mode & S_IXUSR))) {
+        return -EACCES;
+    }
+    return 0;
+}
+
 long
 sys_ioctl(va_list ap)
 {
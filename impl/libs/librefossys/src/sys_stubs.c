@@ -120,10 +120,10 @@ long sys_gtty(va_list ap) {
 	assert(!"sys_gtty not implemented");
 	return 0;
 }
-long sys_access(va_list ap) {
+/*long sys_access(va_list ap) {
 	assert(!"sys_access not implemented");
 	return 0;
-}
+}*/
 long sys_nice(va_list ap) {
 	assert(!"sys_nice not implemented");
 	return 0;
@@ -404,18 +404,18 @@ long sys_getitimer(va_list ap) {
 	assert(!"sys_getitimer not implemented");
 	return 0;
 }
-long sys_stat(va_list ap) {
+/*long sys_stat(va_list ap) {
 	assert(!"sys_stat not implemented");
 	return 0;
-}
-long sys_lstat(va_list ap) {
+}*/
+/*long sys_lstat(va_list ap) {
 	assert(!"sys_lstat not implemented");
 	return 0;
-}
-long sys_fstat(va_list ap) {
+}*/
+/*long sys_fstat(va_list ap) {
 	assert(!"sys_fstat not implemented");
 	return 0;
-}
+}*/
 long sys_olduname(va_list ap) {
 	assert(!"sys_olduname not implemented");
 	return 0;
@@ -544,10 +544,10 @@ long sys_setfsgid(va_list ap) {
 	assert(!"sys__llseek not implemented");
 	return 0;
 }*/
-long sys_getdents(va_list ap) {
+/*long sys_getdents(va_list ap) {
 	assert(!"sys_getdents not implemented");
 	return 0;
-}
+}*/
 long sys__newselect(va_list ap) {
 	assert(!"sys__newselect not implemented");
 	return 0;
@@ -748,18 +748,18 @@ long sys_ftruncate64(va_list ap) {
 	assert(!"sys_ftruncate64 not implemented");
 	return 0;
 }
-long sys_stat64(va_list ap) {
+/*long sys_stat64(va_list ap) {
 	assert(!"sys_stat64 not implemented");
 	return 0;
-}
-long sys_lstat64(va_list ap) {
+}*/
+/*long sys_lstat64(va_list ap) {
 	assert(!"sys_lstat64 not implemented");
 	return 0;
-}
-long sys_fstat64(va_list ap) {
+}*/
+/*long sys_fstat64(va_list ap) {
 	assert(!"sys_fstat64 not implemented");
 	return 0;
-}
+}*/
 long sys_lchown32(va_list ap) {
 	assert(!"sys_lchown32 not implemented");
 	return 0;
@@ -852,10 +852,10 @@ long sys_madvise1(va_list ap) {
 	assert(!"sys_madvise1 not implemented");
 	return 0;
 }
-long sys_getdents64(va_list ap) {
+/*long sys_getdents64(va_list ap) {
 	assert(!"sys_getdents64 not implemented");
 	return 0;
-}
+}*/
 long sys_gettid(va_list ap) {
 	assert(!"sys_gettid not implemented");
 	return 0;
@@ -1396,10 +1396,10 @@ long sys_pause(va_list ap) {
     assert(!"sys_pause not implemented");
     return 0;
 }
-long sys_access(va_list ap) {
+/*long sys_access(va_list ap) {
     assert(!"sys_access not implemented");
     return 0;
-}
+}*/
 long sys_nice(va_list ap) {
     assert(!"sys_nice not implemented");
     return 0;
@@ -1612,18 +1612,18 @@ long sys_getitimer(va_list ap) {
     assert(!"sys_getitimer not implemented");
     return 0;
 }
-long sys_stat(va_list ap) {
+/*long sys_stat(va_list ap) {
     assert(!"sys_stat not implemented");
     return 0;
-}
-long sys_lstat(va_list ap) {
+}*/
+/*long sys_lstat(va_list ap) {
     assert(!"sys_lstat not implemented");
     return 0;
-}
-long sys_fstat(va_list ap) {
+}*/
+/*long sys_fstat(va_list ap) {
     assert(!"sys_fstat not implemented");
     return 0;
-}
+}*/
 long sys_vhangup(va_list ap) {
     assert(!"sys_vhangup not implemented");
     return 0;
@@ -1712,10 +1712,10 @@ long sys_setfsgid(va_list ap) {
     assert(!"sys_setfsgid not implemented");
     return 0;
 }
-long sys_getdents(va_list ap) {
+/*long sys_getdents(va_list ap) {
     assert(!"sys_getdents not implemented");
     return 0;
-}
+}*/
 long sys__newselect(va_list ap) {
     assert(!"sys__newselect not implemented");
     return 0;
@@ -1900,18 +1900,18 @@ long sys_ftruncate64(va_list ap) {
     assert(!"sys_ftruncate64 not implemented");
     return 0;
 }
-long sys_stat64(va_list ap) {
+/*long sys_stat64(va_list ap) {
     assert(!"sys_stat64 not implemented");
     return 0;
-}
-long sys_lstat64(va_list ap) {
+}*/
+/*long sys_lstat64(va_list ap) {
     assert(!"sys_lstat64 not implemented");
     return 0;
-}
-long sys_fstat64(va_list ap) {
+}*/
+/*long sys_fstat64(va_list ap) {
     assert(!"sys_fstat64 not implemented");
     return 0;
-}
+}*/
 long sys_lchown32(va_list ap) {
     assert(!"sys_lchown32 not implemented");
     return 0;
@@ -1988,10 +1988,10 @@ long sys_setfsgid32(va_list ap) {
     assert(!"sys_setfsgid32 not implemented");
     return 0;
 }
-long sys_getdents64(va_list ap) {
+/*long sys_getdents64(va_list ap) {
     assert(!"sys_getdents64 not implemented");
     return 0;
-}
+}*/
 long sys_pivot_root(va_list ap) {
     assert(!"sys_pivot_root not implemented");
     return 0;
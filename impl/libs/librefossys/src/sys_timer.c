@@ -28,6 +28,28 @@ refos_init_timer(char *dspacePath)
     }
 }
 
+void
+refos_init_timer_lazy(char *dspacePath)
+{
+    assert(dspacePath);
+    refosIOState.timerPath = dspacePath;
+}
+
+/*! @brief Get the timer file, opening it first if the timer was set up lazily.
+    @return The timer file if available, NULL otherwise. (No ownership)
+*/
+static FILE *
+refos_timer_file(void)
+{
+    if (!refosIOState.timerFD && refosIOState.timerPath) {
+        /* Only try once; refos_init_timer() complains if this fails. */
+        char *dspacePath = refosIOState.timerPath;
+        refosIOState.timerPath = NULL;
+        refos_init_timer(dspacePath);
+    }
+    return refosIOState.timerFD;
+}
+
 long
 sys_nanosleep(va_list ap)
 {
@@ -39,7 +61,7 @@ sys_nanosleep(va_list ap)
         return 0;
     }
 
-    if (!refosIOState.timerFD) {
+    if (!refos_timer_file()) {
         assert(!"sys_nanosleep not supported");
         return -1;
     }
@@ -70,7 +92,7 @@ sys_clock_gettime(va_list ap)
         seL4_DebugPrintf("WARNING: sys_clock_gettime CPU time feature not supported.\n");
         return -1;
     }
-    if (!refosIOState.timerFD) {
+    if (!refos_timer_file()) {
         assert(!"sys_clock_gettime not supported");
         return -1;
     }
@@ -27,8 +27,16 @@ long sys_read(va_list ap);
 long sys_ioctl(va_list ap);
 long sys_prlimit64(va_list ap);
 long sys_lseek(va_list ap);
+long sys_getdents(va_list ap);
+long sys_getdents64(va_list ap);
 long sys__llseek(va_list ap);
 long sys_access(va_list ap);
+long sys_stat(va_list ap);
+long sys_lstat(va_list ap);
+long sys_fstat(va_list ap);
+long sys_stat64(va_list ap);
+long sys_lstat64(va_list ap);
+long sys_fstat64(va_list ap);
 long sys_brk(va_list ap);
 long sys_mmap2(va_list ap);
 long sys_mremap(va_list ap);
@@ -37,8 +37,24 @@ long (*syscall_table[])(va_list) = {
     [__NR_lseek] = sys_lseek,
 #ifdef __NR__llseek
     [__NR__llseek] = sys__llseek,
+#endif
+#ifdef __NR_getdents
+    [__NR_getdents] = sys_getdents,
+#endif
+#ifdef __NR_getdents64
+    [__NR_getdents64] = sys_getdents64,
 #endif
     [__NR_access] = sys_access,
+#ifdef __NR_stat
+    [__NR_stat] = sys_stat,
+    [__NR_lstat] = sys_lstat,
+    [__NR_fstat] = sys_fstat,
+#endif
+#ifdef __NR_stat64
+    [__NR_stat64] = sys_stat64,
+    [__NR_lstat64] = sys_lstat64,
+    [__NR_fstat64] = sys_fstat64,
+#endif
     [__NR_brk] = sys_brk,
 #ifdef __NR_mmap2
     [__NR_mmap2] = sys_mmap2,
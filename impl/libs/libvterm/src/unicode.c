@@ -321,12 +321,59 @@ static int mk_wcswidth_cjk(const wchar_t *pwcs, size_t n)
 // ################################
 // ### The rest added by Paul Evans
 
+#define UNICODE_BLOCK_SIZE 256
+
+enum {
+  UNICODE_CLASS_NARROW,
+  UNICODE_CLASS_WIDE,
+  UNICODE_CLASS_COMBINING, /* Also zero width */
+  UNICODE_CLASS_CONTROL,
+};
+
+#ifndef VTERM_UNICODE_GENERATOR
+
+/* Two-stage lookup table, generated from the tables above by tools/gen_unicode_table.c. Every
+ * codepoint gets a 2-bit UNICODE_CLASS_*, packed four to a byte in blocks of
+ * UNICODE_BLOCK_SIZE codepoints; unicode_block_index maps a codepoint's block number to the
+ * (shared, deduplicated) block holding its bits. Codepoints at or past UNICODE_TABLE_LIMIT are
+ * all UNICODE_CLASS_NARROW. Regenerate it whenever the tables above change. */
+#include "unicode_table.inc"
+
+static inline int unicode_class(int codepoint)
+{
+  const uint8_t *block = unicode_blocks[unicode_block_index[codepoint / UNICODE_BLOCK_SIZE]];
+  int i = codepoint % UNICODE_BLOCK_SIZE;
+  return (block[i / 4] >> ((i % 4) * 2)) & 3;
+}
+
 int vterm_unicode_width(int codepoint)
 {
-  return mk_wcwidth(codepoint);
+  /* ASCII and Latin-1 hold no combining characters, only controls */
+  if(codepoint >= 0 && codepoint < 0x100) {
+    if(codepoint == 0)
+      return 0;
+    if(codepoint < 0x20 || (codepoint >= 0x7f && codepoint < 0xa0))
+      return -1;
+    return 1;
+  }
+  if(codepoint < 0)
+    return mk_wcwidth(codepoint);
+  if(codepoint >= UNICODE_TABLE_LIMIT)
+    return 1;
+
+  switch(unicode_class(codepoint)) {
+    case UNICODE_CLASS_COMBINING: return 0;
+    case UNICODE_CLASS_WIDE:      return 2;
+    case UNICODE_CLASS_CONTROL:   return -1;
+    default:                      return 1;
+  }
 }
 
 int vterm_unicode_is_combining(int codepoint)
 {
-  return bisearch(codepoint, combining, sizeof(combining) / sizeof(struct interval) - 1);
+  if(codepoint < 0x100 || codepoint >= UNICODE_TABLE_LIMIT)
+    return 0;
+  return unicode_class(codepoint) == UNICODE_CLASS_COMBINING;
 }
+
+#endif
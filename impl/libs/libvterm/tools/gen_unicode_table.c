@@ -0,0 +1,128 @@
+/*
+ * Copyright 2016, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+/* Host tool which generates src/unicode_table.inc, the two-stage width / combining lookup table
+ * used by vterm_unicode_width() and vterm_unicode_is_combining(), from the interval tables in
+ * src/unicode.c.
+ *
+ * Built with VTERM_UNICODE_CHECK, it instead compiles the real vterm_unicode_width() and
+ * vterm_unicode_is_combining() against the emitted table, and checks them against mk_wcwidth()
+ * and bisearch() for every codepoint from -1 to U+10FFFF. It exits non-zero if they disagree.
+ *
+ *   cc -I../include -o gen_unicode_table gen_unicode_table.c
+ *   ./gen_unicode_table > ../src/unicode_table.inc
+ *   cc -I../include -DVTERM_UNICODE_CHECK -o check_unicode_table gen_unicode_table.c
+ *   ./check_unicode_table
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef VTERM_UNICODE_CHECK
+#define VTERM_UNICODE_GENERATOR
+#endif
+#include "../src/unicode.c"
+
+#define MAX_CODEPOINT 0x10FFFF
+
+#ifdef VTERM_UNICODE_CHECK
+
+int main(void)
+{
+  int errors = 0;
+  for(int cp = -1; cp <= MAX_CODEPOINT; cp++) {
+    int expect_width = mk_wcwidth(cp);
+    int expect_combining = bisearch(cp, combining, sizeof(combining) / sizeof(struct interval) - 1);
+    int width = vterm_unicode_width(cp);
+    int is_combining = vterm_unicode_is_combining(cp);
+    if(width != expect_width || !is_combining != !expect_combining) {
+      if(errors++ < 10)
+        fprintf(stderr, "check_unicode_table: U+%04X width %d (expected %d) combining %d "
+                "(expected %d)\n", cp, width, expect_width, is_combining, expect_combining);
+    }
+  }
+  if(errors) {
+    fprintf(stderr, "check_unicode_table: %d mismatches\n", errors);
+    return 1;
+  }
+  printf("check_unicode_table: all %d codepoints match\n", MAX_CODEPOINT + 2);
+  return 0;
+}
+
+#else
+
+#define NUM_BLOCKS ((MAX_CODEPOINT + 1) / UNICODE_BLOCK_SIZE)
+#define BLOCK_BYTES (UNICODE_BLOCK_SIZE / 4)
+#define MAX_UNIQUE_BLOCKS 256
+
+static uint8_t blocks[MAX_UNIQUE_BLOCKS][BLOCK_BYTES];
+static int num_blocks;
+static uint8_t block_index[NUM_BLOCKS];
+
+static int classify(int codepoint)
+{
+  if(bisearch(codepoint, combining, sizeof(combining) / sizeof(struct interval) - 1))
+    return UNICODE_CLASS_COMBINING;
+  switch(mk_wcwidth(codepoint)) {
+    case -1: return UNICODE_CLASS_CONTROL;
+    case 2:  return UNICODE_CLASS_WIDE;
+    /* NUL; the lookup never reaches the table below U+0100 */
+    case 0:  return UNICODE_CLASS_CONTROL;
+    default: return UNICODE_CLASS_NARROW;
+  }
+}
+
+int main(void)
+{
+  /* Block 0 is the all narrow block, which every block past the limit is */
+  num_blocks = 1;
+  int limit_block = 0;
+
+  for(int b = 0; b < NUM_BLOCKS; b++) {
+    uint8_t bits[BLOCK_BYTES];
+    memset(bits, 0, sizeof(bits));
+    for(int i = 0; i < UNICODE_BLOCK_SIZE; i++)
+      bits[i / 4] |= classify(b * UNICODE_BLOCK_SIZE + i) << ((i % 4) * 2);
+
+    int found = -1;
+    for(int j = 0; j < num_blocks && found < 0; j++)
+      if(!memcmp(blocks[j], bits, BLOCK_BYTES))
+        found = j;
+    if(found < 0) {
+      if(num_blocks == MAX_UNIQUE_BLOCKS) {
+        fprintf(stderr, "gen_unicode_table: more than %d unique blocks\n", MAX_UNIQUE_BLOCKS);
+        return 1;
+      }
+      found = num_blocks++;
+      memcpy(blocks[found], bits, BLOCK_BYTES);
+    }
+    block_index[b] = found;
+    if(found != 0)
+      limit_block = b + 1;
+  }
+
+  printf("/* Generated by tools/gen_unicode_table.c; do not edit. */\n\n");
+  printf("#define UNICODE_TABLE_LIMIT 0x%X\n\n", limit_block * UNICODE_BLOCK_SIZE);
+
+  printf("static const uint8_t unicode_block_index[%d] = {", limit_block);
+  for(int b = 0; b < limit_block; b++)
+    printf("%s%3d,", (b % 16) ? " " : "\n  ", block_index[b]);
+  printf("\n};\n\n");
+
+  printf("static const uint8_t unicode_blocks[%d][%d] = {\n", num_blocks, BLOCK_BYTES);
+  for(int j = 0; j < num_blocks; j++) {
+    printf("  {");
+    for(int i = 0; i < BLOCK_BYTES; i++)
+      printf("%s0x%02x,", (i % 16) ? " " : "\n    ", blocks[j][i]);
+    printf("\n  },\n");
+  }
+  printf("};\n");
+
+  return 0;
+}
+
+#endif